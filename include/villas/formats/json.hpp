@@ -22,9 +22,13 @@
 
 #pragma once
 
+#include <string>
+
 #include <jansson.h>
 
 #include <villas/format.hpp>
+#include <villas/signal_data.h>
+#include <villas/formats/json_stream.hpp>
 
 /* Forward declarations */
 struct sample;
@@ -32,21 +36,49 @@ struct sample;
 namespace villas {
 namespace node {
 
+/** JSON serialization of samples.
+ *
+ * Samples are written and parsed by streaming over the buffer
+ * instead of building a jansson document for each of them.
+ * The output is identical to that of json_dumpb().
+ */
 class JsonFormat : public Format {
 
 protected:
-	static enum SignalType detect(const json_t *val);
+	static enum SignalType detect(JsonScanner::Token tok);
+
+	/** Check if a value can be serialized. jansson refuses NaN and infinite numbers. */
+	static bool isValid(const union signal_data *data, enum SignalType type);
+
+	/** Serialize a value like signal_data_to_json(). */
+	static void writeData(JsonWriter &w, const union signal_data *data, enum SignalType type);
+
+	/** Parse a value whose first token \p tok has already been returned like signal_data_parse_json().
+	 *
+	 * Only complex numbers are consumed completely.
+	 */
+	static int readData(JsonScanner &s, JsonScanner::Token tok, union signal_data *data, enum SignalType type);
 
-	json_t * packTimestamps(const struct sample *smp);
-	int unpackTimestamps(json_t *json_ts, struct sample *smp);
+	static int readTimestamp(JsonScanner &s, JsonScanner::Token tok, struct timespec *ts);
 
-	virtual int packSample(json_t **j, const struct sample *smp);
-	virtual int packSamples(json_t **j, const struct sample * const smps[], unsigned cnt);
-	virtual int unpackSample(json_t *json_smp, struct sample *smp);
-	virtual int unpackSamples(json_t *json_smps, struct sample * const smps[], unsigned cnt);
+	void writeTimestamps(JsonWriter &w, const struct sample *smp);
+	int readTimestamps(JsonScanner &s, JsonScanner::Token tok, struct sample *smp);
+
+	virtual int writeSample(JsonWriter &w, const struct sample *smp);
+
+	/** Parse a sample whose first token \p tok has already been returned.
+	 *
+	 * The sample does not need to be consumed completely on failure.
+	 */
+	virtual int readSample(JsonScanner &s, JsonScanner::Token tok, struct sample *smp);
+
+	/** Read a single JSON array or object from a stream into JsonFormat::value. */
+	int readValue(FILE *f);
 
 	int dump_flags;
 
+	std::string value;
+
 public:
 	JsonFormat(int fl) :
 		Format(fl),
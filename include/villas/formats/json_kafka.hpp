@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <villas/signal_type.h>
 #include <villas/formats/json.hpp>
 
@@ -31,13 +34,39 @@ namespace node {
 class JsonKafkaFormat : public JsonFormat {
 
 protected:
-	int packSample(json_t **j, const struct sample *smp);
-	int unpackSample(json_t *json_smp, struct sample *smp);
+	/** A key of the payload object. */
+	struct PayloadKey {
+		std::string name;
+		std::vector<int> sources;	/**< Signal indices or one of SOURCE_TIMESTAMP, SOURCE_SEQUENCE. The last valid one is written. */
+	};
+
+	static constexpr int SOURCE_TIMESTAMP = -2;
+	static constexpr int SOURCE_SEQUENCE = -1;
+
+	int writeSample(JsonWriter &w, const struct sample *smp);
+	int readSample(JsonScanner &s, JsonScanner::Token tok, struct sample *smp);
+	int readPayload(JsonScanner &s, JsonScanner::Token tok, struct sample *smp);
 
 	const char * villasToKafkaType(enum SignalType vt);
 
+	/** Update the serialized schema and the payload keys if the sample has different fields than the previous one. */
+	void updateSchema(const struct sample *smp);
+
 	json_t *json_schema;
 
+	/* The schema only changes with the fields of the samples */
+	struct {
+		const struct vlist *signals;
+		int flags;
+		size_t length;
+
+		std::string schema;			/**< The schema serialized by json_dumps(). */
+		std::vector<PayloadKey> payload;	/**< The keys of the payload in the order of serialization. */
+	} cache;
+
+	std::vector<bool> found;
+	std::vector<size_t> matches;
+
 public:
 	JsonKafkaFormat(int fl);
 
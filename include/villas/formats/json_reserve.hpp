@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <string>
+
 #include <villas/formats/json.hpp>
 
 namespace villas {
@@ -30,8 +32,10 @@ namespace node {
 class JsonReserveFormat : public JsonFormat {
 
 protected:
-	int packSample(json_t **j, const struct sample *smp);
-	int unpackSample(json_t *json_smp, struct sample *smp);
+	int writeSample(JsonWriter &w, const struct sample *smp);
+	int readSample(JsonScanner &s, JsonScanner::Token tok, struct sample *smp);
+
+	std::string name;
 
 public:
 	using JsonFormat::JsonFormat;
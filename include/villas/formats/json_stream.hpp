@@ -0,0 +1,216 @@
+/** Streaming JSON writer and scanner for the JSON-based formats.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#define JSON_STREAM_MAX_DEPTH	32
+
+namespace villas {
+namespace node {
+
+/** Serializes JSON directly into a character buffer.
+ *
+ * The output is identical to json_dumpb() for a document which has been
+ * built in the same order and is dumped with the same flags.
+ * Keys are written in the order in which they are passed. Callers
+ * are responsible for the order required by JSON_SORT_KEYS.
+ */
+class JsonWriter {
+
+public:
+	/** A position to which the writer can be rewound. */
+	struct Mark {
+		size_t off;
+		unsigned depth;
+		unsigned count;
+	};
+
+protected:
+	char *buf;
+	size_t len;
+	size_t off;		/**< Number of bytes which have been written. May exceed JsonWriter::len. */
+
+	size_t flags;		/**< A combination of the json_dumpb() flags. */
+
+	unsigned depth;		/**< Number of open arrays and objects. */
+	unsigned count[JSON_STREAM_MAX_DEPTH + 1]; /**< Number of values per open array or object. */
+	bool after_key;
+
+	void put(const char *s, size_t n);
+	void put(char c);
+
+	void indent(unsigned d, bool space);
+	void separator();
+
+	void begin(char c);
+	void end(char c);
+
+	void escape(const char *s, size_t n);
+
+public:
+	JsonWriter(char *b, size_t l, size_t fl);
+
+	void beginObject()
+	{ begin('{'); }
+
+	void endObject()
+	{ end('}'); }
+
+	void beginArray()
+	{ begin('['); }
+
+	void endArray()
+	{ end(']'); }
+
+	void key(const char *k);
+
+	void string(const char *s);
+	void integer(int64_t i);
+
+	/** Write a floating point number. It must be finite. */
+	void real(double d);
+	void boolean(bool b);
+
+	/** Write a value which has already been serialized by json_dumpb() with the same flags. */
+	void raw(const char *s, size_t n);
+
+	bool sorted() const;
+
+	size_t length() const
+	{ return off; }
+
+	Mark mark() const
+	{ return { off, depth, count[depth] }; }
+
+	void rewind(const Mark &m);
+};
+
+/** A pull parser which returns the tokens of a JSON document one by one.
+ *
+ * The scanner validates the document with the same rules as json_loadb():
+ * the top-level value must be an array or object and must not be followed
+ * by anything but whitespace.
+ */
+class JsonScanner {
+
+public:
+	enum class Token {
+		ERROR,
+		END,
+		OBJECT_BEGIN,
+		OBJECT_END,
+		ARRAY_BEGIN,
+		ARRAY_END,
+		KEY,
+		STRING,
+		INTEGER,
+		REAL,
+		TRUE,
+		FALSE,
+		NUL
+	};
+
+protected:
+	enum class State {
+		START,
+		DONE,
+		ARRAY_FIRST,
+		ARRAY_NEXT,
+		OBJECT_FIRST,
+		OBJECT_NEXT,
+		OBJECT_VALUE
+	};
+
+	const char *pos;
+	const char *start;
+	const char *end;
+	const char *token_begin;
+
+	unsigned depth_;
+	State states[JSON_STREAM_MAX_DEPTH + 1];
+	bool failed;
+
+	std::string_view str;
+	std::string scratch;	/**< Holds strings which contain escape sequences. */
+
+	union {
+		int64_t i;
+		double f;
+	} num;
+
+	Token error();
+	Token value();
+	Token scanString(Token tok);
+	Token scanNumber();
+	Token scanLiteral(const char *lit, size_t n, Token tok);
+
+	void whitespace();
+
+public:
+	JsonScanner(const char *buf, size_t len);
+
+	/** Return the next token. */
+	Token next();
+
+	/** Skip the rest of a value whose first token \p tok has already been returned. */
+	bool skip(Token tok);
+
+	/** Skip tokens until only \p d arrays or objects remain open. */
+	bool skipTo(unsigned d);
+
+	/** Number of open arrays and objects. */
+	unsigned depth() const
+	{ return depth_; }
+
+	/** The first character of the last token. */
+	const char * tokenBegin() const
+	{ return token_begin; }
+
+	/** The character after the last token. */
+	const char * tokenEnd() const
+	{ return pos; }
+
+	/** Number of bytes which have been consumed. */
+	size_t position() const
+	{ return pos - start; }
+
+	/** The value of the last Token::KEY or Token::STRING. Valid until the next call to JsonScanner::next(). */
+	std::string_view string() const
+	{ return str; }
+
+	/** The value of the last Token::INTEGER. */
+	int64_t integer() const
+	{ return num.i; }
+
+	/** The value of the last Token::REAL. */
+	double real() const
+	{ return num.f; }
+};
+
+} /* namespace node */
+} /* namespace villas */
@@ -23,7 +23,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdlib>
+#include <vector>
 
 #include <villas/format.hpp>
 
@@ -39,10 +41,40 @@ namespace node {
 class ProtobufFormat : public BinaryFormat {
 
 protected:
+	/* A message tree which is reused by sprint(). It grows to the largest message. */
+	Villas__Node__Message pb_msg;
+	std::vector<Villas__Node__Sample> pb_samples;
+	std::vector<Villas__Node__Sample *> pb_sample_ptrs;
+	std::vector<Villas__Node__Timestamp> pb_timestamps;
+	std::vector<Villas__Node__Value> pb_values;
+	std::vector<Villas__Node__Value *> pb_value_ptrs;
+	std::vector<Villas__Node__Complex> pb_complex;
+
+	/* An arena into which sscan() unpacks messages. It is released as a whole before the next message. */
+	ProtobufCAllocator allocator;
+	std::vector<std::max_align_t> arena;
+	size_t arena_used;			/**< Number of bytes which have been allocated from the arena. */
+	size_t arena_missed;			/**< Number of bytes which did not fit into the arena. */
+	std::vector<void *> arena_overflow;	/**< Allocations which did not fit into the arena. */
+
+	static void * arenaAlloc(void *ctx, size_t size);
+	static void arenaFree(void *ctx, void *ptr);
+
+	void arenaReset();
+
+	/** Make sure that the message tree can hold \p cnt samples with \p values values in total. */
+	void reserve(unsigned cnt, unsigned values);
+
 	enum SignalType detect(const Villas__Node__Value *val);
 
 public:
-	using BinaryFormat::BinaryFormat;
+	ProtobufFormat(int fl);
+
+	virtual
+	~ProtobufFormat();
+
+	virtual
+	void start();
 
 	int sscan(const char *buf, size_t len, size_t *rbytes, struct sample * const smps[], unsigned cnt);
 	int sprint(char *buf, size_t len, size_t *wbytes, const struct sample * const smps[], unsigned cnt);
@@ -0,0 +1,81 @@
+/** Bulk conversion kernels for binary formats.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+/* Forward declarations */
+union signal_data;
+
+/** Instruction set extensions which are used by the conversion kernels. */
+enum class RawConvertIsa {
+	SCALAR,
+	SSE41,		/**< SSE4.1 including SSSE3. */
+	AVX2
+};
+
+/** Use the kernels for a specific instruction set.
+ *
+ * By default, the best instruction set supported by the CPU is chosen at runtime.
+ *
+ * @retval 0 Success.
+ * @retval -1 The instruction set is not supported by the CPU or this build.
+ */
+int raw_convert_select(enum RawConvertIsa isa);
+
+/** The instruction set of the kernels which are currently used. */
+enum RawConvertIsa raw_convert_isa();
+
+/** Reverse the byte order of \p cnt 16-bit values. \p dst may be equal to \p src. */
+void raw_bswap16(void *dst, const void *src, size_t cnt);
+
+/** Reverse the byte order of \p cnt 32-bit values. \p dst may be equal to \p src. */
+void raw_bswap32(void *dst, const void *src, size_t cnt);
+
+/** Reverse the byte order of \p cnt 64-bit values. \p dst may be equal to \p src. */
+void raw_bswap64(void *dst, const void *src, size_t cnt);
+
+/** Convert signal_data::f to single precision.
+ *
+ * @param swap Reverse the byte order of the 32-bit results.
+ */
+void raw_pack_f32(void *dst, const union signal_data *src, size_t cnt, bool swap);
+
+/** Convert single precision floats to signal_data::f.
+ *
+ * @param swap Reverse the byte order of the 32-bit inputs.
+ */
+void raw_unpack_f32(union signal_data *dst, const void *src, size_t cnt, bool swap);
+
+/** Truncate signal_data::i to 32-bit integers.
+ *
+ * @param swap Reverse the byte order of the 32-bit results.
+ */
+void raw_pack_i32(void *dst, const union signal_data *src, size_t cnt, bool swap);
+
+/** Sign-extend 32-bit integers to signal_data::i.
+ *
+ * @param swap Reverse the byte order of the 32-bit inputs.
+ */
+void raw_unpack_i32(union signal_data *dst, const void *src, size_t cnt, bool swap);
@@ -139,6 +139,23 @@ public:
 		return Reason::OK;
 	};
 
+	/** Called whenever a batch of samples is processed.
+	 *
+	 * Samples which are passed on are moved to the front of \p smps
+	 * while keeping their order. Skipped samples are moved behind them.
+	 *
+	 * Samples for which the processing has been stopped are passed on
+	 * as well, but are not processed by later hooks. They are placed at
+	 * the end of the passed on samples and counted in \p stopped.
+	 *
+	 * The default implementation calls process(struct sample *) for each sample.
+	 * Hooks which can process a whole batch more efficiently should override it.
+	 *
+	 * @return The number of samples which are passed on or -1 on error.
+	 */
+	virtual
+	int process(struct sample *smps[], unsigned cnt, unsigned &stopped);
+
 	int getPriority() const
 	{
 		return priority;
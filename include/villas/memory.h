@@ -29,6 +29,13 @@
 #include <villas/node/config.h>
 #include <villas/memory_type.h>
 
+/** Minimum alignment of the addresses returned by all memory types.
+ *
+ * Allocations are registered by their address without the lower bits.
+ * Hence, all memory types align their allocations to at least this many bytes.
+ */
+#define MEMORY_MIN_ALIGNMENT	16
+
 /* Forward declarations */
 struct vnode;
 
@@ -79,4 +86,10 @@ void * memory_alloc_aligned(size_t len, size_t alignment, struct memory_type *m
 
 int memory_free(void *ptr);
 
+/** Get the allocation which starts at \p ptr.
+ *
+ * This function is thread-safe and does not allocate memory.
+ *
+ * @retval nullptr If \p ptr has not been returned by memory_alloc().
+ */
 struct memory_allocation * memory_get_allocation(void *ptr);
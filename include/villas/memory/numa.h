@@ -0,0 +1,54 @@
+/** NUMA-aware memory allocator.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#pragma once
+
+#include <villas/memory_type.h>
+
+/** Highest NUMA node which can be addressed by memory_numa(). */
+#define MEMORY_NUMA_MAX_NODE	1023
+
+enum class MemoryNumaPolicy {
+	PREFERRED,	/**< Fall back to other NUMA nodes if the requested one is out of memory. */
+	BIND		/**< Only use memory of the requested NUMA node. */
+};
+
+struct memory_numa {
+	int node;
+	enum MemoryNumaPolicy policy;
+	struct memory_type *parent;
+};
+
+/** Create a memory type which places the allocations of \p parent on NUMA node \p node.
+ *
+ * The parent must allocate whole pages (see MemoryFlags::MMAP).
+ */
+struct memory_type * memory_numa(int node, enum MemoryNumaPolicy policy, struct memory_type *parent);
+
+void memory_numa_destroy(struct memory_type *m);
+
+/** Get the NUMA node of the CPUs in the bitmask \p cpus.
+ *
+ * @retval -1 The CPUs belong to different NUMA nodes or the topology is unknown.
+ */
+int memory_numa_node(int cpus);
@@ -37,7 +37,8 @@ enum class MemoryFlags {
 	MMAP		= (1 << 0),
 	DMA		= (1 << 1),
 	HUGEPAGE	= (1 << 2),
-	HEAP		= (1 << 3)
+	HEAP		= (1 << 3),
+	SHARED		= (1 << 4)	/**< The memory is mapped by multiple processes at different addresses. */
 };
 
 struct memory_type {
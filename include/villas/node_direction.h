@@ -56,6 +56,8 @@ struct vnode_direction {
 	int enabled;
 	int builtin;		/**< This node should use built-in hooks by default. */
 	unsigned vectorize;	/**< Number of messages to send / recv at once (scatter / gather) */
+	int affinity;		/**< CPU affinity of the writer thread of a decoupled path (NodeDir::OUT only). */
+	int priority;		/**< Real-time priority of the writer thread of a decoupled path (NodeDir::OUT only). */
 
 	struct vlist hooks;	/**< List of read / write hooks (struct hook). */
 	struct vlist signals;	/**< Signal description. */
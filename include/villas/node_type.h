@@ -194,6 +194,10 @@ struct vnode_type {
 	 * Indexes used to address @p m will wrap around after len messages.
 	 * Some node-types might only support to receive one message at a time.
 	 *
+	 * Node-types may release the first samples in @p smps and replace them
+	 * by samples from their own pools which are then forwarded by reference (see shmem_read()).
+	 * Callers must therefore release the samples in @p smps after use instead of the ones they allocated.
+	 *
 	 * @param n		    A pointer to the node object.
 	 * @param smps		An array of pointers to memory blocks where the function should store received samples.
 	 * @param cnt		The number of samples that are allocated by the calling function.
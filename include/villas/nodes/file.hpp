@@ -33,6 +33,8 @@
 
 #include <villas/format.hpp>
 #include <villas/task.hpp>
+#include <villas/nodes/file_async.hpp>
+#include <villas/nodes/file_columnar.hpp>
 
 /* Forward declarations */
 struct vnode;
@@ -44,6 +46,17 @@ struct file {
 	FILE *stream_in;
 	FILE *stream_out;
 
+	int columnar;			/**< Replay and record a memory-mapped columnar file instead of using the formatter. */
+	struct file_columnar cf;
+	struct file_columnar_pos start;	/**< The position at which the replay starts and to which it is rewound. */
+
+	int async;			/**< Record via buffers which are written by a background thread. */
+	unsigned async_buffers;		/**< Number of buffers for asynchronous recording. */
+	int async_direct;		/**< Bypass the page cache for asynchronous recording. */
+	size_t rotate_size;		/**< Start a new file after this many bytes have been recorded asynchronously. */
+	double rotate_interval;		/**< Start a new file after this many seconds of asynchronous recording. */
+	struct file_async fa;
+
 	char *uri_tmpl;			/**< Format string for file name. */
 	char *uri;			/**< Real file name. */
 	char *mode;			/**< File access mode. */
@@ -52,7 +65,7 @@ struct file {
 	int flush;			/**< Flush / upload file contents after each write. */
 	struct Task task;		/**< Timer file descriptor. Blocks until 1 / rate seconds are elapsed. */
 	double rate;			/**< The read rate. */
-	size_t buffer_size_out;		/**< Defines size of output stream buffer. No buffer is created if value is set to zero. */
+	size_t buffer_size_out;		/**< Defines size of output stream buffer. No buffer is created if value is set to zero. Size of each buffer for asynchronous recording. */
 	size_t buffer_size_in;		/**< Defines size of input stream buffer. No buffer is created if value is set to zero. */
 
 	enum class EpochMode {
@@ -72,6 +85,7 @@ struct file {
 	struct timespec first;		/**< The first timestamp in the file file::{read,write}::uri */
 	struct timespec epoch;		/**< The epoch timestamp from the configuration. */
 	struct timespec offset;		/**< An offset between the timestamp in the input file and the current time */
+	struct timespec seek;		/**< Start the replay at the first sample which is not older than this timestamp. Only for columnar files. */
 };
 
 /** @see node_type::print */
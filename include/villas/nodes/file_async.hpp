@@ -0,0 +1,113 @@
+/** Asynchronous recording for the file node-type.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+/**
+ * @addtogroup file File-IO node type
+ * @ingroup node
+ * @{
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <pthread.h>
+
+#include <villas/queue.h>
+#include <villas/queue_signalled.h>
+
+#define FILE_ASYNC_BUFFER_SIZE	(4 << 20)	/**< Default size of each buffer. */
+#define FILE_ASYNC_SAMPLE_LEN	4096	/**< Upper bound for a single formatted sample. Equals the output buffer of villas::node::Format. */
+
+/** A buffer which is filled by the path thread and written by the writer thread. */
+struct file_async_buffer {
+	char *data;
+	size_t len;		/**< Number of valid bytes. */
+	bool rotate;		/**< Start a new file after this buffer has been written. */
+	bool last;		/**< The stop request of file_async_destroy(). It carries no data. */
+};
+
+/** Records formatted samples into a bounded set of buffers which are written to disk by a background thread.
+ *
+ * The path thread never blocks on the disk. If all buffers are in use,
+ * the sample is dropped and counted instead. All buffers, except for
+ * the last one of each file, are written completely, so that their size
+ * and offset are suitable for O_DIRECT.
+ */
+struct file_async {
+	/* Configuration */
+	const char *uri_tmpl;		/**< strftime(3) format string for the file names. */
+	size_t buffer_size;		/**< Size of a single buffer. A multiple of the page size. */
+	unsigned buffer_count;
+	bool direct;			/**< Bypass the page cache with O_DIRECT. */
+	size_t rotate_size;		/**< Start a new file after this many bytes. Zero disables rotation by size. */
+	double rotate_interval;		/**< Start a new file after this many seconds. Zero disables rotation by time. */
+
+	char *memory;
+	struct file_async_buffer *buffers;	/**< file_async::buffer_count buffers followed by the stop request. */
+	struct queue free;		/**< Buffers which can be filled. */
+	struct queue_signalled full;	/**< Buffers which wait for the writer thread. */
+
+	FILE *stream;			/**< A stream which fills the buffers. Pass it to villas::node::Format::print(). */
+
+	pthread_t thread;
+
+	/* Owned by the writer thread */
+	int fd;
+	bool fd_direct;			/**< The current file has been opened with O_DIRECT. */
+	off_t offset;
+	char *uri;			/**< The name of the current file. */
+	unsigned files;			/**< Number of files which have been opened. */
+	std::atomic<int> error;		/**< The last error of the writer thread as a negative error number. */
+
+	/* Owned by the path thread */
+	struct file_async_buffer *current;
+	size_t file_bytes;		/**< Bytes which have been recorded into the current file. */
+	struct timespec file_started;
+
+	std::atomic<unsigned> pending;	/**< Number of buffers which wait for the writer thread. */
+	unsigned high_water;		/**< Highest value of file_async::pending. */
+	uint64_t dropped;		/**< Number of samples which have been dropped. */
+};
+
+/** Open the first file and start the writer thread.
+ *
+ * @retval 0 Success.
+ * @retval <0 A negative error number.
+ */
+int file_async_init(struct file_async *a, const char *uri_tmpl, size_t buffer_size, unsigned buffer_count, bool direct, size_t rotate_size, double rotate_interval);
+
+/** Write all remaining buffers, stop the writer thread and close the file. */
+int file_async_destroy(struct file_async *a);
+
+/** Make sure that a sample of up to \p len bytes can be written to file_async::stream.
+ *
+ * Starts a new file beforehand if one of the rotation limits has been reached.
+ *
+ * @retval 0 The sample can be written.
+ * @retval -1 All buffers are in use. The sample must be dropped.
+ */
+int file_async_reserve(struct file_async *a, size_t len);
+
+/** @} */
@@ -0,0 +1,152 @@
+/** Memory-mapped columnar recordings for the file node-type.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+/**
+ * @addtogroup file File-IO node type
+ * @ingroup node
+ * @{
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+#include <villas/list.h>
+#include <villas/sample.h>
+
+#define FILE_COLUMNAR_MAGIC		"VILLASCF"
+#define FILE_COLUMNAR_VERSION		1
+#define FILE_COLUMNAR_BYTE_ORDER	0x01020304	/**< Recordings are stored in host byte order. */
+#define FILE_COLUMNAR_BLOCK_ROWS	1024		/**< Number of samples per block in new recordings. */
+
+/** The header at the beginning of a columnar recording.
+ *
+ * It is followed by one byte per signal holding its enum SignalType
+ * and padded to a multiple of the page size.
+ */
+struct file_columnar_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t header_len;	/**< Offset of the first block. */
+	uint32_t signal_count;	/**< Number of columns in each block. */
+	uint32_t block_rows;	/**< Maximum number of samples in each block. */
+	uint32_t reserved;
+	uint64_t block_len;	/**< Size of each block in bytes. A multiple of the page size. */
+	uint8_t types[];
+};
+
+/** The header of each block.
+ *
+ * It is followed by the per-sample arrays
+ *   int64_t ts_origin[block_rows];	Nanoseconds since the UNIX epoch
+ *   uint64_t sequence[block_rows];
+ *   uint32_t flags[block_rows];
+ *   uint32_t length[block_rows];
+ * and a cache-line aligned column of block_rows values for each signal.
+ */
+struct file_columnar_block {
+	uint32_t rows;		/**< Number of valid samples in this block. */
+	uint32_t reserved[15];
+};
+
+/** A position within a recording. */
+struct file_columnar_pos {
+	size_t block;
+	unsigned row;
+};
+
+/** A recording of samples which are stored signal-major in blocks of constant size.
+ *
+ * The whole file is mapped into memory for replay. Reading a sample does not
+ * involve any parsing and any sample can be located without scanning the file:
+ * the blocks have a constant size and store the timestamps in a sorted array.
+ *
+ * Samples are appended by writing complete blocks. Blocks which have been
+ * written only partially, e.g. because the recording has been flushed or stopped,
+ * are skipped by their valid number of rows during replay.
+ */
+struct file_columnar {
+	int fd;
+
+	struct file_columnar_header *header;	/**< The mapping of the whole file. */
+	size_t map_len;
+	size_t blocks;				/**< Number of complete blocks in the mapping. */
+
+	size_t offsets[4];			/**< Offsets of the per-sample arrays within a block. */
+	size_t columns;				/**< Offset of the first column within a block. */
+
+	struct file_columnar_pos pos;		/**< The next sample to replay. */
+
+	/* Recording */
+	struct file_columnar_block *wblock;	/**< The block which is currently written. */
+	off_t wblock_off;			/**< Its offset in the file. */
+};
+
+/** Open or create a recording of \p signals.
+ *
+ * If the file already holds a recording, its signals must match in count and type.
+ *
+ * @param record Open the file for appending samples. Otherwise the recording is opened read-only and must exist.
+ * @retval 0 Success.
+ * @retval -EPROTO The signals of the recording do not match.
+ * @retval <0 A negative error number.
+ */
+int file_columnar_open(struct file_columnar *c, const char *uri, struct vlist *signals, bool record);
+
+/** Write the current block and close the recording. */
+int file_columnar_close(struct file_columnar *c);
+
+/** Extend the mapping by blocks which have been appended to the file since it was mapped. */
+int file_columnar_remap(struct file_columnar *c);
+
+/** Find the first sample whose origin timestamp is not before \p ts.
+ *
+ * @return The position of the sample or the end of the recording.
+ */
+struct file_columnar_pos file_columnar_find(struct file_columnar *c, const struct timespec *ts);
+
+/** Advance \p pos by \p cnt samples. */
+struct file_columnar_pos file_columnar_skip(struct file_columnar *c, struct file_columnar_pos pos, size_t cnt);
+
+/** Get the origin timestamp of the sample at file_columnar::pos.
+ *
+ * @retval 0 Success.
+ * @retval -1 The end of the recording has been reached.
+ */
+int file_columnar_peek(struct file_columnar *c, struct timespec *ts);
+
+/** Copy up to \p cnt samples starting at file_columnar::pos into \p smps and advance the position.
+ *
+ * @return The number of samples. Zero if the end of the recording has been reached.
+ */
+int file_columnar_read(struct file_columnar *c, struct sample * const smps[], unsigned cnt, struct vlist *signals);
+
+/** Append \p cnt samples to the recording. */
+int file_columnar_write(struct file_columnar *c, const struct sample * const smps[], unsigned cnt);
+
+/** Write the current, partially filled block to the file. */
+int file_columnar_flush(struct file_columnar *c);
+
+/** @} */
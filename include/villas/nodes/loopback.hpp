@@ -41,6 +41,7 @@ struct sample;
  */
 struct loopback {
 	int queuelen;
+	int spin;		/**< Spin budget of the reading side in nano seconds. Negative values select it automatically. */
 	enum QueueSignalledMode mode;
 	struct queue_signalled queue;
 };
@@ -47,6 +47,7 @@ struct shmem {
 	struct shmem_conf conf; 	/**< Interface configuration struct. */
 	char **exec;            	/**< External program to execute on start. */
 	struct shmem_int intf;  	/**< Shmem interface */
+	int zerocopy;			/**< Forward received samples by reference instead of copying them out of the shared pool. */
 };
 
 /** @see node_type::print */
@@ -61,6 +62,9 @@ int shmem_start(struct vnode *n);
 /** @see node_type::stop */
 int shmem_stop(struct vnode *n);
 
+/** @see node_type::destroy */
+int shmem_destroy(struct vnode *n);
+
 /** @see node_type::read */
 int shmem_read(struct vnode *n, struct sample * const smps[], unsigned cnt);
 
@@ -35,10 +35,26 @@
 
 /* Forward declarations */
 struct vnode;
+struct socket_uring;
+struct socket_xdp;
 
 /** The maximum length of a packet which contains stuct msg. */
 #define SOCKET_INITIAL_BUFFER_LEN (64*1024)
 
+/** The maximum number of datagrams which are received or sent by a single recvmmsg() / sendmmsg().
+ *
+ * Each of them requires a slot of SOCKET_INITIAL_BUFFER_LEN bytes.
+ */
+#define SOCKET_MAX_BATCH 16
+
+#ifdef __APPLE__
+/* recvmmsg() and sendmmsg() are emulated by receiving / sending a single datagram */
+struct mmsghdr {
+	struct msghdr msg_hdr;
+	unsigned int msg_len;
+};
+#endif /* __APPLE__ */
+
 struct socket {
 	int sd;				/**< The socket descriptor */
 	int verify_source;		/**< Verify the source address of incoming packets against socket::remote. */
@@ -57,9 +73,28 @@ struct socket {
 
 	struct {
 		char *buf;		/**< Buffer for receiving messages */
-		size_t buflen;
+		size_t buflen;		/**< Length of a single datagram slot in socket::buf */
 		union sockaddr_union saddr;	/**< Remote address of the socket */
+
+		/* Scatter / gather of multiple datagrams with a single recvmmsg() / sendmmsg() */
+		unsigned batch;		/**< Number of datagram slots in socket::buf */
+		struct mmsghdr *msgs;
+		struct iovec *iov;
+		union sockaddr_union *addrs;	/**< Source addresses of received datagrams */
 	} in, out;
+
+	int sample_per_datagram;	/**< Send each sample in a separate datagram. */
+
+	int io_uring;			/**< Receive via io_uring if supported by the kernel. */
+	struct socket_uring *uring;	/**< The io_uring receive backend or nullptr if not used. */
+
+	/* AF_XDP options */
+	struct {
+		unsigned queue;		/**< The receive queue of the interface to which the socket is bound. */
+		int native;		/**< Attach the XDP program in driver mode. */
+		int zerocopy;		/**< Let the driver access the UMEM directly. */
+		struct socket_xdp *ctx;	/**< The AF_XDP socket or nullptr if not used. */
+	} xdp;
 };
 
 
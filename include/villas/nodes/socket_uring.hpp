@@ -0,0 +1,110 @@
+/** io_uring receive backend for the socket node-type.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+/**
+ * @addtogroup socket BSD Socket Node Type
+ * @ingroup node
+ * @{
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+
+#include <villas/socket_addr.h>
+
+#define SOCKET_URING_BUFFERS	256		/**< Number of receive buffers provided to the kernel. Must be a power of two. */
+#define SOCKET_URING_BUFFER_LEN	(16*1024)	/**< Length of a single receive buffer including the source address. */
+#define SOCKET_URING_BGID	0		/**< The buffer group ID of the receive buffers. */
+
+/** A ring which receives datagrams with a single multishot recvmsg() request.
+ *
+ * The kernel places incoming datagrams directly into a ring of
+ * pre-registered buffers and posts a completion for each of them.
+ * Completions which are already available are harvested without a system call.
+ *
+ * We use the raw io_uring interface as the few operations we need
+ * do not justify a dependency on liburing.
+ */
+struct socket_uring {
+	int fd;			/**< The io_uring file descriptor. */
+	int sd;			/**< The socket which is read. */
+	bool armed;		/**< The multishot recvmsg() request is active. */
+
+	/* Submission queue */
+	void *ring_ptr;
+	size_t ring_len;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+	size_t sqes_len;
+
+	/* Completion queue */
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	/* Provided receive buffers */
+	struct io_uring_buf_ring *buf_ring;
+	size_t buf_ring_len;
+	uint16_t buf_tail;
+	char *bufs;
+	size_t bufs_len;
+
+	struct msghdr msg;	/**< Template for the multishot recvmsg() request. */
+};
+
+/** A datagram which has been received into one of the provided buffers. */
+struct socket_uring_datagram {
+	char *data;
+	size_t len;
+	union sockaddr_union *src;
+	int flags;		/**< Flags as returned by recvmsg(), e.g. MSG_TRUNC. */
+	uint16_t bid;		/**< The ID of the buffer holding the datagram. */
+};
+
+/** Setup an io_uring and start receiving from the socket \p sd.
+ *
+ * @retval 0 Success.
+ * @retval <0 A negative error number. The kernel does not support all required io_uring features.
+ */
+int socket_uring_init(struct socket_uring *u, int sd);
+
+int socket_uring_destroy(struct socket_uring *u);
+
+/** Wait for at least one datagram and return up to \p cnt of them.
+ *
+ * The buffers of the returned datagrams must be handed back with socket_uring_release().
+ *
+ * @return The number of datagrams or a negative error number.
+ */
+int socket_uring_recv(struct socket_uring *u, struct socket_uring_datagram dgs[], unsigned cnt);
+
+/** Return the buffers of \p cnt datagrams to the kernel. */
+int socket_uring_release(struct socket_uring *u, const struct socket_uring_datagram dgs[], unsigned cnt);
+
+/** @} */
@@ -0,0 +1,126 @@
+/** AF_XDP backend for the Ethernet layer of the socket node-type.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+/**
+ * @addtogroup socket BSD Socket Node Type
+ * @ingroup node
+ * @{
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <sys/uio.h>
+#include <linux/if_xdp.h>
+
+#include <villas/memory.h>
+#include <villas/socket_addr.h>
+
+#define SOCKET_XDP_FRAMES	4096	/**< Number of frames in the UMEM. The first half is used for receiving. Must be a power of two. */
+#define SOCKET_XDP_FRAME_LEN	2048	/**< Length of a single UMEM frame. */
+#define SOCKET_XDP_RING_SIZE	(SOCKET_XDP_FRAMES / 2)	/**< Number of descriptors in each of the four rings. */
+
+/** One of the rings which are shared between user space and the kernel. */
+struct socket_xdp_ring {
+	uint32_t *producer;
+	uint32_t *consumer;
+	uint32_t *flags;
+	void *desc;		/**< Either an array of UMEM addresses or of struct xdp_desc. */
+
+	void *map;
+	size_t map_len;
+};
+
+/** An AF_XDP socket which exchanges Ethernet frames of a single Ethertype.
+ *
+ * A small XDP program redirects all frames of the configured Ethertype
+ * which arrive on the selected receive queue of the interface to the socket.
+ * Other traffic is passed on to the network stack.
+ *
+ * The frames are exchanged via a user memory area (UMEM) which is allocated
+ * from the same memory type as the sample pools of the node and via
+ * rings of descriptors which are accessed without system calls.
+ *
+ * We use the raw bpf() system call and rtnetlink via libnl
+ * as the few operations we need do not justify a dependency on libbpf / libxdp.
+ */
+struct socket_xdp {
+	int fd;			/**< The AF_XDP socket. */
+	int ifindex;
+	unsigned queue;		/**< The receive queue of the interface to which the socket is bound. */
+	uint16_t protocol;	/**< Ethertype in network byte order. */
+	uint8_t mac[ETHER_ADDR_LEN];	/**< The hardware address of the interface. */
+
+	bool copy;		/**< The kernel copies frames from / to the UMEM. */
+	uint32_t xdp_flags;	/**< Flags used to attach the XDP program. */
+	int prog_fd;
+	int map_fd;
+
+	char *umem;
+	size_t umem_len;
+
+	struct socket_xdp_ring fill, comp, rx, tx;
+
+	uint64_t *tx_free;	/**< Stack of transmit frames which are not in use by the kernel. */
+	unsigned tx_free_cnt;
+};
+
+/** A frame which has been received into the UMEM. */
+struct socket_xdp_frame {
+	char *data;		/**< The payload following the Ethernet header. */
+	size_t len;
+	union sockaddr_union src;	/**< The link layer source address of the frame. */
+	uint64_t addr;		/**< The UMEM address of the frame. */
+};
+
+/** Setup an AF_XDP socket on the interface and Ethertype given by \p sll.
+ *
+ * @param native Attach the XDP program in driver mode instead of the generic (skb) mode.
+ * @param zerocopy Let the driver DMA directly to and from the UMEM. Requires native mode.
+ * @param m The memory type which is used for the UMEM.
+ *
+ * @retval 0 Success.
+ * @retval <0 A negative error number. The kernel, the driver or our privileges do not suffice.
+ */
+int socket_xdp_init(struct socket_xdp *x, const struct sockaddr_ll *sll, unsigned queue, bool native, bool zerocopy, struct memory_type *m);
+
+int socket_xdp_destroy(struct socket_xdp *x);
+
+/** Wait for at least one frame and return up to \p cnt of them.
+ *
+ * The frames must be handed back with socket_xdp_release().
+ *
+ * @return The number of frames or a negative error number.
+ */
+int socket_xdp_recv(struct socket_xdp *x, struct socket_xdp_frame frames[], unsigned cnt);
+
+/** Return \p cnt received frames to the kernel. */
+int socket_xdp_release(struct socket_xdp *x, const struct socket_xdp_frame frames[], unsigned cnt);
+
+/** Send each of the \p cnt payloads in a separate Ethernet frame to \p dst.
+ *
+ * @return The number of frames which have been queued for transmission or a negative error number.
+ */
+int socket_xdp_send(struct socket_xdp *x, const struct sockaddr_ll *dst, const struct iovec iov[], unsigned cnt);
+
+/** @} */
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <bitset>
+#include <atomic>
 
 #include <uuid/uuid.h>
 #include <pthread.h>
@@ -38,6 +39,7 @@
 #include <villas/list.h>
 #include <villas/queue.h>
 #include <villas/pool.h>
+#include <villas/memory/numa.h>
 #include <villas/common.hpp>
 #include <villas/mapping.h>
 #include <villas/task.hpp>
@@ -47,6 +49,12 @@
 
 /* Forward declarations */
 struct vnode;
+struct path_scheduler;
+struct path_scheduler_worker;
+struct path_scheduler_event;
+
+#define PATH_MEMORY_NUMA_AUTO	-1	/**< Use the NUMA node of the CPUs in vpath::affinity. */
+#define PATH_MEMORY_NUMA_NONE	-2	/**< Do not place memory on a specific NUMA node. */
 
 /** The register mode determines under which condition the path is triggered. */
 enum class PathMode {
@@ -84,14 +92,31 @@ struct vpath {
 	int muxed;			/**< Is this path muxed? */
 	int affinity;			/**< Thread affinity. */
 	int poll;			/**< Weather or not to use poll(2). */
+	int decouple;			/**< Use a dedicated writer thread for each destination. */
 	int reverse;			/**< This path has a matching reverse path. */
 	int builtin;			/**< This path should use built-in hooks by default. */
 	int original_sequence_no;	/**< Use original source sequence number when multiplexing */
 	unsigned queuelen;		/**< The queue length for each path_destination::queue */
 
+	/** Placement of the sample pools and destination queues of this path. */
+	struct {
+		int numa;			/**< NUMA node or PATH_MEMORY_NUMA_AUTO / PATH_MEMORY_NUMA_NONE. */
+		int hugepages;			/**< Use hugepages. -1 uses them if they have been reserved. */
+		enum MemoryNumaPolicy policy;
+		struct memory_type *type;	/**< The memory type which is used for allocations. */
+	} memory;
+
 	char *_name;			/**< Singleton: A string which is used to print this path to screen. */
 
 	pthread_t tid;			/**< The thread id for this path. */
+
+	/** State of paths which are run by a path_scheduler instead of their own thread. */
+	struct {
+		struct path_scheduler *scheduler;	/**< The scheduler which should run this path or nullptr. */
+		struct path_scheduler_worker *worker;	/**< The worker to which this path is assigned while it is scheduled. */
+		struct path_scheduler_event *events;	/**< One event per entry of vpath::reader::pfds. */
+		std::atomic<unsigned> pending;		/**< Number of events which have not been handled yet. */
+	} sched;
 	json_t *config;			/**< A JSON object containing the configuration of the path. */
 
 	villas::Logger logger;
@@ -128,6 +153,12 @@ int path_start(struct vpath *p);
  */
 int path_stop(struct vpath *p);
 
+/** Handle the readable file descriptor \p i of vpath::reader::pfds. */
+void path_read_event(struct vpath *p, int i);
+
+/** Write the enqueued samples to all destinations unless they have their own writer threads. */
+void path_write_destinations(struct vpath *p);
+
 /** Destroy path by freeing dynamically allocated memory.
  *
  * @param i A pointer to the path structure.
@@ -161,6 +192,8 @@ int path_parse(struct vpath *p, json_t *json, villas::node::NodeList &nodes, con
 
 void path_parse_mask(struct vpath *p, json_t *json_mask, villas::node::NodeList &nodes);
 
+void path_parse_memory(struct vpath *p, json_t *json_memory);
+
 bool path_is_simple(const struct vpath *p);
 
 bool path_is_muxed(const struct vpath *p);
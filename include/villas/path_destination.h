@@ -29,28 +29,58 @@
 
 #pragma once
 
-#include <villas/queue.h>
+#include <atomic>
+
+#include <pthread.h>
+#include <jansson.h>
+
+#include <villas/queue_signalled.h>
 
 /* Forward declarations */
 struct vpath;
 struct sample;
+struct memory_type;
 
 struct vpath_destination {
 	struct vnode *node;
+	struct vpath *path;
+
+	struct queue_signalled queue;
 
-	struct queue queue;
+	pthread_t tid;				/**< The writer thread of this destination (only used if vpath::decouple is set). */
+
+	std::atomic<uint64_t> enqueued;		/**< Number of samples which have been enqueued for this destination. */
+	std::atomic<uint64_t> dropped;		/**< Number of samples which have been dropped due to a queue overrun. */
 };
 
 int path_destination_init(struct vpath_destination *pd, struct vnode *n) __attribute__ ((warn_unused_result));
 
 int path_destination_destroy(struct vpath_destination *pd) __attribute__ ((warn_unused_result));
 
-int path_destination_prepare(struct vpath_destination *pd, int queuelen);
+int path_destination_prepare(struct vpath_destination *pd, int queuelen, bool decouple, struct memory_type *mt);
+
+/** Start the writer thread of a destination.
+ *
+ * This is only used by paths which have the 'decouple' setting enabled.
+ * The thread drains the destination queue and writes the samples to the node.
+ */
+int path_destination_start(struct vpath_destination *pd, struct vpath *p);
+
+int path_destination_stop(struct vpath_destination *pd);
 
 void path_destination_check(struct vpath_destination *pd);
 
+/** Enqueue copies of the samples to all destinations of the path. */
 void path_destination_enqueue(struct vpath *p, const struct sample * const smps[], unsigned cnt);
 
+/** Enqueue the samples to all destinations of the path by reference.
+ *
+ * The samples must not be modified by the caller afterwards.
+ */
+void path_destination_forward(struct vpath *p, struct sample * const smps[], unsigned cnt);
+
 void path_destination_write(struct vpath_destination *pd, struct vpath *p);
 
+json_t * path_destination_to_json(struct vpath_destination *pd);
+
 /** @} */
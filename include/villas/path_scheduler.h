@@ -0,0 +1,126 @@
+/** Worker pool which runs many paths on a few threads.
+ *
+ * @file
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+/** The scheduler runs paths on a fixed number of worker threads.
+ *
+ * Every path is assigned to the worker with the least paths. The file
+ * descriptors of the path are added to the epoll set of this worker.
+ * A worker which receives more than one event at once offers the remaining
+ * events of its batch to idle workers, which steal them.
+ *
+ * Paths with an 'affinity' setting and paths which do not use poll(2)
+ * keep using a dedicated thread.
+ *
+ * @addtogroup path Path
+ * @{
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include <pthread.h>
+#include <jansson.h>
+#include <sys/epoll.h>
+
+#include <villas/common.hpp>
+
+/* Forward declarations */
+struct vpath;
+
+#define PATH_SCHEDULER_BATCH	16	/**< Maximum number of events which a worker takes at once. */
+
+/** An event source of a path. One per entry of vpath::reader::pfds. */
+struct path_scheduler_event {
+	struct vpath *path;
+	int index;				/**< Index in vpath::reader::pfds. */
+
+	std::atomic<bool> ready;		/**< The file descriptor is readable and has not been handled yet. */
+};
+
+struct path_scheduler_worker {
+	struct path_scheduler *scheduler;
+
+	pthread_t tid;
+	int cpu;				/**< The CPU to which the worker is pinned or -1. */
+
+	int epfd;				/**< The epoll set with the events of all paths of this worker. */
+	int kick;				/**< An eventfd to wake up the worker. */
+
+	struct epoll_event events[PATH_SCHEDULER_BATCH];
+
+	std::atomic<uint64_t> batch;		/**< Number of events in the upper, index of the next unhandled event in the lower 32 bits. */
+	std::atomic<unsigned> taken;		/**< Number of events of the current batch which have been handled. */
+
+	std::atomic<uint64_t> loops;		/**< Number of completed iterations of the worker loop. */
+	std::atomic<unsigned> paths;		/**< Number of paths which have been assigned to this worker. */
+
+	std::atomic<uint64_t> handled;		/**< Number of events which have been handled by this worker. */
+	std::atomic<uint64_t> stolen;		/**< Number of events which this worker has stolen from others. */
+};
+
+struct path_scheduler {
+	enum State state;
+
+	int affinity;				/**< The CPUs used by the workers. */
+
+	int nworkers;
+	struct path_scheduler_worker *workers;
+
+	int steal;				/**< An eventfd which is part of the epoll set of all workers. Wakes up one idle worker. */
+
+	std::atomic<bool> stop;
+	std::atomic<int> idle;			/**< Number of workers which are waiting for events. */
+};
+
+/** Initialize a scheduler.
+ *
+ * @param workers The number of worker threads. 0 uses one worker per CPU in \p affinity or per online CPU.
+ * @param affinity Pin each worker to one of the CPUs in this mask. 0 does not pin the workers.
+ */
+int path_scheduler_init(struct path_scheduler *s, int workers, int affinity) __attribute__ ((warn_unused_result));
+
+int path_scheduler_destroy(struct path_scheduler *s) __attribute__ ((warn_unused_result));
+
+int path_scheduler_start(struct path_scheduler *s);
+
+int path_scheduler_stop(struct path_scheduler *s);
+
+/** Check if a path can be run by the scheduler. */
+bool path_scheduler_eligible(const struct vpath *p);
+
+/** Assign a path to the worker with the least paths.
+ *
+ * The path must have been started before.
+ */
+int path_scheduler_add(struct path_scheduler *s, struct vpath *p);
+
+/** Remove a path from its worker.
+ *
+ * Returns only after no worker is handling an event of the path anymore.
+ */
+int path_scheduler_remove(struct path_scheduler *s, struct vpath *p);
+
+json_t * path_scheduler_to_json(struct path_scheduler *s);
+
+/** @} */
@@ -35,6 +35,7 @@
 /* Forward declarations */
 struct vpath;
 struct sample;
+struct memory_type;
 
 enum PathSourceType {
 	MASTER,
@@ -49,13 +50,14 @@ struct vpath_source {
 	enum PathSourceType type;
 
 	struct pool pool;
+	struct memory_type *memory;		/**< The memory type of the pool. */
 	struct vlist mappings;			/**< List of mappings (struct mapping_entry). */
 	struct vlist secondaries;		/**< List of secondary path sources (struct path_sourced). */
 };
 
-int path_source_init_master(struct vpath_source *ps, struct vnode *n) __attribute__ ((warn_unused_result));
+int path_source_init_master(struct vpath_source *ps, struct vnode *n, struct memory_type *mt) __attribute__ ((warn_unused_result));
 
-int path_source_init_secondary(struct vpath_source *ps, struct vnode *n) __attribute__ ((warn_unused_result));
+int path_source_init_secondary(struct vpath_source *ps, struct vnode *n, struct memory_type *mt) __attribute__ ((warn_unused_result));
 
 int path_source_destroy(struct vpath_source *ps) __attribute__ ((warn_unused_result));
 
@@ -63,4 +65,7 @@ void path_source_check(struct vpath_source *ps);
 
 int path_source_read(struct vpath_source *ps, struct vpath *p, int i);
 
+/** Make sure that the pool of the path source holds at least \p cnt samples. */
+int path_source_resize_pool(struct vpath_source *ps, unsigned cnt);
+
 /** @} */
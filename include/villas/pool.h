@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <sys/types.h>
 
@@ -32,11 +33,30 @@
 #include <villas/common.hpp>
 #include <villas/memory.h>
 
+#define POOL_MAGAZINES		16	/**< Number of per-thread caches of a pool */
+#define POOL_MAGAZINE_SIZE	32	/**< Number of blocks which fit into a per-thread cache */
+
+/** Pools with less blocks do not use per-thread caches in order to avoid starving other threads. */
+#define POOL_MAGAZINE_THRESHOLD	(2 * POOL_MAGAZINES * POOL_MAGAZINE_SIZE)
+
+/** A small stack of free blocks which is mostly used by a single thread.
+ *
+ * Threads are assigned to magazines round-robin. If two threads share
+ * a magazine, the lock makes the one which loses fall back to the shared queue.
+ */
+struct pool_magazine {
+	std::atomic<bool> locked;
+	unsigned count;
+
+	void *blocks[POOL_MAGAZINE_SIZE];
+} __attribute__((aligned(CACHELINE_SIZE)));
+
 /** A thread-safe memory pool */
 struct pool {
 	enum State state;
 
 	off_t  buffer_off; /**< Offset from the struct address to the underlying memory area */
+	off_t  magazines_off; /**< Offset from the struct address to the per-thread caches or 0 if disabled */
 
 	size_t len;		/**< Length of the underlying memory area */
 	size_t blocksz;		/**< Length of a block in bytes */
@@ -47,6 +67,7 @@ struct pool {
 
 #define INLINE static inline __attribute__((unused))
 #define pool_buffer(p) ((char *) (p) + (p)->buffer_off)
+#define pool_magazines(p) ((struct pool_magazine *) ((char *) (p) + (p)->magazines_off))
 
 /** Initiazlize a pool
  *
@@ -54,6 +75,11 @@ struct pool {
  * @param[in] cnt The total number of blocks which are reserverd by this pool.
  * @param[in] blocksz The size in bytes per block.
  * @param[in] mem The type of memory which should be used for this pool.
+ *
+ * Pools with at least POOL_MAGAZINE_THRESHOLD blocks use per-thread caches
+ * for all allocations and releases. Pools in memory with the
+ * MemoryFlags::SHARED flag never use them.
+ *
  * @retval 0 The pool has been successfully initialized.
  * @retval <>0 There was an error during the pool initialization.
  */
@@ -62,6 +88,12 @@ int pool_init(struct pool *p, size_t cnt, size_t blocksz, struct memory_type *me
 /** Destroy and release memory used by pool. */
 int pool_destroy(struct pool *p) __attribute__ ((warn_unused_result));
 
+/** Get up to \p cnt blocks using the per-thread cache of the calling thread. */
+ssize_t pool_get_many_cached(struct pool *p, void *blocks[], size_t cnt);
+
+/** Release \p cnt blocks using the per-thread cache of the calling thread. */
+ssize_t pool_put_many_cached(struct pool *p, void *blocks[], size_t cnt);
+
 /** Pop up to \p cnt values from the stack an place them in the array \p blocks.
  *
  * @return The number of blocks actually retrieved from the pool.
@@ -70,12 +102,18 @@ int pool_destroy(struct pool *p) __attribute__ ((warn_unused_result));
  */
 INLINE ssize_t pool_get_many(struct pool *p, void *blocks[], size_t cnt)
 {
+	if (p->magazines_off)
+		return pool_get_many_cached(p, blocks, cnt);
+
 	return queue_pull_many(&p->queue, blocks, cnt);
 }
 
 /** Push \p cnt values which are giving by the array values to the stack. */
 INLINE ssize_t pool_put_many(struct pool *p, void *blocks[], size_t cnt)
 {
+	if (p->magazines_off)
+		return pool_put_many_cached(p, blocks, cnt);
+
 	return queue_push_many(&p->queue, blocks, cnt);
 }
 
@@ -83,11 +121,11 @@ INLINE ssize_t pool_put_many(struct pool *p, void *blocks[], size_t cnt)
 INLINE void * pool_get(struct pool *p)
 {
 	void *ptr;
-	return queue_pull(&p->queue, &ptr) == 1 ? ptr : nullptr;
+	return pool_get_many(p, &ptr, 1) == 1 ? ptr : nullptr;
 }
 
 /** Release a memory block back to the pool. */
 INLINE int pool_put(struct pool *p, void *buf)
 {
-	return queue_push(&p->queue, buf);
+	return pool_put_many(p, &buf, 1);
 }
@@ -50,7 +50,15 @@ struct queue_cell {
 	off_t data_off; /**< Pointer relative to the queue struct */
 };
 
-/** A lock-free multiple-producer, multiple-consumer (MPMC) queue. */
+enum class QueueFlags {
+	SPSC		= (1 << 0)	/**< The queue is only used by a single producer and a single consumer */
+};
+
+/** A lock-free multiple-producer, multiple-consumer (MPMC) queue.
+ *
+ * With QueueFlags::SPSC, the queue works as a ring buffer for a single producer
+ * and a single consumer which does not need the per-cell sequence numbers.
+ */
 struct queue {
 	std::atomic<enum State> state;
 
@@ -58,20 +66,26 @@ struct queue {
 
 	size_t buffer_mask;
 	off_t buffer_off;	/**< Relative pointer to struct queue_cell[] */
+	int flags;
 
 	cacheline_pad_t	_pad1;	/**< Producer area: only producers read & write */
 
 	std::atomic<size_t>	tail;	/**< Queue tail pointer */
+	size_t head_cache;	/**< Last head pointer seen by the producer (SPSC only) */
 
 	cacheline_pad_t	_pad2;	/**< Consumer area: only consumers read & write */
 
 	std::atomic<size_t>	head;	/**< Queue head pointer */
+	size_t tail_cache;	/**< Last tail pointer seen by the consumer (SPSC only) */
 
 	cacheline_pad_t	_pad3;	/**< @todo Why needed? */
 };
 
-/** Initialize MPMC queue */
-int queue_init(struct queue *q, size_t size, struct memory_type *mem = memory_default) __attribute__ ((warn_unused_result));
+/** Initialize MPMC queue
+ *
+ * @param flags A bitmask of QueueFlags.
+ */
+int queue_init(struct queue *q, size_t size, struct memory_type *mem = memory_default, int flags = 0) __attribute__ ((warn_unused_result));
 
 /** Desroy MPMC queue and release memory */
 int queue_destroy(struct queue *q) __attribute__ ((warn_unused_result));
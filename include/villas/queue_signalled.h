@@ -23,10 +23,15 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <pthread.h>
 
 #include <villas/queue.h>
 
+/** Upper limit in nano seconds for the automatically adjusted spin budget of adaptive queues. */
+#define QUEUE_SIGNALLED_SPIN_MAX	50000
+
 enum class QueueSignalledMode {
 	AUTO, /**< We will choose the best method available on the platform */
 	PTHREAD,
@@ -39,16 +44,32 @@ enum class QueueSignalledMode {
 };
 
 enum class QueueSignalledFlags {
-	PROCESS_SHARED	= (1 << 4)
+	PROCESS_SHARED	= (1 << 4),
+	ADAPTIVE	= (1 << 5)	/**< Consumers spin for a while before they block. */
 };
 
-/** Wrapper around queue that uses POSIX CV's for signalling writes. */
+/** Wrapper around queue that uses POSIX CV's for signalling writes.
+ *
+ * Producers only signal if the consumer has consumed the previous signal.
+ * The file descriptor returned by queue_signalled_fd() therefore remains
+ * readable until the consumer blocks in queue_signalled_pull_many().
+ */
 struct queue_signalled {
 	struct queue queue;		/**< Actual underlying queue. */
 
 	enum QueueSignalledMode mode;
 	enum QueueSignalledFlags flags;
 
+	std::atomic<bool> armed;		/**< The next push needs to signal the consumer. */
+
+	std::atomic<uint64_t> pushed;		/**< Number of elements which have been pushed. */
+	std::atomic<uint64_t> signalled;	/**< Number of signals which have been sent to consumers. */
+
+	struct {
+		std::atomic<int> budget;	/**< Duration in nano seconds for which consumers spin before they block. */
+		bool tune;			/**< Adjust the budget to the observed waiting times. */
+	} adaptive;
+
 	union {
 		struct {
 			pthread_cond_t ready;		/**< Condition variable to signal writes to the queue. */
@@ -64,6 +85,10 @@ struct queue_signalled {
 
 #define queue_signalled_available(q) queue_available(&((q)->queue))
 
+/** Initialize a signalled queue
+ *
+ * @param flags A bitmask of QueueSignalledFlags and QueueFlags.
+ */
 int queue_signalled_init(struct queue_signalled *qs, size_t size, struct memory_type *mem = memory_default, enum QueueSignalledMode mode = QueueSignalledMode::AUTO, int flags = 0) __attribute__ ((warn_unused_result));
 
 int queue_signalled_destroy(struct queue_signalled *qs) __attribute__ ((warn_unused_result));
@@ -78,5 +103,12 @@ int queue_signalled_pull_many(struct queue_signalled *qs, void *ptr[], size_t cn
 
 int queue_signalled_close(struct queue_signalled *qs) __attribute__ ((warn_unused_result));
 
+/** Set the duration for which consumers of an adaptive queue spin before they block.
+ *
+ * @param ns The spin budget in nano seconds. A negative value adjusts the budget
+ *           automatically to the waiting times of the consumers (default).
+ */
+void queue_signalled_set_spin(struct queue_signalled *qs, int ns);
+
 /** Returns a file descriptor which can be used with poll / select to wait for new data */
 int queue_signalled_fd(struct queue_signalled *qs);
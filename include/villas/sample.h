@@ -63,6 +63,23 @@ enum class SampleFlags {
 	IS_LAST		= (1 << 17) /**< This sample is the last of a running simulation case */
 };
 
+/** Stages of the processing pipeline at which samples are timestamped.
+ *
+ * Each timestamp is taken when the respective stage has been completed.
+ */
+enum class SampleTraceStage {
+	READ,		/**< The node-type has returned the sample from its read function. */
+	HOOKS_IN,	/**< The input hooks of the source node have been processed. */
+	MUXED,		/**< The sample has been mapped / muxed by path_source_read(). */
+	HOOKS_PATH,	/**< The hooks of the path have been processed. */
+	ENQUEUED,	/**< The sample is handed over to the queues of the path destinations. */
+	DEQUEUED,	/**< The sample has been pulled from the queue of a path destination. */
+	HOOKS_OUT,	/**< The output hooks of the destination node have been processed. */
+	WRITTEN		/**< The node-type has returned from its write function. */
+};
+
+#define SAMPLE_TRACE_STAGES	8
+
 struct sample {
 	uint64_t sequence;	/**< The sequence number of this sample. */
 	unsigned length;	/**< The number of values in sample::values which are valid. */
@@ -80,6 +97,15 @@ struct sample {
 		struct timespec received;	/**< The point in time when this data was received. */
 	} ts;
 
+	/** Monotonic timestamps in nano seconds indexed by SampleTraceStage.
+	 *
+	 * A value of zero denotes a stage which has not been passed.
+	 * The trace is not copied by sample_copy(). See sample_trace_many().
+	 * Samples which are shared by several path destinations carry the
+	 * trace of the destination which has passed a stage last.
+	 */
+	uint64_t trace[SAMPLE_TRACE_STAGES];
+
 	/** The sample signal values.
 	 *
 	 * This variable length array (VLA) extends over the end of struct sample.
@@ -133,6 +159,12 @@ int sample_copy_many(struct sample * const dsts[], const struct sample * const s
 int sample_incref_many(struct sample * const smps[], int cnt);
 int sample_decref_many(struct sample * const smps[], int cnt);
 
+/** Timestamp a batch of samples which have just passed a stage of the processing pipeline.
+ *
+ * The clock is read only once per batch.
+ */
+void sample_trace_many(struct sample * const smps[], int cnt, enum SampleTraceStage stage);
+
 enum SignalType sample_format(const struct sample *s, unsigned idx);
 
 void sample_data_insert(struct sample *smp, const union signal_data *src, size_t offset, size_t len);
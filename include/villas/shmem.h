@@ -37,16 +37,25 @@
 #define DEFAULT_SHMEM_QUEUELEN	512u
 #define DEFAULT_SHMEM_SAMPLELEN	64u
 
+/** The version of the layout of the shared region and of struct sample.
+ *
+ * It must be increased whenever one of them changes.
+ * Version 2 added struct sample::trace.
+ */
+#define SHMEM_VERSION		2u
+
 /** Struct containing all parameters that need to be known when creating a new
  * shared memory object. */
 struct shmem_conf {
 	int polling;			/**< Whether to use polling instead of POSIX CVs */
 	int queuelen;			/**< Size of the queues (in elements) */
 	int samplelen;			/**< Maximum number of data entries in a single sample */
+	int busy_poll;			/**< Microseconds to busy-poll the input queue before blocking on it. */
 };
 
 /** The structure that actually resides in the shared memory. */
 struct shmem_shared {
+	unsigned version;		/**< SHMEM_VERSION of the process which has created the region. Older versions hold shmem_shared::polling here. */
 	int polling;			/**< Whether to use a pthread_cond_t to signal if new samples are written to incoming queue. */
 	struct queue_signalled queue;	/**< Queue for samples passed in both directions. */
 	struct pool pool;		/**< Pool for the samples in the queues. */
@@ -64,6 +73,7 @@ struct shmem_dir {
 struct shmem_int {
 	struct shmem_dir read, write;
 	std::atomic<int> readers, writers, closed;
+	int busy_poll;			/**< Microseconds to busy-poll the input queue before blocking on it. */
 };
 
 /** Open the shared memory objects and retrieve / initialize the shared data structures.
@@ -75,7 +85,7 @@ struct shmem_int {
  * calls will be written to this pointer.
  * @param[in] conf Configuration parameters for the output queue.
  * @retval 0 The objects were opened and initialized successfully.
- * @retval <0 An error occured; errno is set accordingly.
+ * @retval <0 An error occured; errno is set accordingly. errno is EPROTO if the other process uses a different SHMEM_VERSION.
  */
 int shmem_int_open(const char* wname, const char* rname, struct shmem_int* shm, struct shmem_conf* conf);
 
@@ -90,6 +100,9 @@ int shmem_int_close(struct shmem_int *shm);
 /** Read samples from the interface.
  *
  * @param shm The shared memory interface.
+ * If the other process uses POSIX CVs for signalling, the input queue is
+ * busy-polled for shmem_conf::busy_poll microseconds before we block on it.
+ *
  * @param smps  An array where the pointers to the samples will be written. The samples
  * must be freed with sample_decref after use.
  * @param cnt  Number of samples to be read.
@@ -37,8 +37,13 @@
   #include <netinet/ether.h>
 #endif /* LIBNL3_ROUTE_FOUND */
 
+#if defined(WITH_SOCKET_LAYER_ETH) && defined(HAS_AF_XDP)
+  #define WITH_SOCKET_LAYER_XDP
+#endif /* HAS_AF_XDP */
+
 enum class SocketLayer {
 	ETH,
+	XDP,	/**< Ethernet frames exchanged via an AF_XDP socket. Uses the same addresses as ETH. */
 	IP,
 	UDP,
 	UNIX
@@ -64,7 +64,21 @@ public:
 		/* RTP metrics */
 		RTP_LOSS_FRACTION,	/**< Fraction lost since last RTP SR/RR. */
 		RTP_PKTS_LOST,		/**< Cumul. no. pkts lost. */
-		RTP_JITTER		/**< Interarrival jitter. */
+		RTP_JITTER,		/**< Interarrival jitter. */
+
+		/* File metrics */
+		FILE_SMPS_DROPPED,	/**< Samples dropped because all recording buffers were in use. */
+		FILE_BUFFERS_PENDING,	/**< Recording buffers which wait to be written to disk. */
+
+		/* Per-stage latencies, see SampleTraceStage */
+		TRACE_HOOKS_IN,		/**< Processing time of the input hooks. */
+		TRACE_MUX,		/**< Time until the sample has been muxed by the path. */
+		TRACE_HOOKS_PATH,	/**< Processing time of the path hooks. */
+		TRACE_ENQUEUE,		/**< Time until the sample is handed over to the path destinations. */
+		TRACE_QUEUE,		/**< Time which the sample has spent in the queue of the path destination. */
+		TRACE_HOOKS_OUT,	/**< Processing time of the output hooks. */
+		TRACE_WRITE,		/**< Time spent in the write function of the node-type. */
+		TRACE_TOTAL		/**< Time from reading the sample until it has been written. */
 	};
 
 	enum class Type {
@@ -112,6 +126,9 @@ public:
 
 	void update(enum Metric id, double val);
 
+	/** Add the per-stage latencies of samples which have been written to the histograms. */
+	void updateTrace(struct sample * const smps[], unsigned cnt);
+
 	void reset();
 
 	json_t * toJson() const;
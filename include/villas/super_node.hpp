@@ -40,6 +40,7 @@ extern "C" {
 #include <villas/node.h>
 #include <villas/node_list.hpp>
 #include <villas/path_list.hpp>
+#include <villas/path_scheduler.h>
 #include <villas/task.hpp>
 #include <villas/common.hpp>
 #include <villas/kernel/if.hpp>
@@ -75,6 +76,12 @@ protected:
 	int priority;		/**< Process priority (lower is better) */
 	int affinity;		/**< Process affinity of the server and all created threads */
 	int hugepages;		/**< Number of hugepages to reserve. */
+
+	int schedulerEnabled;	/**< Run paths on a pool of worker threads. */
+	int schedulerWorkers;	/**< Number of worker threads. 0 uses one per CPU. */
+	int schedulerAffinity;	/**< CPUs of the worker threads. 0 uses the process affinity. */
+
+	struct path_scheduler scheduler;
 	double statsRate;	/**< Rate at which we display the periodic stats. */
 
 	struct Task task;	/**< Task for periodic stats output */
@@ -102,6 +109,8 @@ public:
 	 */
 	void parse(json_t *json);
 
+	void parseScheduler(json_t *json);
+
 	/** Check validity of super node configuration. */
 	void check();
 
@@ -200,6 +209,11 @@ public:
 		return affinity;
 	}
 
+	struct path_scheduler * getScheduler()
+	{
+		return schedulerEnabled ? &scheduler : nullptr;
+	}
+
 	Logger getLogger()
 	{
 		return logger;
@@ -28,6 +28,7 @@
 #include <villas/timing.h>
 #include <villas/api/request.hpp>
 #include <villas/api/response.hpp>
+#include <villas/path_scheduler.h>
 
 typedef char uuid_string_t[37];
 
@@ -146,6 +147,9 @@ public:
 		json_object_set(json_status, "lws", getLwsStatus());
 #endif /* LWS_WITH_SERVER_STATUS */
 
+		if (sn->getScheduler())
+			json_object_set_new(json_status, "scheduler", path_scheduler_to_json(sn->getScheduler()));
+
 		return new JsonResponse(session, HTTP_STATUS_OK, json_status);
 	}
 };
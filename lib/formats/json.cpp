@@ -20,6 +20,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <cmath>
+
 #include <villas/sample.h>
 #include <villas/compat.hpp>
 #include <villas/signal.h>
@@ -29,22 +31,20 @@
 using namespace villas;
 using namespace villas::node;
 
-enum SignalType JsonFormat::detect(const json_t *val)
+enum SignalType JsonFormat::detect(JsonScanner::Token tok)
 {
-	int type = json_typeof(val);
-
-	switch (type) {
-		case JSON_REAL:
+	switch (tok) {
+		case JsonScanner::Token::REAL:
 			return SignalType::FLOAT;
 
-		case JSON_INTEGER:
+		case JsonScanner::Token::INTEGER:
 			return SignalType::INTEGER;
 
-		case JSON_TRUE:
-		case JSON_FALSE:
+		case JsonScanner::Token::TRUE:
+		case JsonScanner::Token::FALSE:
 			return SignalType::BOOLEAN;
 
-		case JSON_OBJECT:
+		case JsonScanner::Token::OBJECT_BEGIN:
 			return SignalType::COMPLEX; /* must be a complex number */
 
 		default:
@@ -52,168 +52,318 @@ enum SignalType JsonFormat::detect(const json_t *val)
 	}
 }
 
-json_t * JsonFormat::packTimestamps(const struct sample *smp)
+bool JsonFormat::isValid(const union signal_data *data, enum SignalType type)
 {
-	json_t *json_ts = json_object();
+	switch (type) {
+		case SignalType::FLOAT:
+			return std::isfinite(data->f);
 
-#ifdef __arm__ // TODO: check
-	const char *fmt = "[ i, i ]";
-#else
-	const char *fmt = "[ I, I ]";
-#endif
+		case SignalType::COMPLEX:
+			return std::isfinite(std::real(data->z)) && std::isfinite(std::imag(data->z));
 
-	if (flags & (int) SampleFlags::HAS_TS_ORIGIN) {
-		if (smp->flags & (int) SampleFlags::HAS_TS_ORIGIN)
-			json_object_set(json_ts, "origin", json_pack(fmt, smp->ts.origin.tv_sec, smp->ts.origin.tv_nsec));
-	}
+		case SignalType::INTEGER:
+		case SignalType::BOOLEAN:
+			return true;
 
-	if (flags & (int) SampleFlags::HAS_TS_RECEIVED) {
-		if (smp->flags & (int) SampleFlags::HAS_TS_RECEIVED)
-			json_object_set(json_ts, "received", json_pack(fmt, smp->ts.received.tv_sec, smp->ts.received.tv_nsec));
+		default:
+			return false;
 	}
-
-	return json_ts;
 }
 
-int JsonFormat::unpackTimestamps(json_t *json_ts, struct sample *smp)
+void JsonFormat::writeData(JsonWriter &w, const union signal_data *data, enum SignalType type)
 {
-	int ret;
-	json_error_t err;
-	json_t *json_ts_origin = nullptr;
-	json_t *json_ts_received = nullptr;
+	switch (type) {
+		case SignalType::INTEGER:
+			w.integer(data->i);
+			break;
 
-	json_unpack_ex(json_ts, &err, 0, "{ s?: o, s?: o }",
-		"origin",   &json_ts_origin,
-		"received", &json_ts_received
-	);
+		case SignalType::FLOAT:
+			w.real(data->f);
+			break;
 
-	if (json_ts_origin) {
-		ret = json_unpack_ex(json_ts_origin, &err, 0, "[ I, I ]", &smp->ts.origin.tv_sec, &smp->ts.origin.tv_nsec);
-		if (ret)
-			return ret;
+		case SignalType::BOOLEAN:
+			w.boolean(data->b);
+			break;
 
-		smp->flags |= (int) SampleFlags::HAS_TS_ORIGIN;
+		case SignalType::COMPLEX:
+			w.beginObject();
+
+			if (w.sorted()) {
+				w.key("imag");
+				w.real(std::imag(data->z));
+			}
+
+			w.key("real");
+			w.real(std::real(data->z));
+
+			if (!w.sorted()) {
+				w.key("imag");
+				w.real(std::imag(data->z));
+			}
+
+			w.endObject();
+			break;
+
+		default: { }
 	}
+}
 
-	if (json_ts_received) {
-		ret = json_unpack_ex(json_ts_received, &err, 0, "[ I, I ]", &smp->ts.received.tv_sec, &smp->ts.received.tv_nsec);
-		if (ret)
-			return ret;
+int JsonFormat::readData(JsonScanner &s, JsonScanner::Token tok, union signal_data *data, enum SignalType type)
+{
+	switch (type) {
+		case SignalType::FLOAT:
+			data->f = tok == JsonScanner::Token::REAL ? s.real() : 0;
+			break;
+
+		case SignalType::INTEGER:
+			data->i = tok == JsonScanner::Token::INTEGER ? s.integer() : 0;
+			break;
+
+		case SignalType::BOOLEAN:
+			data->b = tok == JsonScanner::Token::TRUE;
+			break;
+
+		case SignalType::COMPLEX: {
+			double real, imag;
+			bool has_real = false, has_imag = false;
+
+			if (tok != JsonScanner::Token::OBJECT_BEGIN)
+				return -2;
+
+			while ((tok = s.next()) == JsonScanner::Token::KEY) {
+				double *v = nullptr;
+
+				if (s.string() == "real") {
+					v = &real;
+					has_real = true;
+				}
+				else if (s.string() == "imag") {
+					v = &imag;
+					has_imag = true;
+				}
+
+				tok = s.next();
+
+				if (!v) {
+					if (!s.skip(tok))
+						return -2;
+				}
+				else if (tok == JsonScanner::Token::REAL)
+					*v = s.real();
+				else if (tok == JsonScanner::Token::INTEGER)
+					*v = s.integer();
+				else
+					return -2;
+			}
+
+			if (tok != JsonScanner::Token::OBJECT_END || !has_real || !has_imag)
+				return -2;
+
+			data->z = std::complex<float>(real, imag);
+
+			return 0;
+		}
 
-		smp->flags |= (int) SampleFlags::HAS_TS_RECEIVED;
+		case SignalType::INVALID:
+			return -1;
 	}
 
 	return 0;
 }
 
-int JsonFormat::packSample(json_t **json_smp, const struct sample *smp)
+int JsonFormat::readTimestamp(JsonScanner &s, JsonScanner::Token tok, struct timespec *ts)
 {
-	json_t *json_root;
-	json_error_t err;
+	if (tok != JsonScanner::Token::ARRAY_BEGIN)
+		return -1;
 
-	json_root = json_pack_ex(&err, 0, "{ s: o }", "ts", packTimestamps(smp));
+	if (s.next() != JsonScanner::Token::INTEGER)
+		return -1;
 
-	if (flags & (int) SampleFlags::HAS_SEQUENCE) {
-		if (smp->flags & (int) SampleFlags::HAS_SEQUENCE) {
-			json_t *json_sequence = json_integer(smp->sequence);
+	ts->tv_sec = s.integer();
 
-			json_object_set_new(json_root, "sequence", json_sequence);
-		}
-	}
+	if (s.next() != JsonScanner::Token::INTEGER)
+		return -1;
 
-	if (flags & (int) SampleFlags::HAS_DATA) {
-		json_t *json_data = json_array();
+	ts->tv_nsec = s.integer();
 
-		for (unsigned i = 0; i < smp->length; i++) {
-			struct signal *sig = (struct signal *) vlist_at_safe(smp->signals, i);
-			if (!sig)
-				return -1;
+	/* Additional elements are ignored */
+	return s.skipTo(s.depth() - 1) ? 0 : -1;
+}
 
-			json_t *json_value = signal_data_to_json(&smp->data[i], sig->type);
+void JsonFormat::writeTimestamps(JsonWriter &w, const struct sample *smp)
+{
+	w.beginObject();
 
-			json_array_append_new(json_data, json_value);
+	if (flags & (int) SampleFlags::HAS_TS_ORIGIN) {
+		if (smp->flags & (int) SampleFlags::HAS_TS_ORIGIN) {
+			w.key("origin");
+			w.beginArray();
+			w.integer(smp->ts.origin.tv_sec);
+			w.integer(smp->ts.origin.tv_nsec);
+			w.endArray();
 		}
-
-		json_object_set_new(json_root, "data", json_data);
 	}
 
-	*json_smp = json_root;
+	if (flags & (int) SampleFlags::HAS_TS_RECEIVED) {
+		if (smp->flags & (int) SampleFlags::HAS_TS_RECEIVED) {
+			w.key("received");
+			w.beginArray();
+			w.integer(smp->ts.received.tv_sec);
+			w.integer(smp->ts.received.tv_nsec);
+			w.endArray();
+		}
+	}
 
-	return 0;
+	w.endObject();
 }
 
-int JsonFormat::packSamples(json_t **json_smps, const struct sample * const smps[], unsigned cnt)
+int JsonFormat::readTimestamps(JsonScanner &s, JsonScanner::Token tok, struct sample *smp)
 {
 	int ret;
-	json_t *json_root = json_array();
 
-	for (unsigned i = 0; i < cnt; i++) {
-		json_t *json_smp;
+	/* Anything but an object is ignored */
+	if (tok != JsonScanner::Token::OBJECT_BEGIN)
+		return s.skip(tok) ? 0 : -1;
 
-		ret = packSample(&json_smp, smps[i]);
-		if (ret)
-			break;
+	while ((tok = s.next()) == JsonScanner::Token::KEY) {
+		if (s.string() == "origin") {
+			ret = readTimestamp(s, s.next(), &smp->ts.origin);
+			if (ret)
+				return ret;
+
+			smp->flags |= (int) SampleFlags::HAS_TS_ORIGIN;
+		}
+		else if (s.string() == "received") {
+			ret = readTimestamp(s, s.next(), &smp->ts.received);
+			if (ret)
+				return ret;
+
+			smp->flags |= (int) SampleFlags::HAS_TS_RECEIVED;
+		}
+		else if (!s.skip(s.next()))
+			return -1;
+	}
+
+	return tok == JsonScanner::Token::OBJECT_END ? 0 : -1;
+}
 
-		json_array_append_new(json_root, json_smp);
+int JsonFormat::writeSample(JsonWriter &w, const struct sample *smp)
+{
+	w.beginObject();
+
+	/* The keys happen to be in reverse alphabetical order */
+	for (int k = 0; k < 3; k++) {
+		switch (w.sorted() ? 2 - k : k) {
+			case 0:
+				w.key("ts");
+				writeTimestamps(w, smp);
+				break;
+
+			case 1:
+				if (flags & (int) SampleFlags::HAS_SEQUENCE) {
+					if (smp->flags & (int) SampleFlags::HAS_SEQUENCE) {
+						w.key("sequence");
+						w.integer(smp->sequence);
+					}
+				}
+				break;
+
+			case 2:
+				if (flags & (int) SampleFlags::HAS_DATA) {
+					w.key("data");
+					w.beginArray();
+
+					for (unsigned i = 0; i < smp->length; i++) {
+						struct signal *sig = (struct signal *) vlist_at_safe(smp->signals, i);
+						if (!sig)
+							return -1;
+
+						/* jansson silently drops values which it can not represent */
+						if (isValid(&smp->data[i], sig->type))
+							writeData(w, &smp->data[i], sig->type);
+					}
+
+					w.endArray();
+				}
+				break;
+		}
 	}
 
-	*json_smps = json_root;
+	w.endObject();
 
-	return cnt;
+	return 0;
 }
 
-int JsonFormat::unpackSample(json_t *json_smp, struct sample *smp)
+int JsonFormat::readSample(JsonScanner &s, JsonScanner::Token tok, struct sample *smp)
 {
 	int ret;
-	json_error_t err;
-	json_t *json_data, *json_value, *json_ts = nullptr;
-	size_t i;
+	bool has_data = false;
 	int64_t sequence = -1;
 
 	smp->signals = signals;
 
-	ret = json_unpack_ex(json_smp, &err, 0, "{ s?: o, s?: I, s: o }",
-		"ts", &json_ts,
-		"sequence", &sequence,
-		"data", &json_data);
-	if (ret)
-		return ret;
+	if (tok != JsonScanner::Token::OBJECT_BEGIN)
+		return -1;
 
 	smp->flags = 0;
 	smp->length = 0;
 
-	if (json_ts) {
-		ret = unpackTimestamps(json_ts, smp);
-		if (ret)
-			return ret;
-	}
+	while ((tok = s.next()) == JsonScanner::Token::KEY) {
+		if (s.string() == "ts") {
+			ret = readTimestamps(s, s.next(), smp);
+			if (ret)
+				return ret;
+		}
+		else if (s.string() == "sequence") {
+			if (s.next() != JsonScanner::Token::INTEGER)
+				return -1;
 
-	if (!json_is_array(json_data))
-		return -1;
+			sequence = s.integer();
+		}
+		else if (s.string() == "data") {
+			if (s.next() != JsonScanner::Token::ARRAY_BEGIN)
+				return -1;
 
-	if (sequence >= 0) {
-		smp->sequence = sequence;
-		smp->flags |= (int) SampleFlags::HAS_SEQUENCE;
-	}
+			has_data = true;
+			smp->length = 0;
 
-	json_array_foreach(json_data, i, json_value) {
-		if (i >= smp->capacity)
-			break;
+			for (unsigned i = 0; (tok = s.next()) != JsonScanner::Token::ARRAY_END; i++) {
+				if (tok == JsonScanner::Token::ERROR)
+					return -1;
 
-		struct signal *sig = (struct signal *) vlist_at_safe(smp->signals, i);
-		if (!sig)
-			return -1;
+				if (i >= smp->capacity) {
+					if (!s.skip(tok))
+						return -1;
 
-		enum SignalType fmt = detect(json_value);
-		if (sig->type != fmt)
-			throw RuntimeError("Received invalid data type in JSON payload: Received {}, expected {} for signal {} (index {}).",
-				signal_type_to_str(fmt), signal_type_to_str(sig->type), sig->name, i);
+					continue;
+				}
 
-		ret = signal_data_parse_json(&smp->data[i], sig->type, json_value);
-		if (ret)
-			return -3;
+				struct signal *sig = (struct signal *) vlist_at_safe(smp->signals, i);
+				if (!sig)
+					return -1;
+
+				enum SignalType fmt = detect(tok);
+				if (sig->type != fmt)
+					throw RuntimeError("Received invalid data type in JSON payload: Received {}, expected {} for signal {} (index {}).",
+						signal_type_to_str(fmt), signal_type_to_str(sig->type), sig->name, i);
 
-		smp->length++;
+				ret = readData(s, tok, &smp->data[i], sig->type);
+				if (ret)
+					return -3;
+
+				smp->length++;
+			}
+		}
+		else if (!s.skip(s.next()))
+			return -1;
+	}
+
+	if (tok != JsonScanner::Token::OBJECT_END || !has_data)
+		return -1;
+
+	if (sequence >= 0) {
+		smp->sequence = sequence;
+		smp->flags |= (int) SampleFlags::HAS_SEQUENCE;
 	}
 
 	if (smp->length > 0)
@@ -222,88 +372,138 @@ int JsonFormat::unpackSample(json_t *json_smp, struct sample *smp)
 	return 0;
 }
 
-int JsonFormat::unpackSamples(json_t *json_smps, struct sample * const smps[], unsigned cnt)
+int JsonFormat::readValue(FILE *f)
 {
-	int ret;
-	json_t *json_smp;
-	size_t i;
+	int c, depth = 0;
+	bool quoted = false, escaped = false;
 
-	if (!json_is_array(json_smps))
-		return -1;
+	value.clear();
 
-	json_array_foreach(json_smps, i, json_smp) {
-		if (i >= cnt)
-			break;
+	do
+		c = getc(f);
+	while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
 
-		ret = unpackSample(json_smp, smps[i]);
-		if (ret < 0)
-			break;
+	if (c != '{' && c != '[')
+		return -1;
+
+	/* We only need to find the end of the value. It is validated by JsonScanner. */
+	for (; c != EOF; c = getc(f)) {
+		value.push_back(c);
+
+		if (quoted) {
+			if (escaped)
+				escaped = false;
+			else if (c == '\\')
+				escaped = true;
+			else if (c == '"')
+				quoted = false;
+		}
+		else if (c == '"')
+			quoted = true;
+		else if (c == '{' || c == '[')
+			depth++;
+		else if (c == '}' || c == ']') {
+			if (--depth == 0)
+				return 0;
+		}
 	}
 
-	return i;
+	return -1;
 }
 
 int JsonFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct sample * const smps[], unsigned cnt)
 {
 	int ret;
-	json_t *json;
-	size_t wr;
+	JsonWriter w(buf, len, dump_flags);
 
-	ret = packSamples(&json, smps, cnt);
-	if (ret < 0)
-		return ret;
+	w.beginArray();
 
-	wr = json_dumpb(json, buf, len, dump_flags);
+	for (unsigned i = 0; i < cnt; i++) {
+		JsonWriter::Mark m = w.mark();
 
-	json_decref(json);
+		ret = writeSample(w, smps[i]);
+		if (ret) {
+			w.rewind(m);
+			break;
+		}
+	}
 
+	w.endArray();
+
+	/* Like json_dumpb(), we return the required size if the buffer is too small */
 	if (wbytes)
-		*wbytes = wr;
+		*wbytes = w.length();
 
-	return ret;
+	return cnt;
 }
 
 int JsonFormat::sscan(const char *buf, size_t len, size_t *rbytes, struct sample * const smps[], unsigned cnt)
 {
 	int ret;
-	json_t *json;
-	json_error_t err;
+	unsigned i = 0;
+	bool failed = false;
+	JsonScanner s(buf, len);
+	JsonScanner::Token tok;
 
-	json = json_loadb(buf, len, 0, &err);
-	if (!json)
+	if (s.next() != JsonScanner::Token::ARRAY_BEGIN)
 		return -1;
 
-	ret = unpackSamples(json, smps, cnt);
+	while ((tok = s.next()) != JsonScanner::Token::ARRAY_END) {
+		if (tok == JsonScanner::Token::ERROR)
+			return -1;
+
+		if (!failed && i < cnt) {
+			ret = readSample(s, tok, smps[i]);
+			if (ret < 0)
+				failed = true;
+			else
+				i++;
+		}
 
-	json_decref(json);
+		/* The remainder of the document must be valid nevertheless */
+		if (!s.skipTo(1))
+			return -1;
+	}
 
-	if (ret < 0)
-		return ret;
+	if (s.next() != JsonScanner::Token::END)
+		return -1;
 
 	if (rbytes)
-		*rbytes = err.position;
+		*rbytes = s.position();
 
-	return ret;
+	return i;
 }
 
 int JsonFormat::print(FILE *f, const struct sample * const smps[], unsigned cnt)
 {
 	int ret;
 	unsigned i;
-	json_t *json;
+	size_t wbytes;
 
 	for (i = 0; i < cnt; i++) {
-		ret = packSample(&json, smps[i]);
-		if (ret)
-			return ret;
+		for (;;) {
+			JsonWriter w(out.buffer, out.buflen, dump_flags);
 
-		ret = json_dumpf(json, f, dump_flags);
-		fputc('\n', f);
+			ret = writeSample(w, smps[i]);
+			if (ret)
+				return ret;
 
-		json_decref(json);
+			wbytes = w.length();
+			if (wbytes <= out.buflen)
+				break;
 
-		if (ret)
-			return ret;
+			/* Samples with many signals might not fit into the buffer */
+			delete[] out.buffer;
+
+			out.buflen = wbytes;
+			out.buffer = new char[out.buflen];
+		}
+
+		ret = fwrite(out.buffer, 1, wbytes, f);
+		fputc('\n', f);
+
+		if (ret != (int) wbytes)
+			return -1;
 	}
 
 	return i;
@@ -313,22 +513,26 @@ int JsonFormat::scan(FILE *f, struct sample * const smps[], unsigned cnt)
 {
 	int ret;
 	unsigned i;
-	json_t *json;
-	json_error_t err;
+	JsonScanner::Token tok;
 
 	for (i = 0; i < cnt; i++) {
 		if (feof(f))
 			return -1;
 
-skip:		json = json_loadf(f, JSON_DISABLE_EOF_CHECK, &err);
-		if (!json)
+skip:		ret = readValue(f);
+		if (ret)
+			break;
+
+		JsonScanner s(value.data(), value.size());
+
+		tok = s.next();
+		ret = readSample(s, tok, smps[i]);
+
+		if (!s.skipTo(0) || s.next() != JsonScanner::Token::END)
 			break;
 
-		ret = unpackSample(json, smps[i]);
 		if (ret)
 			goto skip;
-
-		json_decref(json);
 	}
 
 	return i;
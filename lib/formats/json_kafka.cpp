@@ -20,6 +20,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <algorithm>
+
 #include <villas/timing.h>
 #include <villas/utils.hpp>
 #include <villas/formats/json_kafka.hpp>
@@ -47,28 +49,46 @@ const char * JsonKafkaFormat::villasToKafkaType(enum SignalType vt)
 	}
 }
 
-int JsonKafkaFormat::packSample(json_t **json_smp, const struct sample *smp)
+void JsonKafkaFormat::updateSchema(const struct sample *smp)
 {
-	json_t *json_payload, *json_fields, *json_field, *json_value;
+	json_t *json_fields, *json_field;
+
+	int fl = smp->flags & ((int) SampleFlags::HAS_TS_ORIGIN | (int) SampleFlags::HAS_SEQUENCE);
+	size_t len = MIN(smp->length, vlist_length(smp->signals));
+
+	if (cache.signals == smp->signals && cache.flags == fl && cache.length == len)
+		return;
 
 	json_fields = json_array();
-	json_payload = json_object();
+
+	cache.payload.clear();
+
+	/* Keys which are set twice keep their position, but get the later value */
+	auto addKey = [this](const char *name, int source) {
+		for (auto &key : cache.payload) {
+			if (key.name == name) {
+				key.sources.push_back(source);
+				return;
+			}
+		}
+
+		cache.payload.push_back({ name, { source } });
+	};
 
 	/* Include sample timestamp */
-	if (smp->flags & (int) SampleFlags::HAS_TS_ORIGIN) {
+	if (fl & (int) SampleFlags::HAS_TS_ORIGIN) {
 		json_field = json_pack("{ s: s, s: b, s: s }",
 			"type", "int64",
 			"optional", false,
 			"field", "timestamp"
 		);
 
-		uint64_t ts_origin_ms = smp->ts.origin.tv_sec * 1e3 + smp->ts.origin.tv_nsec / 1e6;
 		json_array_append_new(json_fields, json_field);
-		json_object_set_new(json_payload, "timestamp", json_integer(ts_origin_ms));
+		addKey("timestamp", SOURCE_TIMESTAMP);
 	}
 
 	/* Include sample sequence no */
-	if (smp->flags & (int) SampleFlags::HAS_SEQUENCE) {
+	if (fl & (int) SampleFlags::HAS_SEQUENCE) {
 		json_field = json_pack("{ s: s, s: b, s: s }",
 			"type", "int64",
 			"optional", false,
@@ -76,13 +96,12 @@ int JsonKafkaFormat::packSample(json_t **json_smp, const struct sample *smp)
 		);
 
 		json_array_append_new(json_fields, json_field);
-		json_object_set_new(json_payload, "sequence", json_integer(smp->sequence));
+		addKey("sequence", SOURCE_SEQUENCE);
 	}
 
 	/* Include sample data */
-	for (size_t i = 0; i < MIN(smp->length, vlist_length(smp->signals)); i++) {
+	for (size_t i = 0; i < len; i++) {
 		struct signal *sig = (struct signal *) vlist_at(smp->signals, i);
-		const union signal_data *data = &smp->data[i];
 
 		json_field = json_pack("{ s: s, s: b, s: s }",
 			"type", villasToKafkaType(sig->type),
@@ -90,72 +109,194 @@ int JsonKafkaFormat::packSample(json_t **json_smp, const struct sample *smp)
 			"field", sig->name
 		);
 
-		json_value = signal_data_to_json(data, sig->type);
-
 		json_array_append_new(json_fields, json_field);
-		json_object_set_new(json_payload, sig->name, json_value);
+
+		if (sig->name)
+			addKey(sig->name, i);
 	}
 
 	json_object_set_new(json_schema, "fields", json_fields);
 
-	json_incref(json_schema);
-	*json_smp = json_pack("{ s: o, s: o }",
-		"schema", json_schema,
-		"payload", json_payload
-	);;
-	if (*json_smp == nullptr)
-		return -1;
+	char *str = json_dumps(json_schema, dump_flags);
+	if (!str)
+		throw RuntimeError("Failed to serialize Kafka schema");
 
-	return 0;
+	cache.schema = str;
+	free(str);
+
+	if (dump_flags & JSON_SORT_KEYS) {
+		std::sort(cache.payload.begin(), cache.payload.end(), [](const PayloadKey &a, const PayloadKey &b) {
+			return a.name < b.name;
+		});
+	}
+
+	cache.signals = smp->signals;
+	cache.flags = fl;
+	cache.length = len;
 }
 
-int JsonKafkaFormat::unpackSample(json_t *json_smp, struct sample *smp)
+int JsonKafkaFormat::writeSample(JsonWriter &w, const struct sample *smp)
 {
-	json_t *json_payload, *json_value;
+	updateSchema(smp);
 
-	json_payload = json_object_get(json_smp, "payload");
-	if (!json_payload)
-		return -1;
+	w.beginObject();
+
+	for (int k = 0; k < 2; k++) {
+		/* "payload" is sorted before "schema" */
+		if ((k == 0) != w.sorted()) {
+			w.key("schema");
+			w.raw(cache.schema.data(), cache.schema.size());
+			continue;
+		}
+
+		w.key("payload");
+		w.beginObject();
+
+		for (auto &key : cache.payload) {
+			struct signal *sig = nullptr;
+			int source = SOURCE_TIMESTAMP - 1;
+
+			/* jansson keeps the previous value if the new one can not be represented */
+			for (auto it = key.sources.rbegin(); it != key.sources.rend(); ++it) {
+				if (*it >= 0) {
+					sig = (struct signal *) vlist_at(smp->signals, *it);
+					if (!isValid(&smp->data[*it], sig->type))
+						continue;
+				}
+
+				source = *it;
+				break;
+			}
+
+			if (source == SOURCE_TIMESTAMP) {
+				uint64_t ts_origin_ms = smp->ts.origin.tv_sec * 1e3 + smp->ts.origin.tv_nsec / 1e6;
+
+				w.key(key.name.c_str());
+				w.integer(ts_origin_ms);
+			}
+			else if (source == SOURCE_SEQUENCE) {
+				w.key(key.name.c_str());
+				w.integer(smp->sequence);
+			}
+			else if (source >= 0) {
+				w.key(key.name.c_str());
+				writeData(w, &smp->data[source], sig->type);
+			}
+		}
+
+		w.endObject();
+	}
+
+	w.endObject();
+
+	return 0;
+}
+
+int JsonKafkaFormat::readPayload(JsonScanner &s, JsonScanner::Token tok, struct sample *smp)
+{
+	size_t cnt = vlist_length(signals);
 
 	smp->length = 0;
 	smp->flags = 0;
 	smp->signals = signals;
 
-	/* Unpack timestamp */
-	json_value = json_object_get(json_payload, "timestamp");
-	if (json_value) {
-		uint64_t ts_origin_ms = json_integer_value(json_value);
-		smp->ts.origin = time_from_double(ts_origin_ms / 1e3);
+	/* A payload which is not an object has no fields */
+	if (tok != JsonScanner::Token::OBJECT_BEGIN)
+		return s.skip(tok) ? 0 : -1;
 
-		smp->flags |= (int) SampleFlags::HAS_TS_ORIGIN;
-	}
+	found.assign(cnt, false);
 
-	/* Unpack sequence no */
-	json_value = json_object_get(json_payload, "sequence");
-	if (json_value) {
-		smp->sequence = json_integer_value(json_value);
+	unsigned depth = s.depth();
 
-		smp->flags |= (int) SampleFlags::HAS_SEQUENCE;
-	}
+	while ((tok = s.next()) == JsonScanner::Token::KEY) {
+		std::string_view name = s.string();
+		bool is_timestamp = name == "timestamp";
+		bool is_sequence = name == "sequence";
 
-	/* Unpack signal data */
-	for (size_t i = 0; i < vlist_length(signals); i++) {
-		struct signal *sig = (struct signal *) vlist_at(signals, i);
+		/* Signals with the same name get the same value */
+		matches.clear();
+		for (size_t i = 0; i < cnt && i < smp->capacity; i++) {
+			struct signal *sig = (struct signal *) vlist_at(signals, i);
 
-		json_value = json_object_get(json_payload, sig->name);
-		if (!json_value)
-			continue;
+			if (sig->name && name == sig->name)
+				matches.push_back(i);
+		}
 
-		signal_data_parse_json(&smp->data[i], sig->type, json_value);
-		smp->length++;
+		tok = s.next();
+
+		if (is_timestamp) {
+			uint64_t ts_origin_ms = tok == JsonScanner::Token::INTEGER ? s.integer() : 0;
+			smp->ts.origin = time_from_double(ts_origin_ms / 1e3);
+
+			smp->flags |= (int) SampleFlags::HAS_TS_ORIGIN;
+		}
+
+		if (is_sequence) {
+			smp->sequence = tok == JsonScanner::Token::INTEGER ? s.integer() : 0;
+
+			smp->flags |= (int) SampleFlags::HAS_SEQUENCE;
+		}
+
+		/* Complex numbers are objects. We can parse them only once. */
+		int complex = -1, ret = -1;
+
+		for (size_t i : matches) {
+			struct signal *sig = (struct signal *) vlist_at(signals, i);
+
+			if (sig->type != SignalType::COMPLEX)
+				readData(s, tok, &smp->data[i], sig->type);
+			else if (complex < 0) {
+				ret = readData(s, tok, &smp->data[i], sig->type);
+				complex = i;
+			}
+			else if (ret == 0)
+				smp->data[i] = smp->data[complex];
+
+			found[i] = true;
+		}
+
+		/* Skip whatever has not been consumed */
+		if (!s.skipTo(depth))
+			return -1;
 	}
 
+	if (tok != JsonScanner::Token::OBJECT_END)
+		return -1;
+
+	smp->length = std::count(found.begin(), found.end(), true);
+
 	if (smp->length > 0)
 		smp->flags |= (int) SampleFlags::HAS_DATA;
 
 	return 0;
 }
 
+int JsonKafkaFormat::readSample(JsonScanner &s, JsonScanner::Token tok, struct sample *smp)
+{
+	int ret;
+	bool has_payload = false;
+
+	if (tok != JsonScanner::Token::OBJECT_BEGIN)
+		return -1;
+
+	while ((tok = s.next()) == JsonScanner::Token::KEY) {
+		if (s.string() == "payload") {
+			ret = readPayload(s, s.next(), smp);
+			if (ret)
+				return ret;
+
+			has_payload = true;
+		}
+		else if (!s.skip(s.next()))
+			return -1;
+	}
+
+	if (tok != JsonScanner::Token::OBJECT_END || !has_payload)
+		return -1;
+
+	return 0;
+}
+
 void JsonKafkaFormat::parse(json_t *json)
 {
 	int ret;
@@ -180,10 +321,14 @@ void JsonKafkaFormat::parse(json_t *json)
 	}
 
 	JsonFormat::parse(json);
+
+	/* The schema depends on the dump flags */
+	cache.signals = nullptr;
 }
 
 JsonKafkaFormat::JsonKafkaFormat(int fl) :
-	JsonFormat(fl)
+	JsonFormat(fl),
+	cache()
 {
 	json_schema = json_pack("{ s: s, s: s }",
 		"type", "struct",
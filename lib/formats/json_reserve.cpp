@@ -20,6 +20,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <cmath>
 #include <cstring>
 
 #include <villas/timing.h>
@@ -27,162 +28,175 @@
 
 using namespace villas::node;
 
-#define JSON_RESERVE_INTEGER_TARGET 1
-
-int JsonReserveFormat::packSample(json_t **json_smp, const struct sample *smp)
+int JsonReserveFormat::writeSample(JsonWriter &w, const struct sample *smp)
 {
-	json_error_t err;
-	json_t *json_root;
-	json_t *json_data;
-	json_t *json_name;
-	json_t *json_unit;
-	json_t *json_value;
-	json_t *json_created = nullptr;
-	json_t *json_sequence = nullptr;
+	enum { NAME, VALUE, UNIT, CREATED, SEQUENCE };
+
+	static const int order[] = { NAME, VALUE, UNIT, CREATED, SEQUENCE };
+	static const int order_sorted[] = { CREATED, NAME, SEQUENCE, UNIT, VALUE };
 
-	if (smp->flags & (int) SampleFlags::HAS_TS_ORIGIN)
-		json_created = json_integer(time_to_double(&smp->ts.origin) * 1e3);
+	const int *keys = w.sorted() ? order_sorted : order;
 
-	if (smp->flags & (int) SampleFlags::HAS_SEQUENCE)
-		json_sequence = json_integer(smp->sequence);
+	bool has_created = smp->flags & (int) SampleFlags::HAS_TS_ORIGIN;
+	bool has_sequence = smp->flags & (int) SampleFlags::HAS_SEQUENCE;
 
-	json_data = json_array();
+	json_int_t created = has_created ? time_to_double(&smp->ts.origin) * 1e3 : 0;
+
+	w.beginObject();
+	w.key("measurements");
+	w.beginArray();
 
 	for (unsigned i = 0; i < smp->length; i++) {
 		struct signal *sig = (struct signal *) vlist_at_safe(smp->signals, i);
 		if (!sig)
 			return -1;
 
-		if (sig->name)
-			json_name = json_string(sig->name);
-		else {
-			char name[32];
-			snprintf(name, 32, "signal%u", i);
-
-			json_name = json_string(name);
-		}
-
-		if (sig->unit)
-			json_unit = json_string(sig->unit);
-		else
-			json_unit = nullptr;
-
-		json_value = json_pack_ex(&err, 0, "{ s: o, s: f }",
-			"name", json_name,
-			"value", smp->data[i].f
-		);
-		if (!json_value)
+		/* jansson refuses to pack NaN and infinite values */
+		if (!std::isfinite(smp->data[i].f))
 			continue;
 
-		if (json_unit)
-			json_object_set_new(json_value, "unit", json_unit);
-		if (json_created)
-			json_object_set_new(json_value, "created", json_created);
-		if (json_sequence)
-			json_object_set_new(json_value, "sequence", json_sequence);
-
-		json_array_append_new(json_data, json_value);
-	}
-
-	json_root = json_pack_ex(&err, 0, "{ s: o }",
-		"measurements", json_data
-	);
-	if (json_root == nullptr)
-		return -1;
-#if 0
-#ifdef JSON_RESERVE_INTEGER_TARGET
-	if (io->out.node) {
-		char *endptr;
-		char *id_str = strrchr(io->out.node->name, '_');
-		if (!id_str)
-			return -1;
+		char buf[32];
+		const char *name = sig->name;
+		if (!name) {
+			snprintf(buf, 32, "signal%u", i);
+			name = buf;
+		}
 
-		int id = strtoul(id_str+1, &endptr, 10);
-		if (endptr[0] != 0)
-			return -1;
+		w.beginObject();
+
+		for (int k = 0; k < 5; k++) {
+			switch (keys[k]) {
+				case NAME:
+					w.key("name");
+					w.string(name);
+					break;
+
+				case VALUE:
+					w.key("value");
+					w.real(smp->data[i].f);
+					break;
+
+				case UNIT:
+					if (sig->unit) {
+						w.key("unit");
+						w.string(sig->unit);
+					}
+					break;
+
+				case CREATED:
+					if (has_created) {
+						w.key("created");
+						w.integer(created);
+					}
+					break;
+
+				case SEQUENCE:
+					if (has_sequence) {
+						w.key("sequence");
+						w.integer(smp->sequence);
+					}
+					break;
+			}
+		}
 
-		json_object_set_new(json_root, "target", json_integer(id));
+		w.endObject();
 	}
-#else
-	if (io->out.node)
-		json_object_set_new(json_root, "target", json_string(io->out.node->name));
-#endif
-#endif
 
-	*json_smp = json_root;
+	w.endArray();
+	w.endObject();
 
 	return 0;
 }
 
-int JsonReserveFormat::unpackSample(json_t *json_smp, struct sample *smp)
+int JsonReserveFormat::readSample(JsonScanner &s, JsonScanner::Token tok, struct sample *smp)
 {
 	int ret, idx;
 	double created = -1;
-	json_error_t err;
-	json_t *json_value, *json_data = nullptr;
-	json_t *json_origin = nullptr, *json_target = nullptr;
-	size_t i;
-
-	ret = json_unpack_ex(json_smp, &err, 0, "{ s?: o, s?: o, s?: o, s?: o }",
-		"origin", &json_origin,
-		"target", &json_target,
-		"measurements", &json_data,
-		"setpoints", &json_data
-	);
-	if (ret)
+	bool has_setpoints = false;
+	const char *data = nullptr;
+	size_t data_len = 0;
+
+	if (tok != JsonScanner::Token::OBJECT_BEGIN)
 		return -1;
 
-#if 0
-#ifdef JSON_RESERVE_INTEGER_TARGET
-	if (json_target && io->in.node) {
-		if (!json_is_integer(json_target))
-			return -1;
+	/* We remember the location of the measurements, as setpoints take precedence */
+	while ((tok = s.next()) == JsonScanner::Token::KEY) {
+		bool is_measurements = s.string() == "measurements";
+		bool is_setpoints = s.string() == "setpoints";
 
-		char *endptr;
-		char *id_str = strrchr(io->in.node->name, '_');
-		if (!id_str)
-			return -1;
+		tok = s.next();
 
-		int id = strtoul(id_str+1, &endptr, 10);
-		if (endptr[0] != 0)
-			return -1;
+		const char *begin = s.tokenBegin();
 
-		if (id != json_integer_value(json_target))
-			return 0;
-	}
-#else
-	if (json_target && io->in.node) {
-		const char *target = json_string_value(json_target);
-		if (!target)
+		if (!s.skip(tok))
 			return -1;
 
-		if (strcmp(target, io->in.node->name))
-			return 0;
+		if (is_setpoints || (is_measurements && !has_setpoints)) {
+			data = begin;
+			data_len = s.tokenEnd() - begin;
+			has_setpoints |= is_setpoints;
+		}
 	}
-#endif
-#endif
-	if (!json_data || !json_is_array(json_data))
+
+	if (tok != JsonScanner::Token::OBJECT_END || !data)
+		return -1;
+
+	JsonScanner d(data, data_len);
+
+	if (d.next() != JsonScanner::Token::ARRAY_BEGIN)
 		return -1;
 
 	smp->flags = 0;
 	smp->length = 0;
 
-	json_array_foreach(json_data, i, json_value) {
-		const char *name, *unit = nullptr;
+	while ((tok = d.next()) != JsonScanner::Token::ARRAY_END) {
+		bool has_name = false, has_value = false;
 		double value;
 
-		ret = json_unpack_ex(json_value, &err, 0, "{ s: s, s?: s, s: F, s?: F }",
-			"name", &name,
-			"unit", &unit,
-			"value", &value,
-			"created", &created
-		);
-		if (ret)
+		if (tok != JsonScanner::Token::OBJECT_BEGIN)
+			return -1;
+
+		while ((tok = d.next()) == JsonScanner::Token::KEY) {
+			double *number = nullptr;
+			bool is_name = d.string() == "name";
+			bool is_unit = d.string() == "unit";
+
+			if (d.string() == "value") {
+				number = &value;
+				has_value = true;
+			}
+			else if (d.string() == "created")
+				number = &created;
+
+			tok = d.next();
+
+			if (is_name || is_unit) {
+				if (tok != JsonScanner::Token::STRING)
+					return -1;
+
+				if (is_name) {
+					name = d.string();
+					has_name = true;
+				}
+			}
+			else if (number) {
+				if (tok == JsonScanner::Token::REAL)
+					*number = d.real();
+				else if (tok == JsonScanner::Token::INTEGER)
+					*number = d.integer();
+				else
+					return -1;
+			}
+			else if (!d.skip(tok))
+				return -1;
+		}
+
+		if (tok != JsonScanner::Token::OBJECT_END || !has_name || !has_value)
 			return -1;
 
 		struct signal *sig;
 
-		sig = vlist_lookup_name<struct signal>(signals, name);
+		sig = vlist_lookup_name<struct signal>(signals, name.c_str());
 		if (sig) {
 			if (!sig->enabled)
 				continue;
@@ -190,7 +204,7 @@ int JsonReserveFormat::unpackSample(json_t *json_smp, struct sample *smp)
 			idx = vlist_index(signals, sig);
 		}
 		else {
-			ret = sscanf(name, "signal_%d", &idx);
+			ret = sscanf(name.c_str(), "signal_%d", &idx);
 			if (ret != 1)
 				continue;
 		}
@@ -217,7 +231,6 @@ int JsonReserveFormat::unpackSample(json_t *json_smp, struct sample *smp)
 	return smp->length > 0 ? 1 : 0;
 }
 
-
 static char n[] = "json.reserve";
 static char d[] = "RESERVE JSON format";
 static FormatPlugin<JsonReserveFormat, n, d, (int) SampleFlags::HAS_TS_ORIGIN | (int) SampleFlags::HAS_SEQUENCE | (int) SampleFlags::HAS_DATA> p;
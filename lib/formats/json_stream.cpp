@@ -0,0 +1,749 @@
+/** Streaming JSON writer and scanner for the JSON-based formats.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <jansson.h>
+
+#include <villas/utils.hpp>
+#include <villas/formats/json_stream.hpp>
+
+/* These are the same as in jansson's private headers */
+#define FLAGS_TO_INDENT(f)	((f) & 0x1F)
+#define FLAGS_TO_PRECISION(f)	(((f) >> 11) & 0x1F)
+
+using namespace villas::node;
+
+JsonWriter::JsonWriter(char *b, size_t l, size_t fl) :
+	buf(b),
+	len(l),
+	off(0),
+	flags(fl),
+	depth(0),
+	after_key(false)
+{
+	count[0] = 0;
+}
+
+void JsonWriter::put(const char *s, size_t n)
+{
+	if (off < len)
+		memcpy(buf + off, s, MIN(n, len - off));
+
+	off += n;
+}
+
+void JsonWriter::put(char c)
+{
+	if (off < len)
+		buf[off] = c;
+
+	off++;
+}
+
+/* See dump_indent() in jansson's dump.c */
+void JsonWriter::indent(unsigned d, bool space)
+{
+	unsigned n = FLAGS_TO_INDENT(flags);
+
+	if (n > 0) {
+		static const char spaces[] = "                                ";
+
+		put('\n');
+
+		for (unsigned ws = d * n; ws > 0; ) {
+			unsigned m = MIN(ws, sizeof(spaces) - 1);
+
+			put(spaces, m);
+			ws -= m;
+		}
+	}
+	else if (space && !(flags & JSON_COMPACT))
+		put(' ');
+}
+
+void JsonWriter::separator()
+{
+	if (after_key) {
+		after_key = false;
+		return;
+	}
+
+	if (depth == 0)
+		return;
+
+	if (count[depth]++ > 0) {
+		put(',');
+		indent(depth, true);
+	}
+	else
+		indent(depth, false);
+}
+
+void JsonWriter::begin(char c)
+{
+	separator();
+	put(c);
+
+	depth++;
+	count[depth] = 0;
+}
+
+void JsonWriter::end(char c)
+{
+	if (count[depth] > 0)
+		indent(depth - 1, false);
+
+	put(c);
+
+	depth--;
+}
+
+void JsonWriter::escape(const char *s, size_t n)
+{
+	const char *pos = s, *lim = s + n;
+
+	put('"');
+
+	while (pos < lim) {
+		const char *run = pos;
+
+		/* Copy everything which does not need to be escaped at once */
+		while (pos < lim) {
+			unsigned char c = *pos;
+
+			if (c == '\\' || c == '"' || c < 0x20)
+				break;
+
+			if (c == '/' && (flags & JSON_ESCAPE_SLASH))
+				break;
+
+			if (c > 0x7F && (flags & JSON_ENSURE_ASCII))
+				break;
+
+			pos++;
+		}
+
+		if (pos > run)
+			put(run, pos - run);
+
+		if (pos == lim)
+			break;
+
+		unsigned char c = *pos;
+		uint32_t cp;
+
+		switch (c) {
+			case '\\': put("\\\\", 2); pos++; continue;
+			case '"':  put("\\\"", 2); pos++; continue;
+			case '\b': put("\\b", 2);  pos++; continue;
+			case '\f': put("\\f", 2);  pos++; continue;
+			case '\n': put("\\n", 2);  pos++; continue;
+			case '\r': put("\\r", 2);  pos++; continue;
+			case '\t': put("\\t", 2);  pos++; continue;
+			case '/':  put("\\/", 2);  pos++; continue;
+		}
+
+		/* Decode a UTF-8 sequence */
+		int extra;
+		if (c < 0x80) {
+			cp = c;
+			extra = 0;
+		}
+		else if (c >= 0xF0) {
+			cp = c & 0x07;
+			extra = 3;
+		}
+		else if (c >= 0xE0) {
+			cp = c & 0x0F;
+			extra = 2;
+		}
+		else {
+			cp = c & 0x1F;
+			extra = 1;
+		}
+
+		pos++;
+		for (; extra > 0 && pos < lim; extra--, pos++)
+			cp = (cp << 6) | (*pos & 0x3F);
+
+		char seq[13];
+		int sl;
+
+		if (cp < 0x10000)
+			sl = snprintf(seq, sizeof(seq), "\\u%04X", cp);
+		else {
+			cp -= 0x10000;
+			sl = snprintf(seq, sizeof(seq), "\\u%04X\\u%04X", 0xD800 | (cp >> 10), 0xDC00 | (cp & 0x3FF));
+		}
+
+		put(seq, sl);
+	}
+
+	put('"');
+}
+
+void JsonWriter::key(const char *k)
+{
+	separator();
+	escape(k, strlen(k));
+
+	if (flags & JSON_COMPACT)
+		put(':');
+	else
+		put(": ", 2);
+
+	after_key = true;
+}
+
+void JsonWriter::string(const char *s)
+{
+	separator();
+	escape(s, strlen(s));
+}
+
+void JsonWriter::integer(int64_t i)
+{
+	char tmp[24], *p = tmp + sizeof(tmp);
+	uint64_t u = i < 0 ? -(uint64_t) i : i;
+
+	do {
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while (u);
+
+	if (i < 0)
+		*--p = '-';
+
+	separator();
+	put(p, tmp + sizeof(tmp) - p);
+}
+
+/* See jsonp_dtostr() in jansson's strconv.c */
+void JsonWriter::real(double d)
+{
+	char tmp[64];
+	int precision = FLAGS_TO_PRECISION(flags);
+
+	int n = snprintf(tmp, sizeof(tmp) - 3, "%.*g", precision ? precision : 17, d);
+
+	/* Make sure that the number is not parsed as an integer */
+	if (!strchr(tmp, '.') && !strchr(tmp, 'e')) {
+		tmp[n++] = '.';
+		tmp[n++] = '0';
+		tmp[n] = '\0';
+	}
+
+	/* Remove the sign and leading zeros from a positive exponent */
+	char *exp = strchr(tmp, 'e');
+	if (exp) {
+		char *s = exp + 1, *e = exp + 2;
+
+		if (*s == '-')
+			s++;
+
+		while (*e == '0')
+			e++;
+
+		if (e != s) {
+			memmove(s, e, n - (e - tmp));
+			n -= e - s;
+		}
+	}
+
+	separator();
+	put(tmp, n);
+}
+
+void JsonWriter::boolean(bool b)
+{
+	separator();
+
+	if (b)
+		put("true", 4);
+	else
+		put("false", 5);
+}
+
+void JsonWriter::raw(const char *s, size_t n)
+{
+	separator();
+
+	/* Nested lines must be indented by the depth at which the value is inserted */
+	if (FLAGS_TO_INDENT(flags) > 0 && depth > 0) {
+		const char *lim = s + n;
+
+		for (const char *nl; (nl = (const char *) memchr(s, '\n', lim - s)); s = nl + 1) {
+			put(s, nl - s);
+			indent(depth, false);
+		}
+
+		put(s, lim - s);
+	}
+	else
+		put(s, n);
+}
+
+bool JsonWriter::sorted() const
+{
+	return flags & JSON_SORT_KEYS;
+}
+
+void JsonWriter::rewind(const Mark &m)
+{
+	off = m.off;
+	depth = m.depth;
+	count[depth] = m.count;
+	after_key = false;
+}
+
+JsonScanner::JsonScanner(const char *buf, size_t len) :
+	pos(buf),
+	start(buf),
+	end(buf + len),
+	token_begin(buf),
+	depth_(0),
+	failed(false)
+{
+	states[0] = State::START;
+	num.i = 0;
+}
+
+void JsonScanner::whitespace()
+{
+	while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r'))
+		pos++;
+}
+
+JsonScanner::Token JsonScanner::error()
+{
+	failed = true;
+
+	return Token::ERROR;
+}
+
+JsonScanner::Token JsonScanner::next()
+{
+	if (failed)
+		return Token::ERROR;
+
+	whitespace();
+
+	State &st = states[depth_];
+	char c = pos < end ? *pos : '\0';
+
+	switch (st) {
+		case State::START:
+			/* Like json_loadb(), we only accept arrays and objects at the top-level */
+			if (c != '{' && c != '[')
+				return error();
+
+			st = State::DONE;
+			return value();
+
+		case State::DONE:
+			return pos == end ? Token::END : error();
+
+		case State::ARRAY_FIRST:
+			if (c == ']')
+				break;
+
+			st = State::ARRAY_NEXT;
+			return value();
+
+		case State::ARRAY_NEXT:
+			if (c == ']')
+				break;
+
+			if (c != ',')
+				return error();
+
+			pos++;
+			whitespace();
+			return value();
+
+		case State::OBJECT_FIRST:
+			if (c == '}')
+				break;
+
+			st = State::OBJECT_VALUE;
+			return c == '"' ? scanString(Token::KEY) : error();
+
+		case State::OBJECT_NEXT:
+			if (c == '}')
+				break;
+
+			if (c != ',')
+				return error();
+
+			pos++;
+			whitespace();
+
+			st = State::OBJECT_VALUE;
+			return pos < end && *pos == '"' ? scanString(Token::KEY) : error();
+
+		case State::OBJECT_VALUE:
+			if (c != ':')
+				return error();
+
+			pos++;
+			whitespace();
+
+			st = State::OBJECT_NEXT;
+			return value();
+	}
+
+	/* Closing bracket */
+	token_begin = pos++;
+	depth_--;
+
+	return c == ']' ? Token::ARRAY_END : Token::OBJECT_END;
+}
+
+JsonScanner::Token JsonScanner::value()
+{
+	token_begin = pos;
+
+	if (pos >= end)
+		return error();
+
+	switch (*pos) {
+		case '{':
+		case '[':
+			if (depth_ >= JSON_STREAM_MAX_DEPTH)
+				return error();
+
+			depth_++;
+			states[depth_] = *pos == '{' ? State::OBJECT_FIRST : State::ARRAY_FIRST;
+
+			return *pos++ == '{' ? Token::OBJECT_BEGIN : Token::ARRAY_BEGIN;
+
+		case '"':
+			return scanString(Token::STRING);
+
+		case 't':
+			return scanLiteral("true", 4, Token::TRUE);
+
+		case 'f':
+			return scanLiteral("false", 5, Token::FALSE);
+
+		case 'n':
+			return scanLiteral("null", 4, Token::NUL);
+
+		default:
+			return scanNumber();
+	}
+}
+
+static int hex4(const char *p)
+{
+	int v = 0;
+
+	for (int i = 0; i < 4; i++) {
+		char c = p[i];
+
+		v <<= 4;
+		if (c >= '0' && c <= '9')
+			v |= c - '0';
+		else if (c >= 'a' && c <= 'f')
+			v |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			v |= c - 'A' + 10;
+		else
+			return -1;
+	}
+
+	return v;
+}
+
+/* Returns the length of a valid UTF-8 sequence or zero. See utf8_check_full() in jansson's utf.c */
+static size_t utf8_check(const char *p, const char *end)
+{
+	unsigned char c = *p;
+	size_t n;
+	uint32_t cp;
+
+	if (c < 0x80)
+		return 1;
+	else if (c < 0xC2)
+		return 0;
+	else if (c < 0xE0) {
+		n = 2;
+		cp = c & 0x1F;
+	}
+	else if (c < 0xF0) {
+		n = 3;
+		cp = c & 0x0F;
+	}
+	else if (c < 0xF5) {
+		n = 4;
+		cp = c & 0x07;
+	}
+	else
+		return 0;
+
+	if ((size_t) (end - p) < n)
+		return 0;
+
+	for (size_t i = 1; i < n; i++) {
+		if ((p[i] & 0xC0) != 0x80)
+			return 0;
+
+		cp = (cp << 6) | (p[i] & 0x3F);
+	}
+
+	/* Overlong encodings, surrogates and code points beyond Unicode */
+	if ((n == 3 && cp < 0x800) || (cp >= 0xD800 && cp <= 0xDFFF) || (n == 4 && (cp < 0x10000 || cp > 0x10FFFF)))
+		return 0;
+
+	return n;
+}
+
+JsonScanner::Token JsonScanner::scanString(Token tok)
+{
+	token_begin = pos;
+
+	const char *s = ++pos;
+
+	/* Most strings do not contain escape sequences. We return those without a copy. */
+	while (pos < end && *pos != '"' && *pos != '\\' && (unsigned char) *pos >= 0x20) {
+		size_t n = utf8_check(pos, end);
+		if (!n)
+			return error();
+
+		pos += n;
+	}
+
+	if (pos >= end || (unsigned char) *pos < 0x20)
+		return error();
+
+	if (*pos == '"') {
+		str = std::string_view(s, pos++ - s);
+		return tok;
+	}
+
+	scratch.assign(s, pos - s);
+
+	while (pos < end) {
+		unsigned char c = *pos++;
+
+		if (c == '"') {
+			str = scratch;
+			return tok;
+		}
+
+		if (c < 0x20)
+			break;
+
+		if (c != '\\') {
+			size_t n = utf8_check(pos - 1, end);
+			if (!n)
+				break;
+
+			scratch.append(pos - 1, n);
+			pos += n - 1;
+			continue;
+		}
+
+		if (pos >= end)
+			break;
+
+		switch (*pos++) {
+			case '"':  scratch.push_back('"');  continue;
+			case '\\': scratch.push_back('\\'); continue;
+			case '/':  scratch.push_back('/');  continue;
+			case 'b':  scratch.push_back('\b'); continue;
+			case 'f':  scratch.push_back('\f'); continue;
+			case 'n':  scratch.push_back('\n'); continue;
+			case 'r':  scratch.push_back('\r'); continue;
+			case 't':  scratch.push_back('\t'); continue;
+			case 'u':  break;
+			default:   return error();
+		}
+
+		if (end - pos < 4)
+			break;
+
+		int32_t cp = hex4(pos);
+		pos += 4;
+
+		if (cp < 0)
+			break;
+
+		/* Surrogate pairs */
+		if (cp >= 0xD800 && cp <= 0xDBFF) {
+			if (end - pos < 6 || pos[0] != '\\' || pos[1] != 'u')
+				break;
+
+			int32_t lo = hex4(pos + 2);
+			pos += 6;
+
+			if (lo < 0xDC00 || lo > 0xDFFF)
+				break;
+
+			cp = ((cp - 0xD800) << 10) + (lo - 0xDC00) + 0x10000;
+		}
+		else if (cp >= 0xDC00 && cp <= 0xDFFF)
+			break;
+		else if (cp == 0) /* json_loadb() rejects NUL characters by default */
+			break;
+
+		if (cp < 0x80)
+			scratch.push_back(cp);
+		else if (cp < 0x800) {
+			scratch.push_back(0xC0 | (cp >> 6));
+			scratch.push_back(0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000) {
+			scratch.push_back(0xE0 | (cp >> 12));
+			scratch.push_back(0x80 | ((cp >> 6) & 0x3F));
+			scratch.push_back(0x80 | (cp & 0x3F));
+		}
+		else {
+			scratch.push_back(0xF0 | (cp >> 18));
+			scratch.push_back(0x80 | ((cp >> 12) & 0x3F));
+			scratch.push_back(0x80 | ((cp >> 6) & 0x3F));
+			scratch.push_back(0x80 | (cp & 0x3F));
+		}
+	}
+
+	return error();
+}
+
+JsonScanner::Token JsonScanner::scanNumber()
+{
+	const char *s = pos;
+	bool is_real = false;
+
+	if (pos < end && *pos == '-')
+		pos++;
+
+	if (pos < end && *pos == '0')
+		pos++;
+	else if (pos < end && isdigit(*pos)) {
+		while (pos < end && isdigit(*pos))
+			pos++;
+	}
+	else
+		return error();
+
+	if (pos < end && *pos == '.') {
+		pos++;
+		if (pos >= end || !isdigit(*pos))
+			return error();
+
+		while (pos < end && isdigit(*pos))
+			pos++;
+
+		is_real = true;
+	}
+
+	if (pos < end && (*pos == 'e' || *pos == 'E')) {
+		pos++;
+		if (pos < end && (*pos == '+' || *pos == '-'))
+			pos++;
+
+		if (pos >= end || !isdigit(*pos))
+			return error();
+
+		while (pos < end && isdigit(*pos))
+			pos++;
+
+		is_real = true;
+	}
+
+	/* The buffer is not necessarily null-terminated */
+	char tmp[64];
+	std::string big;
+	const char *num_str;
+	size_t n = pos - s;
+
+	if (n < sizeof(tmp)) {
+		memcpy(tmp, s, n);
+		tmp[n] = '\0';
+		num_str = tmp;
+	}
+	else {
+		big.assign(s, n);
+		num_str = big.c_str();
+	}
+
+	errno = 0;
+
+	if (is_real) {
+		num.f = strtod(num_str, nullptr);
+		if (errno == ERANGE && std::isinf(num.f))
+			return error();
+
+		return Token::REAL;
+	}
+	else {
+		num.i = strtoll(num_str, nullptr, 10);
+		if (errno == ERANGE)
+			return error();
+
+		return Token::INTEGER;
+	}
+}
+
+JsonScanner::Token JsonScanner::scanLiteral(const char *lit, size_t n, Token tok)
+{
+	if ((size_t) (end - pos) < n || memcmp(pos, lit, n))
+		return error();
+
+	pos += n;
+
+	return tok;
+}
+
+bool JsonScanner::skip(Token tok)
+{
+	switch (tok) {
+		case Token::ERROR:
+			return false;
+
+		case Token::KEY:
+			return skip(next());
+
+		case Token::OBJECT_BEGIN:
+		case Token::ARRAY_BEGIN:
+			return skipTo(depth_ - 1);
+
+		default:
+			return true;
+	}
+}
+
+bool JsonScanner::skipTo(unsigned d)
+{
+	while (depth_ > d) {
+		if (next() == Token::ERROR)
+			return false;
+	}
+
+	return !failed;
+}
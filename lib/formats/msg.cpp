@@ -24,6 +24,7 @@
 
 #include <villas/formats/msg.hpp>
 #include <villas/formats/msg_format.hpp>
+#include <villas/formats/raw_convert.hpp>
 #include <villas/sample.h>
 #include <villas/signal.h>
 #include <villas/utils.hpp>
@@ -33,14 +34,16 @@ void msg_ntoh(struct msg *m)
 {
 	msg_hdr_ntoh(m);
 
-	for (int i = 0; i < m->length; i++)
-		m->data[i].i = ntohl(m->data[i].i);
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+	raw_bswap32(m->data, m->data, m->length);
+#endif
 }
 
 void msg_hton(struct msg *m)
 {
-	for (int i = 0; i < m->length; i++)
-		m->data[i].i = htonl(m->data[i].i);
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+	raw_bswap32(m->data, m->data, m->length);
+#endif
 
 	msg_hdr_hton(m);
 }
@@ -83,18 +86,29 @@ int msg_to_sample(const struct msg *msg, struct sample *smp, const struct vlist
 		return ret;
 
 	unsigned len = MIN(msg->length, smp->capacity);
-	for (i = 0; i < MIN(len, vlist_length(sigs)); i++) {
+	len = MIN(len, vlist_length(sigs));
+
+	/* Consecutive values of the same type are converted at once */
+	unsigned n;
+	for (i = 0; i < len; i += n) {
 		struct signal *sig = (struct signal *) vlist_at_safe(sigs, i);
 		if (!sig)
 			return -1;
 
+		for (n = 1; i + n < len; n++) {
+			struct signal *next = (struct signal *) vlist_at_safe(sigs, i + n);
+			if (!next || next->type != sig->type)
+				break;
+		}
+
 		switch (sig->type) {
 			case SignalType::FLOAT:
-				smp->data[i].f = msg->data[i].f;
+				raw_unpack_f32(&smp->data[i], &msg->data[i], n, false);
 				break;
 
 			case SignalType::INTEGER:
-				smp->data[i].i = msg->data[i].i;
+				for (unsigned k = i; k < i + n; k++)
+					smp->data[k].i = msg->data[k].i;
 				break;
 
 			default:
@@ -121,18 +135,26 @@ int msg_from_sample(struct msg *msg_in, const struct sample *smp, const struct v
 	msg_in->ts.sec  = smp->ts.origin.tv_sec;
 	msg_in->ts.nsec = smp->ts.origin.tv_nsec;
 
-	for (unsigned i = 0; i < smp->length; i++) {
+	/* Consecutive values of the same type are converted at once */
+	unsigned n;
+	for (unsigned i = 0; i < smp->length; i += n) {
 		struct signal *sig = (struct signal *) vlist_at_safe(sigs, i);
 		if (!sig)
 			return -1;
 
+		for (n = 1; i + n < smp->length; n++) {
+			struct signal *next = (struct signal *) vlist_at_safe(sigs, i + n);
+			if (!next || next->type != sig->type)
+				break;
+		}
+
 		switch (sig->type) {
 			case SignalType::FLOAT:
-				msg_in->data[i].f = smp->data[i].f;
+				raw_pack_f32(&msg_in->data[i], &smp->data[i], n, false);
 				break;
 
 			case SignalType::INTEGER:
-				msg_in->data[i].i = smp->data[i].i;
+				raw_pack_i32(&msg_in->data[i], &smp->data[i], n, false);
 				break;
 
 			default:
@@ -49,25 +49,115 @@ enum SignalType ProtobufFormat::detect(const Villas__Node__Value *val)
 	}
 }
 
+ProtobufFormat::ProtobufFormat(int fl) :
+	BinaryFormat(fl),
+	arena_used(0),
+	arena_missed(0)
+{
+	villas__node__message__init(&pb_msg);
+
+	allocator.alloc = arenaAlloc;
+	allocator.free = arenaFree;
+	allocator.allocator_data = this;
+}
+
+ProtobufFormat::~ProtobufFormat()
+{
+	for (void *ptr : arena_overflow)
+		free(ptr);
+}
+
+void ProtobufFormat::start()
+{
+	unsigned values = signals ? vlist_length(signals) : 0;
+
+	reserve(1, values);
+
+	/* Room for unpacking a message with a single sample */
+	size_t sz = ALIGN(sizeof(Villas__Node__Message), sizeof(std::max_align_t))
+		  + ALIGN(sizeof(Villas__Node__Sample *), sizeof(std::max_align_t))
+		  + ALIGN(sizeof(Villas__Node__Sample), sizeof(std::max_align_t))
+		  + ALIGN(sizeof(Villas__Node__Timestamp), sizeof(std::max_align_t))
+		  + ALIGN(values * sizeof(Villas__Node__Value *), sizeof(std::max_align_t))
+		  + values * ALIGN(sizeof(Villas__Node__Value), sizeof(std::max_align_t));
+
+	if (arena.size() * sizeof(std::max_align_t) < sz)
+		arena.resize(CEIL(sz, sizeof(std::max_align_t)));
+}
+
+void ProtobufFormat::reserve(unsigned cnt, unsigned values)
+{
+	if (pb_samples.size() < cnt) {
+		pb_samples.resize(cnt);
+		pb_sample_ptrs.resize(cnt);
+		pb_timestamps.resize(cnt);
+	}
+
+	if (pb_values.size() < values) {
+		pb_values.resize(values);
+		pb_value_ptrs.resize(values);
+		pb_complex.resize(values);
+	}
+}
+
+void * ProtobufFormat::arenaAlloc(void *ctx, size_t size)
+{
+	auto *f = (ProtobufFormat *) ctx;
+
+	size = ALIGN(size, sizeof(std::max_align_t));
+
+	if (f->arena_used + size <= f->arena.size() * sizeof(std::max_align_t)) {
+		void *ptr = (char *) f->arena.data() + f->arena_used;
+
+		f->arena_used += size;
+
+		return ptr;
+	}
+
+	/* The arena is enlarged by arenaReset() */
+	void *ptr = malloc(size);
+	if (ptr) {
+		f->arena_overflow.push_back(ptr);
+		f->arena_missed += size;
+	}
+
+	return ptr;
+}
+
+void ProtobufFormat::arenaFree(void *ctx, void *ptr)
+{
+	/* Memory is released as a whole by arenaReset() */
+}
+
+void ProtobufFormat::arenaReset()
+{
+	if (!arena_overflow.empty()) {
+		for (void *ptr : arena_overflow)
+			free(ptr);
+
+		arena_overflow.clear();
+
+		arena.resize(CEIL(arena_used + arena_missed, sizeof(std::max_align_t)));
+	}
+
+	arena_used = 0;
+	arena_missed = 0;
+}
+
 int ProtobufFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct sample * const smps[], unsigned cnt)
 {
-	unsigned psz;
+	unsigned psz, values = 0;
 
-	auto *pb_msg = new Villas__Node__Message;
-	if (!pb_msg)
-		throw MemoryAllocationError();
+	for (unsigned i = 0; i < cnt; i++)
+		values += smps[i]->length;
 
-	villas__node__message__init(pb_msg);
+	reserve(cnt, values);
 
-	pb_msg->n_samples = cnt;
-	pb_msg->samples = new Villas__Node__Sample*[pb_msg->n_samples];
-	if (!pb_msg->samples)
-		throw MemoryAllocationError();
+	pb_msg.n_samples = cnt;
+	pb_msg.samples = pb_sample_ptrs.data();
 
-	for (unsigned i = 0; i < pb_msg->n_samples; i++) {
-		Villas__Node__Sample *pb_smp = pb_msg->samples[i] = new Villas__Node__Sample;
-		if (!pb_msg->samples[i])
-			throw MemoryAllocationError();
+	for (unsigned i = 0, k = 0; i < pb_msg.n_samples; i++) {
+		Villas__Node__Sample *pb_smp = pb_msg.samples[i] = &pb_samples[i];
 
 		villas__node__sample__init(pb_smp);
 
@@ -81,9 +171,7 @@ int ProtobufFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct s
 		}
 
 		if (flags & smp->flags & (int) SampleFlags::HAS_TS_ORIGIN) {
-			pb_smp->timestamp = new Villas__Node__Timestamp;
-			if (!pb_smp->timestamp)
-				throw MemoryAllocationError();
+			pb_smp->timestamp = &pb_timestamps[i];
 
 			villas__node__timestamp__init(pb_smp->timestamp);
 
@@ -92,14 +180,10 @@ int ProtobufFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct s
 		}
 
 		pb_smp->n_values = smp->length;
-		pb_smp->values = new Villas__Node__Value*[pb_smp->n_values];
-		if (!pb_smp->values)
-			throw MemoryAllocationError();
+		pb_smp->values = &pb_value_ptrs[k];
 
-		for (unsigned j = 0; j < pb_smp->n_values; j++) {
-			Villas__Node__Value *pb_val = pb_smp->values[j] = new Villas__Node__Value;
-			if (!pb_val)
-				throw MemoryAllocationError();
+		for (unsigned j = 0; j < pb_smp->n_values; j++, k++) {
+			Villas__Node__Value *pb_val = pb_smp->values[j] = &pb_values[k];
 
 			villas__node__value__init(pb_val);
 
@@ -122,9 +206,7 @@ int ProtobufFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct s
 
 				case SignalType::COMPLEX:
 					pb_val->value_case = VILLAS__NODE__VALUE__VALUE_Z;
-					pb_val->z = new Villas__Node__Complex;
-					if (!pb_val->z)
-						throw MemoryAllocationError();
+					pb_val->z = &pb_complex[k];
 
 					villas__node__complex__init(pb_val->z);
 
@@ -139,22 +221,16 @@ int ProtobufFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct s
 		}
 	}
 
-	psz = villas__node__message__get_packed_size(pb_msg);
+	psz = villas__node__message__get_packed_size(&pb_msg);
 
 	if (psz > len)
-		goto out;
+		return -1;
 
-	villas__node__message__pack(pb_msg, (uint8_t *) buf);
-	villas__node__message__free_unpacked(pb_msg, nullptr);
+	villas__node__message__pack(&pb_msg, (uint8_t *) buf);
 
 	*wbytes = psz;
 
 	return cnt;
-
-out:
-	villas__node__message__free_unpacked(pb_msg, nullptr);
-
-	return -1;
 }
 
 int ProtobufFormat::sscan(const char *buf, size_t len, size_t *rbytes, struct sample * const smps[], unsigned cnt)
@@ -162,10 +238,12 @@ int ProtobufFormat::sscan(const char *buf, size_t len, size_t *rbytes, struct sa
 	unsigned i, j;
 	Villas__Node__Message *pb_msg;
 
-	pb_msg = villas__node__message__unpack(nullptr, len, (uint8_t *) buf);
+	/* The previous message is not referenced anymore */
+	arenaReset();
+
+	pb_msg = villas__node__message__unpack(&allocator, len, (uint8_t *) buf);
 	if (!pb_msg)
 		return -1;
-
 	for (i = 0; i < MIN(pb_msg->n_samples, cnt); i++) {
 		struct sample *smp = smps[i];
 		Villas__Node__Sample *pb_smp = pb_msg->samples[i];
@@ -227,10 +305,9 @@ int ProtobufFormat::sscan(const char *buf, size_t len, size_t *rbytes, struct sa
 		smp->length = j;
 	}
 
+	/* A protobuf message always spans the whole buffer */
 	if (rbytes)
-		*rbytes = villas__node__message__get_packed_size(pb_msg);
-
-	villas__node__message__free_unpacked(pb_msg, nullptr);
+		*rbytes = len;
 
 	return i;
 }
@@ -23,6 +23,7 @@
 #include <villas/sample.h>
 #include <villas/utils.hpp>
 #include <villas/formats/raw.hpp>
+#include <villas/formats/raw_convert.hpp>
 #include <villas/compat.hpp>
 #include <villas/exceptions.hpp>
 
@@ -53,6 +54,238 @@ using namespace villas::node;
 /** Convert integer of varying width to big/little endian byte order */
 #define SWAP_INT_HTOX(o, b, n) (o ? htobe ## b (n) : htole ## b (n))
 
+/** Encode \p cnt values of the same type.
+ *
+ * @return The number of raw values which have been written.
+ */
+static size_t raw_encode(void *vbuf, const union signal_data *data, size_t cnt, enum SignalType fmt, int bits, bool big)
+{
+	int8_t     *i8  =  (int8_t *) vbuf;
+	int16_t    *i16 =  (int16_t *) vbuf;
+	int32_t    *i32 =  (int32_t *) vbuf;
+	int64_t    *i64 =  (int64_t *) vbuf;
+	double     *f64 =  (double *) vbuf;
+
+	/* Bulk conversions only need to know if bytes must be swapped */
+	bool swap = big != (__BYTE_ORDER == __BIG_ENDIAN);
+
+	switch (fmt) {
+		case SignalType::FLOAT:
+			switch (bits) {
+				case 8:
+				case 16:
+					memset(vbuf, 0xff, cnt * (bits / 8)); /* Not supported */
+					return cnt;
+
+				case 32:
+					raw_pack_f32(vbuf, data, cnt, swap);
+					return cnt;
+
+				case 64:
+					if (swap)
+						raw_bswap64(vbuf, data, cnt);
+					else
+						memcpy(vbuf, data, cnt * sizeof(double));
+					return cnt;
+			}
+			break;
+
+		case SignalType::INTEGER:
+			switch (bits) {
+				case 8:
+					for (size_t k = 0; k < cnt; k++)
+						i8[k] = data[k].i;
+					return cnt;
+
+				case 16:
+					for (size_t k = 0; k < cnt; k++)
+						i16[k] = SWAP_INT_HTOX(big, 16, data[k].i);
+					return cnt;
+
+				case 32:
+					raw_pack_i32(vbuf, data, cnt, swap);
+					return cnt;
+
+				case 64:
+					if (swap)
+						raw_bswap64(vbuf, data, cnt);
+					else
+						memcpy(vbuf, data, cnt * sizeof(int64_t));
+					return cnt;
+			}
+			break;
+
+		case SignalType::BOOLEAN:
+			switch (bits) {
+				case 8:
+					for (size_t k = 0; k < cnt; k++)
+						i8[k] = data[k].b ? 1 : 0;
+					return cnt;
+
+				case 16:
+					for (size_t k = 0; k < cnt; k++)
+						i16[k] = SWAP_INT_HTOX(big, 16, data[k].b ? 1 : 0);
+					return cnt;
+
+				case 32:
+					for (size_t k = 0; k < cnt; k++)
+						i32[k] = SWAP_INT_HTOX(big, 32, data[k].b ? 1 : 0);
+					return cnt;
+
+				case 64:
+					for (size_t k = 0; k < cnt; k++)
+						i64[k] = SWAP_INT_HTOX(big, 64, data[k].b ? 1 : 0);
+					return cnt;
+			}
+			break;
+
+		case SignalType::COMPLEX:
+			switch (bits) {
+				case 8:
+				case 16:
+					memset(vbuf, 0xff, 2 * cnt * (bits / 8)); /* Not supported */
+					return 2 * cnt;
+
+				case 32:
+					/* std::complex<float> consists of the real and imaginary part in this order */
+					if (swap)
+						raw_bswap32(vbuf, data, 2 * cnt);
+					else
+						memcpy(vbuf, data, 2 * cnt * sizeof(float));
+					return 2 * cnt;
+
+				case 64:
+					for (size_t k = 0; k < cnt; k++) {
+						f64[2 * k]     = SWAP_FLOAT_HTOX(big, 64, std::real(data[k].z));
+						f64[2 * k + 1] = SWAP_FLOAT_HTOX(big, 64, std::imag(data[k].z));
+					}
+					return 2 * cnt;
+			}
+			break;
+
+		case SignalType::INVALID:
+			break;
+	}
+
+	return 0;
+}
+
+/** Decode \p cnt values of the same type.
+ *
+ * @return The number of raw values which have been read.
+ */
+static size_t raw_decode(union signal_data *data, const void *vbuf, size_t cnt, enum SignalType fmt, int bits, bool big)
+{
+	const int8_t  *i8  = (const int8_t *) vbuf;
+	const int16_t *i16 = (const int16_t *) vbuf;
+	const int32_t *i32 = (const int32_t *) vbuf;
+	const int64_t *i64 = (const int64_t *) vbuf;
+	const double  *f64 = (const double *) vbuf;
+
+	bool swap = big != (__BYTE_ORDER == __BIG_ENDIAN);
+
+	switch (fmt) {
+		case SignalType::FLOAT:
+			switch (bits) {
+				case 8:
+				case 16:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].f = -1; /* Not supported */
+					return cnt;
+
+				case 32:
+					raw_unpack_f32(data, vbuf, cnt, swap);
+					return cnt;
+
+				case 64:
+					if (swap)
+						raw_bswap64(data, vbuf, cnt);
+					else
+						memcpy(data, vbuf, cnt * sizeof(double));
+					return cnt;
+			}
+			break;
+
+		case SignalType::INTEGER:
+			switch (bits) {
+				case 8:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].i = (int8_t) i8[k];
+					return cnt;
+
+				case 16:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].i = (int16_t) SWAP_INT_XTOH(big, 16, i16[k]);
+					return cnt;
+
+				case 32:
+					raw_unpack_i32(data, vbuf, cnt, swap);
+					return cnt;
+
+				case 64:
+					if (swap)
+						raw_bswap64(data, vbuf, cnt);
+					else
+						memcpy(data, vbuf, cnt * sizeof(int64_t));
+					return cnt;
+			}
+			break;
+
+		case SignalType::BOOLEAN:
+			switch (bits) {
+				case 8:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].b = (bool) i8[k];
+					return cnt;
+
+				case 16:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].b = (bool) SWAP_INT_XTOH(big, 16, i16[k]);
+					return cnt;
+
+				case 32:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].b = (bool) SWAP_INT_XTOH(big, 32, i32[k]);
+					return cnt;
+
+				case 64:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].b = (bool) SWAP_INT_XTOH(big, 64, i64[k]);
+					return cnt;
+			}
+			break;
+
+		case SignalType::COMPLEX:
+			switch (bits) {
+				case 8:
+				case 16:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].z = std::complex<float>(-1, -1); /* Not supported */
+					return 2 * cnt;
+
+				case 32:
+					if (swap)
+						raw_bswap32(data, vbuf, 2 * cnt);
+					else
+						memcpy(data, vbuf, 2 * cnt * sizeof(float));
+					return 2 * cnt;
+
+				case 64:
+					for (size_t k = 0; k < cnt; k++)
+						data[k].z = std::complex<float>(
+							SWAP_FLOAT_XTOH(big, 64, f64[2 * k]),
+							SWAP_FLOAT_XTOH(big, 64, f64[2 * k + 1]));
+					return 2 * cnt;
+			}
+			break;
+
+		case SignalType::INVALID:
+			break;
+	}
+
+	return 0;
+}
+
 int RawFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct sample * const smps[], unsigned cnt)
 {
 	int o = 0;
@@ -64,13 +297,13 @@ int RawFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct sample
 	int16_t    *i16 =  (int16_t *) vbuf;
 	int32_t    *i32 =  (int32_t *) vbuf;
 	int64_t    *i64 =  (int64_t *) vbuf;
-	float      *f32 =  (float *) vbuf;
-	double     *f64 =  (double *) vbuf;
 #ifdef HAS_128BIT
 	__int128   *i128 = (__int128 *) vbuf;
-	__float128 *f128 = (__float128 *) vbuf;
 #endif
 
+	/* Highest number of raw values for which o * (bits / 8) < len holds */
+	size_t max = len > 0 ? (len - 1) / (bits / 8) : 0;
+
 	for (unsigned i = 0; i < cnt; i++) {
 		const struct sample *smp = smps[i];
 
@@ -119,125 +352,28 @@ int RawFormat::sprint(char *buf, size_t len, size_t *wbytes, const struct sample
 			}
 		}
 
-		for (unsigned j = 0; j < smp->length; j++) {
+		/* Consecutive values of the same type are converted at once */
+		for (unsigned j = 0, n; j < smp->length; j += n) {
 			enum SignalType fmt = sample_format(smp, j);
-			const union signal_data *data = &smp->data[j];
-
-			/* Check length */
-			nlen = (o + (fmt == SignalType::COMPLEX ? 2 : 1)) * (bits / 8);
-			if (nlen >= len)
-				goto out;
-
-			switch (fmt) {
-				case SignalType::FLOAT:
-					switch (bits) {
-						case 8:
-							i8 [o++] = -1;
-							break; /* Not supported */
-
-						case 16:
-							i16[o++] = -1;
-							break; /* Not supported */
-
-						case 32:
-							f32[o++] = SWAP_FLOAT_HTOX(endianess == Endianess::BIG,  32, (float) data->f);
-							break;
-
-						case 64:
-							f64[o++] = SWAP_FLOAT_HTOX(endianess == Endianess::BIG,  64, data->f);
-							break;
-
-#ifdef HAS_128BIT
-						case 128: f128[o++] = SWAP_FLOAT_HTOX(endianess == Endianess::BIG, 128, data->f); break;
-#endif
-					}
-					break;
-
-				case SignalType::INTEGER:
-					switch (bits) {
-						case 8:
-							i8 [o++] = data->i;
-							break;
-
-						case 16:
-							i16[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 16,  data->i);
-							break;
-
-						case 32:
-							i32[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 32,  data->i);
-							break;
-
-						case 64:
-							i64[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 64,  data->i);
-							break;
 
-#ifdef HAS_128BIT
-						case 128:
-							i128[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 128, data->i);
-							break;
-#endif
-					}
+			for (n = 1; j + n < smp->length; n++) {
+				if (sample_format(smp, j + n) != fmt)
 					break;
+			}
 
-				case SignalType::BOOLEAN:
-					switch (bits) {
-						case 8:
-							i8 [o++] = data->b ? 1 : 0;
-							break;
-
-						case 16:
-							i16[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 16,  data->b ? 1 : 0);
-							break;
-
-						case 32:
-							i32[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 32,  data->b ? 1 : 0);
-							break;
-
-						case 64:
-							i64[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 64,  data->b ? 1 : 0);
-							break;
+			/* Check length */
+			size_t width = fmt == SignalType::COMPLEX ? 2 : 1;
+			size_t fit = max > (size_t) o ? (max - o) / width : 0;
+			if (fit == 0)
+				goto out;
 
-#ifdef HAS_128BIT
-						case 128:
-							i128[o++] = SWAP_INT_HTOX(endianess == Endianess::BIG, 128, data->b ? 1 : 0);
-							break;
-#endif
-					}
-					break;
+			if (fmt == SignalType::INVALID)
+				return -1;
 
-				case SignalType::COMPLEX:
-					switch (bits) {
-						case  8:
-							i8 [o++]  = -1; /* Not supported */
-							i8 [o++]  = -1;
-							break;
-
-						case 16:
-							i16[o++]  = -1; /* Not supported */
-							i16[o++]  = -1;
-							break;
-
-						case 32:
-							f32[o++]  = SWAP_FLOAT_HTOX(endianess == Endianess::BIG,  32, (float) std::real(data->z));
-							f32[o++]  = SWAP_FLOAT_HTOX(endianess == Endianess::BIG,  32, (float) std::imag(data->z));
-							break;
-
-						case 64:
-							f64[o++]  = SWAP_FLOAT_HTOX(endianess == Endianess::BIG,  64, std::real(data->z));
-							f64[o++]  = SWAP_FLOAT_HTOX(endianess == Endianess::BIG,  64, std::imag(data->z));
-							break;
-#ifdef HAS_128BIT
-						case 128:
-							f128[o++] = SWAP_FLOAT_HTOX(endianess == Endianess::BIG, 128, std::real(data->z));
-							f128[o++] = SWAP_FLOAT_HTOX(endianess == Endianess::BIG, 128, std::imag(data->z));
-							break;
-#endif
-					}
-					break;
+			o += raw_encode(buf + o * (bits / 8), &smp->data[j], MIN(n, fit), fmt, bits, endianess == Endianess::BIG);
 
-				case SignalType::INVALID:
-					return -1;
-			}
+			if (fit < n)
+				goto out;
 		}
 	}
 
@@ -255,11 +391,8 @@ int RawFormat::sscan(const char *buf, size_t len, size_t *rbytes, struct sample
 	int16_t    *i16 =  (int16_t *) vbuf;
 	int32_t    *i32 =  (int32_t *) vbuf;
 	int64_t    *i64 =  (int64_t *) vbuf;
-	float      *f32 =  (float *) vbuf;
-	double     *f64 =  (double *) vbuf;
 #ifdef HAS_128BIT
 	__int128   *i128 = (__int128 *) vbuf;
-	__float128 *f128 = (__float128 *) vbuf;
 #endif
 
 	/* The raw format can not encode multiple samples in one buffer
@@ -324,77 +457,25 @@ int RawFormat::sscan(const char *buf, size_t len, size_t *rbytes, struct sample
 
 	smp->signals = signals;
 
-	unsigned i;
-	for (i = 0; i < smp->capacity && o < nlen; i++) {
+	/* Consecutive values of the same type are converted at once */
+	unsigned i, n;
+	for (i = 0; i < smp->capacity && o < nlen; i += n) {
 		enum SignalType fmt = sample_format(smp, i);
-		union signal_data *data = &smp->data[i];
+		if (fmt == SignalType::INVALID)
+			return -1; /* Unsupported format in RAW payload */
 
-		switch (fmt) {
-			case SignalType::FLOAT:
-				switch (bits) {
-					case 8:   data->f = -1; o++; break; /* Not supported */
-					case 16:  data->f = -1; o++; break; /* Not supported */
-
-					case 32:  data->f = SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 32, f32[o++]); break;
-					case 64:  data->f = SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 64, f64[o++]); break;
-#ifdef HAS_128BIT
-					case 128: data->f = SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 128, f128[o++]); break;
-#endif
-				}
-				break;
-
-			case SignalType::INTEGER:
-				switch (bits) {
-					case 8:   data->i = (int8_t)                                                    i8[o++];  break;
-					case 16:  data->i = (int16_t)  SWAP_INT_XTOH(endianess == Endianess::BIG,  16,  i16[o++]); break;
-					case 32:  data->i = (int32_t)  SWAP_INT_XTOH(endianess == Endianess::BIG,  32,  i32[o++]); break;
-					case 64:  data->i = (int64_t)  SWAP_INT_XTOH(endianess == Endianess::BIG,  64,  i64[o++]); break;
-#ifdef HAS_128BIT
-					case 128: data->i = (__int128) SWAP_INT_XTOH(endianess == Endianess::BIG, 128, i128[o++]); break;
-#endif
-				}
+		for (n = 1; i + n < smp->capacity; n++) {
+			if (sample_format(smp, i + n) != fmt)
 				break;
+		}
 
-			case SignalType::BOOLEAN:
-				switch (bits) {
-					case 8:   data->b = (bool)                                                  i8[o++];  break;
-					case 16:  data->b = (bool) SWAP_INT_XTOH(endianess == Endianess::BIG,  16,  i16[o++]); break;
-					case 32:  data->b = (bool) SWAP_INT_XTOH(endianess == Endianess::BIG,  32,  i32[o++]); break;
-					case 64:  data->b = (bool) SWAP_INT_XTOH(endianess == Endianess::BIG,  64,  i64[o++]); break;
-#ifdef HAS_128BIT
-					case 128: data->b = (bool) SWAP_INT_XTOH(endianess == Endianess::BIG, 128, i128[o++]); break;
-#endif
-				}
-				break;
-
-			case SignalType::COMPLEX:
-				switch (bits) {
-					case 8:  data->z = std::complex<float>(-1, -1); o += 2; break; /* Not supported */
-					case 16: data->z = std::complex<float>(-1, -1); o += 2; break; /* Not supported */
-
-					case 32: data->z = std::complex<float>(
-								SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 32, f32[o++]),
-								SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 32, f32[o++]));
-
-						break;
-
-					case 64: data->z = std::complex<float>(
-								SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 64, f64[o++]),
-								SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 64, f64[o++]));
-						break;
-
-#if HAS_128BIT
-					case 128: data->z = std::complex<float>(
-								SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 128, f128[o++]),
-								SWAP_FLOAT_XTOH(endianess == Endianess::BIG, 128, f128[o++]));
-						break;
-#endif
-				}
-				break;
+		/* Only complete values are decoded */
+		unsigned width = fmt == SignalType::COMPLEX ? 2 : 1;
+		n = MIN(n, (nlen - o) / width);
+		if (n == 0)
+			break;
 
-			case SignalType::INVALID:
-				return -1; /* Unsupported format in RAW payload */
-		}
+		o += raw_decode(&smp->data[i], buf + o * (bits / 8), n, fmt, bits, endianess == Endianess::BIG);
 	}
 
 	smp->length = i;
@@ -0,0 +1,467 @@
+/** Bulk conversion kernels for binary formats.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+
+#include <villas/signal_type.h>
+#include <villas/signal_data.h>
+#include <villas/formats/raw_convert.hpp>
+
+/* The SIMD kernels are compiled for their instruction set only.
+ * Hence, they can be used by builds for a generic x86-64 target. */
+#if defined(__x86_64__) && defined(__GNUC__)
+  #define RAW_CONVERT_X86
+  #include <immintrin.h>
+#endif
+
+struct raw_kernels {
+	enum RawConvertIsa isa;
+
+	void (*bswap16)(void *dst, const void *src, size_t cnt);
+	void (*bswap32)(void *dst, const void *src, size_t cnt);
+	void (*bswap64)(void *dst, const void *src, size_t cnt);
+
+	void (*pack_f32)(void *dst, const union signal_data *src, size_t cnt, bool swap);
+	void (*unpack_f32)(union signal_data *dst, const void *src, size_t cnt, bool swap);
+	void (*pack_i32)(void *dst, const union signal_data *src, size_t cnt, bool swap);
+	void (*unpack_i32)(union signal_data *dst, const void *src, size_t cnt, bool swap);
+};
+
+static inline uint16_t bswap(uint16_t x)
+{ return __builtin_bswap16(x); }
+
+static inline uint32_t bswap(uint32_t x)
+{ return __builtin_bswap32(x); }
+
+static inline uint64_t bswap(uint64_t x)
+{ return __builtin_bswap64(x); }
+
+template<typename T>
+static void bswap_scalar(void *dst, const void *src, size_t cnt)
+{
+	auto *d = (char *) dst;
+	auto *s = (const char *) src;
+
+	for (size_t i = 0; i < cnt; i++) {
+		T x;
+
+		memcpy(&x, s + i * sizeof(T), sizeof(T));
+		x = bswap(x);
+		memcpy(d + i * sizeof(T), &x, sizeof(T));
+	}
+}
+
+static void pack_f32_scalar(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	auto *d = (char *) dst;
+
+	for (size_t i = 0; i < cnt; i++) {
+		float f = src[i].f;
+		uint32_t x;
+
+		memcpy(&x, &f, sizeof(x));
+		if (swap)
+			x = bswap(x);
+		memcpy(d + i * 4, &x, sizeof(x));
+	}
+}
+
+static void unpack_f32_scalar(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	auto *s = (const char *) src;
+
+	for (size_t i = 0; i < cnt; i++) {
+		float f;
+		uint32_t x;
+
+		memcpy(&x, s + i * 4, sizeof(x));
+		if (swap)
+			x = bswap(x);
+		memcpy(&f, &x, sizeof(f));
+
+		dst[i].f = f;
+	}
+}
+
+static void pack_i32_scalar(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	auto *d = (char *) dst;
+
+	for (size_t i = 0; i < cnt; i++) {
+		uint32_t x = src[i].i;
+
+		if (swap)
+			x = bswap(x);
+		memcpy(d + i * 4, &x, sizeof(x));
+	}
+}
+
+static void unpack_i32_scalar(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	auto *s = (const char *) src;
+
+	for (size_t i = 0; i < cnt; i++) {
+		uint32_t x;
+
+		memcpy(&x, s + i * 4, sizeof(x));
+		if (swap)
+			x = bswap(x);
+
+		dst[i].i = (int32_t) x;
+	}
+}
+
+static const struct raw_kernels kernels_scalar = {
+	.isa = RawConvertIsa::SCALAR,
+	.bswap16 = bswap_scalar<uint16_t>,
+	.bswap32 = bswap_scalar<uint32_t>,
+	.bswap64 = bswap_scalar<uint64_t>,
+	.pack_f32 = pack_f32_scalar,
+	.unpack_f32 = unpack_f32_scalar,
+	.pack_i32 = pack_i32_scalar,
+	.unpack_i32 = unpack_i32_scalar
+};
+
+#ifdef RAW_CONVERT_X86
+/** A shuffle mask for _mm_shuffle_epi8() which reverses the bytes of each element of type T. */
+template<typename T>
+static inline __m128i bswap_mask(bool swap = true)
+{
+	if (!swap)
+		return _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	else if (sizeof(T) == 2)
+		return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	else if (sizeof(T) == 4)
+		return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	else
+		return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+}
+
+/* SSE4.1 kernels process 16 bytes of 32-bit values per iteration */
+
+template<typename T>
+__attribute__((target("sse4.1")))
+static void bswap_sse41(void *dst, const void *src, size_t cnt)
+{
+	const size_t n = 16 / sizeof(T);
+	const __m128i mask = bswap_mask<T>();
+
+	auto *d = (char *) dst;
+	auto *s = (const char *) src;
+
+	size_t i = 0;
+	for (; i + n <= cnt; i += n) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (s + i * sizeof(T)));
+		_mm_storeu_si128((__m128i *) (d + i * sizeof(T)), _mm_shuffle_epi8(v, mask));
+	}
+
+	bswap_scalar<T>(d + i * sizeof(T), s + i * sizeof(T), cnt - i);
+}
+
+__attribute__((target("sse4.1")))
+static void pack_f32_sse41(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	const __m128i mask = bswap_mask<uint32_t>(swap);
+
+	auto *d = (char *) dst;
+
+	size_t i = 0;
+	for (; i + 4 <= cnt; i += 4) {
+		__m128 lo = _mm_cvtpd_ps(_mm_loadu_pd((const double *) &src[i]));
+		__m128 hi = _mm_cvtpd_ps(_mm_loadu_pd((const double *) &src[i + 2]));
+		__m128i v = _mm_castps_si128(_mm_movelh_ps(lo, hi));
+
+		_mm_storeu_si128((__m128i *) (d + i * 4), _mm_shuffle_epi8(v, mask));
+	}
+
+	pack_f32_scalar(d + i * 4, src + i, cnt - i, swap);
+}
+
+__attribute__((target("sse4.1")))
+static void unpack_f32_sse41(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	const __m128i mask = bswap_mask<uint32_t>(swap);
+
+	auto *s = (const char *) src;
+
+	size_t i = 0;
+	for (; i + 4 <= cnt; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (s + i * 4));
+		__m128 f = _mm_castsi128_ps(_mm_shuffle_epi8(v, mask));
+
+		_mm_storeu_pd((double *) &dst[i], _mm_cvtps_pd(f));
+		_mm_storeu_pd((double *) &dst[i + 2], _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+	}
+
+	unpack_f32_scalar(dst + i, s + i * 4, cnt - i, swap);
+}
+
+__attribute__((target("sse4.1")))
+static void pack_i32_sse41(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	const __m128i mask = bswap_mask<uint32_t>(swap);
+
+	auto *d = (char *) dst;
+
+	size_t i = 0;
+	for (; i + 4 <= cnt; i += 4) {
+		/* Gather the lower halves of four 64-bit integers */
+		__m128 lo = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) &src[i]));
+		__m128 hi = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) &src[i + 2]));
+		__m128i v = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+
+		_mm_storeu_si128((__m128i *) (d + i * 4), _mm_shuffle_epi8(v, mask));
+	}
+
+	pack_i32_scalar(d + i * 4, src + i, cnt - i, swap);
+}
+
+__attribute__((target("sse4.1")))
+static void unpack_i32_sse41(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	const __m128i mask = bswap_mask<uint32_t>(swap);
+
+	auto *s = (const char *) src;
+
+	size_t i = 0;
+	for (; i + 4 <= cnt; i += 4) {
+		__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (s + i * 4)), mask);
+
+		_mm_storeu_si128((__m128i *) &dst[i], _mm_cvtepi32_epi64(v));
+		_mm_storeu_si128((__m128i *) &dst[i + 2], _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+	}
+
+	unpack_i32_scalar(dst + i, s + i * 4, cnt - i, swap);
+}
+
+static const struct raw_kernels kernels_sse41 = {
+	.isa = RawConvertIsa::SSE41,
+	.bswap16 = bswap_sse41<uint16_t>,
+	.bswap32 = bswap_sse41<uint32_t>,
+	.bswap64 = bswap_sse41<uint64_t>,
+	.pack_f32 = pack_f32_sse41,
+	.unpack_f32 = unpack_f32_sse41,
+	.pack_i32 = pack_i32_sse41,
+	.unpack_i32 = unpack_i32_sse41
+};
+
+/* AVX2 kernels process 32 bytes of 32-bit values per iteration */
+
+template<typename T>
+__attribute__((target("avx2")))
+static void bswap_avx2(void *dst, const void *src, size_t cnt)
+{
+	const size_t n = 32 / sizeof(T);
+	const __m256i mask = _mm256_broadcastsi128_si256(bswap_mask<T>());
+
+	auto *d = (char *) dst;
+	auto *s = (const char *) src;
+
+	size_t i = 0;
+	for (; i + n <= cnt; i += n) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) (s + i * sizeof(T)));
+		_mm256_storeu_si256((__m256i *) (d + i * sizeof(T)), _mm256_shuffle_epi8(v, mask));
+	}
+
+	bswap_scalar<T>(d + i * sizeof(T), s + i * sizeof(T), cnt - i);
+}
+
+__attribute__((target("avx2")))
+static void pack_f32_avx2(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	const __m256i mask = _mm256_broadcastsi128_si256(bswap_mask<uint32_t>(swap));
+
+	auto *d = (char *) dst;
+
+	size_t i = 0;
+	for (; i + 8 <= cnt; i += 8) {
+		__m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd((const double *) &src[i]));
+		__m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd((const double *) &src[i + 4]));
+		__m256i v = _mm256_castps_si256(_mm256_set_m128(hi, lo));
+
+		_mm256_storeu_si256((__m256i *) (d + i * 4), _mm256_shuffle_epi8(v, mask));
+	}
+
+	pack_f32_scalar(d + i * 4, src + i, cnt - i, swap);
+}
+
+__attribute__((target("avx2")))
+static void unpack_f32_avx2(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	const __m256i mask = _mm256_broadcastsi128_si256(bswap_mask<uint32_t>(swap));
+
+	auto *s = (const char *) src;
+
+	size_t i = 0;
+	for (; i + 8 <= cnt; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) (s + i * 4));
+		__m256 f = _mm256_castsi256_ps(_mm256_shuffle_epi8(v, mask));
+
+		_mm256_storeu_pd((double *) &dst[i], _mm256_cvtps_pd(_mm256_castps256_ps128(f)));
+		_mm256_storeu_pd((double *) &dst[i + 4], _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)));
+	}
+
+	unpack_f32_scalar(dst + i, s + i * 4, cnt - i, swap);
+}
+
+__attribute__((target("avx2")))
+static void pack_i32_avx2(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	const __m256i mask = _mm256_broadcastsi128_si256(bswap_mask<uint32_t>(swap));
+	const __m256i lower = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+	auto *d = (char *) dst;
+
+	size_t i = 0;
+	for (; i + 8 <= cnt; i += 8) {
+		/* Gather the lower halves of eight 64-bit integers */
+		__m256i lo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *) &src[i]), lower);
+		__m256i hi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *) &src[i + 4]), lower);
+		__m256i v = _mm256_permute2x128_si256(lo, hi, 0x20);
+
+		_mm256_storeu_si256((__m256i *) (d + i * 4), _mm256_shuffle_epi8(v, mask));
+	}
+
+	pack_i32_scalar(d + i * 4, src + i, cnt - i, swap);
+}
+
+__attribute__((target("avx2")))
+static void unpack_i32_avx2(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	const __m256i mask = _mm256_broadcastsi128_si256(bswap_mask<uint32_t>(swap));
+
+	auto *s = (const char *) src;
+
+	size_t i = 0;
+	for (; i + 8 <= cnt; i += 8) {
+		__m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) (s + i * 4)), mask);
+
+		_mm256_storeu_si256((__m256i *) &dst[i], _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+		_mm256_storeu_si256((__m256i *) &dst[i + 4], _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+	}
+
+	unpack_i32_scalar(dst + i, s + i * 4, cnt - i, swap);
+}
+
+static const struct raw_kernels kernels_avx2 = {
+	.isa = RawConvertIsa::AVX2,
+	.bswap16 = bswap_avx2<uint16_t>,
+	.bswap32 = bswap_avx2<uint32_t>,
+	.bswap64 = bswap_avx2<uint64_t>,
+	.pack_f32 = pack_f32_avx2,
+	.unpack_f32 = unpack_f32_avx2,
+	.pack_i32 = pack_i32_avx2,
+	.unpack_i32 = unpack_i32_avx2
+};
+#endif /* RAW_CONVERT_X86 */
+
+static const struct raw_kernels * raw_convert_find(enum RawConvertIsa isa)
+{
+	switch (isa) {
+#ifdef RAW_CONVERT_X86
+		case RawConvertIsa::AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? &kernels_avx2 : nullptr;
+
+		case RawConvertIsa::SSE41:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse4.1") ? &kernels_sse41 : nullptr;
+#endif
+
+		case RawConvertIsa::SCALAR:
+			return &kernels_scalar;
+
+		default:
+			return nullptr;
+	}
+}
+
+/** Find the best kernels for the CPU. */
+static const struct raw_kernels * raw_convert_detect()
+{
+	for (auto isa : { RawConvertIsa::AVX2, RawConvertIsa::SSE41 }) {
+		auto *k = raw_convert_find(isa);
+		if (k)
+			return k;
+	}
+
+	return &kernels_scalar;
+}
+
+static const struct raw_kernels *& raw_convert_kernels()
+{
+	static const struct raw_kernels *kernels = raw_convert_detect();
+
+	return kernels;
+}
+
+int raw_convert_select(enum RawConvertIsa isa)
+{
+	auto *k = raw_convert_find(isa);
+	if (!k)
+		return -1;
+
+	raw_convert_kernels() = k;
+
+	return 0;
+}
+
+enum RawConvertIsa raw_convert_isa()
+{
+	return raw_convert_kernels()->isa;
+}
+
+void raw_bswap16(void *dst, const void *src, size_t cnt)
+{
+	raw_convert_kernels()->bswap16(dst, src, cnt);
+}
+
+void raw_bswap32(void *dst, const void *src, size_t cnt)
+{
+	raw_convert_kernels()->bswap32(dst, src, cnt);
+}
+
+void raw_bswap64(void *dst, const void *src, size_t cnt)
+{
+	raw_convert_kernels()->bswap64(dst, src, cnt);
+}
+
+void raw_pack_f32(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	raw_convert_kernels()->pack_f32(dst, src, cnt, swap);
+}
+
+void raw_unpack_f32(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	raw_convert_kernels()->unpack_f32(dst, src, cnt, swap);
+}
+
+void raw_pack_i32(void *dst, const union signal_data *src, size_t cnt, bool swap)
+{
+	raw_convert_kernels()->pack_i32(dst, src, cnt, swap);
+}
+
+void raw_unpack_i32(union signal_data *dst, const void *src, size_t cnt, bool swap)
+{
+	raw_convert_kernels()->unpack_i32(dst, src, cnt, swap);
+}
@@ -97,3 +97,43 @@ void Hook::parse(json_t *json)
 
 	state = State::PARSED;
 }
+
+int Hook::process(struct sample *smps[], unsigned cnt, unsigned &stopped)
+{
+	unsigned current, processed = 0, nstops = 0, nskips = 0;
+	struct sample *stops[cnt], *skips[cnt];
+	bool error = false;
+
+	for (current = 0; current < cnt && !error; current++) {
+		switch (process(smps[current])) {
+			case Reason::ERROR:
+				error = true;
+				skips[nskips++] = smps[current];
+				break;
+
+			case Reason::OK:
+				smps[processed++] = smps[current];
+				break;
+
+			case Reason::STOP_PROCESSING:
+				stops[nstops++] = smps[current];
+				break;
+
+			case Reason::SKIP_SAMPLE:
+				skips[nskips++] = smps[current];
+				break;
+		}
+	}
+
+	/* Stopped samples are passed on behind the others, followed by the skipped ones.
+	 * On error, the remaining unprocessed samples stay at the end. */
+	memcpy(smps + processed, stops, nstops * sizeof(struct sample *));
+	memcpy(smps + processed + nstops, skips, nskips * sizeof(struct sample *));
+
+	if (error)
+		return -1;
+
+	stopped = nstops;
+
+	return processed + nstops;
+}
@@ -20,6 +20,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+
 #include <villas/plugin.hpp>
 #include <villas/hook.hpp>
 #include <villas/hook_list.hpp>
@@ -138,40 +141,57 @@ skip_add:
 
 int hook_list_process(struct vlist *hs, struct sample * smps[], unsigned cnt)
 {
-	unsigned current, processed = 0;
-
-	if (vlist_length(hs) == 0)
-		return cnt;
+	int ret;
+	unsigned active = cnt, done = 0, stopped;
+	struct sample *order[cnt];
+
+	/* We run one hook after another over the whole batch of samples.
+	 * Each hook passes on a compacted subset of the samples to the next one.
+	 *
+	 * The samples are kept in three partitions: [ active | done | skipped ].
+	 * Samples for which a hook has stopped the processing are moved to the
+	 * done partition. They are not seen by later hooks, but still passed on. */
+	memcpy(order, smps, cnt * sizeof(struct sample *));
+
+	for (size_t i = 0; i < vlist_length(hs) && active > 0; i++) {
+		Hook *h = (Hook *) vlist_at(hs, i);
 
-	for (current = 0; current < cnt; current++) {
-		struct sample *smp = smps[current];
+		stopped = 0;
 
-		for (size_t i = 0; i < vlist_length(hs); i++) {
-			Hook *h = (Hook *) vlist_at(hs, i);
+		ret = h->process(smps, active, stopped);
+		if (ret < 0)
+			return -1;
 
-			auto ret = h->process(smp);
-			smp->signals = h->getSignals();
-			switch (ret) {
-				case Hook::Reason::ERROR:
-					return -1;
+		for (int j = 0; j < ret; j++)
+			smps[j]->signals = h->getSignals();
 
-				case Hook::Reason::OK:
-					continue;
+		/* Move skipped samples behind the done partition */
+		std::rotate(smps + ret, smps + active, smps + active + done);
 
-				case Hook::Reason::SKIP_SAMPLE:
-					goto skip;
+		active = ret - stopped;
+		done += stopped;
+	}
 
-				case Hook::Reason::STOP_PROCESSING:
-					goto stop;
-			}
+	/* Restore the original order of the batch.
+	 * The rotations above do not preserve the order within the partitions.
+	 * Hence, we look up each sample of the original batch among the forwarded ones. */
+	if (done > 0) {
+		unsigned fwdcnt = active + done;
+		struct sample *fwd[fwdcnt];
+
+		memcpy(fwd, smps, fwdcnt * sizeof(struct sample *));
+		std::sort(fwd, fwd + fwdcnt);
+
+		unsigned j = 0, k = fwdcnt;
+		for (unsigned i = 0; i < cnt; i++) {
+			if (std::binary_search(fwd, fwd + fwdcnt, order[i]))
+				smps[j++] = order[i];
+			else
+				smps[k++] = order[i];
 		}
-
-stop:	SWAP(smps[processed], smps[current]);
-		processed++;
-skip: {}
 	}
 
-		return processed;
+	return active + done;
 }
 
 void hook_list_periodic(struct vlist *hs)
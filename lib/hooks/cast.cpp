@@ -152,16 +152,28 @@ public:
 		state = State::PARSED;
 	}
 
-	virtual Hook::Reason process(sample *smp)
+	virtual int process(struct sample *smps[], unsigned cnt, unsigned &stopped)
 	{
 		assert(state == State::STARTED);
 
-		struct signal *orig_sig = (struct signal *) vlist_at(smp->signals, signal_index);
+		if (cnt == 0)
+			return 0;
+
+		/* All samples of a batch share the same signal list */
+		struct signal *orig_sig = (struct signal *) vlist_at(smps[0]->signals, signal_index);
 		struct signal *new_sig  = (struct signal *) vlist_at(&signals,  signal_index);
 
-		signal_data_cast(&smp->data[signal_index], orig_sig->type, new_sig->type);
+		for (unsigned i = 0; i < cnt; i++)
+			signal_data_cast(&smps[i]->data[signal_index], orig_sig->type, new_sig->type);
+
+		return cnt;
+	}
+
+	virtual Hook::Reason process(sample *smp)
+	{
+		unsigned stopped = 0;
 
-		return Reason::OK;
+		return process(&smp, 1, stopped) < 0 ? Reason::ERROR : Reason::OK;
 	}
 };
 
@@ -28,6 +28,8 @@
 #include <cinttypes>
 #include <complex>
 #include <vector>
+#include <map>
+#include <algorithm>
 
 #include <villas/dumper.hpp>
 #include <villas/hook.hpp>
@@ -53,6 +55,13 @@ protected:
 		HAMMING
 	};
 
+	enum Method {
+		MATRIX,		/**< Multiply the window with a dense matrix of DFT coefficients */
+		SLIDING,	/**< Update tracked bins recursively with every new sample */
+		GOERTZEL,	/**< Run a Goertzel filter per frequency bin */
+		FFT		/**< Calculate the whole spectrum with a chirp-z transform */
+	};
+
 	std::shared_ptr<Dumper> origSigSync;
 	std::shared_ptr<Dumper> windowdSigSync;
 	std::shared_ptr<Dumper> phasorPhase;
@@ -61,24 +70,44 @@ protected:
 
 	enum WindowType windowType;
 	enum PaddingType paddingType;
+	enum Method method;
 
 	std::vector<std::vector<double>> smpMemory;
 	std::vector<std::vector<std::complex<double>>> dftMatrix;
 	std::vector<std::complex<double>> dftResults;
 	std::vector<double> filterWindowCoefficents;
+	std::vector<double> windowedSamples;
 	std::vector<double> absDftResults;
 	std::vector<double> absDftFreqs;
 
+	/* State of the sliding DFT */
+	std::vector<double> slidingOmega;			/**< Angular frequency of each tracked bin */
+	std::vector<std::complex<double>> slidingRotation;	/**< e^(jw) per tracked bin */
+	std::vector<std::complex<double>> slidingTail;		/**< e^(-jw(windowSize - 1)) per tracked bin */
+	std::vector<std::complex<double>> slidingBins;		/**< Tracked bins of all signals, one row per signal */
+	std::vector<unsigned> tapIndex;				/**< Tracked bins which are combined into a windowed bin */
+	std::vector<double> tapWeight;				/**< Weights of the tracked bins which are combined into a windowed bin */
+	unsigned windowTaps;					/**< Number of taps per windowed bin */
+
+	/* State of the chirp-z transform */
+	std::vector<std::complex<double>> fftTwiddles;
+	std::vector<std::complex<double>> cztPre;
+	std::vector<std::complex<double>> cztPost;
+	std::vector<std::complex<double>> cztKernel;		/**< Spectrum of the chirp filter */
+	std::vector<std::complex<double>> cztBuffer;
+
 	uint64_t dftCalcCnt;
 	unsigned sampleRate;
 	double startFreqency;
 	double endFreqency;
 	double frequencyResolution;
 	unsigned dftRate;
+	unsigned dftInterval;		/**< Number of samples between two calculations if not synchronized */
 	unsigned windowSize;
 	unsigned windowMultiplier;	/**< Multiplyer for the window to achieve frequency resolution */
 	unsigned freqCount;		/**< Number of requency bins that are calculated */
-	bool syncDft;
+	int startBin;
+	int syncDft;
 
 	uint64_t smpMemPos;
 	uint64_t lastSequence;
@@ -95,21 +124,26 @@ public:
 		Hook(p, n, fl, prio, en),
 		windowType(WindowType::NONE),
 		paddingType(PaddingType::ZERO),
+		method(Method::MATRIX),
 		smpMemory(),
 		dftMatrix(),
 		dftResults(),
 		filterWindowCoefficents(),
+		windowedSamples(),
 		absDftResults(),
 		absDftFreqs(),
+		windowTaps(0),
 		dftCalcCnt(0),
 		sampleRate(0),
 		startFreqency(0),
 		endFreqency(0),
 		frequencyResolution(0),
 		dftRate(0),
+		dftInterval(1),
 		windowSize(0),
 		windowMultiplier(0),
 		freqCount(0),
+		startBin(0),
 		syncDft(0),
 		smpMemPos(0),
 		lastSequence(0),
@@ -140,9 +174,9 @@ public:
 			struct signal *rocofSig;
 
 			/* Add signals */
-			freqSig = signal_create("amplitude", nullptr, SignalType::FLOAT);
-			amplSig = signal_create("phase", nullptr, SignalType::FLOAT);
-			phaseSig = signal_create("frequency", nullptr, SignalType::FLOAT);
+			freqSig = signal_create("frequency", nullptr, SignalType::FLOAT);
+			amplSig = signal_create("amplitude", nullptr, SignalType::FLOAT);
+			phaseSig = signal_create("phase", nullptr, SignalType::FLOAT);
 			rocofSig = signal_create("rocof", nullptr, SignalType::FLOAT);
 
 			if (!freqSig || !amplSig || !phaseSig || !rocofSig)
@@ -160,29 +194,50 @@ public:
 		windowMultiplier = ceil(((double)sampleRate / windowSize) / frequencyResolution);
 
 		freqCount = ceil((endFreqency - startFreqency) / frequencyResolution) + 1;
+		startBin = floor(startFreqency / frequencyResolution);
 
-		/* Initialize matrix of dft coeffients */
-		dftMatrix.clear();
-		for (unsigned i = 0; i < freqCount; i++)
-			dftMatrix.emplace_back(windowSize * windowMultiplier, 0.0);
+		dftInterval = dftRate > 0 ? std::max(1u, sampleRate / dftRate) : 1;
 
 		dftResults.resize(freqCount);
 		filterWindowCoefficents.resize(windowSize);
+		windowedSamples.resize(windowSize);
 		absDftResults.resize(freqCount);
 		absDftFreqs.resize(freqCount);
 
 		for (unsigned i = 0; i < absDftFreqs.size(); i++)
 			absDftFreqs[i] = startFreqency + i * frequencyResolution;
 
-		generateDftMatrix();
 		calculateWindow(windowType);
 
+		switch (method) {
+			case Method::MATRIX:
+				/* Initialize matrix of dft coeffients.
+				 * The zero padded part of the window does not contribute. */
+				dftMatrix.clear();
+				for (unsigned i = 0; i < freqCount; i++)
+					dftMatrix.emplace_back(windowSize, 0.0);
+
+				generateDftMatrix();
+				break;
+
+			case Method::SLIDING:
+				prepareSlidingDft();
+				break;
+
+			case Method::FFT:
+				prepareChirpZ();
+				break;
+
+			case Method::GOERTZEL:
+				break;
+		}
+
 		state = State::PREPARED;
 	}
 
 	virtual void parse(json_t *cfg)
 	{
-		const char *paddingTypeC = nullptr, *windowTypeC= nullptr;
+		const char *paddingTypeC = nullptr, *windowTypeC = nullptr, *methodC = nullptr;
 		int ret;
 		json_error_t err;
 
@@ -192,7 +247,7 @@ public:
 
 		Hook::parse(cfg);
 
-		ret = json_unpack_ex(cfg, &err, 0, "{ s?: i, s?: F, s?: F, s?: F, s?: i , s?: i, s?: s, s?: s, s?: b, s?: o}",
+		ret = json_unpack_ex(cfg, &err, 0, "{ s?: i, s?: F, s?: F, s?: F, s?: i , s?: i, s?: s, s?: s, s?: s, s?: b, s?: o}",
 			"sample_rate", &sampleRate,
 			"start_freqency", &startFreqency,
 			"end_freqency", &endFreqency,
@@ -201,6 +256,7 @@ public:
 			"window_size", &windowSize,
 			"window_type", &windowTypeC,
 			"padding_type", &paddingTypeC,
+			"method", &methodC,
 			"sync", &syncDft,
 			"signal_index", &jsonChannelList
 		);
@@ -261,6 +317,23 @@ public:
 			paddingType = PaddingType::ZERO;
 		}
 
+		if (!methodC || strcmp(methodC, "matrix") == 0)
+			method = Method::MATRIX;
+		else if (strcmp(methodC, "sliding") == 0)
+			method = Method::SLIDING;
+		else if (strcmp(methodC, "goertzel") == 0)
+			method = Method::GOERTZEL;
+		else if (strcmp(methodC, "fft") == 0)
+			method = Method::FFT;
+		else
+			throw ConfigError(cfg, "node-config-hook-dft-method", "Invalid method: {}", methodC);
+
+		if (windowSize == 0)
+			throw ConfigError(cfg, "node-config-hook-dft", "Setting 'window_size' must be larger than zero");
+
+		if (frequencyResolution <= 0)
+			throw ConfigError(cfg, "node-config-hook-dft", "Setting 'frequency_resolution' must be larger than zero");
+
 		if (endFreqency < 0 || endFreqency > sampleRate)
 			throw ConfigError(cfg, err, "node-config-hook-dft", "End frequency must be smaller than sampleRate {}", sampleRate);
 
@@ -274,22 +347,38 @@ public:
 	{
 		assert(state == State::STARTED);
 
-		for (unsigned i = 0; i < signalIndex.size(); i++)
-			smpMemory[i][smpMemPos % windowSize] = smp->data[signalIndex[i]].f;
+		unsigned pos = smpMemPos % windowSize;
+
+		for (unsigned i = 0; i < signalIndex.size(); i++) {
+			double value = smp->data[signalIndex[i]].f;
+
+			if (method == Method::SLIDING)
+				updateSlidingDft(i, smpMemory[i][pos], value);
+
+			smpMemory[i][pos] = value;
+		}
 
 		smpMemPos++;
 
+		/* Recalculate the tracked bins once per window to bound rounding errors */
+		if (method == Method::SLIDING && smpMemPos % windowSize == 0) {
+			for (unsigned i = 0; i < signalIndex.size(); i++)
+				renormalizeSlidingDft(i);
+		}
+
 		bool runDft = false;
 		if (syncDft) {
 			if (lastDftCal.tv_sec != smp->ts.origin.tv_sec)
 				runDft = true;
 		}
+		else
+			runDft = smpMemPos % dftInterval == 0;
 
 		lastDftCal = smp->ts.origin;
 
 		if (runDft) {
 			for (unsigned i = 0; i < signalIndex.size(); i++) {
-				calculateDft(PaddingType::ZERO, smpMemory[i], smpMemPos);
+				calculateDft(i);
 				double maxF = 0;
 				double maxA = 0;
 				int maxPos = 0;
@@ -331,90 +420,297 @@ public:
 		return Reason::SKIP_SAMPLE;
 	}
 
+	/** Angular frequency of bin \p bin of the zero padded window. */
+	double binOmega(int bin) const
+	{
+		return 2 * M_PI * bin / (windowSize * windowMultiplier);
+	}
+
+	/** Coefficients of a window given as sum of cosines.
+	 *
+	 * w[m] = sum_r c[r] * cos(2 * pi * r * m / windowSize)
+	 */
+	static std::vector<double> windowCosines(enum WindowType windowTypeIn)
+	{
+		switch (windowTypeIn) {
+			case WindowType::FLATTOP:
+				return { 0.21557895, -0.41663158, 0.277263158, -0.083578947, 0.006947368 };
+
+			case WindowType::HAMMING:
+				return { 25./46, -(1 - 25./46) };
+
+			case WindowType::HANN:
+				return { 0.5, -0.5 };
+
+			default:
+				return { 1 };
+		}
+	}
+
 	void generateDftMatrix()
 	{
 		using namespace std::complex_literals;
 
 		omega = exp((-2i * M_PI) / (double)(windowSize * windowMultiplier));
-		unsigned startBin = floor(startFreqency / frequencyResolution);
 
 		for (unsigned i = 0; i <  freqCount ; i++) {
-			for (unsigned j = 0 ; j < windowSize * windowMultiplier ; j++)
+			for (unsigned j = 0 ; j < windowSize ; j++)
 				dftMatrix[i][j] = pow(omega, (i + startBin) * j);
 		}
 	}
 
-	void calculateDft(enum PaddingType padding, std::vector<double> &ringBuffer, unsigned ringBufferPos)
+	/** Setup the bins which are tracked by the sliding DFT.
+	 *
+	 * A window which is a sum of cosines is applied in the frequency domain
+	 * by combining each bin with its neighbours at multiples of 1 / windowSize.
+	 * Hence we track those neighbours as well.
+	 */
+	void prepareSlidingDft()
 	{
-		/* RingBuffer size needs to be equal to windowSize
-		 * prepare sample window The following parts can be combined */
-		double tmpSmpWindow[windowSize];
+		auto cosines = windowCosines(windowType);
+		int order = cosines.size() - 1;
+		std::map<int, unsigned> tracked;
 
-		for (unsigned i = 0; i< windowSize; i++)
-			tmpSmpWindow[i] = ringBuffer[(i + ringBufferPos) % windowSize];
+		windowTaps = 2 * order + 1;
 
-		if (origSigSync)
-			origSigSync->writeDataBinary(windowSize, tmpSmpWindow);
+		tapIndex.clear();
+		tapWeight.clear();
 
-		if (dftCalcCnt > 1 && phasorAmplitude)
-			phasorAmplitude->writeDataBinary(1, &tmpSmpWindow[windowSize - 1]);
+		for (unsigned k = 0; k < freqCount; k++) {
+			for (int r = -order; r <= order; r++) {
+				int bin = startBin + k + r * (int) windowMultiplier;
 
-		for (unsigned i = 0; i< windowSize; i++)
-			tmpSmpWindow[i] *= filterWindowCoefficents[i];
+				auto it = tracked.emplace(bin, tracked.size()).first;
 
-		if (windowdSigSync)
-			windowdSigSync->writeDataBinary(windowSize, tmpSmpWindow);
-
-		for (unsigned i = 0; i < freqCount; i++) {
-			dftResults[i] = 0;
-			for (unsigned j = 0; j < windowSize * windowMultiplier; j++) {
-				if (padding == PaddingType::ZERO) {
-					if (j < (windowSize))
-						dftResults[i] += tmpSmpWindow[j] * dftMatrix[i][j];
-					else
-						dftResults[i] += 0;
+				tapIndex.push_back(it->second);
+				tapWeight.push_back(r == 0 ? cosines[0] : cosines[abs(r)] / 2);
+			}
+		}
+
+		slidingOmega.resize(tracked.size());
+		slidingRotation.resize(tracked.size());
+		slidingTail.resize(tracked.size());
+
+		for (auto &t : tracked) {
+			double w = binOmega(t.first);
+
+			slidingOmega[t.second] = w;
+			slidingRotation[t.second] = std::polar(1.0, w);
+			slidingTail[t.second] = std::polar(1.0, -w * (windowSize - 1));
+		}
+
+		slidingBins.assign(signalIndex.size() * tracked.size(), 0.0);
+	}
+
+	/** Shift the oldest sample out of the window and the newest in. */
+	void updateSlidingDft(unsigned sig, double oldest, double newest)
+	{
+		unsigned numBins = slidingOmega.size();
+		std::complex<double> *bins = &slidingBins[sig * numBins];
+
+		for (unsigned b = 0; b < numBins; b++)
+			bins[b] = slidingRotation[b] * (bins[b] - oldest) + newest * slidingTail[b];
+	}
+
+	/** Recalculate the tracked bins from scratch.
+	 *
+	 * Must only be called when the oldest sample is at the start of the ring buffer.
+	 */
+	void renormalizeSlidingDft(unsigned sig)
+	{
+		unsigned numBins = slidingOmega.size();
+		std::complex<double> *bins = &slidingBins[sig * numBins];
+
+		for (unsigned b = 0; b < numBins; b++)
+			bins[b] = goertzel(smpMemory[sig].data(), slidingOmega[b]);
+	}
+
+	/** Calculate a single DFT bin of the window with the Goertzel algorithm. */
+	std::complex<double> goertzel(const double *x, double w) const
+	{
+		double coeff = 2 * cos(w);
+		double s1 = 0, s2 = 0;
+
+		for (unsigned m = 0; m < windowSize; m++) {
+			double s0 = x[m] + coeff * s1 - s2;
+
+			s2 = s1;
+			s1 = s0;
+		}
+
+		/* s1 - e^(-jw) * s2 equals the sum of x[m] * e^(jw(windowSize - 1 - m)) */
+		return (s1 - std::polar(1.0, -w) * s2) * std::polar(1.0, -w * (windowSize - 1));
+	}
+
+	/** Phase factor e^(-j * pi * n / N) for an integer n with N being the padded window length. */
+	std::complex<double> chirp(int64_t n) const
+	{
+		int64_t len = windowSize * windowMultiplier;
+
+		/* Reduce the argument first to avoid a loss of precision for large n */
+		n %= 2 * len;
+
+		return std::polar(1.0, -M_PI * n / len);
+	}
+
+	/** Setup the chirp-z transform for the requested range of bins.
+	 *
+	 * X[k] = post[k] * sum_m (x[m] * pre[m]) * chirp(-(k - m)^2)
+	 *
+	 * The convolution is carried out by a power of two FFT.
+	 */
+	void prepareChirpZ()
+	{
+		unsigned len = 1;
+		while (len < windowSize + freqCount - 1)
+			len <<= 1;
+
+		fftTwiddles.resize(len / 2);
+		for (unsigned i = 0; i < len / 2; i++)
+			fftTwiddles[i] = std::polar(1.0, -2 * M_PI * i / len);
+
+		cztPre.resize(windowSize);
+		for (unsigned m = 0; m < windowSize; m++)
+			cztPre[m] = chirp(2 * (int64_t) startBin * m + (int64_t) m * m);
+
+		cztPost.resize(freqCount);
+		for (unsigned k = 0; k < freqCount; k++)
+			cztPost[k] = chirp((int64_t) k * k);
+
+		cztKernel.assign(len, 0.0);
+		for (int n = -(int) windowSize + 1; n < (int) freqCount; n++)
+			cztKernel[(n + len) % len] = std::conj(chirp((int64_t) n * n));
+
+		fft(cztKernel, false);
+
+		cztBuffer.resize(len);
+	}
+
+	/** In-place iterative radix-2 FFT. */
+	void fft(std::vector<std::complex<double>> &a, bool inverse) const
+	{
+		unsigned len = a.size();
+
+		/* Bit reversal permutation */
+		for (unsigned i = 1, j = 0; i < len; i++) {
+			unsigned bit = len >> 1;
+
+			for (; j & bit; bit >>= 1)
+				j ^= bit;
+
+			j ^= bit;
+
+			if (i < j)
+				std::swap(a[i], a[j]);
+		}
+
+		for (unsigned half = 1; half < len; half <<= 1) {
+			unsigned stride = len / (2 * half);
+
+			for (unsigned i = 0; i < len; i += 2 * half) {
+				for (unsigned j = 0; j < half; j++) {
+					auto w = inverse ? std::conj(fftTwiddles[j * stride]) : fftTwiddles[j * stride];
+					auto u = a[i + j];
+					auto v = a[i + j + half] * w;
+
+					a[i + j] = u + v;
+					a[i + j + half] = u - v;
 				}
-				else if (padding == PaddingType::SIG_REPEAT) /* Repeat samples */
-					dftResults[i] += tmpSmpWindow[j % windowSize] * dftMatrix[i][j];
 			}
 		}
+
+		if (inverse) {
+			for (auto &x : a)
+				x /= len;
+		}
 	}
 
-	void calculateWindow(enum WindowType windowTypeIn)
+	/** Copy the window of a signal in chronological order and apply the window function. */
+	void prepareWindow(unsigned sig)
 	{
-		switch (windowTypeIn) {
-			case WindowType::FLATTOP:
-				for (unsigned i = 0; i < windowSize; i++) {
-					filterWindowCoefficents[i] = 	0.21557895
-									- 0.41663158 * cos(2 * M_PI * i / (windowSize))
-									+ 0.277263158 * cos(4 * M_PI * i / (windowSize))
-									- 0.083578947 * cos(6 * M_PI * i / (windowSize))
-									+ 0.006947368 * cos(8 * M_PI * i / (windowSize));
-					windowCorretionFactor += filterWindowCoefficents[i];
+		std::vector<double> &ringBuffer = smpMemory[sig];
+
+		for (unsigned i = 0; i < windowSize; i++)
+			windowedSamples[i] = ringBuffer[(i + smpMemPos) % windowSize];
+
+		if (origSigSync)
+			origSigSync->writeDataBinary(windowSize, windowedSamples.data());
+
+		if (dftCalcCnt > 1 && phasorAmplitude)
+			phasorAmplitude->writeDataBinary(1, &windowedSamples[windowSize - 1]);
+
+		for (unsigned i = 0; i < windowSize; i++)
+			windowedSamples[i] *= filterWindowCoefficents[i];
+
+		if (windowdSigSync)
+			windowdSigSync->writeDataBinary(windowSize, windowedSamples.data());
+	}
+
+	/** Calculate the requested bins of the zero padded window of a signal. */
+	void calculateDft(unsigned sig)
+	{
+		if (method == Method::SLIDING) {
+			const std::complex<double> *bins = &slidingBins[sig * slidingOmega.size()];
+
+			for (unsigned i = 0; i < freqCount; i++) {
+				dftResults[i] = 0;
+				for (unsigned t = 0; t < windowTaps; t++)
+					dftResults[i] += tapWeight[i * windowTaps + t] * bins[tapIndex[i * windowTaps + t]];
+			}
+
+			return;
+		}
+
+		prepareWindow(sig);
+
+		switch (method) {
+			case Method::MATRIX:
+				for (unsigned i = 0; i < freqCount; i++) {
+					dftResults[i] = 0;
+					for (unsigned j = 0; j < windowSize; j++)
+						dftResults[i] += windowedSamples[j] * dftMatrix[i][j];
 				}
 				break;
 
-			case WindowType::HAMMING:
-			case WindowType::HANN: {
-				double a0 = 0.5; /* This is the hann window */
-				if (windowTypeIn == WindowType::HAMMING)
-					a0 = 25./46;
-
-				for (unsigned i = 0; i < windowSize; i++) {
-					filterWindowCoefficents[i] = a0 - (1 - a0) * cos(2 * M_PI * i / (windowSize));
-					windowCorretionFactor += filterWindowCoefficents[i];
-				}
+			case Method::GOERTZEL:
+				for (unsigned i = 0; i < freqCount; i++)
+					dftResults[i] = goertzel(windowedSamples.data(), binOmega(startBin + i));
+				break;
+
+			case Method::FFT:
+				std::fill(cztBuffer.begin(), cztBuffer.end(), 0.0);
+				for (unsigned m = 0; m < windowSize; m++)
+					cztBuffer[m] = windowedSamples[m] * cztPre[m];
+
+				fft(cztBuffer, false);
+
+				for (unsigned i = 0; i < cztBuffer.size(); i++)
+					cztBuffer[i] *= cztKernel[i];
 
+				fft(cztBuffer, true);
+
+				for (unsigned i = 0; i < freqCount; i++)
+					dftResults[i] = cztBuffer[i] * cztPost[i];
 				break;
-			}
 
-			default:
-				for (unsigned i = 0; i < windowSize; i++) {
-					filterWindowCoefficents[i] = 1;
-					windowCorretionFactor += filterWindowCoefficents[i];
-				}
+			case Method::SLIDING:
 				break;
 		}
+	}
+
+	void calculateWindow(enum WindowType windowTypeIn)
+	{
+		auto cosines = windowCosines(windowTypeIn);
+
+		windowCorretionFactor = 0;
+
+		for (unsigned i = 0; i < windowSize; i++) {
+			filterWindowCoefficents[i] = 0;
+			for (unsigned r = 0; r < cosines.size(); r++)
+				filterWindowCoefficents[i] += cosines[r] * cos(2 * M_PI * r * i / (windowSize));
+
+			windowCorretionFactor += filterWindowCoefficents[i];
+		}
 
 		windowCorretionFactor /= windowSize;
 	}
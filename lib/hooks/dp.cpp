@@ -28,13 +28,14 @@
 #include <cstring>
 
 #include <complex>
+#include <vector>
+#include <string>
+#include <algorithm>
 
 #include <villas/hook.hpp>
 #include <villas/sample.h>
-#include <villas/dsp/window.hpp>
 #include <villas/utils.hpp>
 
-using namespace std::complex_literals;
 using namespace villas::utils;
 
 namespace villas {
@@ -43,118 +44,142 @@ namespace node {
 class DPHook : public Hook {
 
 protected:
-	char *signal_name;
-	unsigned signal_index;
+	std::vector<std::string> signalNames;	/**< Names of the phases or empty if given by index */
+	std::vector<unsigned> signalIndices;	/**< Index of the (first) signal of each phase */
+	std::vector<unsigned> removeOrder;	/**< Phases sorted by descending signal index */
 
 	int offset;
 	int inverse;
 
 	double f0;
 	double timestep;
-	double time;
-	double steps;
+	uint64_t steps;
 
-	std::complex<double> *coeffs;
-	int *fharmonics;
-	int  fharmonics_len;
+	std::vector<int> fharmonics;
 
-	dsp::Window<double> window;
+	unsigned windowLength;				/**< Number of samples per fundamental period */
+	std::vector<std::complex<double>> twiddles;	/**< e^(-j 2 pi m / windowLength) */
+	std::vector<unsigned> twiddleStep;		/**< Harmonic number modulo windowLength */
+	std::vector<unsigned> twiddleIndex;		/**< Current position in the twiddle table per harmonic */
 
-	void step(double *in, std::complex<float> *out)
-	{
-		int N = window.getLength();
-		__attribute__((unused)) std::complex<double> om_k, corr;
-		double newest = *in;
-		__attribute__((unused)) double oldest = window.update(newest);
+	std::vector<double> history;			/**< Last period of each phase indexed by absolute step modulo windowLength */
+	std::vector<std::complex<double>> sums;	/**< Running DFT sums per phase and harmonic */
 
-		for (int k = 0; k < fharmonics_len; k++) {
-			om_k = 2.0i * M_PI * (double) fharmonics[k] / (double) N;
+	std::vector<double> deltas;
+	std::vector<double> signalBuffer;
+	std::vector<std::complex<float>> coeffBuffer;
 
-			/* Correction for stationary phasor */
-			corr = std::exp(-om_k * (steps - (N + 1)));
-			//corr = 1;
+	void step(const double *in, std::complex<float> *out)
+	{
+		unsigned phases = signalIndices.size();
+		unsigned harmonics = fharmonics.size();
+		unsigned pos = steps % windowLength;
 
-#if 0
-			/* Recursive update */
-			coeffs[k] = std::exp(om) * (coeffs[k] + (newest - oldest));
+		/* The sample leaving the window has the same twiddle factor as the new one */
+		for (unsigned p = 0; p < phases; p++) {
+			double newest = in[p];
+			double oldest = history[p * windowLength + pos];
 
-			out[k] = (2.0 / N) * (coeffs[i] * corr);
+			history[p * windowLength + pos] = newest;
+			deltas[p] = newest - oldest;
+		}
 
-			/* DC component */
-			if (fharmonics[k] == 0)
-				out[k] /= 2.0;
-#else
-			/* Full DFT */
-			std::complex<double> X_k = 0;
+		for (unsigned k = 0; k < harmonics; k++) {
+			std::complex<double> tw = twiddles[twiddleIndex[k]];
 
-			for (int n = 0; n < N; n++) {
-				double x_n = window[n];
+			for (unsigned p = 0; p < phases; p++) {
+				std::complex<double> &sum = sums[p * harmonics + k];
 
-				X_k += x_n * std::exp(om_k * (double) n);
-			}
+				sum += deltas[p] * tw;
 
-			out[k] = X_k / (corr * (double) N);
-#endif
+				out[p * harmonics + k] = sum / (double) windowLength;
+			}
 		}
 	}
 
-	void istep(std::complex<float> *in, double *out)
+	void istep(const std::complex<float> *in, double *out)
 	{
-		std::complex<double> value = 0;
+		unsigned phases = signalIndices.size();
+		unsigned harmonics = fharmonics.size();
+
+		for (unsigned p = 0; p < phases; p++)
+			out[p] = 0;
 
 		/* Reconstruct the original signal */
-		for (int k = 0; k < fharmonics_len; k++) {
-			double freq = fharmonics[k];
-			std::complex<double> coeff = in[k];
-			std::complex<double> om = 2.0i * M_PI * freq * time;
+		for (unsigned k = 0; k < harmonics; k++) {
+			std::complex<double> tw = std::conj(twiddles[twiddleIndex[k]]);
+			double scale = fharmonics[k] == 0 ? 1 : 2;
 
-			value += coeff * std::exp(om);
+			for (unsigned p = 0; p < phases; p++)
+				out[p] += scale * std::real(std::complex<double>(in[p * harmonics + k]) * tw);
 		}
+	}
 
-		*out = std::real(value);
+	/** Advance the time reference by one step. */
+	void advance()
+	{
+		steps++;
+
+		for (unsigned k = 0; k < fharmonics.size(); k++) {
+			twiddleIndex[k] += twiddleStep[k];
+			if (twiddleIndex[k] >= windowLength)
+				twiddleIndex[k] -= windowLength;
+		}
+	}
+
+	/** Recalculate the running sums from the history to bound rounding errors. */
+	void renormalize()
+	{
+		unsigned harmonics = fharmonics.size();
+
+		for (unsigned p = 0; p < signalIndices.size(); p++) {
+			const double *x = &history[p * windowLength];
+
+			for (unsigned k = 0; k < harmonics; k++) {
+				std::complex<double> sum = 0;
+				unsigned idx = 0;
+
+				for (unsigned m = 0; m < windowLength; m++) {
+					sum += x[m] * twiddles[idx];
+
+					idx += twiddleStep[k];
+					if (idx >= windowLength)
+						idx -= windowLength;
+				}
+
+				sums[p * harmonics + k] = sum;
+			}
+		}
+	}
+
+	/** Remove the consumed signals of all phases from a sample. */
+	void removeData(struct sample *smp, unsigned len)
+	{
+		for (auto p : removeOrder)
+			sample_data_remove(smp, signalIndices[p], len);
 	}
 
 public:
 
 	DPHook(struct vpath *p, struct vnode *n, int fl, int prio, bool en = true) :
 		Hook(p, n, fl, prio, en),
-		signal_name(nullptr),
-		signal_index(0),
 		offset(0),
 		inverse(0),
 		f0(50.0),
 		timestep(50e-6),
-		time(),
 		steps(0),
-		coeffs(),
-		fharmonics(),
-		fharmonics_len(0)
+		windowLength(0)
 	{ }
 
-	virtual ~DPHook()
-	{
-		/* Release memory */
-		if (fharmonics)
-			delete fharmonics;
-
-		if (coeffs)
-			delete coeffs;
-
-		if (signal_name)
-			free(signal_name);
-	}
-
 	virtual void start()
 	{
 		assert(state == State::PREPARED);
 
-		time = 0;
 		steps = 0;
 
-		for (int i = 0; i < fharmonics_len; i++)
-			coeffs[i] = 0;
-
-		window = dsp::Window<double>((1.0 / f0) / timestep, 0.0);
+		std::fill(twiddleIndex.begin(), twiddleIndex.end(), 0);
+		std::fill(history.begin(), history.end(), 0.0);
+		std::fill(sums.begin(), sums.end(), 0.0);
 
 		state = State::STARTED;
 	}
@@ -163,7 +188,7 @@ public:
 	{
 		int ret;
 		json_error_t err;
-		json_t *json_harmonics, *json_harmonic, *json_signal;
+		json_t *json_harmonics, *json_harmonic, *json_signals, *json_signal;
 		size_t i;
 
 		Hook::parse(json);
@@ -171,7 +196,7 @@ public:
 		double rate = -1, dt = -1;
 
 		ret = json_unpack_ex(json, &err, 0, "{ s: o, s: F, s?: F, s?: F, s: o, s?: b }",
-			"signal", &json_signal,
+			"signal", &json_signals,
 			"f0", &f0,
 			"dt", &dt,
 			"rate", &rate,
@@ -191,31 +216,45 @@ public:
 		if (!json_is_array(json_harmonics))
 			throw ConfigError(json_harmonics, "node-config-hook-dp-harmonics", "Setting 'harmonics' must be a list of integers");
 
-		switch (json_typeof(json_signal)) {
-			case JSON_STRING:
-				signal_name = strdup(json_string_value(json_signal));
-				break;
+		/* Multiple phases are given as a list of signals */
+		if (!json_is_array(json_signals))
+			json_signals = json_pack("[ O ]", json_signals);
+		else
+			json_incref(json_signals);
+
+		signalNames.clear();
+		signalIndices.clear();
+
+		json_array_foreach(json_signals, i, json_signal) {
+			switch (json_typeof(json_signal)) {
+				case JSON_STRING:
+					signalNames.push_back(json_string_value(json_signal));
+					signalIndices.push_back(0);
+					break;
+
+				case JSON_INTEGER:
+					signalNames.push_back("");
+					signalIndices.push_back(json_integer_value(json_signal));
+					break;
+
+				default:
+					json_decref(json_signals);
+					throw ConfigError(json_signal, "node-config-hook-dp-signal", "Invalid value for setting 'signal'");
+			}
+		}
 
-			case JSON_INTEGER:
-				signal_name = nullptr;
-				signal_index = json_integer_value(json_signal);
-				break;
+		json_decref(json_signals);
 
-			default:
-				throw ConfigError(json_signal, "node-config-hook-dp-signal", "Invalid value for setting 'signal'");
-		}
+		if (signalIndices.empty())
+			throw ConfigError(json, "node-config-hook-dp-signal", "Setting 'signal' must not be empty");
 
-		fharmonics_len = json_array_size(json_harmonics);
-		fharmonics = new int[fharmonics_len];
-		coeffs = new std::complex<double>[fharmonics_len];
-		if (!fharmonics || !coeffs)
-			throw MemoryAllocationError();
+		fharmonics.clear();
 
 		json_array_foreach(json_harmonics, i, json_harmonic) {
 			if (!json_is_integer(json_harmonic))
 				throw ConfigError(json_harmonic, "node-config-hook-dp-harmonics", "Setting 'harmonics' must be a list of integers");
 
-			fharmonics[i] = json_integer_value(json_harmonic);
+			fharmonics.push_back(json_integer_value(json_harmonic));
 		}
 
 		state = State::PARSED;
@@ -230,96 +269,169 @@ public:
 		char *new_sig_name;
 		struct signal *orig_sig, *new_sig;
 
-		assert(state != State::STARTED);
+		unsigned phases = signalIndices.size();
+		unsigned harmonics = fharmonics.size();
+
+		for (unsigned p = 0; p < phases; p++) {
+			if (signalNames[p].empty())
+				continue;
+
+			int index = vlist_lookup_index<struct signal>(&signals, signalNames[p].c_str());
+			if (index < 0)
+				throw RuntimeError("Failed to find signal: {}", signalNames[p]);
+
+			signalIndices[p] = index;
+		}
+
+		/* We remove the consumed signals starting with the highest index */
+		removeOrder.resize(phases);
+		for (unsigned p = 0; p < phases; p++)
+			removeOrder[p] = p;
 
-		if (signal_name) {
-			signal_index = vlist_lookup_index<struct signal>(&signals, signal_name);
-			if (signal_index < 0)
-				throw RuntimeError("Failed to find signal: {}", signal_name);
+		std::sort(removeOrder.begin(), removeOrder.end(), [this](unsigned a, unsigned b) {
+			return signalIndices[a] > signalIndices[b];
+		});
+
+		unsigned consumed = inverse ? harmonics : 1;
+		for (unsigned p = 1; p < phases; p++) {
+			if (signalIndices[removeOrder[p]] + consumed > signalIndices[removeOrder[p - 1]])
+				throw RuntimeError("Signals of different phases must not overlap");
 		}
 
 		if (inverse) {
 			/* Remove complex-valued coefficient signals */
-			for (int i = 0; i < fharmonics_len; i++) {
-				orig_sig = (struct signal *) vlist_at_safe(&signals, signal_index + i);
-				if (!orig_sig)
-					throw RuntimeError("Failed to find signal");;
+			for (auto p : removeOrder) {
+				for (unsigned i = 0; i < harmonics; i++) {
+					orig_sig = (struct signal *) vlist_at_safe(&signals, signalIndices[p]);
+					if (!orig_sig)
+						throw RuntimeError("Failed to find signal");
 
-				if (orig_sig->type != SignalType::COMPLEX)
-					throw RuntimeError("Signal is not complex");;
+					if (orig_sig->type != SignalType::COMPLEX)
+						throw RuntimeError("Signal is not complex");
 
-				ret = vlist_remove(&signals, signal_index + i);
-				if (ret)
-					throw RuntimeError("Failed to remove signal from list");;
+					ret = vlist_remove(&signals, signalIndices[p]);
+					if (ret)
+						throw RuntimeError("Failed to remove signal from list");
 
-				signal_decref(orig_sig);
+					signal_decref(orig_sig);
+				}
 			}
 
 			/* Add new real-valued reconstructed signals */
-			new_sig = signal_create("dp", "idp", SignalType::FLOAT);
-			if (!new_sig)
-				throw RuntimeError("Failed to create signal");;
+			for (unsigned p = 0; p < phases; p++) {
+				new_sig = signal_create("dp", "idp", SignalType::FLOAT);
+				if (!new_sig)
+					throw RuntimeError("Failed to create signal");
 
-			ret = vlist_insert(&signals, offset, new_sig);
-			if (ret)
-				throw RuntimeError("Failed to insert signal into list");;
+				ret = vlist_insert(&signals, offset + p, new_sig);
+				if (ret)
+					throw RuntimeError("Failed to insert signal into list");
+			}
 		}
 		else {
-			orig_sig = (struct signal *) vlist_at_safe(&signals, signal_index);
-			if (!orig_sig)
-				throw RuntimeError("Failed to find signal");;
+			std::vector<struct signal *> orig_sigs(phases);
 
-			if (orig_sig->type != SignalType::FLOAT)
-				throw RuntimeError("Signal is not float");;
+			for (unsigned p = 0; p < phases; p++) {
+				orig_sigs[p] = (struct signal *) vlist_at_safe(&signals, signalIndices[p]);
+				if (!orig_sigs[p])
+					throw RuntimeError("Failed to find signal");
 
-			ret = vlist_remove(&signals, signal_index);
-			if (ret)
-				throw RuntimeError("Failed to remove signal from list");;
+				if (orig_sigs[p]->type != SignalType::FLOAT)
+					throw RuntimeError("Signal is not float");
+			}
 
-			for (int i = 0; i < fharmonics_len; i++) {
-				new_sig_name = strf("%s_harm%d", orig_sig->name, i);
+			for (auto p : removeOrder) {
+				ret = vlist_remove(&signals, signalIndices[p]);
+				if (ret)
+					throw RuntimeError("Failed to remove signal from list");
+			}
 
-				new_sig = signal_create(new_sig_name, orig_sig->unit, SignalType::COMPLEX);
-				if (!new_sig)
-					throw RuntimeError("Failed to create new signal");;
+			for (unsigned p = 0; p < phases; p++) {
+				for (unsigned i = 0; i < harmonics; i++) {
+					new_sig_name = strf("%s_harm%d", orig_sigs[p]->name, i);
 
-				ret = vlist_insert(&signals, offset + i, new_sig);
-				if (ret)
-					throw RuntimeError("Failed to insert signal into list");;
+					new_sig = signal_create(new_sig_name, orig_sigs[p]->unit, SignalType::COMPLEX);
+					free(new_sig_name);
+					if (!new_sig)
+						throw RuntimeError("Failed to create new signal");
+
+					ret = vlist_insert(&signals, offset + p * harmonics + i, new_sig);
+					if (ret)
+						throw RuntimeError("Failed to insert signal into list");
+				}
+
+				signal_decref(orig_sigs[p]);
 			}
+		}
+
+		/* Setup twiddle tables */
+		windowLength = round((1.0 / f0) / timestep);
+		if (windowLength == 0)
+			throw RuntimeError("The fundamental period must span at least one sample");
 
-			signal_decref(orig_sig);
+		twiddles.resize(windowLength);
+		for (unsigned m = 0; m < windowLength; m++)
+			twiddles[m] = std::polar(1.0, -2 * M_PI * m / windowLength);
+
+		twiddleStep.resize(harmonics);
+		twiddleIndex.resize(harmonics);
+		for (unsigned k = 0; k < harmonics; k++) {
+			int n = fharmonics[k] % (int) windowLength;
+
+			twiddleStep[k] = n < 0 ? n + windowLength : n;
 		}
 
+		history.resize(phases * windowLength);
+		sums.resize(phases * harmonics);
+
+		deltas.resize(phases);
+		signalBuffer.resize(phases);
+		coeffBuffer.resize(phases * harmonics);
+
 		state = State::PREPARED;
 	}
 
 	virtual Hook::Reason process(sample *smp)
 	{
-		if (signal_index > smp->length)
-			return Hook::Reason::ERROR;
+		unsigned phases = signalIndices.size();
+		unsigned harmonics = fharmonics.size();
+
+		assert(state == State::STARTED);
 
 		if (inverse) {
-			double signal;
-			std::complex<float> *coeffs = reinterpret_cast<std::complex<float> *>(&smp->data[signal_index].z);
+			for (unsigned p = 0; p < phases; p++) {
+				unsigned idx = signalIndices[p];
+
+				if (idx + harmonics > smp->length)
+					return Hook::Reason::ERROR;
+
+				for (unsigned k = 0; k < harmonics; k++)
+					coeffBuffer[p * harmonics + k] = smp->data[idx + k].z;
+			}
 
-			istep(coeffs, &signal);
+			istep(coeffBuffer.data(), signalBuffer.data());
 
-			sample_data_remove(smp, signal_index, fharmonics_len);
-			sample_data_insert(smp, (union signal_data *) &signal, offset, 1);
+			removeData(smp, harmonics);
+			sample_data_insert(smp, (union signal_data *) signalBuffer.data(), offset, phases);
 		}
 		else {
-			double signal = smp->data[signal_index].f;
-			std::complex<float> coeffs[fharmonics_len];
+			for (unsigned p = 0; p < phases; p++) {
+				if (signalIndices[p] >= smp->length)
+					return Hook::Reason::ERROR;
 
-			step(&signal, coeffs);
+				signalBuffer[p] = smp->data[signalIndices[p]].f;
+			}
+
+			step(signalBuffer.data(), coeffBuffer.data());
 
-			sample_data_remove(smp, signal_index, 1);
-			sample_data_insert(smp, (union signal_data *) coeffs, offset, fharmonics_len);
+			removeData(smp, 1);
+			sample_data_insert(smp, (union signal_data *) coeffBuffer.data(), offset, phases * harmonics);
 		}
 
-		time += timestep;
-		steps++;
+		advance();
+
+		if (!inverse && steps % windowLength == 0)
+			renormalize();
 
 		return Reason::OK;
 	}
@@ -25,6 +25,7 @@
  */
 
 #include <bitset>
+#include <vector>
 
 #include <cstring>
 
@@ -39,17 +40,15 @@ namespace node {
 class LimitValueHook : public Hook {
 
 protected:
-	unsigned offset;
-
-	float min, max;
+	double min, max;
 
 	std::bitset<MAX_SAMPLE_LENGTH> mask;
+	std::vector<unsigned> indices;	/**< Indices of the masked signals */
 	vlist signal_names;
 
 public:
 	LimitValueHook(struct vpath *p, struct vnode *n, int fl, int prio, bool en = true) :
 		Hook(p, n, fl, prio, en),
-		offset(0),
 		min(0), max(0)
 	{
 		int ret;
@@ -70,9 +69,6 @@ public:
 
 	virtual void prepare()
 	{
-		int ret;
-		struct signal *avg_sig;
-
 		assert(state == State::CHECKED);
 
 		/* Setup mask */
@@ -89,14 +85,10 @@ public:
 		if (mask.none())
 			throw RuntimeError("Invalid signal mask");
 
-		/* Add averaged signal */
-		avg_sig = signal_create("average", nullptr, SignalType::FLOAT);
-		if (!avg_sig)
-			throw RuntimeError("Failed to create new signal");
-
-		ret = vlist_insert(&signals, offset, avg_sig);
-		if (ret)
-			throw RuntimeError("Failed to intialize list");
+		for (size_t k = 0; k < mask.size(); k++) {
+			if (mask.test(k))
+				indices.push_back(k);
+		}
 
 		state = State::PREPARED;
 	}
@@ -112,16 +104,16 @@ public:
 
 		Hook::parse(json);
 
-		ret = json_unpack_ex(json, &err, 0, "{ s: f, s: f, s: o }",
+		ret = json_unpack_ex(json, &err, 0, "{ s: F, s: F, s: o }",
 			"min", &min,
-			"min", &max,
+			"max", &max,
 			"signals", &json_signals
 		);
 		if (ret)
-			throw ConfigError(json, err, "node-config-hook-average");
+			throw ConfigError(json, err, "node-config-hook-limit_value");
 
 		if (!json_is_array(json_signals))
-			throw ConfigError(json_signals, "node-config-hook-average-signals", "Setting 'signals' must be a list of signal names");
+			throw ConfigError(json_signals, "node-config-hook-limit_value-signals", "Setting 'signals' must be a list of signal names");
 
 		json_array_foreach(json_signals, i, json_signal) {
 			switch (json_typeof(json_signal)) {
@@ -134,52 +126,71 @@ public:
 					break;
 
 				default:
-					throw ConfigError(json_signal, "node-config-hook-average-signals", "Invalid value for setting 'signals'");
+					throw ConfigError(json_signal, "node-config-hook-limit_value-signals", "Invalid value for setting 'signals'");
 			}
 		}
 
 		state = State::PARSED;
 	}
 
-	virtual Hook::Reason process(sample *smp)
+	virtual int process(struct sample *smps[], unsigned cnt, unsigned &stopped)
 	{
 		assert(state == State::STARTED);
 
-		for (unsigned k = 0; k < smp->length; k++) {
-			if (!mask.test(k))
-				continue;
+		if (cnt == 0)
+			return 0;
 
-			switch (sample_format(smp, k)) {
+		/* We process the batch signal by signal.
+		 * All samples of a batch share the same signal list */
+		for (unsigned k : indices) {
+			switch (sample_format(smps[0], k)) {
 				case SignalType::INTEGER:
-					if (smp->data[k].i > max)
-						smp->data[k].i = max;
+					for (unsigned i = 0; i < cnt; i++) {
+						if (k >= smps[i]->length)
+							continue;
 
-					if (smp->data[k].i < min)
-						smp->data[k].i = min;
+						if (smps[i]->data[k].i > max)
+							smps[i]->data[k].i = max;
+
+						if (smps[i]->data[k].i < min)
+							smps[i]->data[k].i = min;
+					}
 					break;
 
 				case SignalType::FLOAT:
-					if (smp->data[k].f > max)
-						smp->data[k].f = max;
+					for (unsigned i = 0; i < cnt; i++) {
+						if (k >= smps[i]->length)
+							continue;
+
+						if (smps[i]->data[k].f > max)
+							smps[i]->data[k].f = max;
 
-					if (smp->data[k].f < min)
-						smp->data[k].f = min;
+						if (smps[i]->data[k].f < min)
+							smps[i]->data[k].f = min;
+					}
 					break;
 
 				case SignalType::INVALID:
 				case SignalType::COMPLEX:
 				case SignalType::BOOLEAN:
-					return Hook::Reason::ERROR; /* not supported */
+					return -1; /* not supported */
 			}
 		}
 
-		return Reason::OK;
+		return cnt;
+	}
+
+	virtual Hook::Reason process(sample *smp)
+	{
+		unsigned stopped = 0;
+
+		return process(&smp, 1, stopped) < 0 ? Reason::ERROR : Reason::OK;
 	}
 };
 
 /* Register hook */
-static char n[] = "average";
-static char d[] = "Calculate average over some signals";
+static char n[] = "limit_value";
+static char d[] = "Limit signal values to a given range";
 static HookPlugin<LimitValueHook, n , d, (int) Hook::Flags::PATH | (int) Hook::Flags::NODE_READ | (int) Hook::Flags::NODE_WRITE> p;
 
 } /* namespace node */
@@ -26,7 +26,10 @@
 
 #include <cstring>
 #include <cinttypes>
+#include <cmath>
 #include <vector>
+#include <algorithm>
+
 #include <villas/timing.h>
 #include <villas/hook.hpp>
 #include <villas/path.h>
@@ -38,37 +41,76 @@ namespace node {
 class RMSHook : public Hook {
 
 protected:
-	std::vector<std::vector<double>> smpMemory;
+	std::vector<int> signalIndex;	/**< A list of signalIndex to do rms on */
+
+	/** Squared values of the last windowSize samples.
+	 *
+	 * The values of all signals of a sample are stored next to each other
+	 * so that the running sums of all signals can be updated in a single loop.
+	 */
+	std::vector<double> window;
+	std::vector<double> squares;	/**< Squared values of the current sample */
+	std::vector<double> sums;	/**< Running sum of squares per signal */
 
-	uint64_t calcCount;
-	unsigned rate;
 	unsigned windowSize;
-	bool sync;
+	unsigned windowPos;		/**< Position of the oldest sample in the window */
+	unsigned decimation;		/**< Only emit every n-th sample */
+	unsigned renormalize;		/**< Recompute the running sums every n-th sample to bound rounding errors */
+
+	int sync;
+	unsigned rate;
 	double nextCalc;
 
-	uint64_t smpMemPos;
+	uint64_t smpCount;
+	uint64_t calcCount;
 	uint64_t lastSequence;
-	struct timespec lastCalc;
 
-	std::vector<int> signalIndex;	/**< A list of signalIndex to do rms on */
+	void renormalizeSums()
+	{
+		unsigned numSignals = signalIndex.size();
+
+		std::fill(sums.begin(), sums.end(), 0.0);
+
+		for (unsigned j = 0; j < windowSize; j++) {
+			const double *row = &window[j * numSignals];
+
+			for (unsigned i = 0; i < numSignals; i++)
+				sums[i] += row[i];
+		}
+	}
 
 public:
 	RMSHook(struct vpath *p, struct vnode *n, int fl, int prio, bool en = true) :
 		Hook(p, n, fl, prio, en),
-		smpMemory(),
-		calcCount(0),
-		rate(0),
+		signalIndex(),
+		window(),
+		squares(),
+		sums(),
 		windowSize(0),
+		windowPos(0),
+		decimation(1),
+		renormalize(0),
 		sync(0),
+		rate(0),
 		nextCalc(0.0),
-		smpMemPos(0),
-		lastSequence(0),
-		lastCalc({0, 0}),
-		signalIndex()
+		smpCount(0),
+		calcCount(0),
+		lastSequence(0)
 	{ }
 
 	virtual void prepare()
 	{
+		assert(state == State::CHECKED);
+
+		for (auto idx : signalIndex) {
+			struct signal *sig = idx >= 0 ? (struct signal *) vlist_at_safe(&signals, (size_t) idx) : nullptr;
+			if (!sig)
+				throw RuntimeError("Invalid signal index: {}", idx);
+
+			if (sig->type != SignalType::FLOAT)
+				throw RuntimeError("Signal {} is not a float", idx);
+		}
+
 		signal_list_clear(&signals);
 		for (unsigned i = 0; i < signalIndex.size(); i++) {
 			struct signal *amplSig;
@@ -83,13 +125,29 @@ public:
 		}
 
 		/* Initialize sample memory */
-		smpMemory.clear();
-		for (unsigned i = 0; i < signalIndex.size(); i++)
-			smpMemory.emplace_back(std::vector<double>(windowSize, 0.0));
+		window.assign(windowSize * signalIndex.size(), 0.0);
+		squares.assign(signalIndex.size(), 0.0);
+		sums.assign(signalIndex.size(), 0.0);
 
 		state = State::PREPARED;
 	}
 
+	virtual void start()
+	{
+		assert(state == State::PREPARED);
+
+		std::fill(window.begin(), window.end(), 0.0);
+		std::fill(sums.begin(), sums.end(), 0.0);
+
+		windowPos = 0;
+		nextCalc = 0.0;
+		smpCount = 0;
+		calcCount = 0;
+		lastSequence = 0;
+
+		state = State::STARTED;
+	}
+
 	virtual void parse(json_t *cfg)
 	{
 		int ret;
@@ -101,15 +159,30 @@ public:
 
 		Hook::parse(cfg);
 
-		ret = json_unpack_ex(cfg, &err, 0, "{ s?: i, s?: b, s?: i, s?: o }",
+		ret = json_unpack_ex(cfg, &err, 0, "{ s: i, s?: b, s?: i, s?: i, s?: i, s?: o }",
 			"window_size", &windowSize,
 			"sync", &sync,
 			"rate", &rate,
+			"decimation", &decimation,
+			"renormalize", &renormalize,
 			"signal_index", &jsonChannelList
 		);
 		if (ret)
 			throw ConfigError(cfg, err, "node-config-hook-rms");
 
+		if (windowSize == 0)
+			throw ConfigError(cfg, "node-config-hook-rms-window-size", "Setting 'window_size' must be larger than zero");
+
+		if (decimation == 0)
+			throw ConfigError(cfg, "node-config-hook-rms-decimation", "Setting 'decimation' must be larger than zero");
+
+		if (sync && rate == 0)
+			throw ConfigError(cfg, "node-config-hook-rms-rate", "Setting 'rate' is required for synchronized calculation");
+
+		/* By default, we recompute the sums once per window */
+		if (renormalize == 0)
+			renormalize = windowSize;
+
 		if (jsonChannelList != nullptr) {
 			signalIndex.clear();
 			if (jsonChannelList->type == JSON_ARRAY) {
@@ -143,56 +216,62 @@ public:
 
 	virtual Hook::Reason process(struct sample *smp)
 	{
-		assert(state == State::STARTED);
+		unsigned numSignals = signalIndex.size();
+		double *row = &window[windowPos * numSignals];
 
-		for (unsigned i = 0; i < signalIndex.size(); i++)
-			smpMemory[i][smpMemPos % windowSize] = pow(smp->data[signalIndex[i]].f, 2);
-
-		smpMemPos++;
+		assert(state == State::STARTED);
 
-		bool runRms = false;
-		if (sync) {
-			double smpNsec = smp->ts.origin.tv_sec * 1e9 + smp->ts.origin.tv_nsec;
+		for (unsigned i = 0; i < numSignals; i++) {
+			double v = smp->data[signalIndex[i]].f;
 
-			if (smpNsec > nextCalc) {
-				runRms = true;
-				nextCalc = (( smp->ts.origin.tv_sec ) + ( ((calcCount % rate) + 1) / (double)rate )) * 1e9;
-			}
+			squares[i] = v * v;
 		}
 
-		if (runRms) {
-			lastCalc = smp->ts.origin;
+		/* Replace the oldest sample in the window */
+		for (unsigned i = 0; i < numSignals; i++) {
+			sums[i] += squares[i] - row[i];
+			row[i] = squares[i];
+		}
 
-			for (unsigned i = 0; i < signalIndex.size(); i++) {
-				double rms = 0;
+		if (++windowPos == windowSize)
+			windowPos = 0;
 
-				for (unsigned j = 0; j < windowSize; j++)
-					rms += smpMemory[i][j];
+		if (++smpCount % renormalize == 0)
+			renormalizeSums();
 
-				rms = pow(rms / windowSize, 0.5) ;
+		if (smpCount > 1 && smp->sequence - lastSequence > 1)
+			logger->warn("Calculation is not Realtime. {} sampled missed", smp->sequence - lastSequence);
 
+		lastSequence = smp->sequence;
 
-				if (calcCount > 1) {
-					smp->data[i * 4 + 0].f = rms; /* RMS */
-				}
-			}
+		/* Wait until the window is filled */
+		if (smpCount < windowSize)
+			return Reason::SKIP_SAMPLE;
 
-			smp->length = calcCount > 1 ? signalIndex.size() * 4 : 0;
+		bool runRms;
+		if (sync) {
+			double smpNsec = smp->ts.origin.tv_sec * 1e9 + smp->ts.origin.tv_nsec;
 
-			calcCount++;
+			runRms = smpNsec > nextCalc;
+			if (runRms)
+				nextCalc = (( smp->ts.origin.tv_sec ) + ( ((calcCount % rate) + 1) / (double)rate )) * 1e9;
 		}
+		else
+			runRms = smpCount % decimation == 0;
 
-		if (smp->sequence - lastSequence > 1)
-			logger->warn("Calculation is not Realtime. {} sampled missed", smp->sequence - lastSequence);
+		if (!runRms)
+			return Reason::SKIP_SAMPLE;
 
-		lastSequence = smp->sequence;
+		/* Rounding errors might let a sum slightly drop below zero */
+		for (unsigned i = 0; i < numSignals; i++)
+			smp->data[i].f = sqrt(std::max(sums[i], 0.0) / windowSize);
 
-		return runRms
-			? Reason::OK
-			: Reason::SKIP_SAMPLE;
-	}
+		smp->length = numSignals;
 
+		calcCount++;
 
+		return Reason::OK;
+	}
 };
 
 /* Register hook */
@@ -104,33 +104,52 @@ public:
 		state = State::PARSED;
 	}
 
-	virtual Hook::Reason process(struct sample *smp)
+	virtual int process(struct sample *smps[], unsigned cnt, unsigned &stopped)
 	{
 		unsigned k = signal_index;
 
-		assert(k < smp->length);
 		assert(state == State::STARTED);
 
-		switch (sample_format(smp, k)) {
+		if (cnt == 0)
+			return 0;
+
+		for (unsigned i = 0; i < cnt; i++)
+			assert(k < smps[i]->length);
+
+		/* All samples of a batch share the same signal list */
+		switch (sample_format(smps[0], k)) {
 			case SignalType::INTEGER:
-				smp->data[k].i *= scale;
-				smp->data[k].i += offset;
+				for (unsigned i = 0; i < cnt; i++) {
+					smps[i]->data[k].i *= scale;
+					smps[i]->data[k].i += offset;
+				}
 				break;
 
 			case SignalType::FLOAT:
-				smp->data[k].f *= scale;
-				smp->data[k].f += offset;
+				for (unsigned i = 0; i < cnt; i++) {
+					smps[i]->data[k].f *= scale;
+					smps[i]->data[k].f += offset;
+				}
 				break;
 
 			case SignalType::COMPLEX:
-				smp->data[k].z *= scale;
-				smp->data[k].z += offset;
+				for (unsigned i = 0; i < cnt; i++) {
+					smps[i]->data[k].z *= scale;
+					smps[i]->data[k].z += offset;
+				}
 				break;
 
 			default: { }
 		}
 
-		return Reason::OK;
+		return cnt;
+	}
+
+	virtual Hook::Reason process(struct sample *smp)
+	{
+		unsigned stopped = 0;
+
+		return process(&smp, 1, stopped) < 0 ? Reason::ERROR : Reason::OK;
 	}
 };
 
@@ -80,28 +80,33 @@ public:
 		state = State::PARSED;
 	}
 
-	virtual Hook::Reason process(sample *smp)
+	virtual int process(struct sample *smps[], unsigned cnt, unsigned &stopped)
 	{
-		timespec *ts;
-
 		assert(state == State::STARTED);
 
 		switch (mode) {
 			case SHIFT_ORIGIN:
-				ts = &smp->ts.origin;
+				for (unsigned i = 0; i < cnt; i++)
+					smps[i]->ts.origin = time_add(&smps[i]->ts.origin, &offset);
 				break;
 
 			case SHIFT_RECEIVED:
-				ts = &smp->ts.received;
+				for (unsigned i = 0; i < cnt; i++)
+					smps[i]->ts.received = time_add(&smps[i]->ts.received, &offset);
 				break;
 
 			default:
-				return Hook::Reason::ERROR;
+				return -1;
 		}
 
-		*ts = time_add(ts, &offset);;
+		return cnt;
+	}
+
+	virtual Hook::Reason process(sample *smp)
+	{
+		unsigned stopped = 0;
 
-		return Reason::OK;
+		return process(&smp, 1, stopped) < 0 ? Reason::ERROR : Reason::OK;
 	}
 };
 
@@ -57,14 +57,19 @@ public:
 class StatsReadHook : public Hook {
 
 protected:
-	sample *last;
+	/* Metadata of the last sample of the previous batch */
+	bool hasLast;
+	int lastFlags;
+	uint64_t lastSequence;
+	timespec lastOrigin;
+	timespec lastReceived;
 
 	StatsHook *parent;
 
 public:
 	StatsReadHook(StatsHook *pa, struct vpath *p, struct vnode *n, int fl, int prio, bool en = true) :
 		Hook(p, n, fl, prio, en),
-		last(nullptr),
+		hasLast(false),
 		parent(pa)
 	{
 		state = State::CHECKED;
@@ -74,7 +79,7 @@ public:
 	{
 		assert(state == State::PREPARED);
 
-		last = nullptr;
+		hasLast = false;
 
 		state = State::STARTED;
 	}
@@ -83,13 +88,17 @@ public:
 	{
 		assert(state == State::STARTED);
 
-		if (last)
-			sample_decref(last);
-
 		state = State::STOPPED;
 	}
 
-	virtual Hook::Reason process(sample *smp);
+	virtual int process(struct sample *smps[], unsigned cnt, unsigned &stopped);
+
+	virtual Hook::Reason process(sample *smp)
+	{
+		unsigned stopped = 0;
+
+		return process(&smp, 1, stopped) < 0 ? Reason::ERROR : Reason::OK;
+	}
 };
 
 class StatsHook : public Hook {
@@ -170,13 +179,20 @@ public:
 		stats->reset();
 	}
 
-	virtual Hook::Reason process(sample *smp)
+	virtual int process(struct sample *smps[], unsigned cnt, unsigned &stopped)
 	{
 		// Only call readHook if it hasnt been added to the node's hook list
 		if (!node)
-			return readHook->process(smp);
+			return readHook->process(smps, cnt, stopped);
 
-		return Hook::Reason::OK;
+		return cnt;
+	}
+
+	virtual Hook::Reason process(sample *smp)
+	{
+		unsigned stopped = 0;
+
+		return process(&smp, 1, stopped) < 0 ? Reason::ERROR : Reason::OK;
 	}
 
 	virtual void periodic()
@@ -247,33 +263,39 @@ Hook::Reason StatsWriteHook::process(sample *smp)
 	return Reason::OK;
 }
 
-Hook::Reason StatsReadHook::process(sample *smp)
+int StatsReadHook::process(struct sample *smps[], unsigned cnt, unsigned &stopped)
 {
-	if (last) {
-		if (smp->flags & last->flags & (int) SampleFlags::HAS_TS_RECEIVED)
-			parent->stats->update(Stats::Metric::GAP_RECEIVED, time_delta(&last->ts.received, &smp->ts.received));
+	auto &stats = parent->stats;
 
-		if (smp->flags & last->flags & (int) SampleFlags::HAS_TS_ORIGIN)
-			parent->stats->update(Stats::Metric::GAP_SAMPLE, time_delta(&last->ts.origin, &smp->ts.origin));
+	for (unsigned j = 0; j < cnt; j++) {
+		const struct sample *smp = smps[j];
 
-		if ((smp->flags & (int) SampleFlags::HAS_TS_ORIGIN) && (smp->flags & (int) SampleFlags::HAS_TS_RECEIVED))
-			parent->stats->update(Stats::Metric::OWD, time_delta(&smp->ts.origin, &smp->ts.received));
+		if (hasLast) {
+			if (smp->flags & lastFlags & (int) SampleFlags::HAS_TS_RECEIVED)
+				stats->update(Stats::Metric::GAP_RECEIVED, time_delta(&lastReceived, &smp->ts.received));
 
-		if (smp->flags & last->flags & (int) SampleFlags::HAS_SEQUENCE) {
-			int dist = smp->sequence - (int32_t) last->sequence;
-			if (dist != 1)
-				parent->stats->update(Stats::Metric::SMPS_REORDERED, dist);
-		}
-	}
+			if (smp->flags & lastFlags & (int) SampleFlags::HAS_TS_ORIGIN)
+				stats->update(Stats::Metric::GAP_SAMPLE, time_delta(&lastOrigin, &smp->ts.origin));
 
-	sample_incref(smp);
+			if ((smp->flags & (int) SampleFlags::HAS_TS_ORIGIN) && (smp->flags & (int) SampleFlags::HAS_TS_RECEIVED))
+				stats->update(Stats::Metric::OWD, time_delta(&smp->ts.origin, &smp->ts.received));
 
-	if (last)
-		sample_decref(last);
+			if (smp->flags & lastFlags & (int) SampleFlags::HAS_SEQUENCE) {
+				int dist = smp->sequence - (int32_t) lastSequence;
+				if (dist != 1)
+					stats->update(Stats::Metric::SMPS_REORDERED, dist);
+			}
+		}
 
-	last = smp;
+		/* Only the metadata is kept. Hence we do not need to hold a reference to the sample. */
+		hasLast = true;
+		lastFlags = smp->flags;
+		lastSequence = smp->sequence;
+		lastOrigin = smp->ts.origin;
+		lastReceived = smp->ts.received;
+	}
 
-	return Reason::OK;
+	return cnt;
 }
 
 /* Register hook */
@@ -36,13 +36,21 @@ class TsHook : public Hook {
 public:
 	using Hook::Hook;
 
-	virtual Hook::Reason process(sample *smp)
+	virtual int process(struct sample *smps[], unsigned cnt, unsigned &stopped)
 	{
 		assert(state == State::STARTED);
 
-		smp->ts.origin = smp->ts.received;
+		for (unsigned i = 0; i < cnt; i++)
+			smps[i]->ts.origin = smps[i]->ts.received;
+
+		return cnt;
+	}
+
+	virtual Hook::Reason process(sample *smp)
+	{
+		unsigned stopped = 0;
 
-		return Reason::OK;
+		return process(&smp, 1, stopped) < 0 ? Reason::ERROR : Reason::OK;
 	}
 };
 
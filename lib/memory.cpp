@@ -20,7 +20,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
-#include <unordered_map>
+#include <new>
+#include <atomic>
 
 #include <unistd.h>
 #include <cstdlib>
@@ -36,11 +37,78 @@
 #include <villas/utils.hpp>
 #include <villas/kernel/kernel.hpp>
 
+/* Allocations are registered in a radix tree which is indexed by their address.
+ * The tree covers the lower MEMORY_REGISTRY_ADDR_BITS of an address. The lowest
+ * MEMORY_REGISTRY_ALIGN_BITS are always zero (see MEMORY_MIN_ALIGNMENT) and are not used.
+ * The root is static, all other nodes are only ever added and never removed.
+ * Hence, lookups, insertions and removals do not need any locks.
+ *
+ * Memory overhead: each node holds 512 slots and takes 4 KiB. A leaf covers
+ * 8 KiB of address space. In the worst case of widely scattered allocations,
+ * each of them costs a leaf and up to three inner nodes (16 KiB). Allocations
+ * which are close to each other share their nodes, so typical pools and
+ * queues need a few leaves per MiB of allocated memory. The static root takes 2 KiB. */
+#define MEMORY_REGISTRY_ADDR_BITS	48
+#define MEMORY_REGISTRY_ALIGN_BITS	4
+#define MEMORY_REGISTRY_KEY_BITS	(MEMORY_REGISTRY_ADDR_BITS - MEMORY_REGISTRY_ALIGN_BITS)
+#define MEMORY_REGISTRY_ROOT_BITS	8
+#define MEMORY_REGISTRY_NODE_BITS	9
+
+static_assert((1 << MEMORY_REGISTRY_ALIGN_BITS) == MEMORY_MIN_ALIGNMENT, "The registry must not ignore significant bits of an address");
+static_assert((MEMORY_REGISTRY_KEY_BITS - MEMORY_REGISTRY_ROOT_BITS) % MEMORY_REGISTRY_NODE_BITS == 0, "The tree must cover all bits of the key");
+
 using namespace villas;
 
-static std::unordered_map<void *, struct memory_allocation *> allocations;
+struct memory_registry_node {
+	std::atomic<void *> slots[1 << MEMORY_REGISTRY_NODE_BITS];
+};
+
+static std::atomic<void *> registry[1 << MEMORY_REGISTRY_ROOT_BITS];
 static Logger logger;
 
+/** Get the slot of the registry which holds the allocation for \p ptr.
+ *
+ * @param create Add missing nodes to the tree.
+ * @retval nullptr The address is not covered by the registry, not aligned to MEMORY_MIN_ALIGNMENT or \p create is not set and the slot does not exist.
+ */
+static std::atomic<void *> * memory_registry_slot(void *ptr, bool create)
+{
+	uint64_t addr = (uintptr_t) ptr;
+
+	/* Such addresses can not be the start of an allocation */
+	if (addr >> MEMORY_REGISTRY_ADDR_BITS || addr % MEMORY_MIN_ALIGNMENT)
+		return nullptr;
+
+	uint64_t key = addr >> MEMORY_REGISTRY_ALIGN_BITS;
+
+	std::atomic<void *> *slot = &registry[key >> (MEMORY_REGISTRY_KEY_BITS - MEMORY_REGISTRY_ROOT_BITS)];
+
+	for (int shift = MEMORY_REGISTRY_KEY_BITS - MEMORY_REGISTRY_ROOT_BITS - MEMORY_REGISTRY_NODE_BITS; shift >= 0; shift -= MEMORY_REGISTRY_NODE_BITS) {
+		auto *n = (struct memory_registry_node *) slot->load(std::memory_order_acquire);
+		if (!n) {
+			if (!create)
+				return nullptr;
+
+			auto *nn = new (std::nothrow) struct memory_registry_node();
+			if (!nn)
+				return nullptr;
+
+			/* Another thread might have added the node in the meantime */
+			void *expected = nullptr;
+			if (slot->compare_exchange_strong(expected, nn, std::memory_order_acq_rel, std::memory_order_acquire))
+				n = nn;
+			else {
+				delete nn;
+				n = (struct memory_registry_node *) expected;
+			}
+		}
+
+		slot = &n->slots[(key >> shift) & ((1 << MEMORY_REGISTRY_NODE_BITS) - 1)];
+	}
+
+	return slot;
+}
+
 int memory_init(int hugepages)
 {
 	int ret;
@@ -123,7 +191,17 @@ void * memory_alloc_aligned(size_t len, size_t alignment, struct memory_type *m)
 		return nullptr;
 	}
 
-	allocations[ma->address] = ma;
+	/* An occupied slot means that the memory type has not respected MEMORY_MIN_ALIGNMENT */
+	void *expected = nullptr;
+	auto *slot = memory_registry_slot(ma->address, true);
+	if (!slot || !slot->compare_exchange_strong(expected, ma, std::memory_order_acq_rel)) {
+		logger->warn("Failed to register memory allocation of type {}: {}", m->name, ma->address);
+
+		m->free(ma, m);
+		delete ma;
+
+		return nullptr;
+	}
 
 	logger->debug("Allocated {:#x} bytes of {:#x}-byte-aligned {} memory: {}", ma->length, ma->alignment, ma->type->name, ma->address);
 
@@ -134,23 +212,23 @@ int memory_free(void *ptr)
 {
 	int ret;
 
-	/* Find corresponding memory allocation entry */
-	struct memory_allocation *ma = allocations[ptr];
+	auto *slot = memory_registry_slot(ptr, false);
+	if (!slot)
+		return -1;
+
+	/* Remove allocation entry. Only one of concurrent calls for the same pointer succeeds. */
+	auto *ma = (struct memory_allocation *) slot->exchange(nullptr, std::memory_order_acq_rel);
 	if (!ma)
 		return -1;
 
 	logger->debug("Releasing {:#x} bytes of {} memory: {}", ma->length, ma->type->name, ma->address);
 
 	ret = ma->type->free(ma, ma->type);
-	if (ret)
+	if (ret) {
+		slot->store(ma, std::memory_order_release);
 		return ret;
+	}
 
-	/* Remove allocation entry */
-	auto iter = allocations.find(ptr);
-	if (iter == allocations.end())
-		return -1;
-
-	allocations.erase(iter);
 	delete ma;
 
 	return 0;
@@ -158,7 +236,11 @@ int memory_free(void *ptr)
 
 struct memory_allocation * memory_get_allocation(void *ptr)
 {
-	return allocations[ptr];
+	auto *slot = memory_registry_slot(ptr, false);
+	if (!slot)
+		return nullptr;
+
+	return (struct memory_allocation *) slot->load(std::memory_order_acquire);
 }
 
 struct memory_type *memory_default = nullptr;
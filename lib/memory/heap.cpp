@@ -41,8 +41,8 @@ static struct memory_allocation * memory_heap_alloc(size_t len, size_t alignment
 	ma->type = m;
 	ma->length = len;
 
-	if (ma->alignment < sizeof(void *))
-		ma->alignment = sizeof(void *);
+	if (ma->alignment < MEMORY_MIN_ALIGNMENT)
+		ma->alignment = MEMORY_MIN_ALIGNMENT;
 
 	ret = posix_memalign(&ma->address, ma->alignment, ma->length);
 	if (ret) {
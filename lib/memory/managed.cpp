@@ -44,6 +44,9 @@ static struct memory_allocation * memory_managed_alloc(size_t len, size_t alignm
 	struct memory_block *first = (struct memory_block *) m->_vd;
 	struct memory_block *block;
 
+	if (alignment < MEMORY_MIN_ALIGNMENT)
+		alignment = MEMORY_MIN_ALIGNMENT;
+
 	for (block = first; block != nullptr; block = block->next) {
 		if (block->used)
 			continue;
@@ -0,0 +1,177 @@
+/** NUMA-aware memory allocator.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#ifdef __linux__
+  #include <sys/syscall.h>
+  #include <linux/mempolicy.h>
+#endif
+
+#include <villas/memory.h>
+#include <villas/memory/numa.h>
+#include <villas/exceptions.hpp>
+#include <villas/log.hpp>
+
+using namespace villas;
+
+static int memory_numa_bind(void *addr, size_t len, struct memory_numa *mn)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	unsigned long mask[(MEMORY_NUMA_MAX_NODE + 1) / (sizeof(unsigned long) * CHAR_BIT)] = { 0 };
+	int mode = mn->policy == MemoryNumaPolicy::BIND ? MPOL_BIND : MPOL_PREFERRED;
+
+	mask[mn->node / (sizeof(unsigned long) * CHAR_BIT)] |= 1ul << (mn->node % (sizeof(unsigned long) * CHAR_BIT));
+
+	/* Pages which have already been faulted in (e.g. due to mlockall(MCL_FUTURE)) are migrated.
+	 * The kernel only reads maxnode - 1 bits of the mask. */
+	return syscall(SYS_mbind, addr, len, mode, mask, MEMORY_NUMA_MAX_NODE + 2, MPOL_MF_MOVE);
+#else
+	errno = ENOSYS;
+
+	return -1;
+#endif
+}
+
+static struct memory_allocation * memory_numa_alloc(size_t len, size_t alignment, struct memory_type *m)
+{
+	int ret;
+	struct memory_numa *mn = (struct memory_numa *) m->_vd;
+
+	auto *ma = new struct memory_allocation;
+	if (!ma)
+		throw MemoryAllocationError();
+
+	ma->parent = mn->parent->alloc(len, alignment, mn->parent);
+	if (!ma->parent) {
+		delete ma;
+		return nullptr;
+	}
+
+	ma->type = m;
+	ma->address = ma->parent->address;
+	ma->length = ma->parent->length;
+	ma->alignment = ma->parent->alignment;
+
+	/* The allocation remains usable. It is just not local to the NUMA node. */
+	ret = memory_numa_bind(ma->address, ma->length, mn);
+	if (ret)
+		logging.get("memory:numa")->warn("Failed to bind {:#x} bytes of memory to NUMA node {}: {}", ma->length, mn->node, strerror(errno));
+
+	return ma;
+}
+
+static int memory_numa_free(struct memory_allocation *ma, struct memory_type *m)
+{
+	int ret;
+	struct memory_numa *mn = (struct memory_numa *) m->_vd;
+
+	ret = mn->parent->free(ma->parent, mn->parent);
+	if (ret)
+		return ret;
+
+	delete ma->parent;
+
+	return 0;
+}
+
+struct memory_type * memory_numa(int node, enum MemoryNumaPolicy policy, struct memory_type *parent)
+{
+	if (node < 0 || node > MEMORY_NUMA_MAX_NODE)
+		return nullptr;
+
+	auto *mt = (struct memory_type *) malloc(sizeof(struct memory_type));
+	if (!mt)
+		throw MemoryAllocationError();
+
+	mt->name = "numa";
+	mt->flags = parent->flags;
+	mt->alloc = memory_numa_alloc;
+	mt->free = memory_numa_free;
+	mt->alignment = parent->alignment;
+
+	mt->_vd = malloc(sizeof(struct memory_numa));
+	if (!mt->_vd)
+		throw MemoryAllocationError();
+
+	struct memory_numa *mn = (struct memory_numa *) mt->_vd;
+
+	mn->node = node;
+	mn->policy = policy;
+	mn->parent = parent;
+
+	return mt;
+}
+
+void memory_numa_destroy(struct memory_type *m)
+{
+	free(m->_vd);
+	free(m);
+}
+
+/** Get the NUMA node of a single CPU from sysfs. */
+static int memory_numa_node_of_cpu(int cpu)
+{
+	char path[64];
+	int node = -1;
+	struct dirent *e;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+
+	DIR *dir = opendir(path);
+	if (!dir)
+		return -1;
+
+	while ((e = readdir(dir))) {
+		if (sscanf(e->d_name, "node%d", &node) == 1)
+			break;
+	}
+
+	closedir(dir);
+
+	return e ? node : -1;
+}
+
+int memory_numa_node(int cpus)
+{
+	int node = -1;
+
+	for (unsigned cpu = 0; cpu < sizeof(cpus) * CHAR_BIT; cpu++) {
+		if (!(cpus & (1u << cpu)))
+			continue;
+
+		int n = memory_numa_node_of_cpu(cpu);
+		if (n < 0 || (node >= 0 && n != node))
+			return -1;
+
+		node = n;
+	}
+
+	return node;
+}
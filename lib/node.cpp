@@ -469,6 +469,7 @@ int node_read(struct vnode *n, struct sample * smps[], unsigned cnt)
 		nread += readd;
 	}
 
+	sample_trace_many(smps, nread, SampleTraceStage::READ);
 
 #ifdef WITH_HOOKS
 	/* Run read hooks */
@@ -476,6 +477,8 @@ int node_read(struct vnode *n, struct sample * smps[], unsigned cnt)
 	if (rread < 0)
 		return rread;
 
+	sample_trace_many(smps, rread, SampleTraceStage::HOOKS_IN);
+
 	int skipped = nread - rread;
 	if (skipped > 0) {
 		if (n->stats != nullptr)
@@ -488,6 +491,8 @@ int node_read(struct vnode *n, struct sample * smps[], unsigned cnt)
 
 	return rread;
 #else
+	sample_trace_many(smps, nread, SampleTraceStage::HOOKS_IN);
+
 	n->logger->debug("Received {} samples", nread);
 
 	return nread;
@@ -513,6 +518,8 @@ int node_write(struct vnode *n, struct sample * smps[], unsigned cnt)
 		return cnt;
 #endif /* WITH_HOOKS */
 
+	sample_trace_many(smps, cnt, SampleTraceStage::HOOKS_OUT);
+
 	vect = node_type(n)->vectorize;
 	if (!vect)
 		vect = cnt;
@@ -522,11 +529,19 @@ int node_write(struct vnode *n, struct sample * smps[], unsigned cnt)
 		sent = node_type(n)->write(n, &smps[nsent], tosend);
 		if (sent < 0)
 			return sent;
+		else if (sent == 0)
+			break; /* The node can not take any more samples at the moment */
 
 		nsent += sent;
 		n->logger->debug("Sent {} samples", sent);
 	}
 
+	if (n->stats) {
+		sample_trace_many(smps, nsent, SampleTraceStage::WRITTEN);
+
+		n->stats->updateTrace(smps, nsent);
+	}
+
 	return nsent;
 }
 
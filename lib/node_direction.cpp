@@ -57,6 +57,8 @@ int node_direction_init(struct vnode_direction *nd, enum NodeDir dir, struct vno
 	nd->enabled = 1;
 	nd->vectorize = 1;
 	nd->builtin = 1;
+	nd->affinity = 0;
+	nd->priority = 0;
 	nd->path = nullptr;
 
 #ifdef WITH_HOOKS
@@ -107,12 +109,14 @@ int node_direction_parse(struct vnode_direction *nd, struct vnode *n, json_t *js
 
 	nd->config = json;
 
-	ret = json_unpack_ex(json, &err, 0, "{ s?: o, s?: o, s?: i, s?: b, s?: b }",
+	ret = json_unpack_ex(json, &err, 0, "{ s?: o, s?: o, s?: i, s?: b, s?: b, s?: i, s?: i }",
 		"hooks", &json_hooks,
 		"signals", &json_signals,
 		"vectorize", &nd->vectorize,
 		"builtin", &nd->builtin,
-		"enabled", &nd->enabled
+		"enabled", &nd->enabled,
+		"affinity", &nd->affinity,
+		"priority", &nd->priority
 	);
 	if (ret)
 		throw ConfigError(json, err, "node-config-node-in");
@@ -174,6 +178,9 @@ int node_direction_check(struct vnode_direction *nd, struct vnode *n)
 	if (nd->vectorize <= 0)
 		throw RuntimeError("Invalid setting 'vectorize' with value {}. Must be natural number!", nd->vectorize);
 
+	if (nd->priority < 0 || nd->priority > 99)
+		throw RuntimeError("Invalid setting 'priority' with value {}. Must be in range [0, 99]!", nd->priority);
+
 	nd->state = State::CHECKED;
 
 	return 0;
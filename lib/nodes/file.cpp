@@ -93,8 +93,10 @@ int file_parse(struct vnode *n, json_t *json)
 	const char *eof = nullptr;
 	const char *epoch = nullptr;
 	double epoch_flt = 0;
+	double seek_flt = 0;
+	json_int_t rotate_size = 0;
 
-	ret = json_unpack_ex(json, &err, 0, "{ s: s, s?: o, s?: { s?: s, s?: F, s?: s, s?: F, s?: i, s?: i }, s?: { s?: b, s?: i } }",
+	ret = json_unpack_ex(json, &err, 0, "{ s: s, s?: o, s?: { s?: s, s?: F, s?: s, s?: F, s?: i, s?: i, s?: F }, s?: { s?: b, s?: i, s?: b, s?: i, s?: b, s?: I, s?: F } }",
 		"uri", &uri_tmpl,
 		"format", &json_format,
 		"in",
@@ -104,22 +106,56 @@ int file_parse(struct vnode *n, json_t *json)
 			"epoch", &epoch_flt,
 			"buffer_size", &f->buffer_size_in,
 			"skip", &f->skip_lines,
+			"seek", &seek_flt,
 		"out",
 			"flush", &f->flush,
-			"buffer_size", &f->buffer_size_out
+			"buffer_size", &f->buffer_size_out,
+			"async", &f->async,
+			"buffers", &f->async_buffers,
+			"direct", &f->async_direct,
+			"rotate_size", &rotate_size,
+			"rotate_interval", &f->rotate_interval
 	);
 	if (ret)
 		throw ConfigError(json, err, "node-config-node-file");
 
 	f->epoch = time_from_double(epoch_flt);
+	f->seek = time_from_double(seek_flt);
+	f->rotate_size = rotate_size;
 	f->uri_tmpl = uri_tmpl ? strdup(uri_tmpl) : nullptr;
 
 	/* Format */
-	f->formatter = json_format
-			? FormatFactory::make(json_format)
-			: FormatFactory::make("villas.human");
-	if (!f->formatter)
-		throw ConfigError(json_format, "node-config-node-file-format", "Invalid format configuration");
+	if (json_is_string(json_format) && !strcmp(json_string_value(json_format), "villas.columnar")) {
+		/* Columnar files are mapped into memory rather than parsed by a formatter */
+		f->columnar = 1;
+		f->formatter = nullptr;
+	}
+	else {
+		f->formatter = json_format
+				? FormatFactory::make(json_format)
+				: FormatFactory::make("villas.human");
+		if (!f->formatter)
+			throw ConfigError(json_format, "node-config-node-file-format", "Invalid format configuration");
+
+		if (seek_flt)
+			throw ConfigError(json, "node-config-node-file-seek", "Setting 'seek' is only supported by the 'villas.columnar' format");
+	}
+
+	if (f->async) {
+		if (f->columnar)
+			throw ConfigError(json, "node-config-node-file-async", "Asynchronous recording is not supported by the 'villas.columnar' format");
+
+		if (f->flush)
+			throw ConfigError(json, "node-config-node-file-async", "Setting 'flush' can not be combined with asynchronous recording");
+
+		if (f->async_buffers < 2)
+			throw ConfigError(json, "node-config-node-file-async", "Asynchronous recording requires at least two buffers");
+
+		if (!f->buffer_size_out)
+			f->buffer_size_out = FILE_ASYNC_BUFFER_SIZE;
+	}
+	else if (rotate_size || f->rotate_interval)
+		throw ConfigError(json, "node-config-node-file-rotate", "File rotation requires asynchronous recording");
 
 	if (eof) {
 		if      (!strcmp(eof, "exit") || !strcmp(eof, "stop"))
@@ -216,6 +252,30 @@ char * file_print(struct vnode *n)
 	if (f->rate)
 		strcatf(&buf, ", in.rate=%.1f", f->rate);
 
+	if (f->async) {
+		strcatf(&buf, ", out.async=yes, out.buffers=%u, out.buffer_size=%zu, out.direct=%s",
+			f->async_buffers,
+			f->buffer_size_out,
+			f->async_direct ? "yes" : "no"
+		);
+
+		if (f->rotate_size)
+			strcatf(&buf, ", out.rotate_size=%zu", f->rotate_size);
+
+		if (f->rotate_interval)
+			strcatf(&buf, ", out.rotate_interval=%.1f", f->rotate_interval);
+
+		if (f->fa.files)
+			strcatf(&buf, ", files=%u, dropped=%" PRIu64 ", high_water=%u", f->fa.files, f->fa.dropped, f->fa.high_water);
+	}
+
+	if (f->columnar) {
+		strcatf(&buf, ", format=villas.columnar");
+
+		if (f->seek.tv_sec || f->seek.tv_nsec)
+			strcatf(&buf, ", in.seek=%.2f", time_to_double(&f->seek));
+	}
+
 	if (f->first.tv_sec || f->first.tv_nsec)
 		strcatf(&buf, ", first=%.2f", time_to_double(&f->first));
 
@@ -236,6 +296,45 @@ char * file_print(struct vnode *n)
 	return buf;
 }
 
+static int file_start_columnar(struct vnode *n)
+{
+	struct file *f = (struct file *) n->_vd;
+
+	int ret;
+
+	/* Nodes which are only used as a path source replay an existing recording */
+	bool record = n->out.enabled && (vlist_length(&n->destinations) > 0 || vlist_length(&n->sources) == 0);
+
+	ret = file_columnar_open(&f->cf, f->uri, &n->in.signals, record);
+	if (ret == -EPROTO)
+		throw RuntimeError("The signals of the columnar file '{}' do not match the node", f->uri);
+	else if (ret)
+		throw RuntimeError("Failed to open columnar file '{}': {}", f->uri, strerror(-ret));
+
+	/* Create timer. It expires once for each batch of 'vectorize' samples */
+	f->task.setRate(f->rate / MAX(n->in.vectorize, 1U));
+
+	/* Seeking and skipping do not need to read the samples in between */
+	f->start = (struct file_columnar_pos) { 0, 0 };
+
+	if (f->seek.tv_sec || f->seek.tv_nsec)
+		f->start = file_columnar_find(&f->cf, &f->seek);
+
+	f->start = file_columnar_skip(&f->cf, f->start, f->skip_lines);
+	f->cf.pos = f->start;
+
+	/* Get timestamp of first sample which is replayed */
+	if (f->epoch_mode != file::EpochMode::ORIGINAL) {
+		ret = file_columnar_peek(&f->cf, &f->first);
+		if (ret)
+			n->logger->warn("Empty file");
+		else
+			f->offset = file_calc_offset(&f->first, &f->epoch, f->epoch_mode);
+	}
+
+	return 0;
+}
+
 int file_start(struct vnode *n)
 {
 	struct file *f = (struct file *) n->_vd;
@@ -269,16 +368,28 @@ int file_start(struct vnode *n)
 
 	free(cpy);
 
+	if (f->columnar)
+		return file_start_columnar(n);
+
 	/* Open file */
 
 	f->formatter->start(&n->in.signals);
 
-	f->stream_in = fopen(f->uri, "r");
-	if (!f->stream_in)
-		return -1;
+	if (f->async) {
+		ret = file_async_init(&f->fa, f->uri_tmpl, f->buffer_size_out, f->async_buffers, f->async_direct, f->rotate_size, f->rotate_interval);
+		if (ret)
+			throw RuntimeError("Failed to start asynchronous recording: {}", strerror(-ret));
 
-	f->stream_out = fopen(f->uri, "a+");
-	if (!f->stream_out)
+		f->stream_out = f->fa.stream;
+	}
+	else {
+		f->stream_out = fopen(f->uri, "a+");
+		if (!f->stream_out)
+			return -1;
+	}
+
+	f->stream_in = fopen(f->async ? f->fa.uri : f->uri, "r");
+	if (!f->stream_in)
 		return -1;
 
 	if (f->buffer_size_in) {
@@ -287,7 +398,7 @@ int file_start(struct vnode *n)
 			return ret;
 	}
 
-	if (f->buffer_size_out) {
+	if (f->buffer_size_out && !f->async) {
 		ret = setvbuf(f->stream_out, nullptr, _IOFBF, f->buffer_size_out);
 		if (ret)
 			return ret;
@@ -334,10 +445,28 @@ int file_stop(struct vnode *n)
 {
 	struct file *f = (struct file *) n->_vd;
 
+	int ret;
+
 	f->task.stop();
 
-	fclose(f->stream_in);
-	fclose(f->stream_out);
+	if (f->columnar) {
+		ret = file_columnar_close(&f->cf);
+		if (ret)
+			throw RuntimeError("Failed to close columnar file '{}': {}", f->uri, strerror(-ret));
+	}
+	else if (f->async) {
+		fclose(f->stream_in);
+
+		ret = file_async_destroy(&f->fa);
+		if (ret)
+			throw RuntimeError("Failed to write recording: {}", strerror(-ret));
+
+		n->logger->info("Recorded into {} file(s): dropped={}, high_water={}/{} buffers", f->fa.files, f->fa.dropped, f->fa.high_water, f->async_buffers);
+	}
+	else {
+		fclose(f->stream_in);
+		fclose(f->stream_out);
+	}
 
 	delete f->formatter;
 	delete f->uri;
@@ -345,42 +474,155 @@ int file_stop(struct vnode *n)
 	return 0;
 }
 
-int file_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
+/** Handle the end of the input file.
+ *
+ * @retval 0 The caller should retry reading.
+ * @retval -1 The node is stopping.
+ */
+static int file_eof(struct vnode *n)
+{
+	struct file *f = (struct file *) n->_vd;
+	int ret;
+
+	switch (f->eof_mode) {
+		case file::EOFBehaviour::REWIND:
+			n->logger->info("Rewind input file");
+
+			f->offset = file_calc_offset(&f->first, &f->epoch, f->epoch_mode);
+
+			if (f->columnar)
+				f->cf.pos = f->start;
+			else
+				rewind(f->stream_in);
+
+			return 0;
+
+		case file::EOFBehaviour::SUSPEND:
+			/* We wait 10ms before fetching again. */
+			usleep(100000);
+
+			/* Try to download more data if this is a remote file. */
+			if (f->columnar) {
+				ret = file_columnar_remap(&f->cf);
+				if (ret)
+					throw RuntimeError("Failed to map columnar file '{}': {}", f->uri, strerror(-ret));
+			}
+			else
+				clearerr(f->stream_in);
+
+			return 0;
+
+		case file::EOFBehaviour::STOP:
+		default:
+			n->logger->info("Reached end-of-file.");
+
+			n->state = State::STOPPING;
+
+			return -1;
+	}
+}
+
+/** Read up to \p cnt samples from a columnar recording.
+ *
+ * The end of the recording is only handled if no sample has been read yet.
+ * Otherwise the samples which have been read so far are returned first.
+ */
+static int file_read_columnar_many(struct vnode *n, struct sample * const smps[], unsigned cnt)
+{
+	struct file *f = (struct file *) n->_vd;
+	int ret;
+
+retry:	ret = file_columnar_read(&f->cf, smps, cnt, &n->in.signals);
+	if (ret == 0) {
+		ret = file_eof(n);
+		if (ret)
+			return ret;
+
+		goto retry;
+	}
+
+	return ret;
+}
+
+static int file_read_columnar(struct vnode *n, struct sample * const smps[], unsigned cnt)
 {
 	struct file *f = (struct file *) n->_vd;
 	int ret;
 	uint64_t steps;
 
-	assert(cnt == 1);
+	/* We dont wait in FILE_EPOCH_ORIGINAL mode */
+	if (f->epoch_mode == file::EpochMode::ORIGINAL)
+		return file_read_columnar_many(n, smps, cnt);
 
-retry:	ret = f->formatter->scan(f->stream_in, smps, cnt);
-	if (ret <= 0) {
-		if (feof(f->stream_in)) {
-			switch (f->eof_mode) {
-				case file::EOFBehaviour::REWIND:
-					n->logger->info("Rewind input file");
+	if (f->rate) {
+		/* The timer expires once per batch of 'vectorize' samples. See file_start_columnar() */
+		unsigned batch = MAX(n->in.vectorize, 1U);
 
-					f->offset = file_calc_offset(&f->first, &f->epoch, f->epoch_mode);
-					rewind(f->stream_in);
-					goto retry;
+		steps = f->task.wait();
+		if (steps == 0)
+			throw SystemError("Failed to wait for timer");
+		else if (steps > 1)
+			n->logger->warn("Missed steps: {}", (steps - 1) * batch);
 
-				case file::EOFBehaviour::SUSPEND:
-					/* We wait 10ms before fetching again. */
-					usleep(100000);
+		ret = file_read_columnar_many(n, smps, MIN(batch, cnt));
+		if (ret < 0)
+			return ret;
 
-					/* Try to download more data if this is a remote file. */
-					clearerr(f->stream_in);
-					goto retry;
+		/* Spread the timestamps of the batch over the periods which it covers */
+		struct timespec now = time_now();
+		for (int i = 0; i < ret; i++) {
+			struct timespec ago = time_from_double((ret - 1 - i) / f->rate);
 
-				case file::EOFBehaviour::STOP:
-					n->logger->info("Reached end-of-file.");
+			smps[i]->ts.origin = time_diff(&ago, &now);
+		}
+	}
+	else {
+		ret = file_read_columnar_many(n, smps, 1);
+		if (ret < 0)
+			return ret;
 
-					n->state = State::STOPPING;
+		smps[0]->ts.origin = time_add(&smps[0]->ts.origin, &f->offset);
 
-					return -1;
+		f->task.setNext(&smps[0]->ts.origin);
+		steps = f->task.wait();
+		if (steps == 0)
+			throw SystemError("Failed to wait for timer");
+		else if (steps != 1)
+			n->logger->warn("Missed steps: {}", steps - 1);
+
+		/* Add the following samples which are already due */
+		struct timespec ts, now = time_now();
+		while ((unsigned) ret < cnt && !file_columnar_peek(&f->cf, &ts)) {
+			ts = time_add(&ts, &f->offset);
+			if (time_delta(&now, &ts) > 0)
+				break;
+
+			ret += file_columnar_read(&f->cf, &smps[ret], 1, &n->in.signals);
+			smps[ret - 1]->ts.origin = ts;
+		}
+	}
 
-				default: { }
-			}
+	return ret;
+}
+
+int file_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
+{
+	struct file *f = (struct file *) n->_vd;
+	int ret;
+	uint64_t steps;
+
+	if (f->columnar)
+		return file_read_columnar(n, smps, cnt);
+
+	/* Text formats are read one sample at a time. node_read() calls us until cnt samples are read */
+retry:	ret = f->formatter->scan(f->stream_in, smps, 1);
+	if (ret <= 0) {
+		if (feof(f->stream_in)) {
+			ret = file_eof(n);
+			if (ret)
+				return ret;
+
+			goto retry;
 		}
 		else
 			n->logger->warn("Failed to read messages: reason={}", ret);
@@ -390,7 +632,7 @@ retry:	ret = f->formatter->scan(f->stream_in, smps, cnt);
 
 	/* We dont wait in FILE_EPOCH_ORIGINAL mode */
 	if (f->epoch_mode == file::EpochMode::ORIGINAL)
-		return cnt;
+		return 1;
 
 	if (f->rate) {
 		steps = f->task.wait();
@@ -410,7 +652,7 @@ retry:	ret = f->formatter->scan(f->stream_in, smps, cnt);
 	else if (steps != 1)
 		n->logger->warn("Missed steps: {}", steps - 1);
 
-	return cnt;
+	return 1;
 }
 
 int file_write(struct vnode *n, struct sample * const smps[], unsigned cnt)
@@ -418,7 +660,48 @@ int file_write(struct vnode *n, struct sample * const smps[], unsigned cnt)
 	int ret;
 	struct file *f = (struct file *) n->_vd;
 
-	assert(cnt == 1);
+	if (f->columnar) {
+		ret = file_columnar_write(&f->cf, smps, cnt);
+		if (ret < 0)
+			return ret;
+
+		if (f->flush) {
+			ret = file_columnar_flush(&f->cf);
+			if (ret)
+				return ret;
+		}
+
+		return cnt;
+	}
+
+	if (f->async) {
+		/* The samples are only copied into the buffers. The writer thread does the I/O. */
+		int error = f->fa.error.exchange(0);
+		if (error)
+			n->logger->error("Failed to write recording: {}", strerror(-error));
+
+		unsigned dropped = 0;
+		for (unsigned i = 0; i < cnt; i++) {
+			ret = file_async_reserve(&f->fa, FILE_ASYNC_SAMPLE_LEN);
+			if (ret) {
+				dropped++;
+				continue;
+			}
+
+			ret = f->formatter->print(f->stream_out, smps[i]);
+			if (ret < 0)
+				return ret;
+		}
+
+		if (n->stats) {
+			n->stats->update(Stats::Metric::FILE_BUFFERS_PENDING, f->fa.pending);
+
+			if (dropped)
+				n->stats->update(Stats::Metric::FILE_SMPS_DROPPED, dropped);
+		}
+
+		return cnt;
+	}
 
 	ret = f->formatter->print(f->stream_out, smps, cnt);
 	if (ret < 0)
@@ -440,7 +723,7 @@ int file_poll_fds(struct vnode *n, int fds[])
 		return 1;
 	}
 	else if (f->epoch_mode == file::EpochMode::ORIGINAL) {
-		fds[0] = fileno(f->stream_in);
+		fds[0] = f->columnar ? f->cf.fd : fileno(f->stream_in);
 
 		return 1;
 	}
@@ -462,6 +745,13 @@ int file_init(struct vnode *n)
 	f->buffer_size_in = 0;
 	f->buffer_size_out = 0;
 	f->skip_lines = 0;
+	f->columnar = 0;
+	f->async = 0;
+	f->async_buffers = 4;
+	f->async_direct = 1;
+	f->rotate_size = 0;
+	f->rotate_interval = 0;
+	f->fa.files = 0;
 
 	return 0;
 }
@@ -481,7 +771,7 @@ __attribute__((constructor(110)))
 static void register_plugin() {
 	p.name		= "file";
 	p.description	= "support for file log / replay node type";
-	p.vectorize	= 1;
+	p.vectorize	= 0;
 	p.size		= sizeof(struct file);
 	p.init		= file_init;
 	p.destroy	= file_destroy;
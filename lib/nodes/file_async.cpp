@@ -0,0 +1,411 @@
+/** Asynchronous recording for the file node-type.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <villas/nodes/file_async.hpp>
+#include <villas/memory.h>
+#include <villas/timing.h>
+#include <villas/utils.hpp>
+#include <villas/kernel/kernel.hpp>
+
+#define FILE_ASYNC_MAX_PATHLEN	512
+
+using namespace villas;
+
+/* Hand the current buffer over to the writer thread */
+static void file_async_submit(struct file_async *a)
+{
+	int ret __attribute__((unused));
+
+	unsigned pending = ++a->pending;
+	if (pending > a->high_water)
+		a->high_water = pending;
+
+	/* The queue can hold all buffers. Hence this never fails. */
+	ret = queue_signalled_push(&a->full, a->current);
+
+	a->current = nullptr;
+}
+
+static ssize_t file_async_cookie_write(void *cookie, const char *buf, size_t size)
+{
+	auto *a = (struct file_async *) cookie;
+	size_t off = 0;
+
+	while (off < size) {
+		if (!a->current) {
+			/* file_async_reserve() makes sure that this only happens for oversized samples */
+			if (queue_pull(&a->free, (void **) &a->current) != 1) {
+				a->current = nullptr;
+				break;
+			}
+		}
+
+		struct file_async_buffer *b = a->current;
+		size_t len = MIN(size - off, a->buffer_size - b->len);
+
+		memcpy(b->data + b->len, buf + off, len);
+		b->len += len;
+		off += len;
+
+		/* Only completely filled buffers are submitted here, so that the offsets remain aligned */
+		if (b->len == a->buffer_size)
+			file_async_submit(a);
+	}
+
+	a->file_bytes += off;
+
+	/* We pretend to have written everything to keep the stream usable */
+	return size;
+}
+
+static int file_async_open(struct file_async *a)
+{
+	int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+	struct timespec now = time_now();
+	struct stat st;
+	struct tm tm;
+	char uri[FILE_ASYNC_MAX_PATHLEN];
+
+	gmtime_r(&now.tv_sec, &tm);
+	strftime(uri, sizeof(uri), a->uri_tmpl, &tm);
+
+	/* Only the first file continues an existing one. Rotated files get a suffix
+	 * if the template does not contain a timestamp with sufficient resolution. */
+	if (a->files > 0) {
+		size_t len = strlen(uri);
+
+		for (unsigned i = 1; access(uri, F_OK) == 0; i++)
+			snprintf(uri + len, sizeof(uri) - len, ".%u", i);
+	}
+
+	free(a->uri);
+	a->uri = strdup(uri);
+	a->files++;
+
+	a->fd_direct = false;
+	if (a->direct) {
+		a->fd = open(uri, flags | O_DIRECT, 0644);
+		if (a->fd >= 0)
+			a->fd_direct = true;
+		else if (errno != EINVAL) /* Some file systems such as tmpfs do not support O_DIRECT */
+			return -errno;
+	}
+
+	if (!a->fd_direct) {
+		a->fd = open(uri, flags, 0644);
+		if (a->fd < 0)
+			return -errno;
+	}
+
+	/* We append to existing files */
+	if (fstat(a->fd, &st))
+		return -errno;
+
+	a->offset = st.st_size;
+
+	/* O_DIRECT requires aligned offsets */
+	if (a->fd_direct && a->offset % kernel::getPageSize()) {
+		close(a->fd);
+
+		a->fd = open(uri, flags, 0644);
+		if (a->fd < 0)
+			return -errno;
+
+		a->fd_direct = false;
+	}
+
+	return 0;
+}
+
+static int file_async_write(struct file_async *a, struct file_async_buffer *b)
+{
+	size_t len = b->len;
+	size_t pgsz = kernel::getPageSize();
+
+	/* The last buffer of a file is padded to the alignment required
+	 * by O_DIRECT. The file is truncated afterwards. */
+	if (a->fd_direct && len % pgsz) {
+		size_t padded = ALIGN(len, pgsz);
+
+		memset(b->data + len, 0, padded - len);
+		len = padded;
+	}
+
+	for (size_t off = 0; off < len; ) {
+		ssize_t ret = pwrite(a->fd, b->data + off, len - off, a->offset + off);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return -errno;
+		}
+
+		off += ret;
+	}
+
+	if (len != b->len) {
+		if (ftruncate(a->fd, a->offset + b->len))
+			return -errno;
+	}
+
+	a->offset += b->len;
+
+	return 0;
+}
+
+static void * file_async_writer(void *ctx)
+{
+	auto *a = (struct file_async *) ctx;
+	struct file_async_buffer *b;
+	int ret;
+
+	for (;;) {
+		ret = queue_signalled_pull(&a->full, (void **) &b);
+		if (ret <= 0)
+			break;
+
+		if (a->fd >= 0 && b->len > 0) {
+			ret = file_async_write(a, b);
+			if (ret)
+				a->error = ret;
+		}
+
+		if (b->rotate || b->last) {
+			if (a->fd >= 0)
+				close(a->fd);
+
+			a->fd = -1;
+
+			if (b->rotate) {
+				ret = file_async_open(a);
+				if (ret)
+					a->error = ret;
+			}
+		}
+
+		/* The stop request of file_async_destroy() is not part of the free buffers */
+		if (b->last)
+			break;
+
+		b->len = 0;
+		b->rotate = false;
+
+		a->pending--;
+
+		ret = queue_push(&a->free, b);
+		if (ret != 1)
+			break;
+	}
+
+	return nullptr;
+}
+
+int file_async_init(struct file_async *a, const char *uri_tmpl, size_t buffer_size, unsigned buffer_count, bool direct, size_t rotate_size, double rotate_interval)
+{
+	int ret;
+	size_t pgsz = kernel::getPageSize();
+
+	a->uri_tmpl = uri_tmpl;
+	a->buffer_size = ALIGN(buffer_size, pgsz);
+	a->buffer_count = buffer_count;
+	a->direct = direct;
+	a->rotate_size = rotate_size;
+	a->rotate_interval = rotate_interval;
+
+	a->fd = -1;
+	a->uri = nullptr;
+	a->files = 0;
+	a->error = 0;
+	a->current = nullptr;
+	a->file_bytes = 0;
+	a->file_started = time_now();
+	a->pending = 0;
+	a->high_water = 0;
+	a->dropped = 0;
+
+	if (buffer_count < 2)
+		return -EINVAL;
+
+	a->memory = (char *) memory_alloc_aligned(a->buffer_size * buffer_count, pgsz, memory_default);
+	if (!a->memory)
+		return -ENOMEM;
+
+	/* The additional buffer carries the stop request of file_async_destroy() */
+	a->buffers = new struct file_async_buffer[buffer_count + 1];
+
+	ret = queue_init(&a->free, LOG2_CEIL(buffer_count));
+	if (ret) {
+		ret = -ENOMEM;
+		goto err_buffers;
+	}
+
+	ret = queue_signalled_init(&a->full, LOG2_CEIL(buffer_count + 1));
+	if (ret) {
+		ret = -ENOMEM;
+		goto err_free;
+	}
+
+	for (unsigned i = 0; i <= buffer_count; i++) {
+		struct file_async_buffer *b = &a->buffers[i];
+
+		b->data = i < buffer_count ? a->memory + i * a->buffer_size : nullptr;
+		b->len = 0;
+		b->rotate = false;
+		b->last = i == buffer_count;
+
+		if (i < buffer_count)
+			queue_push(&a->free, b);
+	}
+
+	cookie_io_functions_t funcs;
+
+	funcs = {
+		.read = nullptr,
+		.write = file_async_cookie_write,
+		.seek = nullptr,
+		.close = nullptr
+	};
+
+	/* Samples are copied into the buffers right away. They provide the buffering. */
+	a->stream = fopencookie(a, "w", funcs);
+	if (!a->stream) {
+		ret = -errno;
+		goto err_full;
+	}
+
+	setvbuf(a->stream, nullptr, _IONBF, 0);
+
+	/* Errors with the first file are reported to the caller */
+	ret = file_async_open(a);
+	if (ret)
+		goto err_open;
+
+	ret = pthread_create(&a->thread, nullptr, file_async_writer, a);
+	if (ret) {
+		ret = -ret;
+		goto err_open;
+	}
+
+	return 0;
+
+err_open:
+	if (a->fd >= 0)
+		close(a->fd);
+
+	free(a->uri);
+	fclose(a->stream);
+err_full:
+	queue_signalled_destroy(&a->full);
+err_free:
+	queue_destroy(&a->free);
+err_buffers:
+	delete[] a->buffers;
+	memory_free(a->memory);
+
+	return ret;
+}
+
+int file_async_destroy(struct file_async *a)
+{
+	int ret;
+
+	/* Write the partially filled buffer */
+	if (a->current)
+		file_async_submit(a);
+
+	/* The queue has room for the stop request in addition to all buffers.
+	 * The writer thread handles all buffers in front of it before it exits. */
+	ret = queue_signalled_push(&a->full, &a->buffers[a->buffer_count]);
+	if (ret != 1)
+		return -EIO;
+
+	ret = pthread_join(a->thread, nullptr);
+	if (ret)
+		return -ret;
+
+	fclose(a->stream);
+
+	ret = queue_signalled_destroy(&a->full);
+	if (ret)
+		return ret;
+
+	ret = queue_destroy(&a->free);
+	if (ret)
+		return ret;
+
+	delete[] a->buffers;
+
+	ret = memory_free(a->memory);
+	if (ret)
+		return ret;
+
+	free(a->uri);
+
+	return a->error;
+}
+
+int file_async_reserve(struct file_async *a, size_t len)
+{
+	bool rotate = false;
+
+	if (a->file_bytes > 0) {
+		if (a->rotate_size && a->file_bytes >= a->rotate_size)
+			rotate = true;
+
+		if (a->rotate_interval) {
+			struct timespec now = time_now();
+
+			if (time_delta(&a->file_started, &now) >= a->rotate_interval)
+				rotate = true;
+		}
+	}
+
+	if (rotate) {
+		/* We need a buffer to carry the request to the writer thread. Otherwise we try again with the next sample. */
+		if (a->current || queue_pull(&a->free, (void **) &a->current) == 1) {
+			a->current->rotate = true;
+			file_async_submit(a);
+
+			a->file_bytes = 0;
+			a->file_started = time_now();
+		}
+		else
+			a->current = nullptr;
+	}
+
+	size_t avail = queue_available(&a->free) * a->buffer_size;
+	if (a->current)
+		avail += a->buffer_size - a->current->len;
+
+	if (avail < len) {
+		a->dropped++;
+		return -1;
+	}
+
+	return 0;
+}
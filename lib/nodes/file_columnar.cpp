@@ -0,0 +1,464 @@
+/** Memory-mapped columnar recordings for the file node-type.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <villas/nodes/file_columnar.hpp>
+#include <villas/signal.h>
+#include <villas/utils.hpp>
+#include <villas/kernel/kernel.hpp>
+
+using namespace villas;
+
+static void file_columnar_layout(struct file_columnar *c, unsigned rows)
+{
+	c->offsets[0] = sizeof(struct file_columnar_block);	/* ts_origin */
+	c->offsets[1] = c->offsets[0] + rows * sizeof(int64_t);	/* sequence */
+	c->offsets[2] = c->offsets[1] + rows * sizeof(uint64_t);	/* flags */
+	c->offsets[3] = c->offsets[2] + rows * sizeof(uint32_t);	/* length */
+	c->columns = ALIGN(c->offsets[3] + rows * sizeof(uint32_t), 64);
+}
+
+static struct file_columnar_block * file_columnar_block(const struct file_columnar *c, size_t block)
+{
+	return (struct file_columnar_block *) ((char *) c->header + c->header->header_len + block * c->header->block_len);
+}
+
+template<typename T>
+static T * file_columnar_array(const struct file_columnar *c, struct file_columnar_block *b, int i)
+{
+	return (T *) ((char *) b + c->offsets[i]);
+}
+
+static union signal_data * file_columnar_column(const struct file_columnar *c, struct file_columnar_block *b, unsigned col)
+{
+	return (union signal_data *) ((char *) b + c->columns + col * c->header->block_rows * sizeof(union signal_data));
+}
+
+/* The number of rows is written last by file_columnar_flush(). */
+static unsigned file_columnar_rows(const struct file_columnar *c, size_t block)
+{
+	unsigned rows = __atomic_load_n(&file_columnar_block(c, block)->rows, __ATOMIC_ACQUIRE);
+
+	return MIN(rows, c->header->block_rows);
+}
+
+static int64_t file_columnar_ts(const struct file_columnar *c, struct file_columnar_pos pos)
+{
+	return file_columnar_array<int64_t>(c, file_columnar_block(c, pos.block), 0)[pos.row];
+}
+
+/* Move a position past the end of a block to the beginning of the next one */
+static struct file_columnar_pos file_columnar_normalize(const struct file_columnar *c, struct file_columnar_pos pos)
+{
+	while (pos.block < c->blocks && pos.row >= file_columnar_rows(c, pos.block)) {
+		/* Skip the remainder of partially written blocks except for the last one */
+		if (pos.block + 1 == c->blocks)
+			break;
+
+		pos.block++;
+		pos.row = 0;
+	}
+
+	return pos;
+}
+
+static bool file_columnar_eof(const struct file_columnar *c, struct file_columnar_pos pos)
+{
+	return pos.block >= c->blocks || pos.row >= file_columnar_rows(c, pos.block);
+}
+
+static int file_columnar_map(struct file_columnar *c)
+{
+	int ret;
+	struct stat st;
+
+	ret = fstat(c->fd, &st);
+	if (ret)
+		return -errno;
+
+	void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, c->fd, 0);
+	if (map == MAP_FAILED)
+		return -errno;
+
+	/* Recordings are replayed front to back */
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	if (c->header)
+		munmap(c->header, c->map_len);
+
+	c->header = (struct file_columnar_header *) map;
+	c->map_len = st.st_size;
+
+	/* A trailing block which has been torn by a crash is ignored */
+	if (c->header->block_len > 0 && c->map_len >= c->header->header_len)
+		c->blocks = (c->map_len - c->header->header_len) / c->header->block_len;
+	else
+		c->blocks = 0;
+
+	return 0;
+}
+
+/* Reject recordings whose blocks do not fit the layout given by the header */
+static int file_columnar_check(const struct file_columnar *c)
+{
+	size_t data_len = (size_t) c->header->signal_count * c->header->block_rows * sizeof(union signal_data);
+
+	if (c->header->block_len < c->columns + data_len)
+		return -EINVAL;
+
+	for (size_t i = 0; i < c->blocks; i++) {
+		struct file_columnar_block *b = file_columnar_block(c, i);
+		auto *length = file_columnar_array<uint32_t>(c, b, 3);
+
+		if (b->rows > c->header->block_rows)
+			return -EINVAL;
+
+		for (unsigned row = 0; row < b->rows; row++) {
+			if (length[row] > c->header->signal_count)
+				return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+int file_columnar_open(struct file_columnar *c, const char *uri, struct vlist *signals, bool record)
+{
+	int ret;
+	struct stat st;
+	size_t pgsz = kernel::getPageSize();
+
+	memset(c, 0, sizeof(*c));
+
+	/* A recording which is only replayed must exist already */
+	c->fd = record
+		? open(uri, O_RDWR | O_CREAT | O_CLOEXEC, 0644)
+		: open(uri, O_RDONLY | O_CLOEXEC);
+	if (c->fd < 0)
+		return -errno;
+
+	ret = fstat(c->fd, &st);
+	if (ret) {
+		ret = -errno;
+		goto err_close;
+	}
+
+	if (st.st_size == 0 && record) {
+		/* Start a new recording */
+		unsigned signal_count = vlist_length(signals);
+		size_t header_len = ALIGN(sizeof(struct file_columnar_header) + signal_count, pgsz);
+
+		auto *h = (struct file_columnar_header *) alloca(header_len);
+
+		memset(h, 0, header_len);
+		memcpy(h->magic, FILE_COLUMNAR_MAGIC, sizeof(h->magic));
+		h->version = FILE_COLUMNAR_VERSION;
+		h->byte_order = FILE_COLUMNAR_BYTE_ORDER;
+		h->header_len = header_len;
+		h->signal_count = signal_count;
+		h->block_rows = FILE_COLUMNAR_BLOCK_ROWS;
+
+		file_columnar_layout(c, h->block_rows);
+		h->block_len = ALIGN(c->columns + signal_count * h->block_rows * sizeof(union signal_data), pgsz);
+
+		for (unsigned i = 0; i < signal_count; i++) {
+			auto *sig = (struct signal *) vlist_at(signals, i);
+
+			h->types[i] = (uint8_t) sig->type;
+		}
+
+		ret = pwrite(c->fd, h, header_len, 0);
+		if (ret != (int) header_len) {
+			ret = ret < 0 ? -errno : -EIO;
+			goto err_close;
+		}
+	}
+	else if (st.st_size < (off_t) sizeof(struct file_columnar_header)) {
+		ret = -EINVAL;
+		goto err_close;
+	}
+
+	ret = file_columnar_map(c);
+	if (ret)
+		goto err_close;
+
+	if (memcmp(c->header->magic, FILE_COLUMNAR_MAGIC, sizeof(c->header->magic)) ||
+	    c->header->version != FILE_COLUMNAR_VERSION ||
+	    c->header->block_len == 0) {
+		ret = -EINVAL;
+		goto err_unmap;
+	}
+
+	if (c->header->header_len < sizeof(struct file_columnar_header) + c->header->signal_count ||
+	    c->header->header_len > c->map_len) {
+		ret = -EINVAL;
+		goto err_unmap;
+	}
+
+	if (c->header->byte_order != FILE_COLUMNAR_BYTE_ORDER ||
+	    c->header->signal_count != vlist_length(signals)) {
+		ret = -EPROTO;
+		goto err_unmap;
+	}
+
+	for (unsigned i = 0; i < c->header->signal_count; i++) {
+		auto *sig = (struct signal *) vlist_at(signals, i);
+
+		if (c->header->types[i] != (uint8_t) sig->type) {
+			ret = -EPROTO;
+			goto err_unmap;
+		}
+	}
+
+	file_columnar_layout(c, c->header->block_rows);
+
+	ret = file_columnar_check(c);
+	if (ret)
+		goto err_unmap;
+
+	if (!record)
+		return 0;
+
+	/* Continue recording in the last block if it has not been filled yet */
+	c->wblock = (struct file_columnar_block *) aligned_alloc(pgsz, c->header->block_len);
+	if (!c->wblock) {
+		ret = -ENOMEM;
+		goto err_unmap;
+	}
+
+	if (c->blocks > 0 && file_columnar_rows(c, c->blocks - 1) < c->header->block_rows) {
+		memcpy(c->wblock, file_columnar_block(c, c->blocks - 1), c->header->block_len);
+		c->wblock_off = c->header->header_len + (c->blocks - 1) * c->header->block_len;
+	}
+	else {
+		memset(c->wblock, 0, c->header->block_len);
+		c->wblock_off = c->header->header_len + c->blocks * c->header->block_len;
+	}
+
+	return 0;
+
+err_unmap:
+	munmap(c->header, c->map_len);
+err_close:
+	close(c->fd);
+
+	return ret;
+}
+
+int file_columnar_close(struct file_columnar *c)
+{
+	int ret;
+
+	ret = file_columnar_flush(c);
+	if (ret)
+		return ret;
+
+	free(c->wblock);
+	munmap(c->header, c->map_len);
+
+	ret = close(c->fd);
+	if (ret)
+		return -errno;
+
+	return 0;
+}
+
+int file_columnar_remap(struct file_columnar *c)
+{
+	struct stat st;
+	int ret;
+
+	ret = fstat(c->fd, &st);
+	if (ret)
+		return -errno;
+
+	if ((size_t) st.st_size == c->map_len)
+		return 0;
+
+	return file_columnar_map(c);
+}
+
+struct file_columnar_pos file_columnar_find(struct file_columnar *c, const struct timespec *ts)
+{
+	int64_t t = ts->tv_sec * 1000000000LL + ts->tv_nsec;
+
+	/* Find the last block which starts before the timestamp */
+	size_t lo = 0, hi = c->blocks;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (file_columnar_rows(c, mid) > 0 && file_columnar_ts(c, { mid, 0 }) <= t)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	struct file_columnar_pos pos = { lo > 0 ? lo - 1 : 0, 0 };
+	if (pos.block >= c->blocks)
+		return pos;
+
+	/* Find the first sample within the block which is not before the timestamp */
+	unsigned rows = file_columnar_rows(c, pos.block);
+	int64_t *first = file_columnar_array<int64_t>(c, file_columnar_block(c, pos.block), 0);
+
+	pos.row = std::lower_bound(first, first + rows, t) - first;
+
+	return file_columnar_normalize(c, pos);
+}
+
+struct file_columnar_pos file_columnar_skip(struct file_columnar *c, struct file_columnar_pos pos, size_t cnt)
+{
+	while (cnt > 0 && !file_columnar_eof(c, pos)) {
+		size_t avail = file_columnar_rows(c, pos.block) - pos.row;
+		size_t skip = MIN(avail, cnt);
+
+		pos.row += skip;
+		cnt -= skip;
+
+		pos = file_columnar_normalize(c, pos);
+	}
+
+	return pos;
+}
+
+int file_columnar_peek(struct file_columnar *c, struct timespec *ts)
+{
+	c->pos = file_columnar_normalize(c, c->pos);
+	if (file_columnar_eof(c, c->pos))
+		return -1;
+
+	int64_t t = file_columnar_ts(c, c->pos);
+
+	ts->tv_sec = t / 1000000000LL;
+	ts->tv_nsec = t % 1000000000LL;
+
+	return 0;
+}
+
+int file_columnar_read(struct file_columnar *c, struct sample * const smps[], unsigned cnt, struct vlist *signals)
+{
+	unsigned i = 0;
+
+	while (i < cnt) {
+		c->pos = file_columnar_normalize(c, c->pos);
+		if (file_columnar_eof(c, c->pos))
+			break;
+
+		struct file_columnar_block *b = file_columnar_block(c, c->pos.block);
+		unsigned rows = file_columnar_rows(c, c->pos.block);
+
+		/* Prefetch the next block when we enter a new one */
+		if (c->pos.row == 0 && c->pos.block + 1 < c->blocks)
+			madvise(file_columnar_block(c, c->pos.block + 1), c->header->block_len, MADV_WILLNEED);
+
+		auto *ts_origin = file_columnar_array<int64_t>(c, b, 0);
+		auto *sequence = file_columnar_array<uint64_t>(c, b, 1);
+		auto *flags = file_columnar_array<uint32_t>(c, b, 2);
+		auto *length = file_columnar_array<uint32_t>(c, b, 3);
+
+		for (; i < cnt && c->pos.row < rows; i++, c->pos.row++) {
+			struct sample *smp = smps[i];
+			unsigned row = c->pos.row;
+
+			smp->signals = signals;
+			smp->sequence = sequence[row];
+			smp->ts.origin.tv_sec = ts_origin[row] / 1000000000LL;
+			smp->ts.origin.tv_nsec = ts_origin[row] % 1000000000LL;
+			smp->flags = flags[row] & ((int) SampleFlags::HAS_TS_ORIGIN | (int) SampleFlags::HAS_SEQUENCE | (int) SampleFlags::HAS_DATA);
+			smp->length = MIN(MIN(length[row], c->header->signal_count), smp->capacity);
+
+			for (unsigned j = 0; j < smp->length; j++)
+				smp->data[j] = file_columnar_column(c, b, j)[row];
+		}
+	}
+
+	return i;
+}
+
+int file_columnar_write(struct file_columnar *c, const struct sample * const smps[], unsigned cnt)
+{
+	int ret;
+	struct file_columnar_block *b = c->wblock;
+
+	if (!b)
+		return -EBADF;
+
+	auto *ts_origin = file_columnar_array<int64_t>(c, b, 0);
+	auto *sequence = file_columnar_array<uint64_t>(c, b, 1);
+	auto *flags = file_columnar_array<uint32_t>(c, b, 2);
+	auto *length = file_columnar_array<uint32_t>(c, b, 3);
+
+	for (unsigned i = 0; i < cnt; i++) {
+		const struct sample *smp = smps[i];
+		unsigned row = b->rows;
+
+		ts_origin[row] = smp->ts.origin.tv_sec * 1000000000LL + smp->ts.origin.tv_nsec;
+		sequence[row] = smp->sequence;
+		flags[row] = smp->flags;
+		length[row] = MIN(smp->length, c->header->signal_count);
+
+		for (unsigned j = 0; j < length[row]; j++)
+			file_columnar_column(c, b, j)[row] = smp->data[j];
+
+		b->rows++;
+
+		if (b->rows == c->header->block_rows) {
+			ret = file_columnar_flush(c);
+			if (ret)
+				return ret;
+
+			memset(b, 0, c->header->block_len);
+			c->wblock_off += c->header->block_len;
+		}
+	}
+
+	return cnt;
+}
+
+int file_columnar_flush(struct file_columnar *c)
+{
+	ssize_t ret;
+	size_t hlen = sizeof(struct file_columnar_block);
+
+	if (!c->wblock || c->wblock->rows == 0)
+		return 0;
+
+	/* Readers which have mapped the file must not see the new number
+	 * of rows before the samples. Hence the block header is written last. */
+	ret = pwrite(c->fd, (char *) c->wblock + hlen, c->header->block_len - hlen, c->wblock_off + hlen);
+	if (ret != (ssize_t) (c->header->block_len - hlen))
+		return ret < 0 ? -errno : -EIO;
+
+	ret = pwrite(c->fd, c->wblock, hlen, c->wblock_off);
+	if (ret != (ssize_t) hlen)
+		return ret < 0 ? -errno : -EIO;
+
+	return 0;
+}
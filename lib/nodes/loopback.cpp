@@ -41,6 +41,7 @@ int loopback_init(struct vnode *n)
 
 	l->mode = QueueSignalledMode::AUTO;
 	l->queuelen = DEFAULT_QUEUE_LENGTH;
+	l->spin = -1;
 
 	return 0;
 }
@@ -53,9 +54,10 @@ int loopback_parse(struct vnode *n, json_t *json)
 	json_error_t err;
 	int ret;
 
-	ret = json_unpack_ex(json, &err, 0, "{ s?: i, s?: s }",
+	ret = json_unpack_ex(json, &err, 0, "{ s?: i, s?: s, s?: i }",
 		"queuelen", &l->queuelen,
-		"mode", &mode_str
+		"mode", &mode_str,
+		"spin", &l->spin
 	);
 	if (ret)
 		throw ConfigError(json, err, "node-config-node-loopback");
@@ -85,8 +87,15 @@ int loopback_parse(struct vnode *n, json_t *json)
 int loopback_prepare(struct vnode *n)
 {
 	struct loopback *l = (struct loopback *) n->_vd;
+	int ret;
+
+	ret = queue_signalled_init(&l->queue, l->queuelen, memory_default, l->mode, (int) QueueSignalledFlags::ADAPTIVE);
+	if (ret)
+		return ret;
 
-	return queue_signalled_init(&l->queue, l->queuelen, memory_default, l->mode);
+	queue_signalled_set_spin(&l->queue, l->spin);
+
+	return 0;
 }
 
 int loopback_destroy(struct vnode *n)
@@ -129,6 +138,9 @@ char * loopback_print(struct vnode *n)
 
 	strcatf(&buf, "queuelen=%d", l->queuelen);
 
+	if (l->spin >= 0)
+		strcatf(&buf, ", spin=%d", l->spin);
+
 	return buf;
 }
 
@@ -325,7 +325,7 @@ int mqtt_prepare(struct vnode *n)
 	if (ret)
 		return ret;
 
-	ret = queue_signalled_init(&m->queue, 1024);
+	ret = queue_signalled_init(&m->queue, 1024, memory_default, QueueSignalledMode::AUTO, (int) QueueSignalledFlags::ADAPTIVE);
 	if (ret)
 		return ret;
 
@@ -56,16 +56,20 @@ int shmem_parse(struct vnode *n, json_t *json)
 	shm->conf.queuelen = MAX(DEFAULT_SHMEM_QUEUELEN, n->in.vectorize);
 	shm->conf.samplelen = len;
 	shm->conf.polling = false;
+	shm->conf.busy_poll = 0;
 	shm->exec = nullptr;
+	shm->zerocopy = 0;
 
-	ret = json_unpack_ex(json, &err, 0, "{ s: { s: s }, s: { s: s }, s?: i, s?: o, s?: s }",
+	ret = json_unpack_ex(json, &err, 0, "{ s: { s: s }, s: { s: s, s?: b }, s?: i, s?: o, s?: s, s?: i }",
 		"out",
 			"name", &shm->out_name,
 		"in",
 			"name", &shm->in_name,
+			"zerocopy", &shm->zerocopy,
 		"queuelen", &shm->conf.queuelen,
 		"exec", &json_exec,
-		"mode", &mode_str
+		"mode", &mode_str,
+		"busy_poll", &shm->conf.busy_poll
 	);
 	if (ret)
 		throw ConfigError(json, err, "node-config-node-shmem");
@@ -127,9 +131,24 @@ int shmem_stop(struct vnode *n)
 {
 	struct shmem* shm = (struct shmem *) n->_vd;
 
+	/* Samples of the shared pool might still be queued in paths.
+	 * Hence the input region is kept mapped until the node is destroyed. */
+	if (shm->zerocopy)
+		atomic_fetch_add(&shm->intf.readers, 1);
+
 	return shmem_int_close(&shm->intf);
 }
 
+int shmem_destroy(struct vnode *n)
+{
+	struct shmem* shm = (struct shmem *) n->_vd;
+
+	if (shm->zerocopy && atomic_load(&shm->intf.closed))
+		munmap(shm->intf.read.base, shm->intf.read.len);
+
+	return 0;
+}
+
 int shmem_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
 {
 	struct shmem *shm = (struct shmem *) n->_vd;
@@ -151,8 +170,20 @@ int shmem_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
 		return recv;
 	}
 
-	sample_copy_many(smps, shared_smps, recv);
-	sample_decref_many(shared_smps, recv);
+	if (shm->zerocopy) {
+		/* Hand out the samples of the shared pool in place of our own ones.
+		 * The external process has written the values directly into them. */
+		auto **out = const_cast<struct sample **>(smps);
+
+		sample_decref_many(out, recv);
+
+		for (int i = 0; i < recv; i++)
+			out[i] = shared_smps[i];
+	}
+	else {
+		sample_copy_many(smps, shared_smps, recv);
+		sample_decref_many(shared_smps, recv);
+	}
 
 	/** @todo: signal descriptions are currently not shared between processes */
 	for (int i = 0; i < recv; i++)
@@ -187,8 +218,9 @@ char * shmem_print(struct vnode *n)
 	struct shmem *shm = (struct shmem *) n->_vd;
 	char *buf = nullptr;
 
-	strcatf(&buf, "out_name=%s, in_name=%s, queuelen=%d, polling=%s",
-		shm->out_name, shm->in_name, shm->conf.queuelen, shm->conf.polling ? "yes" : "no");
+	strcatf(&buf, "out_name=%s, in_name=%s, queuelen=%d, polling=%s, busy_poll=%d, zerocopy=%s",
+		shm->out_name, shm->in_name, shm->conf.queuelen, shm->conf.polling ? "yes" : "no",
+		shm->conf.busy_poll, shm->zerocopy ? "yes" : "no");
 
 	if (shm->exec) {
 		strcatf(&buf, ", exec='");
@@ -214,6 +246,7 @@ static void register_plugin() {
 	p.print		= shmem_print;
 	p.start		= shmem_start;
 	p.stop		= shmem_stop;
+	p.destroy	= shmem_destroy;
 	p.read		= shmem_read;
 	p.write		= shmem_write;
 
@@ -23,6 +23,7 @@
 #include <unistd.h>
 #include <cstring>
 #include <cerrno>
+#include <poll.h>
 #include <arpa/inet.h>
 #include <netinet/ip.h>
 
@@ -38,6 +39,14 @@
   #include <netinet/ether.h>
 #endif /* WITH_SOCKET_LAYER_ETH */
 
+#ifdef HAS_IO_URING
+  #include <villas/nodes/socket_uring.hpp>
+#endif /* HAS_IO_URING */
+
+#ifdef WITH_SOCKET_LAYER_XDP
+  #include <villas/nodes/socket_xdp.hpp>
+#endif /* WITH_SOCKET_LAYER_XDP */
+
 #ifdef WITH_NETEM
   #include <villas/kernel/if.hpp>
   #include <villas/kernel/nl.hpp>
@@ -90,6 +99,10 @@ char * socket_print(struct vnode *n)
 			layer = "eth";
 			break;
 
+		case SocketLayer::XDP:
+			layer = "xdp";
+			break;
+
 		case SocketLayer::UNIX:
 			layer = "unix";
 			break;
@@ -100,6 +113,16 @@ char * socket_print(struct vnode *n)
 
 	buf = strf("layer=%s, in.address=%s, out.address=%s", layer, local, remote);
 
+	if (s->sample_per_datagram)
+		strcatf(&buf, ", out.sample_per_datagram=yes");
+
+	if (s->io_uring)
+		strcatf(&buf, ", in.io_uring=yes");
+
+	if (s->layer == SocketLayer::XDP)
+		strcatf(&buf, ", xdp.queue=%u, xdp.mode=%s", s->xdp.queue,
+			s->xdp.zerocopy ? "zerocopy" : s->xdp.native ? "native" : "copy");
+
 	if (s->multicast.enabled) {
 		char group[INET_ADDRSTRLEN];
 		char interface[INET_ADDRSTRLEN];
@@ -135,7 +158,7 @@ int socket_check(struct vnode *n)
 			throw RuntimeError("IP protocol numbers of local and remote must match!");
 	}
 #ifdef WITH_SOCKET_LAYER_ETH
-	else if (s->layer == SocketLayer::ETH) {
+	else if (s->layer == SocketLayer::ETH || s->layer == SocketLayer::XDP) {
 		if (ntohs(s->in.saddr.sll.sll_protocol) != ntohs(s->out.saddr.sll.sll_protocol))
 			throw RuntimeError("Ethertypes of local and remote must match!");
 
@@ -144,6 +167,16 @@ int socket_check(struct vnode *n)
 	}
 #endif /* WITH_SOCKET_LAYER_ETH */
 
+#ifdef WITH_SOCKET_LAYER_XDP
+	if (s->layer == SocketLayer::XDP) {
+		if (s->in.saddr.sll.sll_ifindex != s->out.saddr.sll.sll_ifindex)
+			throw RuntimeError("Interfaces of local and remote must match!");
+
+		if (s->xdp.zerocopy && !s->xdp.native)
+			throw RuntimeError("The zerocopy mode requires the native XDP mode!");
+	}
+#endif /* WITH_SOCKET_LAYER_XDP */
+
 	if (s->multicast.enabled) {
 		if (s->in.saddr.sa.sa_family != AF_INET)
 			throw RuntimeError("Multicast is only supported by IPv4");
@@ -156,6 +189,28 @@ int socket_check(struct vnode *n)
 	return 0;
 }
 
+static socklen_t socket_addr_length(const union sockaddr_union *sa)
+{
+	switch (sa->ss.ss_family) {
+		case AF_INET:
+			return sizeof(struct sockaddr_in);
+
+		case AF_INET6:
+			return sizeof(struct sockaddr_in6);
+
+		case AF_UNIX:
+			return SUN_LEN(&sa->sun);
+
+#ifdef WITH_SOCKET_LAYER_ETH
+		case AF_PACKET:
+			return sizeof(struct sockaddr_ll);
+#endif /* WITH_SOCKET_LAYER_ETH */
+
+		default:
+			return sizeof(*sa);
+	}
+}
+
 int socket_start(struct vnode *n)
 {
 	struct socket *s = (struct socket *) n->_vd;
@@ -175,6 +230,8 @@ int socket_start(struct vnode *n)
 			break;
 
 #ifdef WITH_SOCKET_LAYER_ETH
+		/* The raw Ethernet socket is kept as a fallback if AF_XDP is not available */
+		case SocketLayer::XDP:
 		case SocketLayer::ETH:
 			s->sd = socket(s->in.saddr.sa.sa_family, SOCK_DGRAM, s->in.saddr.sll.sll_protocol);
 			break;
@@ -199,30 +256,7 @@ int socket_start(struct vnode *n)
 	}
 
 	/* Bind socket for receiving */
-	socklen_t addrlen = 0;
-	switch(s->in.saddr.ss.ss_family) {
-		case AF_INET:
-			addrlen = sizeof(struct sockaddr_in);
-			break;
-
-		case AF_INET6:
-			addrlen = sizeof(struct sockaddr_in6);
-			break;
-
-		case AF_UNIX:
-			addrlen = SUN_LEN(&s->in.saddr.sun);
-			break;
-
-#ifdef WITH_SOCKET_LAYER_ETH
-		case AF_PACKET:
-			addrlen = sizeof(struct sockaddr_ll);
-			break;
-#endif /* WITH_SOCKET_LAYER_ETH */
-		default:
-			addrlen = sizeof(s->in.saddr);
-	}
-
-	ret = bind(s->sd, (struct sockaddr *) &s->in.saddr, addrlen);
+	ret = bind(s->sd, (struct sockaddr *) &s->in.saddr, socket_addr_length(&s->in.saddr));
 	if (ret < 0)
 		throw SystemError("Failed to bind socket");
 
@@ -265,16 +299,94 @@ int socket_start(struct vnode *n)
 #endif /* __linux__ */
 	}
 
+	/* Datagrams are only sent in batches if each of them carries a single sample */
+	s->out.batch = s->sample_per_datagram ? MIN(n->out.vectorize, SOCKET_MAX_BATCH) : 1;
 	s->out.buflen = SOCKET_INITIAL_BUFFER_LEN;
-	s->out.buf = new char[s->out.buflen];
-	if (!s->out.buf)
+	s->out.buf = new char[s->out.batch * s->out.buflen];
+	s->out.msgs = new struct mmsghdr[s->out.batch];
+	s->out.iov = new struct iovec[s->out.batch];
+	s->out.addrs = nullptr;
+	if (!s->out.buf || !s->out.msgs || !s->out.iov)
 		throw MemoryAllocationError();
 
+	s->in.batch = MIN(n->in.vectorize, SOCKET_MAX_BATCH);
 	s->in.buflen = SOCKET_INITIAL_BUFFER_LEN;
-	s->in.buf = new char[s->in.buflen];
-	if (!s->in.buf)
+	s->in.buf = new char[s->in.batch * s->in.buflen];
+	s->in.msgs = new struct mmsghdr[s->in.batch];
+	s->in.iov = new struct iovec[s->in.batch];
+	s->in.addrs = new union sockaddr_union[s->in.batch];
+	if (!s->in.buf || !s->in.msgs || !s->in.iov || !s->in.addrs)
 		throw MemoryAllocationError();
 
+	for (unsigned i = 0; i < s->in.batch; i++) {
+		struct msghdr *hdr = &s->in.msgs[i].msg_hdr;
+
+		s->in.iov[i].iov_base = s->in.buf + i * s->in.buflen;
+		s->in.iov[i].iov_len = s->in.buflen;
+
+		memset(hdr, 0, sizeof(*hdr));
+		hdr->msg_iov = &s->in.iov[i];
+		hdr->msg_iovlen = 1;
+		hdr->msg_name = &s->in.addrs[i];
+	}
+
+	for (unsigned i = 0; i < s->out.batch; i++) {
+		struct msghdr *hdr = &s->out.msgs[i].msg_hdr;
+
+		memset(hdr, 0, sizeof(*hdr));
+		hdr->msg_iov = &s->out.iov[i];
+		hdr->msg_iovlen = 1;
+		hdr->msg_name = &s->out.saddr;
+	}
+
+	s->uring = nullptr;
+	if (s->io_uring) {
+#ifdef HAS_IO_URING
+		if (s->layer == SocketLayer::UDP || s->layer == SocketLayer::UNIX) {
+			s->uring = new struct socket_uring;
+			if (!s->uring)
+				throw MemoryAllocationError();
+
+			ret = socket_uring_init(s->uring, s->sd);
+			if (ret) {
+				n->logger->warn("Failed to setup io_uring: {}. Falling back to recvmmsg()", strerror(-ret));
+
+				delete s->uring;
+				s->uring = nullptr;
+			}
+		}
+		else
+			n->logger->warn("The io_uring backend only supports the udp and unix layers. Falling back to recvmmsg()");
+#else
+		n->logger->warn("This build does not support io_uring. Falling back to recvmmsg()");
+#endif /* HAS_IO_URING */
+	}
+
+	s->xdp.ctx = nullptr;
+#ifdef WITH_SOCKET_LAYER_XDP
+	if (s->layer == SocketLayer::XDP) {
+		s->xdp.ctx = new struct socket_xdp;
+		if (!s->xdp.ctx)
+			throw MemoryAllocationError();
+
+		ret = socket_xdp_init(s->xdp.ctx, &s->in.saddr.sll, s->xdp.queue, s->xdp.native, s->xdp.zerocopy, node_memory_type(n));
+		if (ret) {
+			n->logger->warn("Failed to setup AF_XDP socket: {}. Falling back to raw Ethernet sockets", strerror(-ret));
+
+			delete s->xdp.ctx;
+			s->xdp.ctx = nullptr;
+		}
+		else {
+			/* Our frames are now redirected to the AF_XDP socket */
+			ret = close(s->sd);
+			if (ret)
+				throw SystemError("Failed to close raw Ethernet socket");
+
+			s->sd = -1;
+		}
+	}
+#endif /* WITH_SOCKET_LAYER_XDP */
+
 	return 0;
 }
 
@@ -301,6 +413,28 @@ int socket_stop(struct vnode *n)
 			throw SystemError("Failed to leave multicast group");
 	}
 
+#ifdef HAS_IO_URING
+	if (s->uring) {
+		ret = socket_uring_destroy(s->uring);
+		if (ret)
+			return ret;
+
+		delete s->uring;
+		s->uring = nullptr;
+	}
+#endif /* HAS_IO_URING */
+
+#ifdef WITH_SOCKET_LAYER_XDP
+	if (s->xdp.ctx) {
+		ret = socket_xdp_destroy(s->xdp.ctx);
+		if (ret)
+			return ret;
+
+		delete s->xdp.ctx;
+		s->xdp.ctx = nullptr;
+	}
+#endif /* WITH_SOCKET_LAYER_XDP */
+
 	if (s->sd >= 0) {
 		ret = close(s->sd);
 		if (ret)
@@ -309,31 +443,59 @@ int socket_stop(struct vnode *n)
 
 	delete s->formatter;
 	delete[] s->in.buf;
+	delete[] s->in.msgs;
+	delete[] s->in.iov;
+	delete[] s->in.addrs;
 	delete[] s->out.buf;
+	delete[] s->out.msgs;
+	delete[] s->out.iov;
 
 	return 0;
 }
 
-int socket_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
+/** Receive up to \p vlen datagrams but block only until the first one arrived. */
+static int socket_recv_many(int sd, struct mmsghdr *msgs, unsigned vlen)
 {
-	int ret;
-	struct socket *s = (struct socket *) n->_vd;
+#ifdef __APPLE__
+	ssize_t bytes = recvmsg(sd, &msgs[0].msg_hdr, 0);
+	if (bytes < 0)
+		return -1;
 
-	char *ptr;
-	ssize_t bytes;
-	size_t rbytes;
+	msgs[0].msg_len = bytes;
 
-	union sockaddr_union src;
-	socklen_t srclen = sizeof(src);
+	return 1;
+#else
+	return recvmmsg(sd, msgs, vlen, MSG_WAITFORONE, nullptr);
+#endif /* __APPLE__ */
+}
 
-	/* Receive next sample */
-	bytes = recvfrom(s->sd, s->in.buf, s->in.buflen, 0, &src.sa, &srclen);
+static int socket_send_many(int sd, struct mmsghdr *msgs, unsigned vlen)
+{
+#ifdef __APPLE__
+	ssize_t bytes = sendmsg(sd, &msgs[0].msg_hdr, 0);
 	if (bytes < 0)
-		throw SystemError("Failed recvfrom()");
-	else if (bytes == 0)
-		return 0;
+		return -1;
+
+	msgs[0].msg_len = bytes;
 
-	ptr = s->in.buf;
+	return 1;
+#else
+	return sendmmsg(sd, msgs, vlen, 0);
+#endif /* __APPLE__ */
+}
+
+/** Parse a single datagram into \p cnt samples.
+ *
+ * @return The number of samples or 0 if the datagram was rejected.
+ */
+static int socket_parse_datagram(struct vnode *n, char *ptr, ssize_t bytes, union sockaddr_union *src, struct sample * const smps[], unsigned cnt)
+{
+	int ret;
+	size_t rbytes;
+	struct socket *s = (struct socket *) n->_vd;
+
+	if (bytes == 0)
+		return 0;
 
 	/* Strip IP header from packet */
 	if (s->layer == SocketLayer::IP) {
@@ -346,19 +508,19 @@ int socket_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
 	/* SOCK_RAW IP sockets to not provide the IP protocol number via recvmsg()
 	 * So we simply set it ourself. */
 	if (s->layer == SocketLayer::IP) {
-		switch (src.sa.sa_family) {
+		switch (src->sa.sa_family) {
 			case AF_INET:
-				src.sin.sin_port = s->out.saddr.sin.sin_port;
+				src->sin.sin_port = s->out.saddr.sin.sin_port;
 				break;
 
 			case AF_INET6:
-				src.sin6.sin6_port = s->out.saddr.sin6.sin6_port;
+				src->sin6.sin6_port = s->out.saddr.sin6.sin6_port;
 				break;
 		}
 	}
 
-	if (s->verify_source && socket_compare_addr(&src.sa, &s->out.saddr.sa) != 0) {
-		char *buf = socket_print_addr((struct sockaddr *) &src);
+	if (s->verify_source && socket_compare_addr(&src->sa, &s->out.saddr.sa) != 0) {
+		char *buf = socket_print_addr((struct sockaddr *) src);
 		n->logger->warn("Received packet from unauthorized source: {}", buf);
 		free(buf);
 
@@ -369,7 +531,103 @@ int socket_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
 	if (ret < 0 || (size_t) bytes != rbytes)
 		n->logger->warn("Received invalid packet: ret={}, bytes={}, rbytes={}", ret, bytes, rbytes);
 
-	return ret;
+	return ret > 0 ? ret : 0;
+}
+
+#ifdef HAS_IO_URING
+static int socket_read_uring(struct vnode *n, struct sample * const smps[], unsigned cnt)
+{
+	int ret, received, nread = 0;
+	struct socket *s = (struct socket *) n->_vd;
+
+	unsigned vlen = MIN(cnt, s->in.batch);
+	struct socket_uring_datagram dgs[vlen];
+
+	received = socket_uring_recv(s->uring, dgs, vlen);
+	if (received < 0)
+		throw RuntimeError("Failed to receive via io_uring: {}", strerror(-received));
+
+	for (int i = 0; i < received; i++) {
+		if (dgs[i].flags & MSG_TRUNC) {
+			n->logger->warn("Received truncated packet: bytes>{}", dgs[i].len);
+			continue;
+		}
+
+		/* Leave at least one sample for each of the remaining datagrams */
+		unsigned avail = cnt - nread - (received - i - 1);
+
+		nread += socket_parse_datagram(n, dgs[i].data, dgs[i].len, dgs[i].src, &smps[nread], avail);
+	}
+
+	ret = socket_uring_release(s->uring, dgs, received);
+	if (ret)
+		throw RuntimeError("Failed to re-arm io_uring: {}", strerror(-ret));
+
+	return nread;
+}
+#endif /* HAS_IO_URING */
+
+#ifdef WITH_SOCKET_LAYER_XDP
+static int socket_read_xdp(struct vnode *n, struct sample * const smps[], unsigned cnt)
+{
+	int ret, received, nread = 0;
+	struct socket *s = (struct socket *) n->_vd;
+
+	unsigned vlen = MIN(cnt, s->in.batch);
+	struct socket_xdp_frame frames[vlen];
+
+	received = socket_xdp_recv(s->xdp.ctx, frames, vlen);
+	if (received < 0)
+		throw RuntimeError("Failed to receive via AF_XDP: {}", strerror(-received));
+
+	for (int i = 0; i < received; i++) {
+		/* Leave at least one sample for each of the remaining frames */
+		unsigned avail = cnt - nread - (received - i - 1);
+
+		nread += socket_parse_datagram(n, frames[i].data, frames[i].len, &frames[i].src, &smps[nread], avail);
+	}
+
+	ret = socket_xdp_release(s->xdp.ctx, frames, received);
+	if (ret)
+		throw RuntimeError("Failed to release AF_XDP frames: {}", strerror(-ret));
+
+	return nread;
+}
+#endif /* WITH_SOCKET_LAYER_XDP */
+
+int socket_read(struct vnode *n, struct sample * const smps[], unsigned cnt)
+{
+	int received, nread = 0;
+	struct socket *s = (struct socket *) n->_vd;
+
+#ifdef HAS_IO_URING
+	if (s->uring)
+		return socket_read_uring(n, smps, cnt);
+#endif /* HAS_IO_URING */
+
+#ifdef WITH_SOCKET_LAYER_XDP
+	if (s->xdp.ctx)
+		return socket_read_xdp(n, smps, cnt);
+#endif /* WITH_SOCKET_LAYER_XDP */
+
+	unsigned vlen = MIN(cnt, s->in.batch);
+
+	for (unsigned i = 0; i < vlen; i++)
+		s->in.msgs[i].msg_hdr.msg_namelen = sizeof(s->in.addrs[i]);
+
+	/* Receive next datagrams */
+	received = socket_recv_many(s->sd, s->in.msgs, vlen);
+	if (received < 0)
+		throw SystemError("Failed recvmmsg()");
+
+	for (int i = 0; i < received; i++) {
+		/* Leave at least one sample for each of the remaining datagrams */
+		unsigned avail = cnt - nread - (received - i - 1);
+
+		nread += socket_parse_datagram(n, (char *) s->in.iov[i].iov_base, s->in.msgs[i].msg_len, &s->in.addrs[i], &smps[nread], avail);
+	}
+
+	return nread;
 }
 
 int socket_write(struct vnode *n, struct sample * const smps[], unsigned cnt)
@@ -377,71 +635,95 @@ int socket_write(struct vnode *n, struct sample * const smps[], unsigned cnt)
 	struct socket *s = (struct socket *) n->_vd;
 
 	int ret;
-	ssize_t bytes;
+	unsigned vlen, sent;
 	size_t wbytes;
 
-retry:	ret = s->formatter->sprint(s->out.buf, s->out.buflen, &wbytes, smps, cnt);
-	if (ret < 0) {
-		n->logger->warn("Failed to format payload: reason={}", ret);
-		return ret;
-	}
+	/* Either all samples are packed into a single datagram or each one is sent separately */
+	vlen = s->sample_per_datagram ? MIN(cnt, s->out.batch) : 1;
 
-	if (wbytes == 0) {
-		n->logger->warn("Failed to format payload: wbytes={}", wbytes);
-		return -1;
-	}
+retry:	for (unsigned i = 0; i < vlen; i++) {
+		char *buf = s->out.buf + i * s->out.buflen;
+
+		ret = s->sample_per_datagram
+			? s->formatter->sprint(buf, s->out.buflen, &wbytes, &smps[i], 1)
+			: s->formatter->sprint(buf, s->out.buflen, &wbytes, smps, cnt);
+		if (ret < 0) {
+			n->logger->warn("Failed to format payload: reason={}", ret);
+			return ret;
+		}
 
-	if (wbytes > s->out.buflen) {
-		s->out.buflen = wbytes;
+		if (wbytes == 0) {
+			n->logger->warn("Failed to format payload: wbytes={}", wbytes);
+			return -1;
+		}
 
-		delete[] s->out.buf;
-		s->out.buf = new char[s->out.buflen];
-		if (!s->out.buf)
-			throw MemoryAllocationError();
+		if (wbytes > s->out.buflen) {
+			s->out.buflen = wbytes;
 
-		goto retry;
+			delete[] s->out.buf;
+			s->out.buf = new char[s->out.batch * s->out.buflen];
+			if (!s->out.buf)
+				throw MemoryAllocationError();
+
+			goto retry;
+		}
+
+		s->out.iov[i].iov_base = buf;
+		s->out.iov[i].iov_len = wbytes;
+
+		s->out.msgs[i].msg_hdr.msg_namelen = socket_addr_length(&s->out.saddr);
 	}
 
-	/* Send message */
-	socklen_t addrlen = 0;
-	switch(s->in.saddr.ss.ss_family) {
-		case AF_INET:
-			addrlen = sizeof(struct sockaddr_in);
-			break;
+#ifdef WITH_SOCKET_LAYER_XDP
+	if (s->xdp.ctx) {
+		ret = socket_xdp_send(s->xdp.ctx, &s->out.saddr.sll, s->out.iov, vlen);
+		if (ret < 0) {
+			n->logger->warn("Failed to send via AF_XDP: {}", strerror(-ret));
+			return -1;
+		}
+		else if ((unsigned) ret < vlen)
+			n->logger->debug("Transmit ring is full: queued {} of {} frames", ret, vlen);
 
-		case AF_INET6:
-			addrlen = sizeof(struct sockaddr_in6);
-			break;
+		/* Only report the samples whose frames have been queued */
+		if (s->sample_per_datagram)
+			return ret;
 
-		case AF_UNIX:
-			addrlen = SUN_LEN(&s->out.saddr.sun);
-			break;
+		return ret > 0 ? cnt : 0;
+	}
+#endif /* WITH_SOCKET_LAYER_XDP */
+
+	/* Send messages */
+	for (sent = 0; sent < vlen; ) {
+		ret = socket_send_many(s->sd, &s->out.msgs[sent], vlen - sent);
+		if (ret < 0) {
+			if ((errno == EPERM) ||
+			    (errno == ENOENT && s->layer == SocketLayer::UNIX))
+				n->logger->warn("Failed sendmmsg(): {}", strerror(errno));
+			else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+				/* Wait until the socket buffer has room again instead of spinning */
+				struct pollfd pfd = { .fd = s->sd, .events = POLLOUT };
+
+				ret = poll(&pfd, 1, -1);
+				if (ret >= 0 || errno == EINTR)
+					continue;
+
+				n->logger->warn("Failed to wait for socket: {}", strerror(errno));
+			}
+			else
+				n->logger->warn("Failed sendmmsg(): {}", strerror(errno));
 
-#ifdef WITH_SOCKET_LAYER_ETH
-		case AF_PACKET:
-			addrlen = sizeof(struct sockaddr_ll);
 			break;
-#endif /* WITH_SOCKET_LAYER_ETH */
-		default:
-			addrlen = sizeof(s->in.saddr);
-	}
+		}
 
-retry2:	bytes = sendto(s->sd, s->out.buf, wbytes, 0, (struct sockaddr *) &s->out.saddr, addrlen);
-	if (bytes < 0) {
-		if ((errno == EPERM) ||
-		    (errno == ENOENT && s->layer == SocketLayer::UNIX))
-			n->logger->warn("Failed sendto(): {}", strerror(errno));
-		else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-			n->logger->warn("Blocking sendto()");
-			goto retry2;
+		for (int i = 0; i < ret; i++) {
+			if (s->out.msgs[sent + i].msg_len < s->out.iov[sent + i].iov_len)
+				n->logger->warn("Partial sendmmsg()");
 		}
-		else
-			n->logger->warn("Failed sendto(): {}", strerror(errno));
+
+		sent += ret;
 	}
-	else if ((size_t) bytes < wbytes)
-		n->logger->warn("Partial sendto()");
 
-	return cnt;
+	return s->sample_per_datagram ? vlen : cnt;
 }
 
 int socket_parse(struct vnode *n, json_t *json)
@@ -455,20 +737,29 @@ int socket_parse(struct vnode *n, json_t *json)
 	json_error_t err;
 	json_t *json_multicast = nullptr;
 	json_t *json_format = nullptr;
+	json_t *json_xdp = nullptr;
 
 	/* Default values */
 	s->layer = SocketLayer::UDP;
 	s->verify_source = 0;
+	s->sample_per_datagram = 0;
+	s->io_uring = 0;
+	s->xdp.queue = 0;
+	s->xdp.native = 0;
+	s->xdp.zerocopy = 0;
 
-	ret = json_unpack_ex(json, &err, 0, "{ s?: s, s?: o, s: { s: s }, s: { s: s, s?: b, s?: o } }",
+	ret = json_unpack_ex(json, &err, 0, "{ s?: s, s?: o, s?: o, s: { s: s, s?: b }, s: { s: s, s?: b, s?: o, s?: b } }",
 		"layer", &layer,
 		"format", &json_format,
+		"xdp", &json_xdp,
 		"out",
 			"address", &remote,
+			"sample_per_datagram", &s->sample_per_datagram,
 		"in",
 			"address", &local,
 			"verify_source", &s->verify_source,
-			"multicast", &json_multicast
+			"multicast", &json_multicast,
+			"io_uring", &s->io_uring
 	);
 	if (ret)
 		throw ConfigError(json, err, "node-config-node-socket");
@@ -488,6 +779,10 @@ int socket_parse(struct vnode *n, json_t *json)
 		else if (!strcmp(layer, "eth"))
 			s->layer = SocketLayer::ETH;
 #endif /* WITH_SOCKET_LAYER_ETH */
+#ifdef WITH_SOCKET_LAYER_XDP
+		else if (!strcmp(layer, "xdp"))
+			s->layer = SocketLayer::XDP;
+#endif /* WITH_SOCKET_LAYER_XDP */
 		else if (!strcmp(layer, "udp"))
 			s->layer = SocketLayer::UDP;
 		else if (!strcmp(layer, "unix") || !strcmp(layer, "local"))
@@ -504,6 +799,26 @@ int socket_parse(struct vnode *n, json_t *json)
 	if (ret)
 		throw SystemError("Failed to resolve local address '{}': {}", local, gai_strerror(ret));
 
+	if (json_xdp) {
+		const char *mode = nullptr;
+
+		ret = json_unpack_ex(json_xdp, &err, 0, "{ s?: i, s?: s }",
+			"queue", &s->xdp.queue,
+			"mode", &mode
+		);
+		if (ret)
+			throw ConfigError(json_xdp, err, "node-config-node-socket-xdp", "Failed to parse AF_XDP settings");
+
+		if (!mode || !strcmp(mode, "copy"))
+			s->xdp.native = 0;
+		else if (!strcmp(mode, "native"))
+			s->xdp.native = 1;
+		else if (!strcmp(mode, "zerocopy"))
+			s->xdp.native = s->xdp.zerocopy = 1;
+		else
+			throw ConfigError(json_xdp, "node-config-node-socket-xdp-mode", "Invalid AF_XDP mode '{}'", mode);
+	}
+
 	if (json_multicast) {
 		const char *group, *interface = nullptr;
 
@@ -541,7 +856,31 @@ int socket_fds(struct vnode *n, int fds[])
 {
 	struct socket *s = (struct socket *) n->_vd;
 
+#ifdef HAS_IO_URING
+	/* The ring becomes readable as soon as datagrams have been received into its buffers */
+	fds[0] = s->uring ? s->uring->fd : s->sd;
+#else
 	fds[0] = s->sd;
+#endif /* HAS_IO_URING */
+
+#ifdef WITH_SOCKET_LAYER_XDP
+	if (s->xdp.ctx)
+		fds[0] = s->xdp.ctx->fd;
+#endif /* WITH_SOCKET_LAYER_XDP */
+
+	return 1;
+}
+
+int socket_netem_fds(struct vnode *n, int fds[])
+{
+	struct socket *s = (struct socket *) n->_vd;
+
+	fds[0] = s->sd;
+
+#ifdef WITH_SOCKET_LAYER_XDP
+	if (s->xdp.ctx)
+		fds[0] = s->xdp.ctx->fd;
+#endif /* WITH_SOCKET_LAYER_XDP */
 
 	return 1;
 }
@@ -566,7 +905,7 @@ static void register_plugin() {
 	p.read		= socket_read;
 	p.write		= socket_write;
 	p.poll_fds	= socket_fds;
-	p.netem_fds	= socket_fds;
+	p.netem_fds	= socket_netem_fds;
 
 	if (!node_types)
 		node_types = new NodeTypeList();
@@ -0,0 +1,300 @@
+/** io_uring receive backend for the socket node-type.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <villas/nodes/socket_uring.hpp>
+
+static int io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+static int io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/** Submit the multishot recvmsg() request which keeps receiving until it runs out of buffers. */
+static int socket_uring_arm(struct socket_uring *u)
+{
+	int ret;
+	unsigned tail = *u->sq_tail;
+	unsigned index = tail & *u->sq_mask;
+
+	struct io_uring_sqe *sqe = &u->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = u->sd;
+	sqe->addr = (uint64_t) &u->msg;
+	sqe->len = 1;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = SOCKET_URING_BGID;
+
+	u->sq_array[index] = index;
+
+	__atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	ret = io_uring_enter(u->fd, 1, 0, 0);
+	if (ret < 0)
+		return -errno;
+
+	u->armed = true;
+
+	return 0;
+}
+
+/* The flexible array member io_uring_buf_ring::bufs is misplaced when
+ * <linux/io_uring.h> is compiled as C++. Hence we index the ring directly. */
+static void socket_uring_provide(struct socket_uring *u, uint16_t bid)
+{
+	struct io_uring_buf *buf = (struct io_uring_buf *) u->buf_ring + (u->buf_tail & (SOCKET_URING_BUFFERS - 1));
+
+	buf->addr = (uint64_t) (u->bufs + bid * SOCKET_URING_BUFFER_LEN);
+	buf->len = SOCKET_URING_BUFFER_LEN;
+	buf->bid = bid;
+
+	u->buf_tail++;
+}
+
+int socket_uring_init(struct socket_uring *u, int sd)
+{
+	int ret;
+	struct io_uring_params params;
+
+	memset(u, 0, sizeof(*u));
+	memset(&params, 0, sizeof(params));
+
+	u->sd = sd;
+
+	/* Each received datagram produces a completion. The submission queue is only used to arm the receive. */
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = 2 * SOCKET_URING_BUFFERS;
+
+	u->fd = io_uring_setup(4, &params);
+	if (u->fd < 0)
+		return -errno;
+
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+		ret = -ENOTSUP;
+		goto err_close;
+	}
+
+	u->ring_len = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+			  params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+	u->ring_ptr = mmap(nullptr, u->ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+	if (u->ring_ptr == MAP_FAILED) {
+		ret = -errno;
+		goto err_close;
+	}
+
+	u->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+	u->sqes = (struct io_uring_sqe *) mmap(nullptr, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED) {
+		ret = -errno;
+		goto err_unmap_ring;
+	}
+
+	u->sq_tail  = (unsigned *) ((char *) u->ring_ptr + params.sq_off.tail);
+	u->sq_mask  = (unsigned *) ((char *) u->ring_ptr + params.sq_off.ring_mask);
+	u->sq_array = (unsigned *) ((char *) u->ring_ptr + params.sq_off.array);
+
+	u->cq_head  = (unsigned *) ((char *) u->ring_ptr + params.cq_off.head);
+	u->cq_tail  = (unsigned *) ((char *) u->ring_ptr + params.cq_off.tail);
+	u->cq_mask  = (unsigned *) ((char *) u->ring_ptr + params.cq_off.ring_mask);
+	u->cqes     = (struct io_uring_cqe *) ((char *) u->ring_ptr + params.cq_off.cqes);
+
+	/* Setup and register the ring of receive buffers */
+	u->buf_ring_len = SOCKET_URING_BUFFERS * sizeof(struct io_uring_buf);
+	u->buf_ring = (struct io_uring_buf_ring *) mmap(nullptr, u->buf_ring_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (u->buf_ring == MAP_FAILED) {
+		ret = -errno;
+		goto err_unmap_sqes;
+	}
+
+	u->bufs_len = SOCKET_URING_BUFFERS * SOCKET_URING_BUFFER_LEN;
+	u->bufs = (char *) mmap(nullptr, u->bufs_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (u->bufs == MAP_FAILED) {
+		ret = -errno;
+		goto err_unmap_buf_ring;
+	}
+
+	struct io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t) u->buf_ring;
+	reg.ring_entries = SOCKET_URING_BUFFERS;
+	reg.bgid = SOCKET_URING_BGID;
+
+	ret = io_uring_register(u->fd, IORING_REGISTER_PBUF_RING, &reg, 1);
+	if (ret < 0) {
+		ret = -errno;
+		goto err_unmap_bufs;
+	}
+
+	for (unsigned i = 0; i < SOCKET_URING_BUFFERS; i++)
+		socket_uring_provide(u, i);
+
+	__atomic_store_n(&u->buf_ring->tail, u->buf_tail, __ATOMIC_RELEASE);
+
+	/* Each buffer starts with a struct io_uring_recvmsg_out followed by the source address and the payload */
+	u->msg.msg_namelen = sizeof(union sockaddr_union);
+
+	ret = socket_uring_arm(u);
+	if (ret)
+		goto err_unmap_bufs;
+
+	/* Kernels without support for multishot recvmsg() fail the request immediately */
+	if (*u->cq_head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+		struct io_uring_cqe *cqe = &u->cqes[*u->cq_head & *u->cq_mask];
+
+		if (cqe->res < 0 && !(cqe->flags & IORING_CQE_F_MORE)) {
+			ret = cqe->res;
+			goto err_unmap_bufs;
+		}
+	}
+
+	return 0;
+
+err_unmap_bufs:
+	munmap(u->bufs, u->bufs_len);
+err_unmap_buf_ring:
+	munmap(u->buf_ring, u->buf_ring_len);
+err_unmap_sqes:
+	munmap(u->sqes, u->sqes_len);
+err_unmap_ring:
+	munmap(u->ring_ptr, u->ring_len);
+err_close:
+	close(u->fd);
+
+	return ret;
+}
+
+int socket_uring_destroy(struct socket_uring *u)
+{
+	int ret;
+
+	/* Closing the ring cancels the pending receive */
+	ret = close(u->fd);
+	if (ret)
+		return ret;
+
+	munmap(u->bufs, u->bufs_len);
+	munmap(u->buf_ring, u->buf_ring_len);
+	munmap(u->sqes, u->sqes_len);
+	munmap(u->ring_ptr, u->ring_len);
+
+	return 0;
+}
+
+int socket_uring_recv(struct socket_uring *u, struct socket_uring_datagram dgs[], unsigned cnt)
+{
+	int ret, error = 0;
+	unsigned n = 0;
+
+	unsigned head = *u->cq_head;
+	unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+	/* Only enter the kernel if there are no completions yet */
+	if (head == tail) {
+		if (!u->armed) {
+			ret = socket_uring_arm(u);
+			if (ret)
+				return ret;
+		}
+
+		ret = io_uring_enter(u->fd, 0, 1, IORING_ENTER_GETEVENTS);
+		if (ret < 0 && errno != EINTR)
+			return -errno;
+
+		tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+	}
+
+	while (head != tail && n < cnt) {
+		struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+
+		head++;
+
+		if (!(cqe->flags & IORING_CQE_F_MORE))
+			u->armed = false;
+
+		/* We have run out of buffers. The request is re-armed as soon as buffers are released. */
+		if (cqe->res == -ENOBUFS)
+			continue;
+		else if (cqe->res < 0) {
+			error = cqe->res;
+			break;
+		}
+
+		if (!(cqe->flags & IORING_CQE_F_BUFFER))
+			continue;
+
+		uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+		char *buf = u->bufs + bid * SOCKET_URING_BUFFER_LEN;
+
+		auto *out = (struct io_uring_recvmsg_out *) buf;
+		char *name = buf + sizeof(*out);
+
+		dgs[n].bid = bid;
+		dgs[n].src = (union sockaddr_union *) name;
+		dgs[n].data = name + u->msg.msg_namelen + out->controllen;
+		dgs[n].len = out->payloadlen;
+		dgs[n].flags = out->flags;
+
+		/* The payload is truncated to the available buffer space */
+		size_t avail = SOCKET_URING_BUFFER_LEN - (dgs[n].data - buf);
+		if (dgs[n].len > avail) {
+			dgs[n].len = avail;
+			dgs[n].flags |= MSG_TRUNC;
+		}
+
+		n++;
+	}
+
+	__atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+
+	return n > 0 ? (int) n : error;
+}
+
+int socket_uring_release(struct socket_uring *u, const struct socket_uring_datagram dgs[], unsigned cnt)
+{
+	for (unsigned i = 0; i < cnt; i++)
+		socket_uring_provide(u, dgs[i].bid);
+
+	__atomic_store_n(&u->buf_ring->tail, u->buf_tail, __ATOMIC_RELEASE);
+
+	if (!u->armed)
+		return socket_uring_arm(u);
+
+	return 0;
+}
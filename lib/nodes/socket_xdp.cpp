@@ -0,0 +1,507 @@
+/** AF_XDP backend for the Ethernet layer of the socket node-type.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+
+#include <villas/nodes/socket_xdp.hpp>
+#include <villas/utils.hpp>
+#include <villas/kernel/kernel.hpp>
+#include <villas/kernel/nl.hpp>
+
+#ifndef SOL_XDP
+  #define SOL_XDP 283
+#endif
+
+#ifndef AF_XDP
+  #define AF_XDP 44
+#endif
+
+using namespace villas;
+
+static int bpf(int cmd, union bpf_attr *attr)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static struct bpf_insn bpf_insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm)
+{
+	struct bpf_insn insn;
+
+	insn.code = code;
+	insn.dst_reg = dst;
+	insn.src_reg = src;
+	insn.off = off;
+	insn.imm = imm;
+
+	return insn;
+}
+
+/** Load an XDP program which redirects all frames with the Ethertype \p protocol to the sockets in \p map_fd.
+ *
+ * The program is equivalent to:
+ *
+ *   int prog(struct xdp_md *ctx)
+ *   {
+ *           struct ethhdr *eth = (void *) (long) ctx->data;
+ *
+ *           if ((void *) (eth + 1) > (void *) (long) ctx->data_end || eth->h_proto != protocol)
+ *                   return XDP_PASS;
+ *
+ *           return bpf_redirect_map(&map, ctx->rx_queue_index, XDP_PASS);
+ *   }
+ */
+static int socket_xdp_load_prog(int map_fd, uint16_t protocol)
+{
+	struct bpf_insn insns[] = {
+		/* r6 = ctx */
+		bpf_insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0),
+		/* r2 = ctx->data, r3 = ctx->data_end */
+		bpf_insn(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, data), 0),
+		bpf_insn(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_3, BPF_REG_6, offsetof(struct xdp_md, data_end), 0),
+		/* if (r2 + ETH_HLEN > r3) goto pass */
+		bpf_insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),
+		bpf_insn(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, ETH_HLEN),
+		bpf_insn(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 8, 0),
+		/* if (eth->h_proto != protocol) goto pass */
+		bpf_insn(BPF_LDX | BPF_H | BPF_MEM, BPF_REG_4, BPF_REG_2, offsetof(struct ethhdr, h_proto), 0),
+		bpf_insn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_4, 0, 6, protocol),
+		/* return bpf_redirect_map(map, ctx->rx_queue_index, XDP_PASS) */
+		bpf_insn(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, rx_queue_index), 0),
+		bpf_insn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd),
+		bpf_insn(0, 0, 0, 0, 0),
+		bpf_insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS),
+		bpf_insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+		bpf_insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+		/* pass: return XDP_PASS */
+		bpf_insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS),
+		bpf_insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+	};
+
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.insns = (uint64_t) insns;
+	attr.insn_cnt = ARRAY_LEN(insns);
+	attr.license = (uint64_t) "GPL";
+
+	return bpf(BPF_PROG_LOAD, &attr);
+}
+
+/** Attach (or detach if \p prog_fd is -1) an XDP program to the interface via rtnetlink. */
+static int socket_xdp_attach(int ifindex, int prog_fd, uint32_t flags)
+{
+	int ret;
+	struct nl_sock *sock = kernel::nl::init();
+	struct nl_msg *msg = nlmsg_alloc_simple(RTM_SETLINK, NLM_F_REQUEST | NLM_F_ACK);
+	if (!msg)
+		return -ENOMEM;
+
+	struct ifinfomsg ifi;
+	memset(&ifi, 0, sizeof(ifi));
+
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = ifindex;
+
+	ret = nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO);
+	if (ret)
+		goto out;
+
+	{
+		struct nlattr *xdp = nla_nest_start(msg, IFLA_XDP);
+		if (!xdp) {
+			ret = -NLE_NOMEM;
+			goto out;
+		}
+
+		NLA_PUT_S32(msg, IFLA_XDP_FD, prog_fd);
+		NLA_PUT_U32(msg, IFLA_XDP_FLAGS, flags);
+
+		nla_nest_end(msg, xdp);
+	}
+
+	ret = nl_send_auto(sock, msg);
+	if (ret < 0)
+		goto out;
+
+	ret = nl_wait_for_ack(sock);
+
+out:	nlmsg_free(msg);
+
+	/* Translate the most likely libnl errors back to error numbers */
+	switch (ret < 0 ? -ret : 0) {
+		case 0:			return 0;
+		case NLE_BUSY:		return -EBUSY;
+		case NLE_PERM:		return -EPERM;
+		case NLE_NODEV:		return -ENODEV;
+		case NLE_OPNOTSUPP:	return -EOPNOTSUPP;
+		default:		return -EINVAL;
+	}
+
+nla_put_failure:
+	nlmsg_free(msg);
+
+	return -ENOMEM;
+}
+
+static int socket_xdp_map_ring(struct socket_xdp *x, struct socket_xdp_ring *r, const struct xdp_ring_offset *off, size_t desc_len, off_t pgoff)
+{
+	r->map_len = off->desc + SOCKET_XDP_RING_SIZE * desc_len;
+	r->map = mmap(nullptr, r->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, x->fd, pgoff);
+	if (r->map == MAP_FAILED)
+		return -errno;
+
+	r->producer = (uint32_t *) ((char *) r->map + off->producer);
+	r->consumer = (uint32_t *) ((char *) r->map + off->consumer);
+	r->flags    = (uint32_t *) ((char *) r->map + off->flags);
+	r->desc     = (char *) r->map + off->desc;
+
+	return 0;
+}
+
+static void socket_xdp_unmap_rings(struct socket_xdp *x)
+{
+	for (auto *r : { &x->fill, &x->comp, &x->rx, &x->tx }) {
+		if (r->map && r->map != MAP_FAILED)
+			munmap(r->map, r->map_len);
+	}
+}
+
+int socket_xdp_init(struct socket_xdp *x, const struct sockaddr_ll *sll, unsigned queue, bool native, bool zerocopy, struct memory_type *m)
+{
+	int ret, size = SOCKET_XDP_RING_SIZE;
+	uint32_t prod;
+
+	memset(x, 0, sizeof(*x));
+
+	x->ifindex = sll->sll_ifindex;
+	x->queue = queue;
+	x->protocol = sll->sll_protocol;
+	x->copy = !zerocopy;
+	x->prog_fd = -1;
+	x->map_fd = -1;
+
+	/* Generic XDP works with every driver, e.g. veth */
+	x->xdp_flags = XDP_FLAGS_UPDATE_IF_NOEXIST | (native ? XDP_FLAGS_DRV_MODE : XDP_FLAGS_SKB_MODE);
+
+	/* Get hardware address of the interface */
+	kernel::nl::init();
+
+	struct nl_cache *cache = nl_cache_mngt_require("route/link");
+	struct rtnl_link *link = rtnl_link_get(cache, x->ifindex);
+	if (!link)
+		return -ENODEV;
+
+	struct nl_addr *addr = rtnl_link_get_addr(link);
+	if (!addr || nl_addr_get_len(addr) != ETHER_ADDR_LEN) {
+		rtnl_link_put(link);
+		return -EINVAL;
+	}
+
+	memcpy(x->mac, nl_addr_get_binary_addr(addr), ETHER_ADDR_LEN);
+	rtnl_link_put(link);
+
+	x->fd = socket(AF_XDP, SOCK_RAW, 0);
+	if (x->fd < 0)
+		return -errno;
+
+	/* Register the UMEM */
+	x->umem_len = SOCKET_XDP_FRAMES * SOCKET_XDP_FRAME_LEN;
+	x->umem = (char *) memory_alloc_aligned(x->umem_len, kernel::getPageSize(), m);
+	if (!x->umem) {
+		ret = -ENOMEM;
+		goto err_close;
+	}
+
+	struct xdp_umem_reg mr;
+	memset(&mr, 0, sizeof(mr));
+	mr.addr = (uint64_t) x->umem;
+	mr.len = x->umem_len;
+	mr.chunk_size = SOCKET_XDP_FRAME_LEN;
+
+	ret = setsockopt(x->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr));
+	if (ret)
+		goto err_errno;
+
+	/* Create and map the rings */
+	if (setsockopt(x->fd, SOL_XDP, XDP_UMEM_FILL_RING, &size, sizeof(size)) ||
+	    setsockopt(x->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &size, sizeof(size)) ||
+	    setsockopt(x->fd, SOL_XDP, XDP_RX_RING, &size, sizeof(size)) ||
+	    setsockopt(x->fd, SOL_XDP, XDP_TX_RING, &size, sizeof(size)))
+		goto err_errno;
+
+	struct xdp_mmap_offsets off;
+	socklen_t optlen;
+	optlen = sizeof(off);
+
+	ret = getsockopt(x->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen);
+	if (ret)
+		goto err_errno;
+
+	if ((ret = socket_xdp_map_ring(x, &x->fill, &off.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING)) ||
+	    (ret = socket_xdp_map_ring(x, &x->comp, &off.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING)) ||
+	    (ret = socket_xdp_map_ring(x, &x->rx, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING)) ||
+	    (ret = socket_xdp_map_ring(x, &x->tx, &off.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING)))
+		goto err_unmap;
+
+	/* The first half of the frames is handed to the kernel for receiving */
+	prod = *x->fill.producer;
+	for (unsigned i = 0; i < SOCKET_XDP_FRAMES / 2; i++)
+		((uint64_t *) x->fill.desc)[prod++ & (SOCKET_XDP_RING_SIZE - 1)] = i * SOCKET_XDP_FRAME_LEN;
+
+	__atomic_store_n(x->fill.producer, prod, __ATOMIC_RELEASE);
+
+	/* The second half is used for sending */
+	x->tx_free = new uint64_t[SOCKET_XDP_FRAMES / 2];
+	if (!x->tx_free) {
+		ret = -ENOMEM;
+		goto err_unmap;
+	}
+
+	for (unsigned i = SOCKET_XDP_FRAMES / 2; i < SOCKET_XDP_FRAMES; i++)
+		x->tx_free[x->tx_free_cnt++] = i * SOCKET_XDP_FRAME_LEN;
+
+	struct sockaddr_xdp sxdp;
+	memset(&sxdp, 0, sizeof(sxdp));
+	sxdp.sxdp_family = AF_XDP;
+	sxdp.sxdp_ifindex = x->ifindex;
+	sxdp.sxdp_queue_id = x->queue;
+	sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP | (zerocopy ? XDP_ZEROCOPY : XDP_COPY);
+
+	ret = bind(x->fd, (struct sockaddr *) &sxdp, sizeof(sxdp));
+	if (ret)
+		goto err_errno_free;
+
+	/* Setup the XDP program which redirects our frames to the socket */
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = sizeof(uint32_t);
+	attr.max_entries = x->queue + 1;
+
+	x->map_fd = bpf(BPF_MAP_CREATE, &attr);
+	if (x->map_fd < 0)
+		goto err_errno_free;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = x->map_fd;
+	attr.key = (uint64_t) &x->queue;
+	attr.value = (uint64_t) &x->fd;
+
+	ret = bpf(BPF_MAP_UPDATE_ELEM, &attr);
+	if (ret)
+		goto err_errno_free;
+
+	x->prog_fd = socket_xdp_load_prog(x->map_fd, x->protocol);
+	if (x->prog_fd < 0)
+		goto err_errno_free;
+
+	ret = socket_xdp_attach(x->ifindex, x->prog_fd, x->xdp_flags);
+	if (ret)
+		goto err_free;
+
+	return 0;
+
+err_errno_free:
+	ret = -errno;
+err_free:
+	if (x->prog_fd >= 0)
+		close(x->prog_fd);
+	if (x->map_fd >= 0)
+		close(x->map_fd);
+
+	delete[] x->tx_free;
+	goto err_unmap;
+
+err_errno:
+	ret = -errno;
+err_unmap:
+	socket_xdp_unmap_rings(x);
+	memory_free(x->umem);
+err_close:
+	close(x->fd);
+
+	return ret;
+}
+
+int socket_xdp_destroy(struct socket_xdp *x)
+{
+	int ret;
+
+	ret = socket_xdp_attach(x->ifindex, -1, x->xdp_flags & ~XDP_FLAGS_UPDATE_IF_NOEXIST);
+	if (ret)
+		return ret;
+
+	close(x->prog_fd);
+	close(x->map_fd);
+
+	/* Closing the socket releases the UMEM */
+	ret = close(x->fd);
+	if (ret)
+		return ret;
+
+	socket_xdp_unmap_rings(x);
+
+	delete[] x->tx_free;
+
+	return memory_free(x->umem);
+}
+
+int socket_xdp_recv(struct socket_xdp *x, struct socket_xdp_frame frames[], unsigned cnt)
+{
+	int ret;
+	unsigned n = 0;
+
+	uint32_t cons = *x->rx.consumer;
+	uint32_t prod = __atomic_load_n(x->rx.producer, __ATOMIC_ACQUIRE);
+
+	/* Only enter the kernel if there are no frames yet */
+	if (cons == prod) {
+		struct pollfd pfd = { .fd = x->fd, .events = POLLIN, .revents = 0 };
+
+		ret = poll(&pfd, 1, -1);
+		if (ret < 0)
+			return errno == EINTR ? 0 : -errno;
+
+		prod = __atomic_load_n(x->rx.producer, __ATOMIC_ACQUIRE);
+	}
+
+	for (; cons != prod && n < cnt; cons++, n++) {
+		auto *desc = &((struct xdp_desc *) x->rx.desc)[cons & (SOCKET_XDP_RING_SIZE - 1)];
+		auto *eth = (struct ethhdr *) (x->umem + desc->addr);
+		auto *f = &frames[n];
+
+		f->addr = desc->addr;
+		f->data = (char *) (eth + 1);
+		f->len = desc->len > ETH_HLEN ? desc->len - ETH_HLEN : 0;
+
+		f->src.sll.sll_family = AF_PACKET;
+		f->src.sll.sll_protocol = eth->h_proto;
+		f->src.sll.sll_ifindex = x->ifindex;
+		f->src.sll.sll_halen = ETHER_ADDR_LEN;
+		memcpy(f->src.sll.sll_addr, eth->h_source, ETHER_ADDR_LEN);
+	}
+
+	__atomic_store_n(x->rx.consumer, cons, __ATOMIC_RELEASE);
+
+	return n;
+}
+
+int socket_xdp_release(struct socket_xdp *x, const struct socket_xdp_frame frames[], unsigned cnt)
+{
+	/* The fill ring is large enough to hold all receive frames */
+	uint32_t prod = *x->fill.producer;
+
+	for (unsigned i = 0; i < cnt; i++)
+		((uint64_t *) x->fill.desc)[prod++ & (SOCKET_XDP_RING_SIZE - 1)] = frames[i].addr;
+
+	__atomic_store_n(x->fill.producer, prod, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+/** Reclaim the transmit frames which have been sent by the kernel. */
+static void socket_xdp_complete(struct socket_xdp *x)
+{
+	uint32_t cons = *x->comp.consumer;
+	uint32_t prod = __atomic_load_n(x->comp.producer, __ATOMIC_ACQUIRE);
+
+	for (; cons != prod; cons++)
+		x->tx_free[x->tx_free_cnt++] = ((uint64_t *) x->comp.desc)[cons & (SOCKET_XDP_RING_SIZE - 1)];
+
+	__atomic_store_n(x->comp.consumer, cons, __ATOMIC_RELEASE);
+}
+
+static int socket_xdp_kick(struct socket_xdp *x)
+{
+	int ret;
+
+	/* In copy mode the kernel only transmits frames during sendto() */
+	if (!x->copy && !(__atomic_load_n(x->tx.flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP))
+		return 0;
+
+	ret = sendto(x->fd, nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+	if (ret < 0 && errno != EAGAIN && errno != EBUSY && errno != ENOBUFS && errno != ENETDOWN)
+		return -errno;
+
+	return 0;
+}
+
+int socket_xdp_send(struct socket_xdp *x, const struct sockaddr_ll *dst, const struct iovec iov[], unsigned cnt)
+{
+	int ret;
+	unsigned n;
+
+	for (unsigned i = 0; i < cnt; i++) {
+		if (iov[i].iov_len > SOCKET_XDP_FRAME_LEN - ETH_HLEN)
+			return -EMSGSIZE;
+	}
+
+	socket_xdp_complete(x);
+
+	/* Try once to free transmit frames if we are running short */
+	if (x->tx_free_cnt < cnt) {
+		ret = socket_xdp_kick(x);
+		if (ret)
+			return ret;
+
+		socket_xdp_complete(x);
+	}
+
+	uint32_t prod = *x->tx.producer;
+
+	for (n = 0; n < cnt && x->tx_free_cnt > 0; n++) {
+		uint64_t addr = x->tx_free[--x->tx_free_cnt];
+		auto *eth = (struct ethhdr *) (x->umem + addr);
+
+		memcpy(eth->h_dest, dst->sll_addr, ETHER_ADDR_LEN);
+		memcpy(eth->h_source, x->mac, ETHER_ADDR_LEN);
+		eth->h_proto = dst->sll_protocol;
+		memcpy(eth + 1, iov[n].iov_base, iov[n].iov_len);
+
+		auto *desc = &((struct xdp_desc *) x->tx.desc)[prod++ & (SOCKET_XDP_RING_SIZE - 1)];
+		desc->addr = addr;
+		desc->len = ETH_HLEN + iov[n].iov_len;
+		desc->options = 0;
+	}
+
+	__atomic_store_n(x->tx.producer, prod, __ATOMIC_RELEASE);
+
+	/* The frames are queued even if the kernel could not be woken up.
+	 * They are transmitted with the next wakeup. */
+	ret = socket_xdp_kick(x);
+	if (ret && n == 0)
+		return ret;
+
+	return n;
+}
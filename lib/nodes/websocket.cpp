@@ -376,7 +376,7 @@ int websocket_start(struct vnode *n)
 	if (ret)
 		return ret;
 
-	ret = queue_signalled_init(&w->queue, DEFAULT_WEBSOCKET_QUEUE_LENGTH);
+	ret = queue_signalled_init(&w->queue, DEFAULT_WEBSOCKET_QUEUE_LENGTH, memory_default, QueueSignalledMode::AUTO, (int) QueueSignalledFlags::ADAPTIVE);
 	if (ret)
 		return ret;
 
@@ -47,6 +47,7 @@
 #include <villas/kernel/rt.hpp>
 #include <villas/path_source.h>
 #include <villas/path_destination.h>
+#include <villas/path_scheduler.h>
 
 using namespace villas;
 using namespace villas::node;
@@ -73,11 +74,7 @@ static void * path_run_single(void *arg)
 		if (ret <= 0)
 			continue;
 
-		for (size_t i = 0; i < vlist_length(&p->destinations); i++) {
-			struct vpath_destination *pd = (struct vpath_destination *) vlist_at(&p->destinations, i);
-
-			path_destination_write(pd, p);
-		}
+		path_write_destinations(p);
 	}
 
 	return nullptr;
@@ -102,31 +99,45 @@ static void * path_run_poll(void *arg)
 		p->logger->debug("Path {} returned from poll(2)", path_name(p));
 
 		for (int i = 0; i < p->reader.nfds; i++) {
-			struct vpath_source *ps = (struct vpath_source *) vlist_at(&p->sources, i);
+			if (p->reader.pfds[i].revents & POLLIN)
+				path_read_event(p, i);
+		}
 
-			if (p->reader.pfds[i].revents & POLLIN) {
-				/* Timeout: re-enqueue the last sample */
-				if (p->reader.pfds[i].fd == p->timeout.getFD()) {
-					p->timeout.wait();
+		path_write_destinations(p);
+	}
 
-					p->last_sample->sequence = p->last_sequence++;
+	return nullptr;
+}
 
-					path_destination_enqueue(p, &p->last_sample, 1);
-				}
-				/* A source is ready to receive samples */
-				else
-					path_source_read(ps, p, i);
-			}
-		}
+void path_read_event(struct vpath *p, int i)
+{
+	/* Timeout: re-enqueue the last sample */
+	if (p->reader.pfds[i].fd == p->timeout.getFD()) {
+		p->timeout.wait();
 
-		for (size_t i = 0; i < vlist_length(&p->destinations); i++) {
-			struct vpath_destination *pd = (struct vpath_destination *) vlist_at(&p->destinations, i);
+		p->last_sample->sequence = p->last_sequence++;
 
-			path_destination_write(pd, p);
-		}
+		path_destination_enqueue(p, &p->last_sample, 1);
+	}
+	/* A source is ready to receive samples */
+	else {
+		struct vpath_source *ps = (struct vpath_source *) vlist_at(&p->sources, i);
+
+		path_source_read(ps, p, i);
 	}
+}
 
-	return nullptr;
+void path_write_destinations(struct vpath *p)
+{
+	/* Destinations are drained by their own writer threads */
+	if (p->decouple)
+		return;
+
+	for (size_t i = 0; i < vlist_length(&p->destinations); i++) {
+		struct vpath_destination *pd = (struct vpath_destination *) vlist_at(&p->destinations, i);
+
+		path_destination_write(pd, p);
+	}
 }
 
 int path_init(struct vpath *p)
@@ -169,6 +180,11 @@ int path_init(struct vpath *p)
 	p->reader.pfds = nullptr;
 	p->reader.nfds = 0;
 
+	p->sched.scheduler = nullptr;
+	p->sched.worker = nullptr;
+	p->sched.events = nullptr;
+	p->sched.pending = 0;
+
 	/* Default values */
 	p->mode = PathMode::ANY;
 	p->rate = 0; /* Disabled */
@@ -177,10 +193,16 @@ int path_init(struct vpath *p)
 	p->reverse = 0;
 	p->enabled = 1;
 	p->poll = -1;
+	p->decouple = 0;
 	p->queuelen = DEFAULT_QUEUE_LENGTH;
 	p->original_sequence_no = -1;
 	p->affinity = 0;
 
+	p->memory.numa = PATH_MEMORY_NUMA_AUTO;
+	p->memory.hugepages = -1;
+	p->memory.policy = MemoryNumaPolicy::PREFERRED;
+	p->memory.type = nullptr;
+
 	p->state = State::INITIALIZED;
 
 	return 0;
@@ -193,6 +215,11 @@ static int path_prepare_poll(struct vpath *p)
 	if (p->reader.pfds)
 		delete[] p->reader.pfds;
 
+	if (p->sched.events) {
+		delete[] p->sched.events;
+		p->sched.events = nullptr;
+	}
+
 	p->reader.pfds = nullptr;
 	p->reader.nfds = 0;
 
@@ -234,17 +261,60 @@ static int path_prepare_poll(struct vpath *p)
 	return 0;
 }
 
+static int path_prepare_memory(struct vpath *p)
+{
+	struct memory_type *mt = memory_default;
+	int numa = p->memory.numa;
+
+	/* Hugepages are only available if they have been reserved by memory_init() */
+	if (p->memory.hugepages > 0 && mt != &memory_mmap_hugetlb)
+		p->logger->warn("No hugepages have been reserved. Path {} uses regular pages", path_name(p));
+	else if (p->memory.hugepages == 0 && mt == &memory_mmap_hugetlb)
+		mt = &memory_mmap;
+
+	if (numa == PATH_MEMORY_NUMA_AUTO) {
+		numa = p->affinity
+			? memory_numa_node(p->affinity)
+			: PATH_MEMORY_NUMA_NONE;
+
+		if (numa < 0 && p->affinity)
+			p->logger->debug("The affinity of path {} spans multiple NUMA nodes", path_name(p));
+	}
+
+	if (numa >= 0) {
+		/* NUMA policies can only be applied to whole pages */
+		if (!(mt->flags & (int) MemoryFlags::MMAP))
+			mt = &memory_mmap;
+
+		mt = memory_numa(numa, p->memory.policy, mt);
+		if (!mt)
+			return -1;
+
+		p->logger->debug("Allocating memory of path {} on NUMA node {}", path_name(p), numa);
+	}
+
+	p->memory.type = mt;
+
+	return 0;
+}
+
 int path_prepare(struct vpath *p, NodeList &nodes)
 {
 	int ret;
 	unsigned pool_size;
 
-	struct memory_type *pool_mt = memory_default;
+	struct memory_type *pool_mt;
 
 	assert(p->state == State::CHECKED);
 
 	p->mask.reset();
 
+	ret = path_prepare_memory(p);
+	if (ret)
+		return ret;
+
+	pool_mt = p->memory.type;
+
 	/* Prepare mappings */
 	ret = mapping_list_prepare(&p->mappings, nodes);
 	if (ret)
@@ -276,8 +346,8 @@ int path_prepare(struct vpath *p, NodeList &nodes)
 			 */
 			bool isSecondary = vlist_length(&n->sources) > 0;
 			ret = isSecondary
-				? path_source_init_secondary(ps, n)
-				: path_source_init_master(ps, n);
+				? path_source_init_secondary(ps, n, p->memory.type)
+				: path_source_init_master(ps, n, p->memory.type);
 			if (ret)
 				return ret;
 
@@ -338,9 +408,9 @@ int path_prepare(struct vpath *p, NodeList &nodes)
 			pool_size = node_type(pd->node)->pool_size;
 
 		if (node_type(pd->node)->memory_type)
-			pool_mt = node_memory_type(pd->node);
+			pool_mt = node_type(pd->node)->memory_type(pd->node, p->memory.type);
 
-		ret = path_destination_prepare(pd, p->queuelen);
+		ret = path_destination_prepare(pd, p->queuelen, p->decouple, p->memory.type);
 		if (ret)
 			return ret;
 	}
@@ -380,6 +450,28 @@ int path_prepare(struct vpath *p, NodeList &nodes)
 	if (ret)
 		return ret;
 
+	/* Samples of paths which are not muxed are forwarded by reference.
+	 * The re-sending of the last sample requires muxing as well as path hooks
+	 * which add more signals than the received samples can hold. */
+	if (!p->muxed) {
+		struct vpath_source *ps = (struct vpath_source *) vlist_at(&p->sources, 0);
+
+		if (p->rate > 0 || vlist_length(path_output_signals(p)) > vlist_length(node_input_signals(ps->node)))
+			p->muxed = 1;
+		else {
+			/* The received samples are now also held by the destination queues */
+			unsigned src_pool_size = MAX(DEFAULT_QUEUE_LENGTH, ps->node->in.vectorize);
+			if (node_type(ps->node)->pool_size)
+				src_pool_size = node_type(ps->node)->pool_size;
+
+			ret = path_source_resize_pool(ps, src_pool_size + vlist_length(&p->destinations) * p->queuelen);
+			if (ret)
+				return ret;
+
+			p->logger->debug("Forwarding samples of path {} by reference", path_name(p));
+		}
+	}
+
 	p->logger->info("Prepared path {} with {} output signals", path_name(p), vlist_length(path_output_signals(p)));
 	signal_list_dump(p->logger, path_output_signals(p));
 
@@ -395,6 +487,7 @@ int path_parse(struct vpath *p, json_t *json, NodeList &nodes, const uuid_t sn_u
 	json_error_t err;
 	json_t *json_in;
 	json_t *json_out = nullptr;
+	json_t *json_memory = nullptr;
 	json_t *json_hooks = nullptr;
 	json_t *json_mask = nullptr;
 
@@ -407,7 +500,7 @@ int path_parse(struct vpath *p, json_t *json, NodeList &nodes, const uuid_t sn_u
 	if (ret)
 		return ret;
 
-	ret = json_unpack_ex(json, &err, 0, "{ s: o, s?: o, s?: o, s?: b, s?: b, s?: b, s?: i, s?: s, s?: b, s?: F, s?: o, s?: b, s?: s, s?: i }",
+	ret = json_unpack_ex(json, &err, 0, "{ s: o, s?: o, s?: o, s?: b, s?: b, s?: b, s?: i, s?: s, s?: b, s?: F, s?: o, s?: b, s?: s, s?: i, s?: b, s?: o }",
 		"in", &json_in,
 		"out", &json_out,
 		"hooks", &json_hooks,
@@ -421,7 +514,9 @@ int path_parse(struct vpath *p, json_t *json, NodeList &nodes, const uuid_t sn_u
 		"mask", &json_mask,
 		"original_sequence_no", &p->original_sequence_no,
 		"uuid", &uuid_str,
-		"affinity", &p->affinity
+		"affinity", &p->affinity,
+		"decouple", &p->decouple,
+		"memory", &json_memory
 	);
 	if (ret)
 		throw ConfigError(json, err, "node-config-path", "Failed to parse path configuration");
@@ -486,6 +581,9 @@ int path_parse(struct vpath *p, json_t *json, NodeList &nodes, const uuid_t sn_u
 	if (json_mask)
 		path_parse_mask(p, json_mask, nodes);
 
+	if (json_memory)
+		path_parse_memory(p, json_memory);
+
 	ret = vlist_destroy(&destinations, nullptr, false);
 	if (ret)
 		return ret;
@@ -520,6 +618,52 @@ void path_parse_mask(struct vpath *p, json_t *json_mask, villas::node::NodeList
 	}
 }
 
+void path_parse_memory(struct vpath *p, json_t *json_memory)
+{
+	int ret;
+	json_error_t err;
+	json_t *json_numa = nullptr;
+	const char *policy = nullptr;
+	int hugepages = -1;
+
+	ret = json_unpack_ex(json_memory, &err, 0, "{ s?: o, s?: s, s?: b }",
+		"numa", &json_numa,
+		"policy", &policy,
+		"hugepages", &hugepages
+	);
+	if (ret)
+		throw ConfigError(json_memory, err, "node-config-path-memory", "Failed to parse memory settings of path {}", path_name(p));
+
+	if (json_is_integer(json_numa)) {
+		p->memory.numa = json_integer_value(json_numa);
+		if (p->memory.numa < 0 || p->memory.numa > MEMORY_NUMA_MAX_NODE)
+			throw ConfigError(json_numa, "node-config-path-memory", "Setting 'numa' must be between 0 and {}", MEMORY_NUMA_MAX_NODE);
+	}
+	else if (json_is_string(json_numa)) {
+		const char *numa = json_string_value(json_numa);
+
+		if (!strcmp(numa, "auto"))
+			p->memory.numa = PATH_MEMORY_NUMA_AUTO;
+		else if (!strcmp(numa, "none"))
+			p->memory.numa = PATH_MEMORY_NUMA_NONE;
+		else
+			throw ConfigError(json_numa, "node-config-path-memory", "Setting 'numa' must be a node number, 'auto' or 'none'");
+	}
+	else if (json_numa)
+		throw ConfigError(json_numa, "node-config-path-memory", "Setting 'numa' must be a node number, 'auto' or 'none'");
+
+	if (policy) {
+		if (!strcmp(policy, "preferred"))
+			p->memory.policy = MemoryNumaPolicy::PREFERRED;
+		else if (!strcmp(policy, "bind"))
+			p->memory.policy = MemoryNumaPolicy::BIND;
+		else
+			throw ConfigError(json_memory, "node-config-path-memory", "Invalid NUMA policy '{}'", policy);
+	}
+
+	p->memory.hugepages = hugepages;
+}
+
 void path_check(struct vpath *p)
 {
 	assert(p->state != State::DESTROYED);
@@ -568,6 +712,53 @@ void path_check(struct vpath *p)
 	p->state = State::CHECKED;
 }
 
+/** Stop the reader of a path and the writer threads of its first \p ndest destinations. */
+static int path_stop_threads(struct vpath *p, size_t ndest)
+{
+	int ret;
+
+	if (p->sched.worker) {
+		ret = path_scheduler_remove(p->sched.scheduler, p);
+		if (ret)
+			return ret;
+	}
+	else {
+		/* Cancel the thread in case is currently in a blocking syscall.
+		 *
+		 * We dont care if the thread has already been terminated.
+		 */
+		ret = pthread_cancel(p->tid);
+		if (ret && ret != ESRCH)
+			return ret;
+
+		ret = pthread_join(p->tid, nullptr);
+		if (ret)
+			return ret;
+	}
+
+	for (size_t i = 0; i < ndest; i++) {
+		struct vpath_destination *pd = (struct vpath_destination *) vlist_at(&p->destinations, i);
+
+		ret = path_destination_stop(pd);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/** Undo path_start() after it failed. The path can be started again afterwards. */
+static void path_start_abort(struct vpath *p)
+{
+#ifdef WITH_HOOKS
+	hook_list_stop(&p->hooks);
+#endif /* WITH_HOOKS */
+
+	sample_decref(p->last_sample);
+
+	p->state = State::PREPARED;
+}
+
 int path_start(struct vpath *p)
 {
 	int ret;
@@ -591,7 +782,7 @@ int path_start(struct vpath *p)
 
 	p->logger->info("Starting path {}: #signals={}({}), #hooks={}, #sources={}, "
 	                "#destinations={}, mode={}, poll={}, mask={:b}, rate={}, "
-	                "enabled={}, reversed={}, queuelen={}, original_sequence_no={}",
+	                "enabled={}, reversed={}, queuelen={}, original_sequence_no={}, decouple={}",
 		path_name(p),
 		vlist_length(&p->signals),
 		vlist_length(path_output_signals(p)),
@@ -605,7 +796,8 @@ int path_start(struct vpath *p)
 		path_is_enabled(p) ? "yes" : "no",
 		path_is_reversed(p) ? "yes" : "no",
 		p->queuelen,
-		p->original_sequence_no ? "yes" : "no"
+		p->original_sequence_no ? "yes" : "no",
+		p->decouple ? "yes" : "no"
 	);
 
 #ifdef WITH_HOOKS
@@ -634,18 +826,50 @@ int path_start(struct vpath *p)
 
 	p->state = State::STARTED;
 
-	/* Start one thread per path for sending to destinations
-	 *
-	 * Special case: If the path only has a single source and this source
-	 * does not offer a file descriptor for polling, we will use a special
-	 * thread function.
-	 */
-	ret = pthread_create(&p->tid, nullptr, p->poll ? path_run_poll : path_run_single, p);
-	if (ret)
-		return ret;
+	/* Many paths share the threads of the scheduler */
+	if (p->sched.scheduler && path_scheduler_eligible(p)) {
+		ret = path_scheduler_add(p->sched.scheduler, p);
+		if (ret) {
+			path_start_abort(p);
+			return ret;
+		}
+	}
+	else {
+		/* Start one thread per path for sending to destinations
+		 *
+		 * Special case: If the path only has a single source and this source
+		 * does not offer a file descriptor for polling, we will use a special
+		 * thread function.
+		 */
+		ret = pthread_create(&p->tid, nullptr, p->poll ? path_run_poll : path_run_single, p);
+		if (ret) {
+			path_start_abort(p);
+			return ret;
+		}
+
+		if (p->affinity)
+			kernel::rt::setThreadAffinity(p->tid, p->affinity);
+	}
+
+	/* Start one writer thread per destination */
+	if (p->decouple) {
+		for (size_t i = 0; i < vlist_length(&p->destinations); i++) {
+			struct vpath_destination *pd = (struct vpath_destination *) vlist_at(&p->destinations, i);
+
+			ret = path_destination_start(pd, p);
+			if (ret) {
+				p->logger->error("Failed to start writer thread for destination {} of path {}", node_name(pd->node), path_name(p));
+
+				/* Stop the reader and the writer threads which have already been started */
+				p->state = State::STOPPING;
 
-	if (p->affinity)
-		kernel::rt::setThreadAffinity(p->tid, p->affinity);
+				path_stop_threads(p, i);
+				path_start_abort(p);
+
+				return ret;
+			}
+		}
+	}
 
 	return 0;
 }
@@ -662,15 +886,7 @@ int path_stop(struct vpath *p)
 	if (p->state != State::STOPPING)
 		p->state = State::STOPPING;
 
-	/* Cancel the thread in case is currently in a blocking syscall.
-	 *
-	 * We dont care if the thread has already been terminated.
-	 */
-	ret = pthread_cancel(p->tid);
-	if (ret && ret != ESRCH)
-	 	return ret;
-
-	ret = pthread_join(p->tid, nullptr);
+	ret = path_stop_threads(p, p->decouple ? vlist_length(&p->destinations) : 0);
 	if (ret)
 		return ret;
 
@@ -716,6 +932,11 @@ int path_destroy(struct vpath *p)
 	if (p->reader.pfds)
 		delete[] p->reader.pfds;
 
+	if (p->sched.events) {
+		delete[] p->sched.events;
+		p->sched.events = nullptr;
+	}
+
 	if (p->_name)
 		free(p->_name);
 
@@ -723,6 +944,9 @@ int path_destroy(struct vpath *p)
 	if (ret)
 		return ret;
 
+	if (p->memory.type && !strcmp(p->memory.type->name, "numa"))
+		memory_numa_destroy(p->memory.type);
+
 	using bs = std::bitset<MAX_SAMPLE_LENGTH>;
 	using lg = std::shared_ptr<spdlog::logger>;
 
@@ -784,13 +1008,11 @@ bool path_is_simple(const struct vpath *p)
 
 bool path_is_muxed(const struct vpath *p)
 {
-	if (vlist_length(&p->sources) > 0)
-		return true;
-
-	if (vlist_length(&p->mappings) > 0)
+	/* Multiple mapping entries imply multiple sources or a reordering of signals */
+	if (vlist_length(&p->mappings) != 1)
 		return true;
 
-	struct mapping_entry *me = (struct mapping_entry *) vlist_at_safe(&p->mappings, 0);
+	struct mapping_entry *me = (struct mapping_entry *) vlist_at(&p->mappings, 0);
 
 	if (me->type != MappingType::DATA)
 		return true;
@@ -798,7 +1020,7 @@ bool path_is_muxed(const struct vpath *p)
 	if (me->data.offset != 0)
 		return true;
 
-	if (me->length != -1)
+	if (me->length != (int) vlist_length(node_input_signals(me->node)))
 		return true;
 
 	return false;
@@ -833,6 +1055,7 @@ json_t * path_to_json(struct vpath *p)
 	json_t *json_hooks = hook_list_to_json(&p->hooks);
 	json_t *json_sources = json_array();
 	json_t *json_destinations = json_array();
+	json_t *json_queues = json_array();
 
 	for (size_t i = 0; i < vlist_length(&p->sources); i++) {
 		struct vpath_source *pd = (struct vpath_source *) vlist_at_safe(&p->sources, i);
@@ -844,9 +1067,22 @@ json_t * path_to_json(struct vpath *p)
 		struct vpath_destination *pd = (struct vpath_destination *) vlist_at_safe(&p->destinations, i);
 
 		json_array_append_new(json_destinations, json_string(node_name_short(pd->node)));
+		json_array_append_new(json_queues, path_destination_to_json(pd));
+	}
+
+	json_t *json_memory = json_pack("{ s: s }",
+		"type", p->memory.type ? p->memory.type->name : "default"
+	);
+
+	if (p->memory.type && !strcmp(p->memory.type->name, "numa")) {
+		auto *mn = (struct memory_numa *) p->memory.type->_vd;
+
+		json_object_set_new(json_memory, "numa", json_integer(mn->node));
+		json_object_set_new(json_memory, "policy", json_string(mn->policy == MemoryNumaPolicy::BIND ? "bind" : "preferred"));
+		json_object_set_new(json_memory, "parent", json_string(mn->parent->name));
 	}
 
-	json_t *json_path = json_pack("{ s: s, s: s, s: s, s: b, s: b s: b, s: b, s: b, s: b s: i, s: o, s: o, s: o, s: o }",
+	json_t *json_path = json_pack("{ s: s, s: s, s: s, s: b, s: b s: b, s: b, s: b, s: b, s: b, s: i, s: o, s: o, s: o, s: o, s: o, s: o }",
 		"uuid", uuid,
 		"state", state_print(p->state),
 		"mode", p->mode == PathMode::ANY ? "any" : "all",
@@ -856,11 +1092,14 @@ json_t * path_to_json(struct vpath *p)
 		"original_sequence_no", p->original_sequence_no,
 		"last_sequence", p->last_sequence,
 		"poll", p->poll,
+		"decouple", p->decouple,
 		"queuelen", p->queuelen,
 		"signals", json_signals,
 		"hooks", json_hooks,
 		"in", json_sources,
-		"out", json_destinations
+		"out", json_destinations,
+		"destinations", json_queues,
+		"memory", json_memory
 	);
 
 	return json_path;
@@ -20,12 +20,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <cerrno>
+#include <cstring>
+
 #include <villas/utils.hpp>
 #include <villas/memory.h>
 #include <villas/sample.h>
 #include <villas/node.h>
 #include <villas/path.h>
 #include <villas/exceptions.hpp>
+#include <villas/kernel/rt.hpp>
 #include <villas/path_destination.h>
 
 using namespace villas;
@@ -33,17 +37,32 @@ using namespace villas;
 int path_destination_init(struct vpath_destination *pd, struct vnode *n)
 {
 	pd->node = n;
+	pd->path = nullptr;
+
+	pd->enqueued = 0;
+	pd->dropped = 0;
 
 	vlist_push(&n->destinations, pd);
 
 	return 0;
 }
 
-int path_destination_prepare(struct vpath_destination *pd, int queuelen)
+int path_destination_prepare(struct vpath_destination *pd, int queuelen, bool decouple, struct memory_type *mt)
 {
 	int ret;
 
-	ret = queue_init(&pd->queue, queuelen);
+	/* Only the writer threads of decoupled paths are blocking on the queue.
+	 * All other paths drain the queue from the path thread itself and therefore
+	 * do not need to be signalled. */
+	auto mode = decouple
+		? QueueSignalledMode::AUTO
+		: QueueSignalledMode::POLLING;
+
+	/* Samples are only enqueued by the path thread and dequeued either
+	 * by the path thread or the writer thread of the destination. */
+	int flags = (int) QueueFlags::SPSC;
+
+	ret = queue_signalled_init(&pd->queue, queuelen, mt, mode, flags);
 	if (ret)
 		return ret;
 
@@ -54,7 +73,7 @@ int path_destination_destroy(struct vpath_destination *pd)
 {
 	int ret;
 
-	ret = queue_destroy(&pd->queue);
+	ret = queue_signalled_destroy(&pd->queue);
 	if (ret)
 		return ret;
 
@@ -63,7 +82,7 @@ int path_destination_destroy(struct vpath_destination *pd)
 
 void path_destination_enqueue(struct vpath *p, const struct sample * const smps[], unsigned cnt)
 {
-	unsigned enqueued, cloned;
+	unsigned cloned;
 
 	struct sample *clones[cnt];
 
@@ -71,20 +90,60 @@ void path_destination_enqueue(struct vpath *p, const struct sample * const smps[
 	if (cloned < cnt)
 		p->logger->warn("Pool underrun in path {}", path_name(p));
 
+	path_destination_forward(p, clones, cloned);
+
+	sample_decref_many(clones, cloned);
+}
+
+void path_destination_forward(struct vpath *p, struct sample * const smps[], unsigned cnt)
+{
+	int ret;
+	unsigned enqueued;
+
+	sample_trace_many(smps, cnt, SampleTraceStage::ENQUEUED);
+
 	for (size_t i = 0; i < vlist_length(&p->destinations); i++) {
 		struct vpath_destination *pd = (struct vpath_destination *) vlist_at(&p->destinations, i);
 
-		enqueued = queue_push_many(&pd->queue, (void **) clones, cloned);
-		if (enqueued != cnt)
-			p->logger->warn("Queue overrun for path {}", path_name(p));
-
 		/* Increase reference counter of these samples as they are now also owned by the queue. */
-		sample_incref_many(clones, cloned);
+		sample_incref_many(smps, cnt);
+
+		ret = queue_signalled_push_many(&pd->queue, (void **) smps, cnt);
+		enqueued = ret > 0 ? ret : 0;
+		if (enqueued < cnt) {
+			/* Release the references of the samples which did not fit into the queue */
+			sample_decref_many(smps + enqueued, cnt - enqueued);
+
+			pd->dropped += cnt - enqueued;
+
+			p->logger->warn("Queue overrun for destination {} of path {}", node_name(pd->node), path_name(p));
+		}
+
+		pd->enqueued += enqueued;
 
 		p->logger->debug("Enqueued {} samples to destination {} of path {}", enqueued, node_name(pd->node), path_name(p));
 	}
+}
 
-	sample_decref_many(clones, cloned);
+static int path_destination_send(struct vpath_destination *pd, struct vpath *p, struct sample *smps[], int cnt)
+{
+	int sent;
+
+	sample_trace_many(smps, cnt, SampleTraceStage::DEQUEUED);
+
+	p->logger->debug("Dequeued {} samples from queue of node {} which is part of path {}", cnt, node_name(pd->node), path_name(p));
+
+	sent = node_write(pd->node, smps, cnt);
+	if (sent < 0)
+		p->logger->error("Failed to sent {} samples to node {}: reason={}", cnt, node_name(pd->node), sent);
+	else if (sent < cnt)
+		p->logger->debug("Partial write to node {}: written={}, expected={}", node_name(pd->node), sent, cnt);
+
+	int released = sample_decref_many(smps, cnt);
+
+	p->logger->debug("Released {} samples back to memory pool", released);
+
+	return sent;
 }
 
 void path_destination_write(struct vpath_destination *pd, struct vpath *p)
@@ -97,26 +156,108 @@ void path_destination_write(struct vpath_destination *pd, struct vpath *p)
 
 	/* As long as there are still samples in the queue */
 	while (1) {
-		allocated = queue_pull_many(&pd->queue, (void **) smps, cnt);
-		if (allocated == 0)
+		allocated = queue_pull_many(&pd->queue.queue, (void **) smps, cnt);
+		if (allocated <= 0)
 			break;
 		else if (allocated < cnt)
 			p->logger->debug("Queue underrun for path {}: allocated={} expected={}", path_name(p), allocated, cnt);
 
-		p->logger->debug("Dequeued {} samples from queue of node {} which is part of path {}", allocated, node_name(pd->node), path_name(p));
-
-		sent = node_write(pd->node, smps, allocated);
-		if (sent < 0) {
-			p->logger->error("Failed to sent {} samples to node {}: reason={}", cnt, node_name(pd->node), sent);
+		sent = path_destination_send(pd, p, smps, allocated);
+		if (sent < 0)
 			return;
-		}
-		else if (sent < allocated)
-			p->logger->debug("Partial write to node {}: written={}, expected={}", node_name(pd->node), sent, allocated);
+	}
+}
 
-		int released = sample_decref_many(smps, allocated);
+/** Writer thread function per destination:
+ *     dequeue samples -> write samples to destination node
+ *
+ * This thread is only used by paths which have the 'decouple'
+ * setting enabled. A slow destination node will then only
+ * overrun its own queue instead of stalling the path thread.
+ */
+static void * path_destination_run(void *arg)
+{
+	struct vpath_destination *pd = (struct vpath_destination *) arg;
+	struct vpath *p = pd->path;
+
+	int cnt = pd->node->out.vectorize;
+	int pulled;
 
-		p->logger->debug("Released {} samples back to memory pool", released);
+	struct sample *smps[cnt];
+
+	while (p->state == State::STARTED) {
+		pthread_testcancel();
+
+		/* Blocks until at least one sample is available */
+		pulled = queue_signalled_pull_many(&pd->queue, (void **) smps, cnt);
+		if (pulled < 0)
+			break;
+		else if (pulled == 0)
+			continue;
+
+		path_destination_send(pd, p, smps, pulled);
 	}
+
+	return nullptr;
+}
+
+int path_destination_start(struct vpath_destination *pd, struct vpath *p)
+{
+	int ret;
+
+	pd->path = p;
+
+	ret = pthread_create(&pd->tid, nullptr, path_destination_run, pd);
+	if (ret)
+		return ret;
+
+	if (pd->node->out.affinity)
+		kernel::rt::setThreadAffinity(pd->tid, pd->node->out.affinity);
+
+	if (pd->node->out.priority) {
+		struct sched_param param;
+
+		param.sched_priority = pd->node->out.priority;
+
+		ret = pthread_setschedparam(pd->tid, SCHED_FIFO, &param);
+		if (ret)
+			p->logger->warn("Failed to set real-time priority of writer thread for destination {}: {}", node_name(pd->node), strerror(ret));
+	}
+
+	return 0;
+}
+
+int path_destination_stop(struct vpath_destination *pd)
+{
+	int ret;
+
+	/* Cancel the thread as it is most likely blocked on the queue.
+	 *
+	 * We dont care if the thread has already been terminated.
+	 */
+	ret = pthread_cancel(pd->tid);
+	if (ret && ret != ESRCH)
+		return ret;
+
+	ret = pthread_join(pd->tid, nullptr);
+	if (ret)
+		return ret;
+
+	return 0;
+}
+
+json_t * path_destination_to_json(struct vpath_destination *pd)
+{
+	return json_pack("{ s: s, s: { s: I, s: I, s: I, s: I }, s: I, s: I }",
+		"node", node_name_short(pd->node),
+		"queue",
+			"depth", (json_int_t) queue_signalled_available(&pd->queue),
+			"length", (json_int_t) (pd->queue.queue.buffer_mask + 1),
+			"pushed", (json_int_t) pd->queue.pushed.load(),
+			"signalled", (json_int_t) pd->queue.signalled.load(),
+		"enqueued", (json_int_t) pd->enqueued.load(),
+		"dropped", (json_int_t) pd->dropped.load()
+	);
 }
 
 void path_destination_check(struct vpath_destination *pd)
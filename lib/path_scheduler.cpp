@@ -0,0 +1,508 @@
+/** Worker pool which runs many paths on a few threads.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <villas/utils.hpp>
+#include <villas/exceptions.hpp>
+#include <villas/path.h>
+#include <villas/path_scheduler.h>
+#include <villas/kernel/rt.hpp>
+
+using namespace villas;
+
+static void path_scheduler_notify(int fd)
+{
+	uint64_t incr = 1;
+	ssize_t ret __attribute__((unused));
+
+	ret = write(fd, &incr, sizeof(incr));
+}
+
+static void path_scheduler_clear(int fd)
+{
+	uint64_t cntr;
+	ssize_t ret __attribute__((unused));
+
+	ret = read(fd, &cntr, sizeof(cntr));
+}
+
+/* Events are registered with EPOLLONESHOT so that only one worker handles them.
+ * They are re-armed after the file descriptor has been read. */
+static int path_scheduler_arm(struct path_scheduler_event *e, int op)
+{
+	struct vpath *p = e->path;
+	struct epoll_event ev;
+
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.ptr = e;
+
+	return epoll_ctl(p->sched.worker->epfd, op, p->reader.pfds[e->index].fd, &ev);
+}
+
+/* Several events of the same path might be handled by different workers at
+ * the same time. The first worker becomes the owner of the path and handles
+ * all events of the path until none is pending anymore. */
+static void path_scheduler_handle(struct path_scheduler_event *e)
+{
+	struct vpath *p = e->path;
+	unsigned cnt = 1;
+
+	e->ready.store(true, std::memory_order_release);
+
+	if (p->sched.pending.fetch_add(1, std::memory_order_acq_rel) != 0)
+		return;
+
+	do {
+		for (int i = 0; i < p->reader.nfds; i++) {
+			struct path_scheduler_event *f = &p->sched.events[i];
+
+			if (!f->ready.exchange(false, std::memory_order_acq_rel))
+				continue;
+
+			/* A path which is not running anymore would not read the
+			 * file descriptor. It stays readable, so we do not re-arm it. */
+			if (p->state == State::STARTED) {
+				path_read_event(p, i);
+				path_scheduler_arm(f, EPOLL_CTL_MOD);
+			}
+			else
+				epoll_ctl(p->sched.worker->epfd, EPOLL_CTL_DEL, p->reader.pfds[i].fd, nullptr);
+		}
+
+		if (p->state == State::STARTED)
+			path_write_destinations(p);
+
+		cnt = p->sched.pending.fetch_sub(cnt, std::memory_order_acq_rel) - cnt;
+	} while (cnt > 0);
+}
+
+/** Take the next event from the current batch of worker \p w. */
+static struct path_scheduler_event * path_scheduler_take(struct path_scheduler_worker *w)
+{
+	uint64_t batch = w->batch.fetch_add(1, std::memory_order_acq_rel);
+
+	unsigned cnt = batch >> 32;
+	unsigned idx = batch & 0xffffffff;
+
+	return idx < cnt
+		? (struct path_scheduler_event *) w->events[idx].data.ptr
+		: nullptr;
+}
+
+static void path_scheduler_steal(struct path_scheduler_worker *w)
+{
+	struct path_scheduler *s = w->scheduler;
+	struct path_scheduler_event *e;
+
+	for (int i = 0; i < s->nworkers; i++) {
+		struct path_scheduler_worker *v = &s->workers[i];
+
+		if (v == w)
+			continue;
+
+		while ((e = path_scheduler_take(v))) {
+			path_scheduler_handle(e);
+
+			w->handled++;
+			w->stolen++;
+
+			/* The owner reuses its batch only after all stolen events have been handled */
+			v->taken.fetch_add(1, std::memory_order_release);
+		}
+	}
+}
+
+static void * path_scheduler_run(void *ctx)
+{
+	struct path_scheduler_worker *w = (struct path_scheduler_worker *) ctx;
+	struct path_scheduler *s = w->scheduler;
+	struct path_scheduler_event *e;
+
+	while (!s->stop) {
+		bool steal = false;
+		int ret, cnt = 0;
+
+		s->idle++;
+		ret = epoll_wait(w->epfd, w->events, PATH_SCHEDULER_BATCH, -1);
+		s->idle--;
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			throw SystemError("Failed to wait for events");
+		}
+
+		/* Separate our own control events from the events of the paths */
+		for (int i = 0; i < ret; i++) {
+			void *ptr = w->events[i].data.ptr;
+
+			if (ptr == w)
+				path_scheduler_clear(w->kick);
+			else if (ptr == s) {
+				path_scheduler_clear(s->steal);
+				steal = true;
+			}
+			else
+				w->events[cnt++] = w->events[i];
+		}
+
+		/* Publish the batch. Idle workers can help us if we have more than one event. */
+		w->taken.store(0, std::memory_order_relaxed);
+		w->batch.store((uint64_t) cnt << 32, std::memory_order_release);
+
+		if (cnt > 1 && s->idle > 0)
+			path_scheduler_notify(s->steal);
+
+		while ((e = path_scheduler_take(w))) {
+			path_scheduler_handle(e);
+
+			w->handled++;
+			w->taken.fetch_add(1, std::memory_order_release);
+		}
+
+		while (w->taken.load(std::memory_order_acquire) != (unsigned) cnt)
+			sched_yield();
+
+		w->batch.store(0, std::memory_order_release);
+
+		if (steal)
+			path_scheduler_steal(w);
+
+		w->loops.fetch_add(1, std::memory_order_release);
+	}
+
+	return nullptr;
+}
+
+/** Wait until all workers have completed the iteration of their loop during which this function was called. */
+static void path_scheduler_synchronize(struct path_scheduler *s)
+{
+	std::vector<uint64_t> loops(s->nworkers);
+
+	for (int i = 0; i < s->nworkers; i++) {
+		struct path_scheduler_worker *w = &s->workers[i];
+
+		loops[i] = w->loops.load(std::memory_order_acquire);
+
+		path_scheduler_notify(w->kick);
+	}
+
+	for (int i = 0; i < s->nworkers; i++) {
+		struct path_scheduler_worker *w = &s->workers[i];
+
+		while (w->loops.load(std::memory_order_acquire) == loops[i])
+			sched_yield();
+	}
+}
+
+/** Close the file descriptors and release the workers of a scheduler. */
+static void path_scheduler_release(struct path_scheduler *s)
+{
+	for (int i = 0; i < s->nworkers; i++) {
+		struct path_scheduler_worker *w = &s->workers[i];
+
+		if (w->epfd >= 0)
+			close(w->epfd);
+
+		if (w->kick >= 0)
+			close(w->kick);
+	}
+
+	if (s->steal >= 0)
+		close(s->steal);
+
+	delete[] s->workers;
+
+	s->workers = nullptr;
+	s->steal = -1;
+}
+
+int path_scheduler_init(struct path_scheduler *s, int workers, int affinity)
+{
+	int ret, cpu = 0;
+	struct epoll_event ev;
+
+	if (workers <= 0) {
+		workers = affinity
+			? __builtin_popcount(affinity)
+			: sysconf(_SC_NPROCESSORS_ONLN);
+
+		if (workers <= 0)
+			workers = 1;
+	}
+
+	s->affinity = affinity;
+	s->nworkers = workers;
+	s->stop = false;
+	s->idle = 0;
+
+	s->state = State::DESTROYED;
+
+	s->steal = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (s->steal < 0)
+		return -errno;
+
+	s->workers = new struct path_scheduler_worker[workers];
+
+	for (int i = 0; i < workers; i++) {
+		s->workers[i].epfd = -1;
+		s->workers[i].kick = -1;
+	}
+
+	for (int i = 0; i < workers; i++) {
+		struct path_scheduler_worker *w = &s->workers[i];
+
+		w->scheduler = s;
+		w->batch = 0;
+		w->taken = 0;
+		w->loops = 0;
+		w->paths = 0;
+		w->handled = 0;
+		w->stolen = 0;
+
+		/* Distribute the workers round-robin over the CPUs in the mask */
+		if (affinity) {
+			while (!(affinity & (1 << cpu)))
+				cpu = (cpu + 1) % (sizeof(affinity) * 8);
+
+			w->cpu = cpu;
+
+			cpu = (cpu + 1) % (sizeof(affinity) * 8);
+		}
+		else
+			w->cpu = -1;
+
+		w->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (w->epfd < 0)
+			goto fail;
+
+		w->kick = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (w->kick < 0)
+			goto fail;
+
+		ev.events = EPOLLIN;
+		ev.data.ptr = w;
+
+		ret = epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->kick, &ev);
+		if (ret)
+			goto fail;
+
+		/* Only one idle worker is woken up to steal events */
+		ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+		ev.data.ptr = s;
+
+		ret = epoll_ctl(w->epfd, EPOLL_CTL_ADD, s->steal, &ev);
+		if (ret)
+			goto fail;
+	}
+
+	s->state = State::INITIALIZED;
+
+	return 0;
+
+fail:
+	ret = -errno;
+
+	path_scheduler_release(s);
+
+	return ret;
+}
+
+int path_scheduler_destroy(struct path_scheduler *s)
+{
+	if (s->state == State::DESTROYED)
+		return 0;
+
+	path_scheduler_release(s);
+
+	s->state = State::DESTROYED;
+
+	return 0;
+}
+
+/** Stop and join the first \p cnt workers. */
+static int path_scheduler_join(struct path_scheduler *s, int cnt)
+{
+	int ret, err = 0;
+
+	s->stop = true;
+
+	for (int i = 0; i < cnt; i++)
+		path_scheduler_notify(s->workers[i].kick);
+
+	for (int i = 0; i < cnt; i++) {
+		ret = pthread_join(s->workers[i].tid, nullptr);
+		if (ret)
+			err = -ret;
+	}
+
+	return err;
+}
+
+int path_scheduler_start(struct path_scheduler *s)
+{
+	int ret;
+
+	assert(s->state == State::INITIALIZED || s->state == State::STOPPED);
+
+	s->stop = false;
+
+	for (int i = 0; i < s->nworkers; i++) {
+		struct path_scheduler_worker *w = &s->workers[i];
+
+		ret = pthread_create(&w->tid, nullptr, path_scheduler_run, w);
+		if (ret) {
+			/* Do not leave a partially started scheduler behind */
+			path_scheduler_join(s, i);
+
+			return -ret;
+		}
+
+		if (w->cpu >= 0)
+			kernel::rt::setThreadAffinity(w->tid, 1 << w->cpu);
+	}
+
+	s->state = State::STARTED;
+
+	return 0;
+}
+
+int path_scheduler_stop(struct path_scheduler *s)
+{
+	int ret;
+
+	if (s->state != State::STARTED)
+		return 0;
+
+	ret = path_scheduler_join(s, s->nworkers);
+	if (ret)
+		return ret;
+
+	s->state = State::STOPPED;
+
+	return 0;
+}
+
+bool path_scheduler_eligible(const struct vpath *p)
+{
+	/* Real-time critical paths are pinned to their own thread */
+	if (p->affinity)
+		return false;
+
+	/* Paths without polling block in node_read() */
+	if (!p->poll)
+		return false;
+
+	return p->reader.nfds > 0;
+}
+
+int path_scheduler_add(struct path_scheduler *s, struct vpath *p)
+{
+	int ret;
+	struct path_scheduler_worker *w = &s->workers[0];
+
+	assert(s->state == State::STARTED);
+	assert(p->state == State::STARTED);
+
+	for (int i = 1; i < s->nworkers; i++) {
+		if (s->workers[i].paths < w->paths)
+			w = &s->workers[i];
+	}
+
+	if (p->sched.events)
+		delete[] p->sched.events;
+
+	p->sched.events = new struct path_scheduler_event[p->reader.nfds];
+	p->sched.pending = 0;
+	p->sched.worker = w;
+
+	for (int i = 0; i < p->reader.nfds; i++) {
+		struct path_scheduler_event *e = &p->sched.events[i];
+
+		e->path = p;
+		e->index = i;
+		e->ready = false;
+
+		ret = path_scheduler_arm(e, EPOLL_CTL_ADD);
+		if (ret)
+			return -errno;
+	}
+
+	w->paths++;
+
+	p->logger->debug("Path {} is run by scheduler worker {}", path_name(p), w - s->workers);
+
+	return 0;
+}
+
+int path_scheduler_remove(struct path_scheduler *s, struct vpath *p)
+{
+	int ret;
+	struct path_scheduler_worker *w = p->sched.worker;
+
+	for (int i = 0; i < p->reader.nfds; i++) {
+		ret = epoll_ctl(w->epfd, EPOLL_CTL_DEL, p->reader.pfds[i].fd, nullptr);
+		if (ret && errno != ENOENT)
+			return -errno;
+	}
+
+	/* Events which have been received before might still be handled */
+	if (s->state == State::STARTED)
+		path_scheduler_synchronize(s);
+
+	w->paths--;
+
+	p->sched.worker = nullptr;
+
+	return 0;
+}
+
+json_t * path_scheduler_to_json(struct path_scheduler *s)
+{
+	json_t *json_workers = json_array();
+
+	for (int i = 0; i < s->nworkers; i++) {
+		struct path_scheduler_worker *w = &s->workers[i];
+
+		json_array_append_new(json_workers, json_pack("{ s: i, s: i, s: I, s: I }",
+			"cpu", w->cpu,
+			"paths", (int) w->paths,
+			"handled", (json_int_t) w->handled,
+			"stolen", (json_int_t) w->stolen
+		));
+	}
+
+	return json_pack("{ s: i, s: i, s: o }",
+		"affinity", s->affinity,
+		"idle", (int) s->idle,
+		"workers", json_workers
+	);
+}
@@ -20,6 +20,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <cstring>
+
 #include <fmt/format.h>
 
 #include <villas/utils.hpp>
@@ -36,13 +38,16 @@
 
 using namespace villas;
 
-int path_source_init_master(struct vpath_source *ps, struct vnode *n)
+int path_source_init_master(struct vpath_source *ps, struct vnode *n, struct memory_type *mt)
 {
 	int ret;
 
 	ps->node = n;
 	ps->masked = false;
 	ps->type = PathSourceType::MASTER;
+	ps->memory = node_type(n)->memory_type
+		? node_type(n)->memory_type(n, mt)
+		: mt;
 
 	ret = vlist_init(&ps->mappings);
 	if (ret)
@@ -57,19 +62,19 @@ int path_source_init_master(struct vpath_source *ps, struct vnode *n)
 	if (ps->node->_vt->pool_size)
 		pool_size = ps->node->_vt->pool_size;
 
-	ret = pool_init(&ps->pool, pool_size, SAMPLE_LENGTH(vlist_length(node_input_signals(ps->node))), node_memory_type(ps->node));
+	ret = pool_init(&ps->pool, pool_size, SAMPLE_LENGTH(vlist_length(node_input_signals(ps->node))), ps->memory);
 	if (ret)
 		return ret;
 
 	return 0;
 }
 
-int path_source_init_secondary(struct vpath_source *ps, struct vnode *n)
+int path_source_init_secondary(struct vpath_source *ps, struct vnode *n, struct memory_type *mt)
 {
 	int ret;
 	struct vpath_source *mps;
 
-	ret = path_source_init_master(ps, n);
+	ret = path_source_init_master(ps, n, mt);
 	if (ret)
 		return ret;
 
@@ -118,6 +123,7 @@ int path_source_destroy(struct vpath_source *ps)
 int path_source_read(struct vpath_source *ps, struct vpath *p, int i)
 {
 	int ret, recv, tomux, allocated, cnt, toenqueue, enqueued = 0;
+	bool forward;
 
 	cnt = ps->node->in.vectorize;
 
@@ -175,7 +181,26 @@ int path_source_read(struct vpath_source *ps, struct vpath *p, int i)
 		tomux = 1;
 	}
 
+	/* Samples of paths which do not need to be muxed are forwarded by reference.
+	 * This is only possible as long as no secondary path source shares them with us. */
+	forward = !p->muxed && vlist_length(&ps->secondaries) == 0;
+
 	for (int i = 0; i < tomux; i++) {
+		if (forward) {
+			muxed_smps[i] = tomux_smps[i];
+			muxed_smps[i]->signals = &p->signals;
+
+			if (!p->original_sequence_no) {
+				muxed_smps[i]->sequence = p->last_sequence++;
+				muxed_smps[i]->flags |= (int) SampleFlags::HAS_SEQUENCE;
+			}
+
+			if (muxed_smps[i]->length > 0)
+				muxed_smps[i]->flags |= (int) SampleFlags::HAS_DATA;
+
+			continue;
+		}
+
 		muxed_smps[i] = i == 0
 			? sample_clone(p->last_sample)
 			: sample_clone(muxed_smps[i-1]);
@@ -198,6 +223,8 @@ int path_source_read(struct vpath_source *ps, struct vpath *p, int i)
 		muxed_smps[i]->ts = tomux_smps[i]->ts;
 		muxed_smps[i]->flags |= tomux_smps[i]->flags & (int) SampleFlags::HAS_TS;
 
+		memcpy(muxed_smps[i]->trace, tomux_smps[i]->trace, sizeof(muxed_smps[i]->trace));
+
 		ret = mapping_list_remap(&ps->mappings, muxed_smps[i], tomux_smps[i]);
 		if (ret)
 			return ret;
@@ -206,7 +233,10 @@ int path_source_read(struct vpath_source *ps, struct vpath *p, int i)
 			muxed_smps[i]->flags |= (int) SampleFlags::HAS_DATA;
 	}
 
-	sample_copy(p->last_sample, muxed_smps[tomux-1]);
+	sample_trace_many(muxed_smps, tomux, SampleTraceStage::MUXED);
+
+	if (!forward)
+		sample_copy(p->last_sample, muxed_smps[tomux-1]);
 
 	p->logger->debug("Path {} received = {}", path_name(p), p->received.to_ullong());
 
@@ -221,15 +251,21 @@ int path_source_read(struct vpath_source *ps, struct vpath *p, int i)
 
 		p->logger->debug("Hooks skipped {} out of {} samples for path {}", skipped, tomux, path_name(p));
 	}
+
+	sample_trace_many(muxed_smps, toenqueue, SampleTraceStage::HOOKS_PATH);
 #else
 	toenqueue = tomux;
+
+	sample_trace_many(muxed_smps, toenqueue, SampleTraceStage::HOOKS_PATH);
 #endif
 
 	if (p->mask.test(i)) {
 		/* Check if we received an update from all nodes */
 		if ((p->mode == PathMode::ANY) ||
 		    (p->mode == PathMode::ALL && p->mask == p->received)) {
-			path_destination_enqueue(p, muxed_smps, toenqueue);
+			/* The muxed samples are exclusively owned by this path.
+			 * Hence we can pass them on by reference without cloning them again. */
+			path_destination_forward(p, muxed_smps, toenqueue);
 
 			/* Reset mask of updated nodes */
 			p->received.reset();
@@ -238,12 +274,32 @@ int path_source_read(struct vpath_source *ps, struct vpath *p, int i)
 		}
 	}
 
-	sample_decref_many(muxed_smps, tomux);
+	if (!forward)
+		sample_decref_many(muxed_smps, tomux);
 out2:	sample_decref_many(read_smps, recv);
 
 	return enqueued;
 }
 
+int path_source_resize_pool(struct vpath_source *ps, unsigned cnt)
+{
+	int ret;
+	size_t blocksz = ps->pool.blocksz;
+
+	if (cnt <= ps->pool.len / blocksz)
+		return 0;
+
+	ret = pool_destroy(&ps->pool);
+	if (ret)
+		return ret;
+
+	ret = pool_init(&ps->pool, cnt, blocksz, ps->memory);
+	if (ret)
+		return ret;
+
+	return 0;
+}
+
 void path_source_check(struct vpath_source *ps)
 {
 	if (!node_is_enabled(ps->node))
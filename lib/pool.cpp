@@ -20,6 +20,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <cstring>
+
+#include <sched.h>
+
 #include <villas/utils.hpp>
 #include <villas/exceptions.hpp>
 #include <villas/pool.h>
@@ -38,14 +42,32 @@ int pool_init(struct pool *p, size_t cnt, size_t blocksz, struct memory_type *m)
 	p->blocksz = p->alignment * CEIL(blocksz, p->alignment);
 	p->len = cnt * p->blocksz;
 
-	void *buffer = memory_alloc_aligned(p->len, p->alignment, m);
+	/* The per-thread caches are placed behind the blocks so that they
+	 * share the memory type of the pool. As they hold absolute pointers
+	 * they can not be used by pools which are shared between processes. */
+	bool cached = cnt >= POOL_MAGAZINE_THRESHOLD && !(m->flags & (int) MemoryFlags::SHARED);
+	size_t maglen = cached ? POOL_MAGAZINES * sizeof(struct pool_magazine) : 0;
+
+	void *buffer = memory_alloc_aligned(p->len + maglen, p->alignment, m);
 	if (!buffer)
 		throw MemoryAllocationError();
 
 	auto logger = logging.get("pool");
-	logger->debug("Allocated {:#x} bytes for memory pool", p->len);
+	logger->debug("Allocated {:#x} bytes for memory pool", p->len + maglen);
 
 	p->buffer_off = (char*) buffer - (char*) p;
+	p->magazines_off = 0;
+
+	if (cached) {
+		struct pool_magazine *mags = (struct pool_magazine *) ((char *) buffer + p->len);
+
+		for (unsigned i = 0; i < POOL_MAGAZINES; i++) {
+			new (&mags[i].locked) std::atomic<bool>(false);
+			mags[i].count = 0;
+		}
+
+		p->magazines_off = (char *) mags - (char *) p;
+	}
 
 	ret = queue_init(&p->queue, LOG2_CEIL(cnt), m);
 	if (ret)
@@ -77,3 +99,160 @@ int pool_destroy(struct pool *p)
 
 	return ret;
 }
+
+/** Index of the per-thread cache which is used by the calling thread. */
+static int pool_magazine_index()
+{
+	static std::atomic<unsigned> next(0);
+	static thread_local int index = -1;
+
+	if (index < 0)
+		index = next++ % POOL_MAGAZINES;
+
+	return index;
+}
+
+/** Lock the per-thread cache of the calling thread.
+ *
+ * @return nullptr if the cache is currently used by another thread.
+ */
+static struct pool_magazine * pool_magazine_lock(struct pool *p)
+{
+	struct pool_magazine *mag = &pool_magazines(p)[pool_magazine_index()];
+
+	if (mag->locked.exchange(true, std::memory_order_acquire))
+		return nullptr;
+
+	return mag;
+}
+
+static void pool_magazine_unlock(struct pool_magazine *mag)
+{
+	mag->locked.store(false, std::memory_order_release);
+}
+
+/** Return blocks to the shared queue.
+ *
+ * The queue can hold all blocks of the pool. Hence, a failed push is only
+ * caused by a concurrent pull which has not finished yet and we retry.
+ */
+static void pool_push_all(struct pool *p, void *blocks[], size_t cnt)
+{
+	int ret;
+
+	for (size_t done = 0; done < cnt; done += ret) {
+		ret = queue_push_many(&p->queue, &blocks[done], cnt - done);
+		if (ret < 0)
+			break; /* The queue has been closed */
+		else if (ret == 0)
+			sched_yield();
+	}
+}
+
+/** Take blocks from the caches of other threads if the shared queue ran empty. */
+static size_t pool_magazine_steal(struct pool *p, void *blocks[], size_t cnt)
+{
+	size_t got = 0;
+
+	for (unsigned i = 0; i < POOL_MAGAZINES && got < cnt; i++) {
+		struct pool_magazine *mag = &pool_magazines(p)[i];
+
+		if (mag->locked.exchange(true, std::memory_order_acquire))
+			continue;
+
+		size_t take = MIN(cnt - got, mag->count);
+		mag->count -= take;
+		memcpy(&blocks[got], &mag->blocks[mag->count], take * sizeof(void *));
+
+		got += take;
+
+		pool_magazine_unlock(mag);
+	}
+
+	return got;
+}
+
+ssize_t pool_get_many_cached(struct pool *p, void *blocks[], size_t cnt)
+{
+	int ret;
+	size_t got, take;
+	struct pool_magazine *mag;
+
+	mag = pool_magazine_lock(p);
+	if (!mag) {
+		ret = queue_pull_many(&p->queue, blocks, cnt);
+		got = ret > 0 ? ret : 0;
+
+		if (got < cnt)
+			got += pool_magazine_steal(p, &blocks[got], cnt - got);
+
+		return got;
+	}
+
+	take = MIN(cnt, mag->count);
+	mag->count -= take;
+	memcpy(blocks, &mag->blocks[mag->count], take * sizeof(void *));
+
+	got = take;
+
+	if (got < cnt) {
+		if (cnt - got >= POOL_MAGAZINE_SIZE) {
+			/* Large requests bypass the cache */
+			ret = queue_pull_many(&p->queue, &blocks[got], cnt - got);
+			if (ret > 0)
+				got += ret;
+		}
+		else {
+			/* Refill the cache with a full batch */
+			ret = queue_pull_many(&p->queue, mag->blocks, POOL_MAGAZINE_SIZE);
+			mag->count = ret > 0 ? ret : 0;
+
+			take = MIN(cnt - got, mag->count);
+			mag->count -= take;
+			memcpy(&blocks[got], &mag->blocks[mag->count], take * sizeof(void *));
+
+			got += take;
+		}
+	}
+
+	pool_magazine_unlock(mag);
+
+	if (got < cnt)
+		got += pool_magazine_steal(p, &blocks[got], cnt - got);
+
+	return got;
+}
+
+ssize_t pool_put_many_cached(struct pool *p, void *blocks[], size_t cnt)
+{
+	size_t done, put;
+	struct pool_magazine *mag;
+
+	mag = pool_magazine_lock(p);
+	if (!mag) {
+		pool_push_all(p, blocks, cnt);
+		return cnt;
+	}
+
+	for (done = 0; done < cnt; done += put) {
+		/* Large releases bypass the cache */
+		if (cnt - done >= POOL_MAGAZINE_SIZE) {
+			pool_push_all(p, &blocks[done], cnt - done);
+			break;
+		}
+
+		/* Flush the upper half of a full cache */
+		if (mag->count == POOL_MAGAZINE_SIZE) {
+			pool_push_all(p, &mag->blocks[POOL_MAGAZINE_SIZE / 2], POOL_MAGAZINE_SIZE / 2);
+			mag->count = POOL_MAGAZINE_SIZE / 2;
+		}
+
+		put = MIN(cnt - done, POOL_MAGAZINE_SIZE - mag->count);
+		memcpy(&mag->blocks[mag->count], &blocks[done], put * sizeof(void *));
+		mag->count += put;
+	}
+
+	pool_magazine_unlock(mag);
+
+	return cnt;
+}
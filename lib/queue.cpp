@@ -39,7 +39,7 @@
 using namespace villas;
 
 /** Initialize MPMC queue */
-int queue_init(struct queue *q, size_t size, struct memory_type *m)
+int queue_init(struct queue *q, size_t size, struct memory_type *m, int flags)
 {
 	/* Queue size must be 2 exponent */
 	if (!IS_POW2(size)) {
@@ -51,6 +51,7 @@ int queue_init(struct queue *q, size_t size, struct memory_type *m)
 	}
 
 	q->buffer_mask = size - 1;
+	q->flags = flags;
 	struct queue_cell *buffer = (struct queue_cell *) memory_alloc(sizeof(struct queue_cell) * size, m);
 	if (!buffer)
 		return -2;
@@ -68,6 +69,9 @@ int queue_init(struct queue *q, size_t size, struct memory_type *m)
 	std::atomic_store_explicit(&q->head, 0u, std::memory_order_relaxed);
 #endif
 
+	q->head_cache = 0;
+	q->tail_cache = 0;
+
 	q->state = State::INITIALIZED;
 
 	return 0;
@@ -94,12 +98,73 @@ size_t queue_available(struct queue *q)
 		std::atomic_load_explicit(&q->head, std::memory_order_relaxed);
 }
 
+/** Enqueue into a single-producer, single-consumer queue.
+ *
+ * Only the producer writes the tail pointer. The head pointer is only
+ * re-read if the cached copy indicates a full queue.
+ */
+static int queue_push_many_spsc(struct queue *q, void *ptr[], size_t cnt)
+{
+	struct queue_cell *buffer;
+	size_t tail, size = q->buffer_mask + 1;
+
+	if (std::atomic_load_explicit(&q->state, std::memory_order_relaxed) == State::STOPPED)
+		return -1;
+
+	buffer = (struct queue_cell *) ((char *) q + q->buffer_off);
+	tail = std::atomic_load_explicit(&q->tail, std::memory_order_relaxed);
+
+	if (tail - q->head_cache + cnt > size)
+		q->head_cache = std::atomic_load_explicit(&q->head, std::memory_order_acquire);
+
+	cnt = MIN(cnt, size - (tail - q->head_cache));
+
+	for (size_t i = 0; i < cnt; i++)
+		buffer[(tail + i) & q->buffer_mask].data_off = (char *) ptr[i] - (char *) q;
+
+	std::atomic_store_explicit(&q->tail, tail + cnt, std::memory_order_release);
+
+	return cnt;
+}
+
+/** Dequeue from a single-producer, single-consumer queue.
+ *
+ * Only the consumer writes the head pointer. The tail pointer is only
+ * re-read if the cached copy indicates an empty queue.
+ */
+static int queue_pull_many_spsc(struct queue *q, void *ptr[], size_t cnt)
+{
+	struct queue_cell *buffer;
+	size_t head;
+
+	if (std::atomic_load_explicit(&q->state, std::memory_order_relaxed) == State::STOPPED)
+		return -1;
+
+	buffer = (struct queue_cell *) ((char *) q + q->buffer_off);
+	head = std::atomic_load_explicit(&q->head, std::memory_order_relaxed);
+
+	if (q->tail_cache - head < cnt)
+		q->tail_cache = std::atomic_load_explicit(&q->tail, std::memory_order_acquire);
+
+	cnt = MIN(cnt, q->tail_cache - head);
+
+	for (size_t i = 0; i < cnt; i++)
+		ptr[i] = (char *) q + buffer[(head + i) & q->buffer_mask].data_off;
+
+	std::atomic_store_explicit(&q->head, head + cnt, std::memory_order_release);
+
+	return cnt;
+}
+
 int queue_push(struct queue *q, void *ptr)
 {
 	struct queue_cell *cell, *buffer;
 	size_t pos, seq;
 	intptr_t diff;
 
+	if (q->flags & (int) QueueFlags::SPSC)
+		return queue_push_many_spsc(q, &ptr, 1);
+
 	if (std::atomic_load_explicit(&q->state, std::memory_order_relaxed) == State::STOPPED)
 		return -1;
 
@@ -132,6 +197,9 @@ int queue_pull(struct queue *q, void **ptr)
 	size_t pos, seq;
 	intptr_t diff;
 
+	if (q->flags & (int) QueueFlags::SPSC)
+		return queue_pull_many_spsc(q, ptr, 1);
+
 	if (std::atomic_load_explicit(&q->state, std::memory_order_relaxed) == State::STOPPED)
 		return -1;
 
@@ -163,6 +231,9 @@ int queue_push_many(struct queue *q, void *ptr[], size_t cnt)
 	int ret;
 	size_t i;
 
+	if (q->flags & (int) QueueFlags::SPSC)
+		return queue_push_many_spsc(q, ptr, cnt);
+
 	for (i = 0; i < cnt; i++) {
 		ret = queue_push(q, ptr[i]);
 		if (ret <= 0)
@@ -180,6 +251,9 @@ int queue_pull_many(struct queue *q, void *ptr[], size_t cnt)
 	int ret;
 	size_t i;
 
+	if (q->flags & (int) QueueFlags::SPSC)
+		return queue_pull_many_spsc(q, ptr, cnt);
+
 	for (i = 0; i < cnt; i++) {
 		ret = queue_pull(q, &ptr[i]);
 		if (ret <= 0)
@@ -21,13 +21,20 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <ctime>
+#include <unistd.h>
+
 #include <villas/node/config.h>
+#include <villas/utils.hpp>
 #include <villas/queue_signalled.h>
 
 #ifdef HAS_EVENTFD
   #include <sys/eventfd.h>
 #endif
 
+/** Number of unsuccessful attempts after which a spinning consumer checks its budget. */
+#define QUEUE_SIGNALLED_SPIN_CHECK	16
+
 static void queue_signalled_cleanup(void *p)
 {
 	struct queue_signalled *qs = (struct queue_signalled *) p;
@@ -36,11 +43,113 @@ static void queue_signalled_cleanup(void *p)
 		pthread_mutex_unlock(&qs->pthread.mutex);
 }
 
+static int64_t queue_signalled_clock()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+/** Check if the queue is armed and hence the consumer needs to be signalled.
+ *
+ * The queue is disarmed by the first push after the consumer has consumed
+ * the last signal. Hence, producers only signal on the transition from an
+ * empty to a non-empty queue.
+ */
+static bool queue_signalled_disarm(struct queue_signalled *qs)
+{
+	/* Pairs with the fence in queue_signalled_arm() */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (!qs->armed.load(std::memory_order_relaxed) || !qs->armed.exchange(false))
+		return false;
+
+	qs->signalled.fetch_add(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+/** Request a signal for the next push.
+ *
+ * The consumer needs to check the queue once again afterwards, as producers
+ * which have pushed in the meantime did not see the armed queue.
+ */
+static void queue_signalled_arm(struct queue_signalled *qs)
+{
+	qs->armed.store(true, std::memory_order_relaxed);
+
+	/* Pairs with the fence in queue_signalled_disarm() */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/** Spin on an empty queue until elements become available or the budget is exhausted. */
+static int queue_signalled_spin(struct queue_signalled *qs, void *ptr[], size_t cnt, int64_t start)
+{
+	int pulled = 0;
+	int budget = qs->adaptive.budget.load(std::memory_order_relaxed);
+
+	if (budget <= 0)
+		return 0;
+
+	/* Producers do not need to signal us while we are spinning */
+	qs->armed.store(false, std::memory_order_relaxed);
+
+	for (unsigned i = 1; ; i++) {
+		pulled = queue_pull_many(&qs->queue, ptr, cnt);
+		if (pulled != 0)
+			break;
+
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+
+		if (i % QUEUE_SIGNALLED_SPIN_CHECK == 0 && queue_signalled_clock() - start >= budget)
+			break;
+	}
+
+	queue_signalled_arm(qs);
+
+	if (pulled == 0)
+		pulled = queue_pull_many(&qs->queue, ptr, cnt);
+
+	return pulled;
+}
+
+/** Move the spin budget towards twice the last waiting time.
+ *
+ * Consumers which wait longer than QUEUE_SIGNALLED_SPIN_MAX stop spinning eventually.
+ */
+static void queue_signalled_tune(struct queue_signalled *qs, int64_t waited)
+{
+	if (!qs->adaptive.tune)
+		return;
+
+	int64_t budget = qs->adaptive.budget.load(std::memory_order_relaxed);
+	int64_t target = waited <= QUEUE_SIGNALLED_SPIN_MAX
+		? MIN(2 * waited, QUEUE_SIGNALLED_SPIN_MAX)
+		: 0;
+
+	budget += (target - budget) / 8;
+
+	qs->adaptive.budget.store(budget, std::memory_order_relaxed);
+}
+
 int queue_signalled_init(struct queue_signalled *qs, size_t size, struct memory_type *mem, enum QueueSignalledMode mode, int flags)
 {
 	int ret;
 
 	qs->mode = mode;
+	qs->flags = (enum QueueSignalledFlags) flags;
+
+	qs->armed = true;
+	qs->pushed = 0;
+	qs->signalled = 0;
+
+	/* Spinning only pays off if producers and consumers run in parallel */
+	qs->adaptive.budget = 0;
+	qs->adaptive.tune = sysconf(_SC_NPROCESSORS_ONLN) > 1;
 
 	if (qs->mode == QueueSignalledMode::AUTO) {
 #ifdef __linux__
@@ -63,7 +172,7 @@ int queue_signalled_init(struct queue_signalled *qs, size_t size, struct memory_
 #endif
 	}
 
-	ret = queue_init(&qs->queue, size, mem);
+	ret = queue_init(&qs->queue, size, mem, flags & (int) QueueFlags::SPSC);
 	if (ret < 0)
 		return ret;
 
@@ -141,14 +250,9 @@ int queue_signalled_destroy(struct queue_signalled *qs)
 	return 0;
 }
 
-int queue_signalled_push(struct queue_signalled *qs, void *ptr)
+/** Wake up the consumer. */
+static int queue_signalled_signal(struct queue_signalled *qs)
 {
-	int pushed;
-
-	pushed = queue_push(&qs->queue, ptr);
-	if (pushed < 0)
-		return pushed;
-
 	if (qs->mode == QueueSignalledMode::PTHREAD) {
 		pthread_mutex_lock(&qs->pthread.mutex);
 		pthread_cond_broadcast(&qs->pthread.ready);
@@ -177,100 +281,57 @@ int queue_signalled_push(struct queue_signalled *qs, void *ptr)
 	else
 		return -1;
 
-	return pushed;
+	return 0;
+}
+
+int queue_signalled_push(struct queue_signalled *qs, void *ptr)
+{
+	return queue_signalled_push_many(qs, &ptr, 1);
 }
 
 int queue_signalled_push_many(struct queue_signalled *qs, void *ptr[], size_t cnt)
 {
-	int pushed;
+	int ret, pushed;
 
 	pushed = queue_push_many(&qs->queue, ptr, cnt);
 	if (pushed < 0)
 		return pushed;
 
-	if (qs->mode == QueueSignalledMode::PTHREAD) {
-		pthread_mutex_lock(&qs->pthread.mutex);
-		pthread_cond_broadcast(&qs->pthread.ready);
-		pthread_mutex_unlock(&qs->pthread.mutex);
-	}
-	else if (qs->mode == QueueSignalledMode::POLLING) {
-		/* Nothing todo */
-	}
-#ifdef HAS_EVENTFD
-	else if (qs->mode == QueueSignalledMode::EVENTFD) {
-		int ret;
-		uint64_t incr = 1;
-		ret = write(qs->eventfd, &incr, sizeof(incr));
-		if (ret < 0)
-			return ret;
-	}
-#elif defined(__APPLE__)
-	else if (qs->mode == QueueSignalledMode::PIPE) {
-		int ret;
-		uint8_t incr = 1;
-		ret = write(qs->pipe[1], &incr, sizeof(incr));
+	qs->pushed.fetch_add(pushed, std::memory_order_relaxed);
+
+	if (queue_signalled_disarm(qs)) {
+		ret = queue_signalled_signal(qs);
 		if (ret < 0)
 			return ret;
 	}
-#endif
-	else
-		return -1;
 
 	return pushed;
 }
 
 int queue_signalled_pull(struct queue_signalled *qs, void **ptr)
 {
-	int pulled = 0;
-
-	/* Make sure that qs->mutex is unlocked if this thread gets cancelled. */
-	pthread_cleanup_push(queue_signalled_cleanup, qs);
-
-	if (qs->mode == QueueSignalledMode::PTHREAD)
-		pthread_mutex_lock(&qs->pthread.mutex);
+	return queue_signalled_pull_many(qs, ptr, 1);
+}
 
-	while (!pulled) {
-		pulled = queue_pull(&qs->queue, ptr);
-		if (pulled < 0)
-			break;
-		else if (pulled == 0) {
-			if (qs->mode == QueueSignalledMode::PTHREAD)
-				pthread_cond_wait(&qs->pthread.ready, &qs->pthread.mutex);
-			else if (qs->mode == QueueSignalledMode::POLLING)
-				continue; /* Try again */
-#ifdef HAS_EVENTFD
-			else if (qs->mode == QueueSignalledMode::EVENTFD) {
-				int ret;
-				uint64_t cntr;
-				ret = read(qs->eventfd, &cntr, sizeof(cntr));
-				if (ret < 0)
-					break;
-			}
-#elif defined(__APPLE__)
-			else if (qs->mode == QueueSignalledMode::PIPE) {
-				int ret;
-				uint8_t incr = 1;
-				ret = read(qs->pipe[0], &incr, sizeof(incr));
-				if (ret < 0)
-					break;
-			}
-#endif
-			else
-				break;
-		}
-	}
+int queue_signalled_pull_many(struct queue_signalled *qs, void *ptr[], size_t cnt)
+{
+	int pulled;
+	int64_t start = 0;
+	bool rearmed = false;
 
-	if (qs->mode == QueueSignalledMode::PTHREAD)
-		pthread_mutex_unlock(&qs->pthread.mutex);
+	bool adaptive = qs->mode != QueueSignalledMode::POLLING &&
+	                ((int) qs->flags & (int) QueueSignalledFlags::ADAPTIVE);
 
-	pthread_cleanup_pop(0);
+	pulled = queue_pull_many(&qs->queue, ptr, cnt);
+	if (pulled != 0)
+		return pulled;
 
-	return pulled;
-}
+	if (adaptive) {
+		start = queue_signalled_clock();
 
-int queue_signalled_pull_many(struct queue_signalled *qs, void *ptr[], size_t cnt)
-{
-	int pulled = 0;
+		pulled = queue_signalled_spin(qs, ptr, cnt, start);
+		rearmed = true;
+	}
 
 	/* Make sure that qs->mutex is unlocked if this thread gets cancelled. */
 	pthread_cleanup_push(queue_signalled_cleanup, qs);
@@ -283,10 +344,17 @@ int queue_signalled_pull_many(struct queue_signalled *qs, void *ptr[], size_t cn
 		if (pulled < 0)
 			break;
 		else if (pulled == 0) {
-			if (qs->mode == QueueSignalledMode::PTHREAD)
-				pthread_cond_wait(&qs->pthread.ready, &qs->pthread.mutex);
-			else if (qs->mode == QueueSignalledMode::POLLING)
+			if (qs->mode == QueueSignalledMode::POLLING)
 				continue; /* Try again */
+			else if (qs->mode == QueueSignalledMode::PTHREAD) {
+				/* Check again after arming as signals are not buffered by the condition variable */
+				if (!qs->armed.load(std::memory_order_relaxed)) {
+					queue_signalled_arm(qs);
+					continue;
+				}
+
+				pthread_cond_wait(&qs->pthread.ready, &qs->pthread.mutex);
+			}
 #ifdef HAS_EVENTFD
 			else if (qs->mode == QueueSignalledMode::EVENTFD) {
 				int ret;
@@ -294,6 +362,10 @@ int queue_signalled_pull_many(struct queue_signalled *qs, void *ptr[], size_t cn
 				ret = read(qs->eventfd, &cntr, sizeof(cntr));
 				if (ret < 0)
 					break;
+
+				/* The counter has been reset. Hence, the next push needs to signal again. */
+				queue_signalled_arm(qs);
+				rearmed = true;
 			}
 #elif defined(__APPLE__)
 			else if (qs->mode == QueueSignalledMode::PIPE) {
@@ -302,6 +374,10 @@ int queue_signalled_pull_many(struct queue_signalled *qs, void *ptr[], size_t cn
 				ret = read(qs->pipe[0], &incr, sizeof(incr));
 				if (ret < 0)
 					break;
+
+				/* The signal has been consumed. Hence, the next push needs to signal again. */
+				queue_signalled_arm(qs);
+				rearmed = true;
 			}
 #endif
 			else
@@ -314,6 +390,17 @@ int queue_signalled_pull_many(struct queue_signalled *qs, void *ptr[], size_t cn
 
 	pthread_cleanup_pop(0);
 
+	if (pulled > 0) {
+		if (adaptive)
+			queue_signalled_tune(qs, queue_signalled_clock() - start);
+
+		/* Elements which have been pushed before we re-armed the queue did not signal.
+		 * We signal them ourself to keep the file descriptor readable for consumers which poll it. */
+		if (rearmed && qs->mode != QueueSignalledMode::PTHREAD &&
+		    queue_available(&qs->queue) > 0 && queue_signalled_disarm(qs))
+			queue_signalled_signal(qs);
+	}
+
 	return pulled;
 }
 
@@ -358,6 +445,12 @@ int queue_signalled_close(struct queue_signalled *qs)
 	return ret;
 }
 
+void queue_signalled_set_spin(struct queue_signalled *qs, int ns)
+{
+	qs->adaptive.tune = ns < 0;
+	qs->adaptive.budget = ns < 0 ? 0 : ns;
+}
+
 int queue_signalled_fd(struct queue_signalled *qs)
 {
 	switch (qs->mode) {
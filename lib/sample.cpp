@@ -44,6 +44,8 @@ int sample_init(struct sample *s)
 	s->capacity = (p->blocksz - sizeof(struct sample)) / sizeof(s->data[0]);
 	s->refcnt = ATOMIC_VAR_INIT(1);
 
+	memset(s->trace, 0, sizeof(s->trace));
+
 	return 0;
 }
 
@@ -108,21 +110,70 @@ int sample_alloc_many(struct pool *p, struct sample *smps[], int cnt)
 	return ret;
 }
 
+/** Collects released samples of the same pool to return them in a single batch. */
+struct sample_release_batch {
+	struct pool *pool;
+	unsigned count;
+
+	void *blocks[POOL_MAGAZINE_SIZE];
+};
+
+static void sample_release_flush(struct sample_release_batch *b)
+{
+	if (b->count > 0)
+		pool_put_many(b->pool, b->blocks, b->count);
+
+	b->count = 0;
+}
+
+static void sample_release(struct sample_release_batch *b, struct sample *s)
+{
+	struct pool *p = sample_pool(s);
+
+	if (!p) {
+		delete[] (char *) s;
+		return;
+	}
+
+	if (p != b->pool || b->count == POOL_MAGAZINE_SIZE) {
+		sample_release_flush(b);
+		b->pool = p;
+	}
+
+	b->blocks[b->count++] = s;
+}
+
 void sample_free_many(struct sample *smps[], int cnt)
 {
+	struct sample_release_batch b;
+
+	b.pool = nullptr;
+	b.count = 0;
+
 	for (int i = 0; i < cnt; i++)
-		sample_free(smps[i]);
+		sample_release(&b, smps[i]);
+
+	sample_release_flush(&b);
 }
 
 int sample_decref_many(struct sample * const smps[], int cnt)
 {
 	int released = 0;
+	struct sample_release_batch b;
+
+	b.pool = nullptr;
+	b.count = 0;
 
 	for (int i = 0; i < cnt; i++) {
-		if (sample_decref(smps[i]) == 0)
+		/* Did we had the last reference? */
+		if (atomic_fetch_sub(&smps[i]->refcnt, 1) == 1) {
+			sample_release(&b, smps[i]);
 			released++;
+		}
 	}
 
+	sample_release_flush(&b);
+
 	return released;
 }
 
@@ -134,6 +185,21 @@ int sample_incref_many(struct sample * const smps[], int cnt)
 	return cnt;
 }
 
+void sample_trace_many(struct sample * const smps[], int cnt, enum SampleTraceStage stage)
+{
+	struct timespec now;
+
+	if (cnt <= 0)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	uint64_t ns = now.tv_sec * 1000000000ull + now.tv_nsec;
+
+	for (int i = 0; i < cnt; i++)
+		smps[i]->trace[(int) stage] = ns;
+}
+
 int sample_incref(struct sample *s)
 {
 	return atomic_fetch_add(&s->refcnt, 1) + 1;
@@ -325,7 +391,7 @@ void sample_data_insert(struct sample *smp, const union signal_data *src, size_t
 
 void sample_data_remove(struct sample *smp, size_t offset, size_t len)
 {
-	size_t sz = sizeof(smp->data[0]) * len;
+	size_t sz = sizeof(smp->data[0]) * (smp->length - offset - len);
 
 	memmove(&smp->data[offset], &smp->data[offset + len], sz);
 
@@ -23,6 +23,7 @@
 
 #include <cerrno>
 #include <fcntl.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -32,6 +33,7 @@
 #include <villas/utils.hpp>
 #include <villas/sample.h>
 #include <villas/shmem.h>
+#include <villas/timing.h>
 
 using namespace villas;
 
@@ -96,12 +98,15 @@ retry:	fd = shm_open(wname, O_RDWR|O_CREAT|O_EXCL, 0600);
 	close(fd);
 
 	manager = memory_managed(base, len);
+	manager->flags |= (int) MemoryFlags::SHARED;
+
 	shared = (struct shmem_shared *) memory_alloc(sizeof(struct shmem_shared), manager);
 	if (!shared) {
 		errno = ENOMEM;
 		return -5;
 	}
 
+	shared->version = SHMEM_VERSION;
 	shared->polling = conf->polling;
 
 	int flags = (int) QueueSignalledFlags::PROCESS_SHARED;
@@ -147,6 +152,13 @@ retry:	fd = shm_open(wname, O_RDWR|O_CREAT|O_EXCL, 0600);
 
 	cptr = (char *) base + sizeof(struct memory_type) + sizeof(struct memory_block);
 	shared = (struct shmem_shared *) cptr;
+
+	/* Both processes must agree on the layout of the samples */
+	if (shared->version != SHMEM_VERSION) {
+		munmap(base, len);
+		errno = EPROTO;
+		return -13;
+	}
 	shm->read.base = base;
 	shm->read.name = rname;
 	shm->read.len = len;
@@ -155,6 +167,7 @@ retry:	fd = shm_open(wname, O_RDWR|O_CREAT|O_EXCL, 0600);
 	shm->readers = 0;
 	shm->writers = 0;
 	shm->closed = 0;
+	shm->busy_poll = conf->busy_poll;
 
 	/* Unlink the semaphores; we don't need them anymore */
 	sem_unlink(wname);
@@ -183,13 +196,41 @@ int shmem_int_close(struct shmem_int *shm)
 	return 0;
 }
 
-int shmem_int_read(struct shmem_int *shm, struct sample * const smps[], unsigned cnt)
+/** Poll the input queue without blocking for at most shmem_int::busy_poll microseconds. */
+static int shmem_int_busy_poll(struct shmem_int *shm, struct sample * const smps[], unsigned cnt)
 {
 	int ret;
+	struct timespec start = time_now(), now;
+
+	do {
+		/* Reading the clock is more expensive than checking the queue */
+		for (int i = 0; i < 64; i++) {
+			ret = queue_pull_many(&shm->read.shared->queue.queue, (void **) smps, cnt);
+			if (ret != 0)
+				return ret;
+		}
+
+		/* Give the other process a chance to run if it shares our CPU */
+		sched_yield();
+
+		now = time_now();
+	} while (time_delta(&start, &now) * 1e6 < shm->busy_poll);
+
+	return 0;
+}
+
+int shmem_int_read(struct shmem_int *shm, struct sample * const smps[], unsigned cnt)
+{
+	int ret = 0;
 
 	atomic_fetch_add(&shm->readers, 1);
 
-	ret = queue_signalled_pull_many(&shm->read.shared->queue, (void **) smps, cnt);
+	/* The writer signals each push. We only spin to avoid the latency of waking up. */
+	if (shm->busy_poll > 0 && shm->read.shared->queue.mode == QueueSignalledMode::PTHREAD)
+		ret = shmem_int_busy_poll(shm, smps, cnt);
+
+	if (ret == 0)
+		ret = queue_signalled_pull_many(&shm->read.shared->queue, (void **) smps, cnt);
 
 	if (atomic_fetch_sub(&shm->readers, 1) == 1 && atomic_load(&shm->closed) == 1)
 		munmap(shm->read.base, shm->read.len);
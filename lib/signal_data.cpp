@@ -20,12 +20,25 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *********************************************************************************/
 
+#include <cctype>
+#include <cmath>
 #include <cstring>
 #include <cinttypes>
+#include <charconv>
 
 #include <villas/signal_type.h>
 #include <villas/signal_data.h>
 
+/* std::to_chars() for floating point numbers is implemented with Ryu printf.
+ * std::from_chars() uses the fast_float algorithm since libstdc++ 12. Older
+ * versions fall back to strtod() internally which is slower than calling it directly. */
+#ifdef __cpp_lib_to_chars
+  #define SIGNAL_DATA_FAST_PRINT
+  #if !defined(_GLIBCXX_RELEASE) || _GLIBCXX_RELEASE >= 12
+    #define SIGNAL_DATA_FAST_PARSE
+  #endif
+#endif
+
 void signal_data_set(union signal_data *data, enum SignalType type, double val)
 {
 	switch (type) {
@@ -145,11 +158,70 @@ void signal_data_cast(union signal_data *data, enum SignalType from, enum Signal
 	}
 }
 
+/** A replacement for strtod() which accepts the same decimal notation. */
+static double signal_data_parse_real(const char *ptr, char **end)
+{
+#ifdef SIGNAL_DATA_FAST_PARSE
+	const char *p = ptr;
+
+	while (isspace(*p))
+		p++;
+
+	/* std::from_chars() does not accept a leading plus sign */
+	const char *first = *p == '+' ? p + 1 : p;
+	const char *digits = *p == '+' || *p == '-' ? p + 1 : p;
+
+	/* Hexadecimal numbers, infinity and NaN are left to strtod() */
+	bool decimal = isdigit(digits[0]) || (digits[0] == '.' && isdigit(digits[1]));
+	bool hex = digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X');
+
+	if (decimal && !hex) {
+		/* An upper bound for the end of the number */
+		const char *last = digits;
+		while (isdigit(*last) || *last == '.' || *last == 'e' || *last == 'E' || *last == '+' || *last == '-')
+			last++;
+
+		double d;
+		auto res = std::from_chars(first, last, d);
+		if (res.ec == std::errc() && std::fpclassify(d) != FP_SUBNORMAL) {
+			*end = (char *) res.ptr;
+			return d;
+		}
+	}
+#endif /* SIGNAL_DATA_FAST_PARSE */
+
+	/* Out-of-range and subnormal values are also handled here to get the same errno as before */
+	return strtod(ptr, end);
+}
+
+#ifdef SIGNAL_DATA_FAST_PRINT
+/** Print a floating point number like printf("%.*f") into [ \p p, \p e ).
+ *
+ * @param sign Always print a sign like printf("%+.*f").
+ * @return The end of the printed number or nullptr if it does not fit.
+ */
+static char * signal_data_print_real(char *p, char *e, double d, int precision, bool sign)
+{
+	if (sign && !std::signbit(d)) {
+		if (p == e)
+			return nullptr;
+
+		*p++ = '+';
+	}
+
+	auto res = std::to_chars(p, e, d, std::chars_format::fixed, precision);
+	if (res.ec != std::errc())
+		return nullptr;
+
+	return res.ptr;
+}
+#endif /* SIGNAL_DATA_FAST_PRINT */
+
 int signal_data_parse_str(union signal_data *data, enum SignalType type, const char *ptr, char **end)
 {
 	switch (type) {
 		case SignalType::FLOAT:
-			data->f = strtod(ptr, end);
+			data->f = signal_data_parse_real(ptr, end);
 			break;
 
 		case SignalType::INTEGER:
@@ -163,7 +235,7 @@ int signal_data_parse_str(union signal_data *data, enum SignalType type, const c
 		case SignalType::COMPLEX: {
 			float real, imag = 0;
 
-			real = strtod(ptr, end);
+			real = signal_data_parse_real(ptr, end);
 			if (*end == ptr)
 				return -1;
 
@@ -176,7 +248,7 @@ int signal_data_parse_str(union signal_data *data, enum SignalType type, const c
 				(*end)++;
 			}
 			else if (*ptr == '-' || *ptr == '+') {
-				imag = strtod(ptr, end);
+				imag = signal_data_parse_real(ptr, end);
 				if (*end == ptr)
 					return -1;
 
@@ -263,6 +335,37 @@ json_t * signal_data_to_json(const union signal_data *data, enum SignalType type
 
 int signal_data_print_str(const union signal_data *data, enum SignalType type, char *buf, size_t len, int precision)
 {
+#ifdef SIGNAL_DATA_FAST_PRINT
+	/* Truncated output is left to snprintf() */
+	if (len > 0) {
+		char *p = nullptr, *e = buf + len - 1;
+
+		switch (type) {
+			case SignalType::FLOAT:
+				p = signal_data_print_real(buf, e, data->f, precision, false);
+				break;
+
+			case SignalType::COMPLEX:
+				p = signal_data_print_real(buf, e, std::real(data->z), precision, false);
+				if (p)
+					p = signal_data_print_real(p, e, std::imag(data->z), precision, true);
+				if (p && p < e)
+					*p++ = 'i';
+				else
+					p = nullptr;
+				break;
+
+			default: { }
+		}
+
+		if (p) {
+			*p = '\0';
+
+			return p - buf;
+		}
+	}
+#endif /* SIGNAL_DATA_FAST_PRINT */
+
 	switch (type) {
 		case SignalType::FLOAT:
 			return snprintf(buf, len, "%.*f", precision, data->f);
@@ -111,7 +111,7 @@ int socket_parse_address(const char *addr, struct sockaddr *saddr, enum SocketLa
 		ret = 0;
 	}
 #ifdef WITH_SOCKET_LAYER_ETH
-	else if (layer == SocketLayer::ETH) { /* Format: "ab:cd:ef:12:34:56%ifname:protocol" */
+	else if (layer == SocketLayer::ETH || layer == SocketLayer::XDP) { /* Format: "ab:cd:ef:12:34:56%ifname:protocol" */
 		/* Split string */
 		char *lasts;
 		char *node = strtok_r(copy, "%", &lasts);
@@ -27,6 +27,7 @@
 #include <villas/timing.h>
 #include <villas/node.h>
 #include <villas/utils.hpp>
+#include <villas/sample.h>
 #include <villas/node.h>
 
 using namespace villas;
@@ -42,6 +43,16 @@ std::unordered_map<Stats::Metric, Stats::MetricDescription> Stats::metrics = {
 	{ Stats::Metric::RTP_LOSS_FRACTION, 	{ "rtp.loss_fraction",	"percent", "Fraction lost since last RTP SR/RR."			}},
 	{ Stats::Metric::RTP_PKTS_LOST, 	{ "rtp.pkts_lost",	"packets", "Cumulative number of packtes lost" 				}},
 	{ Stats::Metric::RTP_JITTER, 		{ "rtp.jitter",		"seconds", "Interarrival jitter" 					}},
+	{ Stats::Metric::FILE_SMPS_DROPPED, 	{ "file.dropped",	"samples", "Samples dropped because all recording buffers were in use" 	}},
+	{ Stats::Metric::FILE_BUFFERS_PENDING, 	{ "file.pending",	"buffers", "Recording buffers which wait to be written to disk" 	}},
+	{ Stats::Metric::TRACE_HOOKS_IN, 	{ "trace.in_hooks",	"seconds", "Processing time of the input hooks" 			}},
+	{ Stats::Metric::TRACE_MUX, 		{ "trace.mux",		"seconds", "Time until the sample has been mapped and muxed by the path" }},
+	{ Stats::Metric::TRACE_HOOKS_PATH, 	{ "trace.path_hooks",	"seconds", "Processing time of the path hooks" 				}},
+	{ Stats::Metric::TRACE_ENQUEUE, 	{ "trace.enqueue",	"seconds", "Time until the sample is handed over to the destinations" 	}},
+	{ Stats::Metric::TRACE_QUEUE, 		{ "trace.queue",	"seconds", "Time spent in the queue of the path destination" 		}},
+	{ Stats::Metric::TRACE_HOOKS_OUT, 	{ "trace.out_hooks",	"seconds", "Processing time of the output hooks" 			}},
+	{ Stats::Metric::TRACE_WRITE, 		{ "trace.write",	"seconds", "Time spent in the write function of the node-type" 	}},
+	{ Stats::Metric::TRACE_TOTAL, 		{ "trace.total",	"seconds", "Time from reading the sample until it has been written" 	}},
 };
 
 std::unordered_map<Stats::Type, Stats::TypeDescription> Stats::types = {
@@ -117,6 +128,37 @@ void Stats::update(enum Metric m, double val)
 	histograms[m].put(val);
 }
 
+void Stats::updateTrace(struct sample * const smps[], unsigned cnt)
+{
+	/* The latency of a stage is measured from the completion of the previous one */
+	static const Metric stages[SAMPLE_TRACE_STAGES] = {
+		Metric::TRACE_TOTAL, /* Unused as there is no stage before SampleTraceStage::READ */
+		Metric::TRACE_HOOKS_IN,
+		Metric::TRACE_MUX,
+		Metric::TRACE_HOOKS_PATH,
+		Metric::TRACE_ENQUEUE,
+		Metric::TRACE_QUEUE,
+		Metric::TRACE_HOOKS_OUT,
+		Metric::TRACE_WRITE
+	};
+
+	for (unsigned i = 0; i < cnt; i++) {
+		const uint64_t *t = smps[i]->trace;
+
+		/* Stages which have been skipped (e.g. for samples created by hooks) are not accounted */
+		for (unsigned j = 1; j < SAMPLE_TRACE_STAGES; j++) {
+			if (t[j-1] && t[j] >= t[j-1])
+				histograms[stages[j]].put((t[j] - t[j-1]) * 1e-9);
+		}
+
+		uint64_t first = t[(int) SampleTraceStage::READ];
+		uint64_t last = t[(int) SampleTraceStage::WRITTEN];
+
+		if (first && last >= first)
+			histograms[Metric::TRACE_TOTAL].put((last - first) * 1e-9);
+	}
+}
+
 void Stats::reset()
 {
 	for (auto m : metrics)
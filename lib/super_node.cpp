@@ -66,6 +66,9 @@ SuperNode::SuperNode() :
 	priority(0),
 	affinity(0),
 	hugepages(DEFAULT_NR_HUGEPAGES),
+	schedulerEnabled(0),
+	schedulerWorkers(0),
+	schedulerAffinity(0),
 	statsRate(1.0),
 	task(CLOCK_REALTIME),
 	started(time_now())
@@ -85,6 +88,8 @@ SuperNode::SuperNode() :
 #endif /* WITH_NETEM */
 
 	logger = logging.get("super_node");
+
+	scheduler.state = State::DESTROYED;
 }
 
 void SuperNode::parse(const std::string &u)
@@ -106,12 +111,13 @@ void SuperNode::parse(json_t *root)
 	json_t *json_paths = nullptr;
 	json_t *json_logging = nullptr;
 	json_t *json_http = nullptr;
+	json_t *json_scheduler = nullptr;
 
 	json_error_t err;
 
 	idleStop = 1;
 
-	ret = json_unpack_ex(root, &err, 0, "{ s?: F, s?: o, s?: o, s?: o, s?: o, s?: i, s?: i, s?: i, s?: b, s?: s }",
+	ret = json_unpack_ex(root, &err, 0, "{ s?: F, s?: o, s?: o, s?: o, s?: o, s?: i, s?: i, s?: i, s?: b, s?: s, s?: o }",
 		"stats", &statsRate,
 		"http", &json_http,
 		"logging", &json_logging,
@@ -121,7 +127,8 @@ void SuperNode::parse(json_t *root)
 		"affinity", &affinity,
 		"priority", &priority,
 		"idle_stop", &idleStop,
-		"uuid", &uuid_str
+		"uuid", &uuid_str,
+		"scheduler", &json_scheduler
 	);
 	if (ret)
 		throw ConfigError(root, err, "node-config", "Unpacking top-level config failed");
@@ -140,6 +147,9 @@ void SuperNode::parse(json_t *root)
 	if (json_logging)
 		logging.parse(json_logging);
 
+	if (json_scheduler)
+		parseScheduler(json_scheduler);
+
 	/* Parse nodes */
 	if (json_nodes) {
 		if (!json_is_object(json_nodes))
@@ -291,6 +301,25 @@ void SuperNode::startNodes()
 	}
 }
 
+void SuperNode::parseScheduler(json_t *json)
+{
+	int ret;
+	json_error_t err;
+
+	schedulerEnabled = 1;
+
+	ret = json_unpack_ex(json, &err, 0, "{ s?: b, s?: i, s?: i }",
+		"enabled", &schedulerEnabled,
+		"workers", &schedulerWorkers,
+		"affinity", &schedulerAffinity
+	);
+	if (ret)
+		throw ConfigError(json, err, "node-config-scheduler", "Failed to parse scheduler settings");
+
+	if (schedulerWorkers < 0)
+		throw ConfigError(json, "node-config-scheduler", "Setting 'workers' must not be negative");
+}
+
 void SuperNode::startPaths()
 {
 	int ret;
@@ -330,6 +359,8 @@ void SuperNode::preparePaths()
 		ret = path_prepare(p, nodes);
 		if (ret)
 			throw RuntimeError("Failed to prepare path: {}", path_name(p));
+
+		p->sched.scheduler = getScheduler();
 	}
 }
 
@@ -345,6 +376,14 @@ void SuperNode::prepare()
 
 	kernel::rt::init(priority, affinity);
 
+	if (schedulerEnabled) {
+		ret = path_scheduler_init(&scheduler, schedulerWorkers, schedulerAffinity ? schedulerAffinity : affinity);
+		if (ret)
+			throw RuntimeError("Failed to initialize path scheduler");
+
+		logger->info("Running paths on {} scheduler workers", scheduler.nworkers);
+	}
+
 	prepareNodes();
 	preparePaths();
 
@@ -361,6 +400,8 @@ void SuperNode::prepare()
 
 void SuperNode::start()
 {
+	int ret;
+
 	assert(state == State::PREPARED);
 
 #ifdef WITH_API
@@ -374,6 +415,13 @@ void SuperNode::start()
 	startNodeTypes();
 	startInterfaces();
 	startNodes();
+
+	if (schedulerEnabled) {
+		ret = path_scheduler_start(&scheduler);
+		if (ret)
+			throw RuntimeError("Failed to start path scheduler");
+	}
+
 	startPaths();
 
 	if (statsRate > 0) // A rate <0 will disable the periodic stats
@@ -432,8 +480,16 @@ void SuperNode::stopInterfaces()
 
 void SuperNode::stop()
 {
+	int ret;
+
 	stopNodes();
 	stopPaths();
+
+	if (schedulerEnabled) {
+		ret = path_scheduler_stop(&scheduler);
+		if (ret)
+			throw RuntimeError("Failed to stop path scheduler");
+	}
 	stopNodeTypes();
 	stopInterfaces();
 
@@ -476,6 +532,9 @@ SuperNode::~SuperNode()
 		ret = node_destroy(n);
 		delete n;
 	}
+
+	if (schedulerEnabled && scheduler.state != State::DESTROYED)
+		ret = path_scheduler_destroy(&scheduler);
 }
 
 int SuperNode::periodic()
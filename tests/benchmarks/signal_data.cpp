@@ -0,0 +1,111 @@
+/** Benchmark of the conversion of floating point values from and to text.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <string>
+
+#include <villas/signal.h>
+#include <villas/tsc.h>
+#include <villas/log.hpp>
+
+using namespace villas;
+
+#define BENCHMARK_VALUES	1000000
+
+/** Compares snprintf() / strtod() with signal_data_print_str() / signal_data_parse_str().
+ *
+ * Usage: benchmark-signal-data [NUM_VALUES]
+ */
+int main(int argc, char *argv[])
+{
+	int ret;
+	struct tsc tsc;
+	uint64_t start, old_print, new_print, old_parse, new_parse;
+	char buf[64], *end;
+	double old_sum = 0, new_sum = 0;
+	union signal_data sd;
+
+	Logger logger = logging.get("benchmark:signal_data");
+
+	unsigned cnt = argc > 1 ? strtoul(argv[1], nullptr, 10) : BENCHMARK_VALUES;
+	if (cnt == 0) {
+		logger->error("Invalid number of values: {}", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	std::mt19937_64 rng(42);
+	std::uniform_real_distribution<double> dist(-1e3, 1e3);
+
+	std::vector<double> values(cnt);
+	for (auto &v : values)
+		v = dist(rng);
+
+	std::vector<std::string> strings;
+	for (auto v : values) {
+		snprintf(buf, sizeof(buf), "%.*f", 17, v);
+		strings.emplace_back(buf);
+	}
+
+	ret = tsc_init(&tsc);
+	if (ret) {
+		logger->error("Failed to initialize TSC");
+		return EXIT_FAILURE;
+	}
+
+	start = tsc_now(&tsc);
+	for (auto v : values)
+		snprintf(buf, sizeof(buf), "%.*f", 17, v);
+	old_print = tsc_now(&tsc) - start;
+
+	start = tsc_now(&tsc);
+	for (auto v : values) {
+		sd.f = v;
+		signal_data_print_str(&sd, SignalType::FLOAT, buf, sizeof(buf), 17);
+	}
+	new_print = tsc_now(&tsc) - start;
+
+	start = tsc_now(&tsc);
+	for (auto &s : strings)
+		old_sum += strtod(s.c_str(), &end);
+	old_parse = tsc_now(&tsc) - start;
+
+	start = tsc_now(&tsc);
+	for (auto &s : strings) {
+		signal_data_parse_str(&sd, SignalType::FLOAT, s.c_str(), &end);
+		new_sum += sd.f;
+	}
+	new_parse = tsc_now(&tsc) - start;
+
+	/* Both parsers must produce identical results */
+	if (old_sum != new_sum) {
+		logger->error("Parsed values differ: strtod={}, signal_data_parse_str={}", old_sum, new_sum);
+		return EXIT_FAILURE;
+	}
+
+	logger->info("print: snprintf={} cycles/value, signal_data_print_str={} cycles/value", old_print / cnt, new_print / cnt);
+	logger->info("parse: strtod={} cycles/value, signal_data_parse_str={} cycles/value", old_parse / cnt, new_parse / cnt);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+#!/bin/bash
+#
+# Integration test for dft hook.
+#
+# @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+# @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+# @license GNU General Public License (version 3)
+#
+# VILLASnode
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+##################################################################################
+
+INPUT_FILE=$(mktemp)
+OUTPUT_FILE=$(mktemp)
+EXPECT_FILE=$(mktemp)
+
+NUM_SAMPLES=2000
+RATE=1000
+WINDOW_SIZE=200
+DFT_RATE=10
+
+F0=50
+AMPLITUDE=2
+PHASE=0.5
+
+EPSILON=0.0001
+
+# A cosine which is sampled at the bins of the DFT
+# Every window starts at a multiple of the period and has a phase of PHASE
+awk -v n=${NUM_SAMPLES} -v r=${RATE} -v f=${F0} -v a=${AMPLITUDE} -v p=${PHASE} 'BEGIN {
+	pi = atan2(0, -1);
+	for (i = 0; i < n; i++)
+		printf("%d.%09d(%d)\t%.9f\n", 1490500400 + int(i / r), (i % r) * (1e9 / r), i, a * cos(2 * pi * f * i / r + p));
+}' > ${INPUT_FILE}
+
+# Samples between two calculations
+INTERVAL=$(( RATE / DFT_RATE ))
+
+# The first two calculations do not produce output yet
+STEADY="\$2 >= $(( 3 * INTERVAL - 1 ))"
+
+awk -v n=${NUM_SAMPLES} -v s=$(( 3 * INTERVAL - 1 )) -v d=${INTERVAL} -v f=${F0} -v a=${AMPLITUDE} -v p=${PHASE} 'BEGIN {
+	for (i = s; i < n; i += d)
+		printf("0.0(%d)\t%.6f\t%.6f\t%.6f\t%.6f\n", i, f, a / sqrt(2), p, 0);
+}' > ${EXPECT_FILE}
+
+OPTS="-o sample_rate=${RATE} -o start_freqency=40 -o end_freqency=60 -o frequency_resolution=5 -o dft_rate=${DFT_RATE} -o window_size=${WINDOW_SIZE} -o signal_index=0"
+
+RC=0
+for METHOD in matrix sliding goertzel fft; do
+	for WINDOW in none hann; do
+		villas-hook ${OPTS} -o method=${METHOD} -o window_type=${WINDOW} dft < ${INPUT_FILE} | \
+		awk -F'[()]' "/^#/ || ${STEADY}" > ${OUTPUT_FILE}
+
+		# Compare only the data values
+		if ! villas-compare -T -e ${EPSILON} ${OUTPUT_FILE} ${EXPECT_FILE}; then
+			echo "Method ${METHOD} with window ${WINDOW} failed"
+			RC=1
+		fi
+	done
+done
+
+rm -f ${INPUT_FILE} ${OUTPUT_FILE} ${EXPECT_FILE}
+
+exit ${RC}
@@ -22,32 +22,60 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ##################################################################################
 
-# Test is not ready yet
-exit 99
-
-
 INPUT_FILE=$(mktemp)
 OUTPUT_FILE=$(mktemp)
 RECON_FILE=$(mktemp)
+EXPECT_FILE=$(mktemp)
 
-NUM_SAMPLES=10000
+NUM_SAMPLES=1000
 RATE=5000
 F0=50
 
+AMPLITUDE=2
+PHASE=0.5
+
+EPSILON=0.0001
+
+# Samples per fundamental period
+PERIOD=$(( RATE / F0 ))
+
+# The phasors are stationary after the first full period
+awk -v n=${NUM_SAMPLES} -v r=${RATE} -v f=${F0} -v a=${AMPLITUDE} -v p=${PHASE} 'BEGIN {
+	pi = atan2(0, -1);
+	for (i = 0; i < n; i++)
+		printf("%d.%09d(%d)\t%.9f\n", 1490500400 + int(i / r), (i % r) * (1e9 / r), i, a * cos(2 * pi * f * i / r + p));
+}' > ${INPUT_FILE}
+
+# Only the fundamental is present with half of the amplitude
+awk -v n=${NUM_SAMPLES} -v s=$(( PERIOD - 1 )) -v a=${AMPLITUDE} -v p=${PHASE} 'BEGIN {
+	for (i = s; i < n; i++)
+		printf("0.0(%d)\t0.0+0.0i\t%.6f%+.6fi\t0.0+0.0i\t0.0+0.0i\t0.0+0.0i\n", i, a / 2 * cos(p), a / 2 * sin(p));
+}' > ${EXPECT_FILE}
+
 OPTS="-o f0=${F0} -o rate=${RATE} -o signal=0 -o harmonics=0,1,3,5,7"
 
-villas-signal sine -v1 -l ${NUM_SAMPLES} -f ${F0} -r ${RATE} -n > ${INPUT_FILE}
+villas-hook -o inverse=false ${OPTS} dp < ${INPUT_FILE} > ${OUTPUT_FILE}
+villas-hook -t 5c -o inverse=true ${OPTS} dp < ${OUTPUT_FILE} > ${RECON_FILE}
+
+# Compare only the data values after the first period
+STEADY="\$2 >= $(( PERIOD - 1 ))"
 
-villas-hook dp -o inverse=false ${OPTS} < ${INPUT_FILE} > ${OUTPUT_FILE}
+awk -F'[()]' "/^#/ || ${STEADY}" ${OUTPUT_FILE} > ${OUTPUT_FILE}.steady
+awk -F'[()]' "/^#/ || ${STEADY}" ${RECON_FILE} > ${RECON_FILE}.steady
+awk -F'[()]' "${STEADY}" ${INPUT_FILE} > ${INPUT_FILE}.steady
 
-villas-hook dp -o inverse=true ${OPTS} < ${OUTPUT_FILE} > ${RECON_FILE}
+RC=0
 
-exit 0
+if ! villas-compare -T -t 5c -e ${EPSILON} ${OUTPUT_FILE}.steady ${EXPECT_FILE}; then
+	echo "Phasors do not match"
+	RC=1
+fi
 
-# Compare only the data values
-villas-compare ${OUTPUT_FILE} ${EXPECT_FILE}
-RC=$?
+if ! villas-compare -T -e ${EPSILON} ${RECON_FILE}.steady ${INPUT_FILE}.steady; then
+	echo "Reconstructed signal does not match"
+	RC=1
+fi
 
-rm -f ${INPUT_FILE} ${OUTPUT_FILE} ${EXPECT_FILE}
+rm -f ${INPUT_FILE}* ${OUTPUT_FILE}* ${RECON_FILE}* ${EXPECT_FILE}
 
 exit ${RC}
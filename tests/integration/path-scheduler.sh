@@ -0,0 +1,107 @@
+#!/bin/bash
+#
+# Integration test for the path scheduler.
+#
+# @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+# @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+# @license GNU General Public License (version 3)
+#
+# VILLASnode
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+##################################################################################
+
+SCRIPT=$(realpath $0)
+SCRIPTPATH=$(dirname ${SCRIPT})
+source ${SCRIPTPATH}/../../tools/villas-helper.sh
+
+CONFIG_FILE=$(mktemp)
+EXPECT_FILE=$(mktemp)
+OUTPUT_DIR=$(mktemp -d)
+
+NUM_PATHS=${NUM_PATHS:-64}
+NUM_SAMPLES=${NUM_SAMPLES:-2000}
+RATE=${RATE:-1000}
+
+# The second half of the paths is stopped while they are under load
+NUM_STOPPED=$((NUM_PATHS / 2))
+NUM_RUNNING=$((NUM_PATHS - NUM_STOPPED))
+
+function path_uuid() {
+	printf "00000000-0000-0000-0000-%012d" $1
+}
+
+NODES=""
+PATHS=""
+for I in $(seq 1 ${NUM_PATHS}); do
+	NODES+="\"signal_${I}\": { \"type\": \"signal\", \"signal\": \"counter\", \"values\": 1, \"limit\": ${NUM_SAMPLES}, \"rate\": ${RATE} },"
+	NODES+="\"file_${I}\": { \"type\": \"file\", \"uri\": \"${OUTPUT_DIR}/${I}.dat\" },"
+	PATHS+="{ \"uuid\": \"$(path_uuid ${I})\", \"in\": \"signal_${I}\", \"out\": \"file_${I}\" },"
+done
+
+cat > ${CONFIG_FILE} <<EOF
+{
+	"http": {
+		"port": 8080
+	},
+	"scheduler": {
+		"workers": 2
+	},
+	"nodes": {
+		${NODES%,}
+	},
+	"paths": [
+		${PATHS%,}
+	]
+}
+EOF
+
+villas signal counter -v 1 -l ${NUM_SAMPLES} -n > ${EXPECT_FILE}
+
+# Start node
+VILLAS_LOG_PREFIX=$(colorize "[Node]  ") \
+villas-node ${CONFIG_FILE} &
+PID=$!
+
+# Stopping a path removes it from its scheduler worker
+sleep 1
+for I in $(seq $((NUM_RUNNING + 1)) ${NUM_PATHS}); do
+	curl -s -X POST http://localhost:8080/api/v2/path/$(path_uuid ${I})/stop
+done
+
+sleep $((NUM_SAMPLES / RATE + 2))
+
+# The node must still be running
+kill ${PID}
+RC=$?
+
+wait ${PID}
+
+# All samples of the remaining paths must have been delivered
+for I in $(seq 1 ${NUM_RUNNING}); do
+	villas-compare -T ${OUTPUT_DIR}/${I}.dat ${EXPECT_FILE} || RC=1
+done
+
+# Stopped paths must not have delivered all samples
+for I in $(seq $((NUM_RUNNING + 1)) ${NUM_PATHS}); do
+	N=$(grep -vc '^#' ${OUTPUT_DIR}/${I}.dat)
+	if [ "${N}" -ge "${NUM_SAMPLES}" ]; then
+		echo "Path ${I} has not been stopped"
+		RC=1
+	fi
+done
+
+rm -rf ${CONFIG_FILE} ${EXPECT_FILE} ${OUTPUT_DIR}
+
+exit ${RC}
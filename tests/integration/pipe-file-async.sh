@@ -0,0 +1,72 @@
+#!/bin/bash
+#
+# Integration test for asynchronous recording with the file node-type.
+#
+# @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+# @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+# @license GNU General Public License (version 3)
+#
+# VILLASnode
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+##################################################################################
+
+CONFIG_FILE=$(mktemp)
+INPUT_FILE=$(mktemp)
+NODE_DIR=$(mktemp -d -p /var/tmp)
+
+NUM_SAMPLES=${NUM_SAMPLES:-100000}
+
+function cleanup() {
+	rm -rf ${INPUT_FILE} ${CONFIG_FILE} ${NODE_DIR}
+}
+
+trap cleanup EXIT
+
+# /var/tmp is usually not a tmpfs and hence supports O_DIRECT
+cat > ${CONFIG_FILE} << EOF
+{
+	"nodes" : {
+		"node1" : {
+			"type" : "file",
+
+			"uri" : "${NODE_DIR}/recording.log",
+
+			"out" : {
+				"async" : true,
+				"buffers" : 4,
+				"buffer_size" : 65536,
+				"direct" : true,
+				"rotate_size" : 1048576
+			}
+		}
+	}
+}
+EOF
+
+# Generate test data
+villas-signal -l ${NUM_SAMPLES} -v 4 -n random > ${INPUT_FILE}
+
+villas-pipe -s ${CONFIG_FILE} node1 < ${INPUT_FILE}
+
+# Concatenate the rotated files in the order of their suffixes
+OUTPUT_FILES=$(ls -v ${NODE_DIR}/recording.log*)
+
+if (( $(echo ${OUTPUT_FILES} | wc -w) < 2 )); then
+	echo "The recording has not been rotated"
+	exit 1
+fi
+
+# Compare data
+villas-compare ${INPUT_FILE} <(cat ${OUTPUT_FILES})
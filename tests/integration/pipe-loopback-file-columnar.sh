@@ -0,0 +1,87 @@
+#!/bin/bash
+#
+# Integration loopback test for the columnar format of the file node-type.
+#
+# @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+# @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+# @license GNU General Public License (version 3)
+#
+# VILLASnode
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+##################################################################################
+
+CONFIG_FILE=$(mktemp)
+INPUT_FILE=$(mktemp)
+OUTPUT_FILE=$(mktemp)
+NODE_FILE=$(mktemp)
+
+NUM_SAMPLES=${NUM_SAMPLES:-2000}
+
+function cleanup() {
+	rm -f ${OUTPUT_FILE} ${INPUT_FILE} ${CONFIG_FILE} ${NODE_FILE}
+}
+
+trap cleanup EXIT
+
+function config() {
+cat > ${CONFIG_FILE} << EOF
+{
+	"nodes" : {
+		"node1" : {
+			"type" : "file",
+			"format" : "villas.columnar",
+
+			"uri"   : "${NODE_FILE}",
+
+			"in" : {
+				"epoch_mode" : "original",
+				"eof" : "$1"
+			},
+			"out" : {
+				"flush" : true
+			}
+		}
+	}
+}
+EOF
+}
+
+# Generate test data
+villas-signal -l ${NUM_SAMPLES} -v 4 -n random > ${INPUT_FILE}
+
+# Record the samples and replay them from the mapping while it grows
+config wait
+villas-pipe -l ${NUM_SAMPLES} ${CONFIG_FILE} node1 > ${OUTPUT_FILE} < ${INPUT_FILE}
+
+villas-compare ${INPUT_FILE} ${OUTPUT_FILE}
+RC=$?
+
+if (( ${RC} != 0 )); then
+	echo "=========== Sub-test failed for: eof=wait"
+	exit ${RC}
+fi
+
+# Replay the finished recording
+config stop
+villas-pipe -r -l ${NUM_SAMPLES} ${CONFIG_FILE} node1 > ${OUTPUT_FILE}
+
+villas-compare ${INPUT_FILE} ${OUTPUT_FILE}
+RC=$?
+
+if (( ${RC} != 0 )); then
+	echo "=========== Sub-test failed for: eof=stop"
+fi
+
+exit ${RC}
@@ -31,6 +31,8 @@ NUM_SAMPLES=${NUM_SAMPLES:-10}
 for MODE in polling pthread; do
 for VECTORIZE in 1 5 25; do
 for SIGNAL_COUNT in 1 10 100; do
+for ZEROCOPY in false true; do
+for BUSY_POLL in 0 20; do
 
 cat > ${CONFIG_FILE} << EOF
 {
@@ -41,10 +43,12 @@ cat > ${CONFIG_FILE} << EOF
 				"name" : "/villas-test"
 			},
 			"in" : {
-				"name" : "/villas-test"	
+				"name" : "/villas-test",
+				"zerocopy" : ${ZEROCOPY}
 			},
 			"queuelen" : 1024,
 			"mode" : "${MODE}",
+			"busy_poll" : ${BUSY_POLL},
 			"vectorize" : ${VECTORIZE}
 		}
 	}
@@ -61,7 +65,7 @@ villas-compare ${INPUT_FILE} ${OUTPUT_FILE}
 RC=$?
 
 if (( ${RC} != 0 )); then
-	echo "=========== Sub-test failed for: mode=${MODE}, vectorize=${VECTORIZE}, SIGNAL_COUNT=${SIGNAL_COUNT}"
+	echo "=========== Sub-test failed for: mode=${MODE}, vectorize=${VECTORIZE}, SIGNAL_COUNT=${SIGNAL_COUNT}, zerocopy=${ZEROCOPY}, busy_poll=${BUSY_POLL}"
 	cat ${CONFIG_FILE}
 	echo
 	cat ${INPUT_FILE}
@@ -69,10 +73,10 @@ if (( ${RC} != 0 )); then
 	cat ${OUTPUT_FILE}
 	exit ${RC}
 else
-	echo "=========== Sub-test succeeded for: mode=${MODE}, vectorize=${VECTORIZE}, SIGNAL_COUNT=${SIGNAL_COUNT}"
+	echo "=========== Sub-test succeeded for: mode=${MODE}, vectorize=${VECTORIZE}, SIGNAL_COUNT=${SIGNAL_COUNT}, zerocopy=${ZEROCOPY}, busy_poll=${BUSY_POLL}"
 fi
 
-done; done; done
+done; done; done; done; done
 
 rm ${OUTPUT_FILE} ${INPUT_FILE} ${CONFIG_FILE}
 
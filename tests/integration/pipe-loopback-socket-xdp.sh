@@ -0,0 +1,163 @@
+#!/bin/bash
+#
+# Integration test for the AF_XDP layer of the socket node-type.
+#
+# Samples are sent over a veth pair between two network namespaces.
+#
+# @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+# @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+# @license GNU General Public License (version 3)
+#
+# VILLASnode
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+##################################################################################
+
+# Check if tools are present
+if ! command -v ip; then
+	echo "'ip' tool is missing"
+	exit 99
+fi
+
+# Check if user is superuser. SU is used for namespace
+if [[ "$EUID" -ne 0 ]]; then
+	echo "Please run as root"
+	exit 99
+fi
+
+SCRIPT=$(realpath $0)
+SCRIPTPATH=$(dirname ${SCRIPT})
+source ${SCRIPTPATH}/../../tools/villas-helper.sh
+
+CONFIG_FILE_SEND=$(mktemp)
+CONFIG_FILE_RECV=$(mktemp)
+INPUT_FILE=$(mktemp)
+OUTPUT_FILE=$(mktemp)
+
+NUM_SAMPLES=${NUM_SAMPLES:-100}
+NUM_VALUES=${NUM_VALUES:-4}
+
+NS_SEND=villas-xdp-send
+NS_RECV=villas-xdp-recv
+
+function cleanup() {
+	ip netns del ${NS_SEND}
+	ip netns del ${NS_RECV}
+
+	rm -f ${OUTPUT_FILE} ${INPUT_FILE} ${CONFIG_FILE_SEND} ${CONFIG_FILE_RECV}
+}
+
+trap cleanup EXIT
+
+# Setup a veth pair between two namespaces
+ip netns add ${NS_SEND}
+ip netns add ${NS_RECV}
+ip link add xdp0 netns ${NS_SEND} type veth peer name xdp1 netns ${NS_RECV}
+ip -n ${NS_SEND} link set xdp0 up
+ip -n ${NS_RECV} link set xdp1 up
+
+MAC_RECV=$(ip netns exec ${NS_RECV} cat /sys/class/net/xdp1/address)
+
+# Generate test data
+villas-signal -v ${NUM_VALUES} -l ${NUM_SAMPLES} -n random > ${INPUT_FILE}
+
+for FORMAT in villas.binary protobuf; do
+for VECTORIZE in 1 10; do
+for SAMPLE_PER_DATAGRAM in false true; do
+
+cat > ${CONFIG_FILE_SEND} << EOF
+{
+	"nodes" : {
+		"node1" : {
+			"type" : "socket",
+			"layer" : "xdp",
+			"format" : "${FORMAT}",
+			"vectorize" : ${VECTORIZE},
+
+			"xdp" : {
+				"mode" : "copy"
+			},
+
+			"out" : {
+				"address" : "${MAC_RECV}%xdp0:34997",
+				"sample_per_datagram" : ${SAMPLE_PER_DATAGRAM}
+			},
+			"in" : {
+				"address" : "00:00:00:00:00:00%xdp0:34997"
+			}
+		}
+	}
+}
+EOF
+
+cat > ${CONFIG_FILE_RECV} << EOF
+{
+	"nodes" : {
+		"node1" : {
+			"type" : "socket",
+			"layer" : "xdp",
+			"format" : "${FORMAT}",
+			"vectorize" : ${VECTORIZE},
+
+			"xdp" : {
+				"mode" : "copy"
+			},
+
+			"out" : {
+				"address" : "00:00:00:00:00:00%xdp1:34997"
+			},
+			"in" : {
+				"address" : "00:00:00:00:00:00%xdp1:34997",
+				"signals" : {
+					"count" : ${NUM_VALUES},
+					"type" : "float"
+				}
+			}
+		}
+	}
+}
+EOF
+
+ip netns exec ${NS_RECV} villas-pipe -r -l ${NUM_SAMPLES} ${CONFIG_FILE_RECV} node1 > ${OUTPUT_FILE} &
+PID_RECV=$!
+
+# Wait until the XDP program has been attached
+sleep 1
+
+ip netns exec ${NS_SEND} villas-pipe -s ${CONFIG_FILE_SEND} node1 < ${INPUT_FILE}
+
+wait ${PID_RECV}
+
+# Compare data
+villas-compare ${INPUT_FILE} ${OUTPUT_FILE}
+RC=$?
+
+if (( ${RC} != 0 )); then
+	echo "=========== Sub-test failed for: format=${FORMAT}, vectorize=${VECTORIZE}, sample_per_datagram=${SAMPLE_PER_DATAGRAM}"
+	echo "Config:"
+	cat ${CONFIG_FILE_SEND}
+	echo
+	echo "Input:"
+	cat ${INPUT_FILE}
+	echo
+	echo "Output:"
+	cat ${OUTPUT_FILE}
+	exit ${RC}
+else
+	echo "=========== Sub-test succeeded for: format=${FORMAT}, vectorize=${VECTORIZE}, sample_per_datagram=${SAMPLE_PER_DATAGRAM}"
+fi
+
+done; done; done
+
+exit ${RC}
@@ -48,6 +48,8 @@ if villas_format_supports_vectorize ${FORMAT}; then
 fi
 
 for VECTORIZE in ${VECTORIZES}; do
+for SAMPLE_PER_DATAGRAM in false true; do
+for IO_URING in false true; do
 
 case ${LAYER} in
 	udp)
@@ -83,10 +85,12 @@ cat > ${CONFIG_FILE} << EOF
 			"layer" : "${LAYER}",
 
 			"out" : {
-				"address" : "${REMOTE}"
+				"address" : "${REMOTE}",
+				"sample_per_datagram" : ${SAMPLE_PER_DATAGRAM}
 			},
 			"in" : {
 				"address" : "${LOCAL}",
+				"io_uring" : ${IO_URING},
 				"signals" : {
 					"count" : ${NUM_VALUES},
 					"type" : "float"
@@ -109,7 +113,7 @@ villas-compare ${CMPFLAGS} ${INPUT_FILE} ${OUTPUT_FILE}
 RC=$?
 
 if (( ${RC} != 0 )); then
-	echo "=========== Sub-test failed for: format=${FORMAT}, layer=${LAYER}, vectorize=${VECTORIZE}"
+	echo "=========== Sub-test failed for: format=${FORMAT}, layer=${LAYER}, vectorize=${VECTORIZE}, sample_per_datagram=${SAMPLE_PER_DATAGRAM}, io_uring=${IO_URING}"
 	echo "Config:"
 	cat ${CONFIG_FILE}
 	echo
@@ -120,10 +124,10 @@ if (( ${RC} != 0 )); then
 	cat ${OUTPUT_FILE}
 	exit ${RC}
 else
-	echo "=========== Sub-test succeeded for: format=${FORMAT}, layer=${LAYER}, vectorize=${VECTORIZE}"
+	echo "=========== Sub-test succeeded for: format=${FORMAT}, layer=${LAYER}, vectorize=${VECTORIZE}, sample_per_datagram=${SAMPLE_PER_DATAGRAM}, io_uring=${IO_URING}"
 fi
 
-done; done; done
+done; done; done; done; done
 
 rm ${OUTPUT_FILE} ${INPUT_FILE} ${CONFIG_FILE} ${THEORIES}
 
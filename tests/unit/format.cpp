@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <float.h>
+#include <math.h>
 #include <complex>
 
 #include <criterion/criterion.h>
@@ -34,6 +35,7 @@
 #include <villas/pool.h>
 #include <villas/format.hpp>
 #include <villas/log.hpp>
+#include <villas/formats/raw_convert.hpp>
 
 #include "helpers.hpp"
 
@@ -211,6 +213,8 @@ ParameterizedTestParameters(format, lowlevel)
 	params.emplace_back("{ \"type\": \"csv\" }",						10, 0);
 	params.emplace_back("{ \"type\": \"tsv\" }",						10, 0);
 	params.emplace_back("{ \"type\": \"json\" }",						10, 0);
+	params.emplace_back("{ \"type\": \"json\", \"indent\": 4, \"sort_keys\": true }",		10, 0);
+	params.emplace_back("{ \"type\": \"json\", \"compact\": true }",				10, 0);
 	// params.emplace_back("{ \"type\": \"json.kafka\" }",					10, 0); # broken due to signal names
 	// params.emplace_back("{ \"type\": \"json.reserve\" }",				10, 0);
 #ifdef PROTOBUF_FOUND
@@ -301,6 +305,8 @@ ParameterizedTestParameters(format, highlevel)
 	params.emplace_back("{ \"type\": \"csv\" }",						10, 0);
 	params.emplace_back("{ \"type\": \"tsv\" }",						10, 0);
 	params.emplace_back("{ \"type\": \"json\" }",						10, 0);
+	params.emplace_back("{ \"type\": \"json\", \"indent\": 4, \"sort_keys\": true }",		10, 0);
+	params.emplace_back("{ \"type\": \"json\", \"compact\": true }",				10, 0);
 	// params.emplace_back("{ \"type\": \"json.kafka\" }",					10, 0); # broken due to signal names
 	// params.emplace_back("{ \"type\": \"json.reserve\" }",				10, 0);
 #ifdef PROTOBUF_FOUND
@@ -408,3 +414,207 @@ ParameterizedTest(Param *p, format, highlevel, .init = init_memory)
 	ret = pool_destroy(&pool);
 	cr_assert_eq(ret, 0);
 }
+
+/* The streaming serializer of the json format must produce the same output as jansson */
+Test(format, json_dump, .init = init_memory)
+{
+	int ret;
+	unsigned cnt;
+	char buf[8192];
+	size_t wbytes;
+
+	struct pool pool;
+	struct vlist signals;
+	struct sample *smps[2];
+
+	const std::pair<const char *, size_t> cfgs[] = {
+		{ "{ \"type\": \"json\" }",								JSON_REAL_PRECISION(17) },
+		{ "{ \"type\": \"json\", \"indent\": 4, \"sort_keys\": true, \"escape_slash\": true }",	JSON_INDENT(4) | JSON_SORT_KEYS | JSON_ESCAPE_SLASH | JSON_REAL_PRECISION(17) },
+		{ "{ \"type\": \"json\", \"compact\": true, \"real_precision\": 6 }",			JSON_COMPACT | JSON_REAL_PRECISION(6) }
+	};
+
+	ret = pool_init(&pool, 2, SAMPLE_LENGTH(NUM_VALUES));
+	cr_assert_eq(ret, 0);
+
+	ret = vlist_init(&signals);
+	cr_assert_eq(ret, 0);
+	signal_list_generate(&signals, NUM_VALUES, SignalType::FLOAT);
+
+	ret = sample_alloc_many(&pool, smps, 2);
+	cr_assert_eq(ret, 2);
+
+	fill_sample_data(&signals, smps, 2);
+
+	/* jansson drops values which it can not represent */
+	smps[1]->data[3].f = NAN;
+
+	json_t *json_smps = json_array();
+
+	for (unsigned i = 0; i < 2; i++) {
+		json_t *json_data = json_array();
+
+		for (unsigned j = 0; j < smps[i]->length; j++)
+			json_array_append_new(json_data, json_real(smps[i]->data[j].f));
+
+		json_array_append_new(json_smps, json_pack("{ s: { s: [ I, I ] }, s: I, s: o }",
+			"ts",
+				"origin", (json_int_t) smps[i]->ts.origin.tv_sec, (json_int_t) smps[i]->ts.origin.tv_nsec,
+			"sequence", (json_int_t) smps[i]->sequence,
+			"data", json_data
+		));
+	}
+
+	for (auto &cfg : cfgs) {
+		json_t *json_format = json_loads(cfg.first, 0, nullptr);
+		cr_assert_not_null(json_format);
+
+		Format *fmt = FormatFactory::make(json_format);
+		cr_assert_not_null(fmt);
+
+		fmt->start(&signals, (int) SampleFlags::HAS_ALL);
+
+		cnt = fmt->sprint(buf, sizeof(buf), &wbytes, smps, 2);
+		cr_assert_eq(cnt, 2);
+
+		char *ref = json_dumps(json_smps, cfg.second);
+		cr_assert_not_null(ref);
+
+		cr_assert_eq(wbytes, strlen(ref));
+		cr_assert_arr_eq(buf, ref, wbytes, "Output differs for %s:\n%.*s\n%s", cfg.first, (int) wbytes, buf, ref);
+
+		free(ref);
+		delete fmt;
+	}
+
+	json_decref(json_smps);
+
+	sample_free_many(smps, 2);
+
+	ret = pool_destroy(&pool);
+	cr_assert_eq(ret, 0);
+}
+
+/* All SIMD kernels of the binary formats must produce the same results as the scalar ones */
+Test(format, raw_convert, .init = init_memory)
+{
+	int ret;
+	const size_t max = 67;
+
+	union signal_data data[max], out[2][max];
+	char raw[2][8 * max + 1], in[8 * max + 1];
+
+	srand(1337);
+
+	for (size_t i = 0; i < max; i++)
+		data[i].i = ((int64_t) rand() << 32) | rand();
+
+	for (auto &c : in)
+		c = rand();
+
+	auto isa = raw_convert_isa();
+
+	for (auto simd : { RawConvertIsa::SSE41, RawConvertIsa::AVX2 }) {
+		if (raw_convert_select(simd))
+			continue; /* Not supported by this CPU */
+
+		for (size_t cnt = 0; cnt < max; cnt++) {
+			for (bool swap : { false, true }) {
+				/* Index 0 holds the scalar results, index 1 the SIMD results. Odd offsets test unaligned access. */
+				for (int k = 0; k < 2; k++) {
+					ret = raw_convert_select(k ? simd : RawConvertIsa::SCALAR);
+					cr_assert_eq(ret, 0);
+
+					memset(raw[k], 0, sizeof(raw[k]));
+					memset(out[k], 0, sizeof(out[k]));
+
+					raw_pack_f32(raw[k] + 1, data, cnt, swap);
+					raw_pack_i32(raw[k] + 1 + 4 * cnt, data, cnt, swap);
+					raw_unpack_f32(out[k], in + 1, cnt, swap);
+					raw_unpack_i32(out[k] + cnt, in + 1, max - cnt, swap);
+				}
+
+				cr_assert_arr_eq(raw[0], raw[1], sizeof(raw[0]), "Mismatch for cnt=%zu, swap=%d", cnt, swap);
+				cr_assert_arr_eq(out[0], out[1], sizeof(out[0]), "Mismatch for cnt=%zu, swap=%d", cnt, swap);
+			}
+
+			for (int k = 0; k < 2; k++) {
+				ret = raw_convert_select(k ? simd : RawConvertIsa::SCALAR);
+				cr_assert_eq(ret, 0);
+
+				memset(raw[k], 0, sizeof(raw[k]));
+
+				raw_bswap16(raw[k] + 1, in, cnt);
+				raw_bswap32(raw[k] + 1 + 2 * cnt, in, cnt);
+				raw_bswap64(raw[k] + 1 + 6 * cnt, in, (max - cnt) / 4);
+			}
+
+			cr_assert_arr_eq(raw[0], raw[1], sizeof(raw[0]), "Mismatch for cnt=%zu", cnt);
+		}
+	}
+
+	ret = raw_convert_select(isa);
+	cr_assert_eq(ret, 0);
+}
+
+#ifdef PROTOBUF_FOUND
+/* The protobuf format reuses its message tree and arena across calls of different sizes */
+Test(format, protobuf_reuse, .init = init_memory)
+{
+	int ret;
+	unsigned cnt;
+	char buf[16384];
+	size_t wbytes, rbytes;
+
+	struct pool pool;
+	struct vlist signals;
+	struct sample *smps[16];
+	struct sample *smpt[16];
+
+	ret = pool_init(&pool, 32, SAMPLE_LENGTH(4 * NUM_VALUES));
+	cr_assert_eq(ret, 0);
+
+	ret = vlist_init(&signals);
+	cr_assert_eq(ret, 0);
+	signal_list_generate2(&signals, "10f10i10b10c");
+
+	ret = sample_alloc_many(&pool, smps, 16);
+	cr_assert_eq(ret, 16);
+
+	ret = sample_alloc_many(&pool, smpt, 16);
+	cr_assert_eq(ret, 16);
+
+	fill_sample_data(&signals, smps, 16);
+
+	json_t *json_format = json_loads("{ \"type\": \"protobuf\" }", 0, nullptr);
+	cr_assert_not_null(json_format);
+
+	Format *fmt = FormatFactory::make(json_format);
+	cr_assert_not_null(fmt);
+
+	fmt->start(&signals, (int) SampleFlags::HAS_ALL);
+
+	for (unsigned n : { 1, 16, 3, 8, 1, 16 }) {
+		/* Vary the number of values per sample as well */
+		for (unsigned i = 0; i < n; i++)
+			smps[i]->length = (i * 7 + n) % vlist_length(&signals) + 1;
+
+		cnt = fmt->sprint(buf, sizeof(buf), &wbytes, smps, n);
+		cr_assert_eq(cnt, n);
+
+		cnt = fmt->sscan(buf, wbytes, &rbytes, smpt, n);
+		cr_assert_eq(cnt, n);
+		cr_assert_eq(rbytes, wbytes);
+
+		for (unsigned i = 0; i < n; i++)
+			cr_assert_eq_sample(smps[i], smpt[i], fmt->getFlags());
+	}
+
+	delete fmt;
+
+	sample_free_many(smps, 16);
+	sample_free_many(smpt, 16);
+
+	ret = pool_destroy(&pool);
+	cr_assert_eq(ret, 0);
+}
+#endif /* PROTOBUF_FOUND */
@@ -0,0 +1,191 @@
+/** Unit tests for hook lists.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+
+#include <criterion/criterion.h>
+
+#include <cstring>
+#include <vector>
+
+#include <villas/hook.hpp>
+#include <villas/hook_list.hpp>
+#include <villas/sample.h>
+
+using namespace villas::node;
+
+extern void init_memory();
+
+#define NUM_SAMPLES	12
+
+/** Stops the processing of every third and skips every third sample. */
+class StopHook : public Hook {
+
+public:
+	using Hook::Hook;
+
+	virtual Hook::Reason process(struct sample *smp)
+	{
+		switch (smp->sequence % 3) {
+			case 1:
+				return Reason::STOP_PROCESSING;
+
+			case 2:
+				return Reason::SKIP_SAMPLE;
+
+			default:
+				return Reason::OK;
+		}
+	}
+};
+
+/** Returns a fixed reason for a single sample. */
+class SingleHook : public Hook {
+
+protected:
+	uint64_t sequence;
+	Hook::Reason reason;
+
+public:
+	SingleHook(uint64_t seq, Hook::Reason r, int prio) :
+		Hook(nullptr, nullptr, (int) Hook::Flags::BUILTIN, prio),
+		sequence(seq),
+		reason(r)
+	{ }
+
+	virtual Hook::Reason process(struct sample *smp)
+	{
+		return smp->sequence == sequence ? reason : Reason::OK;
+	}
+};
+
+/** Records the sequence numbers of all processed samples. */
+class RecordHook : public Hook {
+
+public:
+	std::vector<uint64_t> seen;
+
+	using Hook::Hook;
+
+	virtual Hook::Reason process(struct sample *smp)
+	{
+		seen.push_back(smp->sequence);
+
+		return Reason::OK;
+	}
+};
+
+// cppcheck-suppress unknownMacro
+Test(hook_list, stop_processing, .init = init_memory)
+{
+	int ret;
+	struct vlist hs;
+	struct sample *smps[NUM_SAMPLES];
+
+	ret = hook_list_init(&hs);
+	cr_assert_eq(ret, 0);
+
+	auto *stop = new StopHook(nullptr, nullptr, (int) Hook::Flags::BUILTIN, 1);
+	auto *record = new RecordHook(nullptr, nullptr, (int) Hook::Flags::BUILTIN, 2);
+
+	vlist_push(&hs, stop);
+	vlist_push(&hs, record);
+
+	for (unsigned i = 0; i < NUM_SAMPLES; i++) {
+		smps[i] = sample_alloc_mem(1);
+		cr_assert_not_null(smps[i]);
+
+		smps[i]->sequence = i;
+	}
+
+	ret = hook_list_process(&hs, smps, NUM_SAMPLES);
+	cr_assert_eq(ret, 2 * NUM_SAMPLES / 3);
+
+	/* The second hook does not see stopped or skipped samples */
+	cr_assert_eq(record->seen.size(), NUM_SAMPLES / 3);
+	for (auto seq : record->seen)
+		cr_assert_eq(seq % 3, 0);
+
+	/* Stopped samples are still forwarded in their original order */
+	for (int i = 0; i < ret; i++)
+		cr_assert_eq(smps[i]->sequence, (uint64_t) i / 2 * 3 + i % 2);
+
+	/* Skipped samples are moved behind the forwarded ones */
+	for (unsigned i = ret; i < NUM_SAMPLES; i++)
+		cr_assert_eq(smps[i]->sequence % 3, 2);
+
+	sample_free_many(smps, NUM_SAMPLES);
+
+	ret = hook_list_destroy(&hs);
+	cr_assert_eq(ret, 0);
+}
+
+Test(hook_list, multiple_stops, .init = init_memory)
+{
+	int ret;
+	struct vlist hs;
+	struct sample *smps[NUM_SAMPLES];
+
+	ret = hook_list_init(&hs);
+	cr_assert_eq(ret, 0);
+
+	/* Each hook stops a different sample, later hooks stop later samples */
+	vlist_push(&hs, new SingleHook(0, Hook::Reason::STOP_PROCESSING, 1));
+	vlist_push(&hs, new SingleHook(1, Hook::Reason::STOP_PROCESSING, 2));
+	vlist_push(&hs, new SingleHook(7, Hook::Reason::SKIP_SAMPLE, 3));
+	vlist_push(&hs, new SingleHook(5, Hook::Reason::STOP_PROCESSING, 4));
+	vlist_push(&hs, new SingleHook(9, Hook::Reason::STOP_PROCESSING, 5));
+
+	auto *record = new RecordHook(nullptr, nullptr, (int) Hook::Flags::BUILTIN, 6);
+	vlist_push(&hs, record);
+
+	for (unsigned i = 0; i < NUM_SAMPLES; i++) {
+		smps[i] = sample_alloc_mem(1);
+		cr_assert_not_null(smps[i]);
+
+		smps[i]->sequence = i;
+	}
+
+	struct sample *orig[NUM_SAMPLES];
+	memcpy(orig, smps, sizeof(orig));
+
+	ret = hook_list_process(&hs, smps, NUM_SAMPLES);
+	cr_assert_eq(ret, NUM_SAMPLES - 1);
+
+	cr_assert_eq(record->seen.size(), NUM_SAMPLES - 5);
+	for (auto seq : record->seen)
+		cr_assert(seq != 0 && seq != 1 && seq != 5 && seq != 7 && seq != 9);
+
+	/* All forwarded samples are in their original order */
+	for (int i = 0; i < ret; i++)
+		cr_assert_eq(smps[i]->sequence, (uint64_t) (i < 7 ? i : i + 1));
+
+	cr_assert_eq(smps[NUM_SAMPLES - 1]->sequence, 7);
+
+	/* The batch is still a permutation of the original samples */
+	for (unsigned i = 0; i < NUM_SAMPLES; i++)
+		cr_assert_eq(smps[i], orig[smps[i]->sequence]);
+
+	sample_free_many(smps, NUM_SAMPLES);
+
+	ret = hook_list_destroy(&hs);
+	cr_assert_eq(ret, 0);
+}
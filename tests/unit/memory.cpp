@@ -24,6 +24,7 @@
 #include <criterion/theories.h>
 
 #include <cerrno>
+#include <pthread.h>
 
 #include <villas/memory.h>
 #include <villas/utils.hpp>
@@ -34,6 +35,10 @@ extern void init_memory();
 #define PAGESIZE (1 << 12)
 #define HUGEPAGESIZE (1 << 21)
 
+#define STRESS_THREADS		8
+#define STRESS_ITERATIONS	10000
+#define STRESS_BATCH		16
+
 TheoryDataPoints(memory, aligned) = {
 	DataPoints(size_t, 1, 32, 55, 1 << 10, PAGESIZE, HUGEPAGESIZE),
 	DataPoints(size_t, 1, 8, PAGESIZE, PAGESIZE),
@@ -112,3 +117,101 @@ Test(memory, manager, .init = init_memory) {
 	ret = memory_free(p);
 	cr_assert(ret == 0);
 }
+
+Test(memory, double_free, .init = init_memory) {
+	int ret;
+	char *ptr;
+
+	ptr = (char *) memory_alloc(64, &memory_heap);
+	cr_assert_not_null(ptr);
+
+	/* Pointers into an allocation are not registered */
+	cr_assert_null(memory_get_allocation(ptr + 8));
+	cr_assert_null(memory_get_allocation(ptr + MEMORY_MIN_ALIGNMENT));
+
+	ret = memory_free(ptr + 8);
+	cr_assert_eq(ret, -1);
+
+	ret = memory_free(ptr);
+	cr_assert_eq(ret, 0);
+
+	/* A second release must be rejected */
+	cr_assert_null(memory_get_allocation(ptr));
+
+	ret = memory_free(ptr);
+	cr_assert_eq(ret, -1);
+}
+
+struct stress_param {
+	pthread_barrier_t *barrier;
+	unsigned seed;
+};
+
+static void * stress_alloc_free(void *ctx)
+{
+	struct stress_param *p = (struct stress_param *) ctx;
+	void *ptrs[STRESS_BATCH];
+	size_t lens[STRESS_BATCH];
+	unsigned seed = p->seed;
+	intptr_t errors = 0;
+
+	pthread_barrier_wait(p->barrier);
+
+	for (int i = 0; i < STRESS_ITERATIONS; i++) {
+		for (int j = 0; j < STRESS_BATCH; j++) {
+			lens[j] = 1 + rand_r(&seed) % 4096;
+
+			ptrs[j] = memory_alloc(lens[j], &memory_heap);
+			if (!ptrs[j]) {
+				errors++;
+				continue;
+			}
+
+			memset(ptrs[j], j, lens[j]);
+		}
+
+		for (int j = 0; j < STRESS_BATCH; j++) {
+			if (!ptrs[j])
+				continue;
+
+			struct memory_allocation *ma = memory_get_allocation(ptrs[j]);
+			if (!ma || ma->address != ptrs[j] || ma->length != lens[j])
+				errors++;
+
+			if (memory_free(ptrs[j]))
+				errors++;
+		}
+	}
+
+	return (void *) errors;
+}
+
+Test(memory, registry_stress, .init = init_memory) {
+	int ret;
+	pthread_t threads[STRESS_THREADS];
+	struct stress_param params[STRESS_THREADS];
+	pthread_barrier_t barrier;
+
+	ret = pthread_barrier_init(&barrier, nullptr, STRESS_THREADS);
+	cr_assert_eq(ret, 0, "Failed to create barrier");
+
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		params[i].barrier = &barrier;
+		params[i].seed = i;
+
+		ret = pthread_create(&threads[i], nullptr, stress_alloc_free, &params[i]);
+		cr_assert_eq(ret, 0, "Failed to create thread");
+	}
+
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		void *errors;
+
+		ret = pthread_join(threads[i], &errors);
+		cr_assert_eq(ret, 0, "Failed to join thread");
+		cr_assert_eq((intptr_t) errors, 0, "Thread %d encountered %zd errors", i, (intptr_t) errors);
+	}
+
+	pthread_barrier_destroy(&barrier);
+
+	cr_assert_null(memory_get_allocation(&barrier));
+}
@@ -24,9 +24,14 @@
 #include <criterion/parameterized.h>
 
 #include <signal.h>
+#include <pthread.h>
 
 #include <villas/pool.h>
 #include <villas/utils.hpp>
+#include <villas/tsc.h>
+#include <villas/log.hpp>
+
+using namespace villas;
 
 extern void init_memory();
 
@@ -83,3 +88,229 @@ ParameterizedTest(struct param *p, pool, basic, .init = init_memory)
 	cr_assert_eq(ret, 0, "Failed to destroy pool");
 
 }
+
+Test(pool, cached, .init = init_memory)
+{
+	int ret;
+	struct pool pool;
+	size_t cnt = POOL_MAGAZINE_THRESHOLD;
+
+	void *ptrs[cnt];
+
+	ret = pool_init(&pool, cnt, 64, &memory_heap);
+	cr_assert_eq(ret, 0, "Failed to create pool");
+	cr_assert_neq(pool.magazines_off, 0, "Pool does not use per-thread caches");
+
+	/* Blocks which are released into the cache must be handed out again */
+	for (int round = 0; round < 2; round++) {
+		size_t got = 0;
+
+		while (got < cnt) {
+			ret = pool_get_many(&pool, &ptrs[got], MIN(cnt - got, (size_t) 10));
+			if (ret <= 0)
+				break;
+
+			got += ret;
+		}
+
+		cr_assert_eq(got, cnt, "Only got %zu of %zu blocks", got, cnt);
+
+		ret = pool_get_many(&pool, ptrs, 1);
+		cr_assert_eq(ret, 0);
+
+		for (size_t i = 0; i < cnt; i += 7)
+			pool_put_many(&pool, &ptrs[i], MIN(cnt - i, (size_t) 7));
+	}
+
+	ret = pool_destroy(&pool);
+	cr_assert_eq(ret, 0, "Failed to destroy pool");
+}
+
+static void * get_put_cached(void *ctx)
+{
+	struct pool *p = (struct pool *) ctx;
+	void *blocks[POOL_MAGAZINE_SIZE / 2];
+
+	/* The blocks remain in the cache of this thread */
+	ssize_t got = pool_get_many(p, blocks, ARRAY_LEN(blocks));
+	if (got > 0)
+		pool_put_many(p, blocks, got);
+
+	return nullptr;
+}
+
+Test(pool, cached_single, .init = init_memory)
+{
+	int ret;
+	struct pool pool;
+	pthread_t thread;
+	size_t cnt = POOL_MAGAZINE_THRESHOLD;
+
+	void *ptrs[cnt];
+
+	ret = pool_init(&pool, cnt, 64, &memory_heap);
+	cr_assert_eq(ret, 0, "Failed to create pool");
+
+	ret = pthread_create(&thread, nullptr, get_put_cached, &pool);
+	cr_assert_eq(ret, 0);
+
+	ret = pthread_join(thread, nullptr);
+	cr_assert_eq(ret, 0);
+
+	/* pool_get() must steal the blocks cached by the other thread */
+	for (size_t i = 0; i < cnt; i++) {
+		ptrs[i] = pool_get(&pool);
+		cr_assert_not_null(ptrs[i], "Only got %zu of %zu blocks", i, cnt);
+	}
+
+	cr_assert_null(pool_get(&pool));
+
+	for (size_t i = 0; i < cnt; i++) {
+		ret = pool_put(&pool, ptrs[i]);
+		cr_assert_eq(ret, 1);
+	}
+
+	ret = pool_get_many(&pool, ptrs, cnt);
+	cr_assert_eq(ret, (int) cnt, "Only got %d of %zu blocks", ret, cnt);
+
+	ret = pool_destroy(&pool);
+	cr_assert_eq(ret, 0, "Failed to destroy pool");
+}
+
+Test(pool, shared, .init = init_memory)
+{
+	int ret;
+	struct pool pool;
+	struct memory_type *m;
+	size_t cnt = POOL_MAGAZINE_THRESHOLD;
+	size_t blocksz = 64;
+
+	void *ptrs[cnt];
+
+	/* Just enough space for the blocks and the queue like in shmem_total_size() */
+	size_t len = sizeof(struct memory_type) + cnt * (blocksz + sizeof(struct queue_cell)) + 4 * sizeof(struct memory_block) + 1024;
+
+	void *base = memory_alloc(len, &memory_heap);
+	cr_assert_not_null(base);
+
+	m = memory_managed(base, len);
+	cr_assert_not_null(m);
+
+	m->flags |= (int) MemoryFlags::SHARED;
+
+	ret = pool_init(&pool, cnt, blocksz, m);
+	cr_assert_eq(ret, 0, "Failed to create pool");
+	cr_assert_eq(pool.magazines_off, 0, "Shared pool must not use per-thread caches");
+
+	ret = pool_get_many(&pool, ptrs, cnt);
+	cr_assert_eq(ret, (int) cnt, "Only got %d of %zu blocks", ret, cnt);
+
+	ret = pool_put_many(&pool, ptrs, cnt);
+	cr_assert_eq(ret, (int) cnt);
+
+	ret = pool_destroy(&pool);
+	cr_assert_eq(ret, 0, "Failed to destroy pool");
+
+	ret = memory_free(base);
+	cr_assert_eq(ret, 0);
+}
+
+#if defined(_POSIX_BARRIERS) && _POSIX_BARRIERS > 0
+#define BENCHMARK_ITERATIONS	(1 << 16)
+#define BENCHMARK_BATCH		8
+
+struct benchmark_param {
+	int thread_count;
+	bool cached;
+
+	struct pool pool;
+	pthread_barrier_t barrier;
+};
+
+static void * alloc_free(void *ctx)
+{
+	struct benchmark_param *p = (struct benchmark_param *) ctx;
+	void *blocks[BENCHMARK_BATCH];
+	ssize_t got;
+
+	pthread_barrier_wait(&p->barrier);
+
+	for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		/* Without caches, pool_get_many() and pool_put_many() directly use the shared queue */
+		if (p->cached) {
+			got = pool_get_many(&p->pool, blocks, BENCHMARK_BATCH);
+			if (got > 0)
+				pool_put_many(&p->pool, blocks, got);
+		}
+		else {
+			got = queue_pull_many(&p->pool.queue, blocks, BENCHMARK_BATCH);
+			if (got > 0)
+				queue_push_many(&p->pool.queue, blocks, got);
+		}
+	}
+
+	return nullptr;
+}
+
+ParameterizedTestParameters(pool, benchmark)
+{
+	static struct benchmark_param params[] = {
+		{ .thread_count = 1,	.cached = false },
+		{ .thread_count = 1,	.cached = true },
+		{ .thread_count = 2,	.cached = false },
+		{ .thread_count = 2,	.cached = true },
+		{ .thread_count = 4,	.cached = false },
+		{ .thread_count = 4,	.cached = true },
+		{ .thread_count = 8,	.cached = false },
+		{ .thread_count = 8,	.cached = true },
+		{ .thread_count = 16,	.cached = false },
+		{ .thread_count = 16,	.cached = true }
+	};
+
+	return cr_make_param_array(struct benchmark_param, params, ARRAY_LEN(params));
+}
+
+// cppcheck-suppress unknownMacro
+ParameterizedTest(struct benchmark_param *p, pool, benchmark, .timeout = 60, .init = init_memory)
+{
+	int ret;
+	struct tsc tsc;
+	uint64_t start, end, ops;
+
+	Logger logger = logging.get("test:pool:benchmark");
+
+	pthread_t threads[p->thread_count];
+
+	ret = pool_init(&p->pool, 4 * POOL_MAGAZINE_THRESHOLD, 64, &memory_heap);
+	cr_assert_eq(ret, 0, "Failed to create pool");
+
+	ret = pthread_barrier_init(&p->barrier, nullptr, p->thread_count + 1);
+	cr_assert_eq(ret, 0, "Failed to create barrier");
+
+	for (int i = 0; i < p->thread_count; i++)
+		pthread_create(&threads[i], nullptr, alloc_free, p);
+
+	ret = tsc_init(&tsc);
+	cr_assert(!ret);
+
+	pthread_barrier_wait(&p->barrier);
+
+	start = tsc_now(&tsc);
+
+	for (int i = 0; i < p->thread_count; i++)
+		pthread_join(threads[i], nullptr);
+
+	end = tsc_now(&tsc);
+
+	/* One operation is the allocation and release of a single block */
+	ops = (uint64_t) p->thread_count * BENCHMARK_ITERATIONS * BENCHMARK_BATCH;
+
+	logger->info("threads={}, cached={}: {} cycles/op", p->thread_count, p->cached, (end - start) / ops);
+
+	ret = pthread_barrier_destroy(&p->barrier);
+	cr_assert_eq(ret, 0, "Failed to destroy barrier");
+
+	ret = pool_destroy(&p->pool);
+	cr_assert_eq(ret, 0, "Failed to destroy pool");
+}
+#endif /* _POSIX_BARRIERS */
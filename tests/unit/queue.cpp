@@ -339,6 +339,132 @@ ParameterizedTest(struct param *p, queue, multi_threaded, .timeout = 20, .init =
 }
 #endif /* _POSIX_BARRIERS */
 
+Test(queue, single_threaded_spsc, .init = init_memory)
+{
+	int ret;
+	struct param p;
+
+	p.iter_count = 1 << 8;
+	p.queue_size = 1 << 10;
+	p.start = 1; /* we start immeadiatly */
+
+	ret = queue_init(&p.queue, p.queue_size, &memory_heap, (int) QueueFlags::SPSC);
+	cr_assert_eq(ret, 0, "Failed to create queue");
+
+	producer(&p);
+	consumer(&p);
+
+	cr_assert_eq(queue_available(&p.queue), 0);
+
+	ret = queue_destroy(&p.queue);
+	cr_assert_eq(ret, 0, "Failed to destroy queue");
+}
+
+struct spsc_param {
+	int flags;
+	int batch_size;
+	intptr_t iter_count;
+	struct queue queue;
+};
+
+static void * spsc_producer(void *ctx)
+{
+	struct spsc_param *p = (struct spsc_param *) ctx;
+	void *ptrs[p->batch_size];
+
+	for (intptr_t count = 0; count < p->iter_count;) {
+		int cnt = MIN(p->batch_size, p->iter_count - count);
+
+		for (int i = 0; i < cnt; i++)
+			ptrs[i] = (void *) (count + i);
+
+		int pushed = 0;
+		while (pushed < cnt) {
+			pushed += queue_push_many(&p->queue, &ptrs[pushed], cnt - pushed);
+			if (pushed < cnt)
+				pthread_yield(); /* queue full, let the consumer proceed */
+		}
+
+		count += cnt;
+	}
+
+	return nullptr;
+}
+
+static void * spsc_consumer(void *ctx)
+{
+	int ret;
+	struct spsc_param *p = (struct spsc_param *) ctx;
+	void *ptrs[p->batch_size];
+
+	for (intptr_t count = 0; count < p->iter_count;) {
+		ret = queue_pull_many(&p->queue, ptrs, p->batch_size);
+		if (ret < 0)
+			return (void *) 1;
+		else if (ret == 0)
+			pthread_yield(); /* queue empty, let the producer proceed */
+
+		for (int i = 0; i < ret; i++, count++) {
+			if ((intptr_t) ptrs[i] != count)
+				return (void *) 2; /* Samples must be received in order */
+		}
+	}
+
+	return nullptr;
+}
+
+ParameterizedTestParameters(queue, spsc_throughput)
+{
+	static struct spsc_param params[] = {
+		{ .flags = 0,				.batch_size = 1,	.iter_count = 1 << 20 },
+		{ .flags = (int) QueueFlags::SPSC,	.batch_size = 1,	.iter_count = 1 << 20 },
+		{ .flags = 0,				.batch_size = 16,	.iter_count = 1 << 20 },
+		{ .flags = (int) QueueFlags::SPSC,	.batch_size = 16,	.iter_count = 1 << 20 }
+	};
+
+	return cr_make_param_array(struct spsc_param, params, ARRAY_LEN(params));
+}
+
+// cppcheck-suppress unknownMacro
+ParameterizedTest(struct spsc_param *p, queue, spsc_throughput, .timeout = 20, .init = init_memory)
+{
+	int ret;
+	struct tsc tsc;
+	void *r1, *r2;
+	uint64_t start, end;
+
+	Logger logger = logging.get("test:queue:spsc_throughput");
+
+	pthread_t t1, t2;
+
+	ret = queue_init(&p->queue, 1 << 10, &memory_heap, p->flags);
+	cr_assert_eq(ret, 0, "Failed to create queue");
+
+	ret = tsc_init(&tsc);
+	cr_assert(!ret);
+
+	start = tsc_now(&tsc);
+
+	pthread_create(&t1, nullptr, spsc_producer, p);
+	pthread_create(&t2, nullptr, spsc_consumer, p);
+
+	pthread_join(t1, &r1);
+	pthread_join(t2, &r2);
+
+	end = tsc_now(&tsc);
+
+	cr_assert_null(r1, "Producer failed: %p", r1);
+	cr_assert_null(r2, "Consumer failed: %p", r2);
+
+	logger->info("spsc={}, batch_size={}: {} cycles/op",
+		p->flags & (int) QueueFlags::SPSC ? true : false, p->batch_size, (end - start) / p->iter_count);
+
+	cr_assert_eq(queue_available(&p->queue), 0);
+
+	ret = queue_destroy(&p->queue);
+	cr_assert_eq(ret, 0, "Failed to destroy queue");
+}
+
 Test(queue, init_destroy, .init = init_memory)
 {
 	int ret;
@@ -118,9 +118,17 @@ ParameterizedTestParameters(queue_signalled, simple)
 		{ QueueSignalledMode::PTHREAD, 0, false },
 		{ QueueSignalledMode::PTHREAD, (int) QueueSignalledFlags::PROCESS_SHARED, false },
 		{ QueueSignalledMode::POLLING, 0, false },
+		{ QueueSignalledMode::AUTO,    (int) QueueFlags::SPSC, false },
+		{ QueueSignalledMode::POLLING, (int) QueueFlags::SPSC, false },
+		{ QueueSignalledMode::AUTO,    (int) QueueSignalledFlags::ADAPTIVE, false },
+		{ QueueSignalledMode::PTHREAD, (int) QueueSignalledFlags::ADAPTIVE, false },
+		{ QueueSignalledMode::PTHREAD, (int) QueueSignalledFlags::ADAPTIVE | (int) QueueSignalledFlags::PROCESS_SHARED, false },
 #if defined(__linux__) && defined(HAS_EVENTFD)
 		{ QueueSignalledMode::EVENTFD, 0, false },
-		{ QueueSignalledMode::EVENTFD, 0, true }
+		{ QueueSignalledMode::EVENTFD, 0, true },
+		{ QueueSignalledMode::EVENTFD, (int) QueueFlags::SPSC, true },
+		{ QueueSignalledMode::EVENTFD, (int) QueueSignalledFlags::ADAPTIVE | (int) QueueFlags::SPSC, false },
+		{ QueueSignalledMode::EVENTFD, (int) QueueSignalledFlags::ADAPTIVE, true }
 #endif
 	};
 
@@ -139,6 +147,10 @@ ParameterizedTest(struct param *param, queue_signalled, simple, .timeout = 5, .i
 	ret = queue_signalled_init(&q, LOG2_CEIL(NUM_ELEM), &memory_heap, param->mode, param->flags);
 	cr_assert_eq(ret, 0, "Failed to initialize queue: mode=%d, flags=%#x, ret=%d", (int) param->mode, param->flags, ret);
 
+	/* Make sure that consumers spin even if the budget would be tuned down */
+	if (param->flags & (int) QueueSignalledFlags::ADAPTIVE)
+		queue_signalled_set_spin(&q, 200000);
+
 	ret = pthread_create(&t1, nullptr, producer, &q);
 	cr_assert_eq(ret, 0);
 
@@ -163,3 +175,36 @@ ParameterizedTest(struct param *param, queue_signalled, simple, .timeout = 5, .i
 	ret = queue_signalled_destroy(&q);
 	cr_assert_eq(ret, 0);
 }
+
+// cppcheck-suppress unknownMacro
+Test(queue_signalled, coalesce, .init = init_memory)
+{
+	int ret;
+	struct queue_signalled q;
+
+	void *data[NUM_ELEM];
+
+	ret = queue_signalled_init(&q, LOG2_CEIL(NUM_ELEM), &memory_heap);
+	cr_assert_eq(ret, 0);
+
+	/* Only the first push needs to wake up the consumer */
+	for (intptr_t i = 0; i < 100; i++) {
+		ret = queue_signalled_push(&q, (void *) i);
+		cr_assert_eq(ret, 1);
+	}
+
+	ret = queue_signalled_push_many(&q, data, 100);
+	cr_assert_eq(ret, 100);
+
+	cr_assert_eq(q.pushed.load(), 200);
+	cr_assert_eq(q.signalled.load(), 1);
+
+	ret = queue_signalled_pull_many(&q, data, ARRAY_LEN(data));
+	cr_assert_eq(ret, 200);
+
+	ret = queue_signalled_close(&q);
+	cr_assert_eq(ret, 0);
+
+	ret = queue_signalled_destroy(&q);
+	cr_assert_eq(ret, 0);
+}
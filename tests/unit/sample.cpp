@@ -0,0 +1,91 @@
+/** Unit tests for samples.
+ *
+ * @author Steffen Vogel <stvogel@eonerc.rwth-aachen.de>
+ * @copyright 2014-2020, Institute for Automation of Complex Power Systems, EONERC
+ * @license GNU General Public License (version 3)
+ *
+ * VILLASnode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *********************************************************************************/
+
+
+#include <criterion/criterion.h>
+
+#include <villas/sample.h>
+#include <villas/pool.h>
+
+extern void init_memory();
+
+#define NUM_SAMPLES	4
+
+// cppcheck-suppress unknownMacro
+Test(sample, trace, .init = init_memory)
+{
+	int ret;
+	struct pool pool;
+	struct sample *smps[NUM_SAMPLES], *copy;
+
+	ret = pool_init(&pool, NUM_SAMPLES + 1, SAMPLE_LENGTH(1), &memory_heap);
+	cr_assert_eq(ret, 0);
+
+	ret = sample_alloc_many(&pool, smps, NUM_SAMPLES);
+	cr_assert_eq(ret, NUM_SAMPLES);
+
+	/* Fresh samples have not passed any stage */
+	for (unsigned i = 0; i < NUM_SAMPLES; i++) {
+		for (unsigned s = 0; s < SAMPLE_TRACE_STAGES; s++)
+			cr_assert_eq(smps[i]->trace[s], 0);
+	}
+
+	/* Pass the samples through all stages except the last one */
+	for (unsigned s = 0; s < SAMPLE_TRACE_STAGES - 1; s++)
+		sample_trace_many(smps, NUM_SAMPLES, (enum SampleTraceStage) s);
+
+	for (unsigned i = 0; i < NUM_SAMPLES; i++) {
+		for (unsigned s = 0; s < SAMPLE_TRACE_STAGES - 1; s++) {
+			cr_assert_neq(smps[i]->trace[s], 0);
+
+			/* The clock is read once per batch */
+			cr_assert_eq(smps[i]->trace[s], smps[0]->trace[s]);
+
+			/* Stages are passed in order */
+			if (s > 0)
+				cr_assert_geq(smps[i]->trace[s], smps[i]->trace[s-1]);
+		}
+
+		cr_assert_eq(smps[i]->trace[(int) SampleTraceStage::WRITTEN], 0);
+	}
+
+	/* Only a part of the batch is written */
+	sample_trace_many(smps, 1, SampleTraceStage::WRITTEN);
+	cr_assert_geq(smps[0]->trace[(int) SampleTraceStage::WRITTEN], smps[0]->trace[(int) SampleTraceStage::HOOKS_OUT]);
+	cr_assert_eq(smps[1]->trace[(int) SampleTraceStage::WRITTEN], 0);
+
+	/* Copies start with an empty trace */
+	copy = sample_alloc(&pool);
+	cr_assert_not_null(copy);
+
+	ret = sample_copy(copy, smps[0]);
+	cr_assert_eq(ret, 0);
+
+	for (unsigned s = 0; s < SAMPLE_TRACE_STAGES; s++)
+		cr_assert_eq(copy->trace[s], 0);
+
+	sample_free(copy);
+	sample_free_many(smps, NUM_SAMPLES);
+
+	ret = pool_destroy(&pool);
+	cr_assert_eq(ret, 0);
+}
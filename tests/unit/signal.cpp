@@ -22,6 +22,10 @@
 
 #include <criterion/criterion.h>
 
+#include <cmath>
+#include <cstring>
+#include <random>
+
 #include <villas/signal.h>
 
 extern void init_memory();
@@ -85,3 +89,60 @@ Test(signal_data, parse, .init = init_memory) {
 	cr_assert_float_eq(std::real(sd.z), 0, 1e-6);
 	cr_assert_float_eq(std::imag(sd.z), -3, 1e-6);
 }
+
+// cppcheck-suppress unknownMacro
+Test(signal_data, print_parse_roundtrip, .init = init_memory) {
+	int ret;
+	union signal_data sd, out;
+	char buf[512], ref[512], *end;
+
+	std::mt19937_64 rng(42);
+
+	for (int i = 0; i < 100000; i++) {
+		uint64_t bits = rng();
+		int precision = i % 32;
+
+		/* Arbitrary bit patterns include NaN, infinity and subnormal numbers */
+		memcpy(&sd.f, &bits, sizeof(sd.f));
+
+		ret = signal_data_print_str(&sd, SignalType::FLOAT, buf, sizeof(buf), precision);
+		snprintf(ref, sizeof(ref), "%.*f", precision, sd.f);
+		cr_assert_eq(ret, (int) strlen(ref));
+		cr_assert_str_eq(buf, ref);
+
+		/* Truncated output behaves like snprintf() */
+		ret = signal_data_print_str(&sd, SignalType::FLOAT, buf, i % 24, precision);
+		cr_assert_eq(ret, (int) strlen(ref));
+		if (i % 24)
+			cr_assert_eq(strncmp(buf, ref, i % 24 - 1), 0);
+
+		sd.z = std::complex<float>(sd.f, -sd.f);
+
+		ret = signal_data_print_str(&sd, SignalType::COMPLEX, buf, sizeof(buf), precision);
+		snprintf(ref, sizeof(ref), "%.*f%+.*fi", precision, std::real(sd.z), precision, std::imag(sd.z));
+		cr_assert_eq(ret, (int) strlen(ref));
+		cr_assert_str_eq(buf, ref);
+
+		/* 17 significant digits are sufficient for all numbers. NaN payloads are not preserved. */
+		memcpy(&sd.f, &bits, sizeof(sd.f));
+		snprintf(ref, sizeof(ref), "%.17g", sd.f);
+
+		ret = signal_data_parse_str(&out, SignalType::FLOAT, ref, &end);
+		cr_assert_eq(ret, 0);
+		cr_assert_eq(end, ref + strlen(ref));
+		if (!std::isnan(sd.f))
+			cr_assert_eq(memcmp(&out.f, &sd.f, sizeof(sd.f)), 0, "Failed to parse %s", ref);
+
+		/* 17 fractional digits are sufficient for values which are not too small */
+		sd.f = std::uniform_real_distribution<double>(-1e6, 1e6)(rng);
+		if (fabs(sd.f) < 1)
+			continue;
+
+		signal_data_print_str(&sd, SignalType::FLOAT, buf, sizeof(buf), 17);
+
+		ret = signal_data_parse_str(&out, SignalType::FLOAT, buf, &end);
+		cr_assert_eq(ret, 0);
+		cr_assert_eq(end, buf + strlen(buf));
+		cr_assert_eq(out.f, sd.f, "Failed to round-trip %s", buf);
+	}
+}